@@ -0,0 +1,519 @@
+/*
+ * bench.c
+ *
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <cvl/cvl.h>
+
+#include "mh.h"
+#include "bench.h"
+
+
+const char *bench_report_names[] = { "csv", "json", NULL };
+const char *bench_type_names[] = { "uint8", "float", "float16", NULL };
+const char *bench_format_names[] = { "lum", "xyz", "rgb", "hsl", "unknown", NULL };
+
+static int bench_report_count;
+
+
+cvl_gl_context_t *bench_init(void)
+{
+    const char *display_name;
+#ifdef W32_NATIVE
+    display_name = NULL;
+#else
+    if (!(display_name = getenv("DISPLAY")))
+    {
+	mh_msg_err("Cannot create OpenGL context: No environment variable DISPLAY.");
+	return NULL;
+    }
+#endif
+    cvl_gl_context_t *ctx = cvl_gl_context_new(display_name);
+    if (!ctx)
+    {
+	mh_msg_err("Cannot create OpenGL context");
+	return NULL;
+    }
+    cvl_init();
+    if (cvl_error())
+    {
+	mh_msg_err("%s", cvl_error_msg());
+	cvl_gl_context_free(ctx);
+	return NULL;
+    }
+    return ctx;
+}
+
+void bench_deinit(cvl_gl_context_t *ctx)
+{
+    cvl_deinit();
+    cvl_gl_context_free(ctx);
+}
+
+bool bench_list_contains(const char *list, const char *word)
+{
+    size_t len = strlen(word);
+    const char *p = list;
+    while ((p = strstr(p, word)))
+    {
+	if ((p == list || p[-1] == ',') && (p[len] == '\0' || p[len] == ','))
+	    return true;
+	p += len;
+    }
+    return false;
+}
+
+bool bench_parse_names(const char *list, const char **names, bool *flags)
+{
+    int n = 0;
+    for (int i = 0; names[i]; i++)
+    {
+	flags[i] = bench_list_contains(list, names[i]);
+	if (flags[i])
+	    n++;
+    }
+    /* Every element of the list must have been a known name. */
+    int elements = 1;
+    for (const char *p = list; *p; p++)
+	if (*p == ',')
+	    elements++;
+    return (n == elements);
+}
+
+cvl_frame_t *bench_frame_new(int width, int height, int channels, cvl_format_t format, cvl_type_t type)
+{
+    cvl_frame_t *frame = cvl_frame_new(width, height, channels, format, type, CVL_MEM);
+    if (!frame)
+	return NULL;
+    int memchannels = (format == CVL_LUM ? 1 : format == CVL_UNKNOWN ? 4 : 3);
+    uint8_t *p8 = cvl_frame_pointer(frame);
+    float *pf = cvl_frame_pointer(frame);
+    /* A smooth pattern with noise from a fixed LCG, so that every run sees
+     * the same data. */
+    uint32_t seed = 0x2545f491;
+    for (int y = 0; y < height; y++)
+    {
+	for (int x = 0; x < width; x++)
+	{
+	    for (int c = 0; c < memchannels; c++)
+	    {
+		seed = seed * 1664525 + 1013904223;
+		float noise = (float)(seed >> 8) / (float)(1 << 24);
+		float v = 0.5f + 0.25f * sinf(0.05f * x + c) * cosf(0.07f * y) + 0.25f * (noise - 0.5f);
+		size_t i = ((size_t)y * width + x) * memchannels + c;
+		if (type == CVL_UINT8)
+		    p8[i] = mh_iroundf(v * 255.0f);
+		else
+		    pf[i] = v;
+	    }
+	}
+    }
+    cvl_frame_texture(frame);
+    return frame;
+}
+
+static int bench_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x < y ? -1 : x > y ? +1 : 0);
+}
+
+double bench_percentile(const double *times, int n, double p)
+{
+    double *sorted = mh_alloc(mh_alloc_mul(n, sizeof(double)));
+    memcpy(sorted, times, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), bench_cmp_double);
+    /* Nearest rank */
+    int rank = (int)ceil(p * n);
+    double r = sorted[mh_maxi(0, mh_mini(n - 1, rank - 1))];
+    free(sorted);
+    return r;
+}
+
+double bench_median(const double *times, int n)
+{
+    double *sorted = mh_alloc(mh_alloc_mul(n, sizeof(double)));
+    memcpy(sorted, times, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), bench_cmp_double);
+    double r = (n % 2 == 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0);
+    free(sorted);
+    return r;
+}
+
+/* A minimal JSON reader, sufficient for the reports that we write. */
+
+typedef struct
+{
+    const char *p;
+    bool error;
+} bench_json_t;
+
+static void bench_json_ws(bench_json_t *j)
+{
+    while (*j->p == ' ' || *j->p == '\t' || *j->p == '\n' || *j->p == '\r')
+	j->p++;
+}
+
+static bool bench_json_char(bench_json_t *j, char c)
+{
+    bench_json_ws(j);
+    if (*j->p == c)
+    {
+	j->p++;
+	return true;
+    }
+    return false;
+}
+
+static char *bench_json_string(bench_json_t *j)
+{
+    if (!bench_json_char(j, '"'))
+    {
+	j->error = true;
+	return NULL;
+    }
+    const char *start = j->p;
+    while (*j->p && *j->p != '"')
+    {
+	if (*j->p == '\\' && j->p[1])
+	    j->p++;
+	j->p++;
+    }
+    if (!*j->p)
+    {
+	j->error = true;
+	return NULL;
+    }
+    char *str = mh_strndup(start, j->p - start);
+    j->p++;
+    return str;
+}
+
+static double bench_json_number(bench_json_t *j)
+{
+    bench_json_ws(j);
+    char *end;
+    double v = strtod(j->p, &end);
+    if (end == j->p)
+	j->error = true;
+    j->p = end;
+    return v;
+}
+
+static void bench_json_skip(bench_json_t *j)
+{
+    bench_json_ws(j);
+    if (*j->p == '"')
+    {
+	free(bench_json_string(j));
+    }
+    else if (*j->p == '{' || *j->p == '[')
+    {
+	char close = (*j->p == '{' ? '}' : ']');
+	j->p++;
+	if (bench_json_char(j, close))
+	    return;
+	do
+	{
+	    if (close == '}')
+	    {
+		free(bench_json_string(j));
+		if (!bench_json_char(j, ':'))
+		    j->error = true;
+	    }
+	    bench_json_skip(j);
+	}
+	while (!j->error && bench_json_char(j, ','));
+	if (!bench_json_char(j, close))
+	    j->error = true;
+    }
+    else if (strncmp(j->p, "true", 4) == 0 || strncmp(j->p, "null", 4) == 0)
+    {
+	j->p += 4;
+    }
+    else if (strncmp(j->p, "false", 5) == 0)
+    {
+	j->p += 5;
+    }
+    else
+    {
+	bench_json_number(j);
+    }
+}
+
+static void bench_json_result(bench_json_t *j, bench_result_t *r)
+{
+    int times_size = 0;
+    if (!bench_json_char(j, '{'))
+    {
+	j->error = true;
+	return;
+    }
+    if (bench_json_char(j, '}'))
+	return;
+    do
+    {
+	char *key = bench_json_string(j);
+	if (!key || !bench_json_char(j, ':'))
+	{
+	    free(key);
+	    j->error = true;
+	    return;
+	}
+	if (strcmp(key, "op") == 0)
+	    r->op = bench_json_string(j);
+	else if (strcmp(key, "type") == 0)
+	    r->type = bench_json_string(j);
+	else if (strcmp(key, "format") == 0)
+	    r->format = bench_json_string(j);
+	else if (strcmp(key, "width") == 0)
+	    r->width = bench_json_number(j);
+	else if (strcmp(key, "height") == 0)
+	    r->height = bench_json_number(j);
+	else if (strcmp(key, "times_ms") == 0)
+	{
+	    if (!bench_json_char(j, '['))
+		j->error = true;
+	    else if (!bench_json_char(j, ']'))
+	    {
+		do
+		{
+		    if (r->repetitions == times_size)
+		    {
+			times_size = (times_size == 0 ? 16 : 2 * times_size);
+			r->times = mh_realloc(r->times, mh_alloc_mul(times_size, sizeof(double)));
+		    }
+		    r->times[r->repetitions++] = bench_json_number(j) / 1e3;
+		}
+		while (!j->error && bench_json_char(j, ','));
+		if (!bench_json_char(j, ']'))
+		    j->error = true;
+	    }
+	}
+	else
+	    bench_json_skip(j);
+	free(key);
+    }
+    while (!j->error && bench_json_char(j, ','));
+    if (!bench_json_char(j, '}'))
+	j->error = true;
+}
+
+bench_baseline_t *bench_baseline_load(const char *filename)
+{
+    FILE *f;
+    if (!(f = fopen(filename, "r")))
+    {
+	mh_msg_err("cannot open %s: %s", filename, strerror(errno));
+	return NULL;
+    }
+    size_t len = 0, size = 0;
+    char *buf = NULL;
+    do
+    {
+	if (size - len < 4096)
+	{
+	    size += 65536;
+	    buf = mh_realloc(buf, size);
+	}
+	len += fread(buf + len, 1, size - len - 1, f);
+    }
+    while (!ferror(f) && !feof(f));
+    if (ferror(f))
+    {
+	mh_msg_err("cannot read %s: %s", filename, strerror(errno));
+	fclose(f);
+	free(buf);
+	return NULL;
+    }
+    fclose(f);
+    buf[len] = '\0';
+
+    bench_baseline_t *b = mh_alloc(sizeof(bench_baseline_t));
+    int results_size = 0;
+    b->n = 0;
+    b->results = NULL;
+    bench_json_t j = { buf, false };
+    if (!bench_json_char(&j, '{'))
+	j.error = true;
+    else if (!bench_json_char(&j, '}'))
+    {
+	do
+	{
+	    char *key = bench_json_string(&j);
+	    if (!key || !bench_json_char(&j, ':'))
+		j.error = true;
+	    else if (strcmp(key, "results") != 0)
+		bench_json_skip(&j);
+	    else if (!bench_json_char(&j, '['))
+		j.error = true;
+	    else if (!bench_json_char(&j, ']'))
+	    {
+		do
+		{
+		    if (b->n == results_size)
+		    {
+			results_size = (results_size == 0 ? 64 : 2 * results_size);
+			b->results = mh_realloc(b->results, mh_alloc_mul(results_size, sizeof(bench_result_t)));
+		    }
+		    bench_result_t *r = &(b->results[b->n++]);
+		    memset(r, 0, sizeof(bench_result_t));
+		    bench_json_result(&j, r);
+		    if (!j.error && (!r->op || !r->type || !r->format || r->repetitions == 0))
+			j.error = true;
+		}
+		while (!j.error && bench_json_char(&j, ','));
+		if (!bench_json_char(&j, ']'))
+		    j.error = true;
+	    }
+	    free(key);
+	}
+	while (!j.error && bench_json_char(&j, ','));
+	if (!bench_json_char(&j, '}'))
+	    j.error = true;
+    }
+    free(buf);
+    if (j.error)
+    {
+	mh_msg_err("%s is not a valid JSON report", filename);
+	bench_baseline_free(b);
+	return NULL;
+    }
+    return b;
+}
+
+void bench_baseline_free(bench_baseline_t *b)
+{
+    if (b)
+    {
+	for (int i = 0; i < b->n; i++)
+	{
+	    free((char *)b->results[i].op);
+	    free((char *)b->results[i].type);
+	    free((char *)b->results[i].format);
+	    free(b->results[i].times);
+	}
+	free(b->results);
+	free(b);
+    }
+}
+
+const bench_result_t *bench_baseline_find(const bench_baseline_t *b, const bench_result_t *r)
+{
+    for (int i = 0; i < b->n; i++)
+    {
+	const bench_result_t *x = &(b->results[i]);
+	if (strcmp(x->op, r->op) == 0 && x->width == r->width && x->height == r->height
+		&& strcmp(x->type, r->type) == 0 && strcmp(x->format, r->format) == 0)
+	    return x;
+    }
+    return NULL;
+}
+
+bool bench_compare(const bench_result_t *base, const bench_result_t *r, double threshold, double *change)
+{
+    double base_median = bench_median(base->times, base->repetitions);
+    double median = bench_median(r->times, r->repetitions);
+    *change = (base_median > 0.0 ? median / base_median - 1.0 : 0.0);
+    if (*change <= threshold)
+	return false;
+
+    /* Mann-Whitney U test with the normal approximation: is r significantly
+     * slower than base? With too few repetitions, the threshold decides. */
+    int na = base->repetitions;
+    int nb = r->repetitions;
+    if (na < 3 || nb < 3)
+	return true;
+    double rank_sum = 0.0;
+    for (int i = 0; i < nb; i++)
+    {
+	/* The rank of r->times[i] among all times, with ties averaged. */
+	int less = 0, equal = 0;
+	for (int k = 0; k < na; k++)
+	{
+	    less += (base->times[k] < r->times[i]);
+	    equal += (base->times[k] == r->times[i]);
+	}
+	for (int k = 0; k < nb; k++)
+	{
+	    less += (r->times[k] < r->times[i]);
+	    equal += (r->times[k] == r->times[i]);
+	}
+	rank_sum += less + (equal + 1) / 2.0;
+    }
+    double u = rank_sum - nb * (nb + 1) / 2.0;
+    double mean = na * nb / 2.0;
+    double sigma = sqrt(na * nb * (na + nb + 1) / 12.0);
+    double z = (u - mean) / sigma;
+    /* One-sided, 5% significance level */
+    return (z > 1.645);
+}
+
+void bench_report_begin(FILE *f, bench_report_t report)
+{
+    bench_report_count = 0;
+    if (report == BENCH_REPORT_CSV)
+	fprintf(f, "op,width,height,type,format,repetitions,median_ms,p95_ms,mpixels_per_s\n");
+    else
+	fprintf(f, "{\n  \"results\": [");
+}
+
+void bench_report_result(FILE *f, bench_report_t report, const bench_result_t *r)
+{
+    double median = bench_median(r->times, r->repetitions);
+    double p95 = bench_percentile(r->times, r->repetitions, 0.95);
+    double mpixels = (median > 0.0 ? (double)r->pixels / median / 1e6 : 0.0);
+    if (report == BENCH_REPORT_CSV)
+    {
+	fprintf(f, "%s,%d,%d,%s,%s,%d,%.4f,%.4f,%.2f\n",
+		r->op, r->width, r->height, r->type, r->format, r->repetitions,
+		median * 1e3, p95 * 1e3, mpixels);
+    }
+    else
+    {
+	fprintf(f, "%s\n    { \"op\": \"%s\", \"width\": %d, \"height\": %d, "
+		"\"type\": \"%s\", \"format\": \"%s\", \"repetitions\": %d, "
+		"\"median_ms\": %.4f, \"p95_ms\": %.4f, \"mpixels_per_s\": %.2f, \"times_ms\": [",
+		bench_report_count == 0 ? "" : ",",
+		r->op, r->width, r->height, r->type, r->format, r->repetitions,
+		median * 1e3, p95 * 1e3, mpixels);
+	for (int i = 0; i < r->repetitions; i++)
+	    fprintf(f, "%s%.4f", i == 0 ? "" : ", ", r->times[i] * 1e3);
+	fprintf(f, "] }");
+    }
+    fflush(f);
+    bench_report_count++;
+}
+
+void bench_report_end(FILE *f, bench_report_t report)
+{
+    if (report == BENCH_REPORT_JSON)
+	fprintf(f, "\n  ]\n}\n");
+    fflush(f);
+}
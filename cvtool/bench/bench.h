@@ -0,0 +1,107 @@
+/*
+ * bench.h
+ *
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <cvl/cvl.h>
+
+/* The result of one benchmark: the time of each repetition, in seconds, and
+ * the number of pixels that each repetition processed. */
+typedef struct
+{
+    const char *op;
+    int width;
+    int height;
+    const char *type;
+    const char *format;
+    int repetitions;
+    double *times;
+    long long pixels;
+} bench_result_t;
+
+/* Report formats. */
+typedef enum
+{
+    BENCH_REPORT_CSV = 0,
+    BENCH_REPORT_JSON = 1
+} bench_report_t;
+
+/* The names of the report formats, for mh_getopt(), and of frame types and
+ * formats, for reports and for parsing lists of them. */
+extern const char *bench_report_names[];
+extern const char *bench_type_names[];
+extern const char *bench_format_names[];
+
+/* Create an OpenGL context on the display given by the environment and
+ * initialize CVL in it. Returns NULL on error. */
+cvl_gl_context_t *bench_init(void);
+
+/* Deinitialize CVL and free the context. */
+void bench_deinit(cvl_gl_context_t *ctx);
+
+/* Parse a comma separated list of names into flags: flags[i] is set if
+ * names[i] appears in the list. Returns false if the list contains an unknown
+ * name. */
+bool bench_parse_names(const char *list, const char **names, bool *flags);
+
+/* Return whether the comma separated list contains the given word. */
+bool bench_list_contains(const char *list, const char *word);
+
+/* Create a frame with reproducible synthetic content in [0,1]. The frame is
+ * uploaded to a texture. */
+cvl_frame_t *bench_frame_new(int width, int height, int channels, cvl_format_t format, cvl_type_t type);
+
+/* Return the median and a percentile p in [0,1] of the given times. */
+double bench_median(const double *times, int n);
+double bench_percentile(const double *times, int n, double p);
+
+/* A set of results read from a JSON report. */
+typedef struct
+{
+    int n;
+    bench_result_t *results;
+} bench_baseline_t;
+
+/* Read a JSON report written by bench_report_result(). Returns NULL on error. */
+bench_baseline_t *bench_baseline_load(const char *filename);
+void bench_baseline_free(bench_baseline_t *baseline);
+
+/* Find the baseline result with the same op, size, type, and format as r, or
+ * return NULL. */
+const bench_result_t *bench_baseline_find(const bench_baseline_t *baseline, const bench_result_t *r);
+
+/* Compare a result to its baseline. The relative change of the median time is
+ * stored in change (0.1 means 10% slower). Returns true if the result is
+ * slower by more than the threshold (0.05 means 5%) and the slowdown is
+ * significant according to a one-sided Mann-Whitney U test over the
+ * repetitions. */
+bool bench_compare(const bench_result_t *baseline, const bench_result_t *r, double threshold, double *change);
+
+/* Write a report header, the results, and the report footer. */
+void bench_report_begin(FILE *f, bench_report_t report);
+void bench_report_result(FILE *f, bench_report_t report, const bench_result_t *result);
+void bench_report_end(FILE *f, bench_report_t report);
+
+#endif
@@ -0,0 +1,947 @@
+/*
+ * cvl-bench.c
+ *
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <cvl/cvl.h>
+
+#include "mh.h"
+#include "bench.h"
+
+
+/* The frames that the operations work on. They are created once for each
+ * combination of size, type, and format. */
+typedef struct
+{
+    cvl_frame_t *src;		/* Synthetic input */
+    cvl_frame_t *src2;		/* Second synthetic input */
+    cvl_frame_t *dst;		/* Same properties as src */
+    cvl_frame_t *fdst;		/* Like src, but float */
+    cvl_frame_t *ftmp;		/* Like src, but float */
+    cvl_frame_t *tmp4;		/* Four float channels */
+    cvl_frame_t *edge;		/* Two float channels */
+    cvl_frame_t *alpha;		/* One float channel */
+    cvl_frame_t *xyz;		/* src in XYZ, only for LUM and RGB */
+    cvl_frame_t *xyz_dst;	/* Same properties as xyz */
+    cvl_frame_t *hsl;		/* src in HSL, only for LUM and RGB */
+    cvl_frame_t *hsl_dst;	/* Same properties as hsl */
+    cvl_frame_t *rgb_tmp;	/* Three float channels, RGB */
+    cvl_frame_t *out[8];	/* Frames created by an operation; freed after each repetition */
+    FILE *file;			/* Temporary file for I/O */
+} data_t;
+
+/* Operation flags */
+#define OP_IMAGE	1	/* Needs a LUM or RGB frame */
+#define OP_XYZ		2	/* Works on the XYZ frames; implies OP_IMAGE */
+#define OP_HSL		4	/* Works on the HSL frames; implies OP_IMAGE */
+
+typedef struct
+{
+    const char *name;
+    const char *category;
+    int flags;
+    void (*prepare)(data_t *d);	/* Untimed preparation for each repetition, or NULL */
+    void (*run)(data_t *d);
+} op_t;
+
+
+/* Filters */
+
+static void op_convolve(data_t *d)
+{
+    const float k[9] = { 1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,
+	2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
+	1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f };
+    cvl_convolve(d->dst, d->src, k, 3, 3);
+}
+
+static void op_convolve_15x15_rank1(data_t *d)
+{
+    static float k[15 * 15];
+    for (int r = 0; r < 15; r++)
+	for (int c = 0; c < 15; c++)
+	    k[r * 15 + c] = (float)((8 - abs(r - 7)) * (8 - abs(c - 7)));
+    cvl_convolve(d->dst, d->src, k, 15, 15);
+}
+
+static void op_convolve_31x31(data_t *d)
+{
+    static float k[31 * 31];
+    for (int i = 0; i < 31 * 31; i++)
+	k[i] = 1.0f / (31.0f * 31.0f);
+    cvl_convolve(d->dst, d->src, k, 31, 31);
+}
+
+static void op_gauss_k2(data_t *d)
+{
+    cvl_gauss(d->dst, d->src, 2, 2, cvl_gauss_k_to_sigma(2), cvl_gauss_k_to_sigma(2));
+}
+
+static void op_gauss_k8(data_t *d)
+{
+    cvl_gauss(d->dst, d->src, 8, 8, cvl_gauss_k_to_sigma(8), cvl_gauss_k_to_sigma(8));
+}
+
+static void op_gauss_k64(data_t *d)
+{
+    cvl_gauss(d->dst, d->src, 64, 64, cvl_gauss_k_to_sigma(64), cvl_gauss_k_to_sigma(64));
+}
+
+static void op_gauss3d_k2(data_t *d)
+{
+    cvl_frame_t *srcs[5] = { d->src, d->src2, d->src, d->src2, d->src };
+    cvl_gauss3d(d->dst, srcs, 2, 2, 2,
+	    cvl_gauss_k_to_sigma(2), cvl_gauss_k_to_sigma(2), cvl_gauss_k_to_sigma(2));
+}
+
+static void op_mean_k2(data_t *d)
+{
+    cvl_mean(d->dst, d->src, 2, 2);
+}
+
+static void op_mean_k8(data_t *d)
+{
+    cvl_mean(d->dst, d->src, 8, 8);
+}
+
+static void op_mean_k32(data_t *d)
+{
+    cvl_mean(d->dst, d->src, 32, 32);
+}
+
+static void op_integral_image(data_t *d)
+{
+    cvl_integral_image(d->fdst, d->src);
+}
+
+static void op_integral_image_cpu(data_t *d)
+{
+    cvl_integral_image_using(d->fdst, d->src, CVL_INTEGRAL_CPU);
+}
+
+static void op_mean3d_k2(data_t *d)
+{
+    cvl_frame_t *srcs[5] = { d->src, d->src2, d->src, d->src2, d->src };
+    cvl_mean3d(d->dst, srcs, 2, 2, 2);
+}
+
+static void op_min_k2(data_t *d)
+{
+    cvl_min(d->dst, d->src, 2, 2);
+}
+
+static void op_max_k2(data_t *d)
+{
+    cvl_max(d->dst, d->src, 2, 2);
+}
+
+static void op_min_k64(data_t *d)
+{
+    cvl_min(d->dst, d->src, 64, 64);
+}
+
+static void op_opening_k64(data_t *d)
+{
+    cvl_opening(d->dst, d->src, 64, 64);
+}
+
+static void op_bilateral_s16(data_t *d)
+{
+    cvl_bilateral(d->dst, d->src, 16.0f, 0.1f);
+}
+
+static void op_median_k1(data_t *d)
+{
+    cvl_median(d->dst, d->src, 1, 1);
+}
+
+static void op_median_k2(data_t *d)
+{
+    cvl_median(d->dst, d->src, 2, 2);
+}
+
+static void op_median_k8(data_t *d)
+{
+    cvl_median(d->dst, d->src, 8, 8);
+}
+
+static void op_median_separated_k2(data_t *d)
+{
+    cvl_median_separated(d->dst, d->src, 2, 2);
+}
+
+static void op_median3d_k1(data_t *d)
+{
+    cvl_frame_t *srcs[3] = { d->src, d->src2, d->src };
+    cvl_median3d(d->dst, srcs, 1, 1, 1);
+}
+
+static void op_laplace(data_t *d)
+{
+    cvl_laplace(d->dst, d->src, 0.5f);
+}
+
+static void op_unsharpmask(data_t *d)
+{
+    cvl_unsharpmask(d->dst, d->src, d->src2, 0.7f);
+}
+
+static void op_edge_sobel(data_t *d)
+{
+    cvl_edge_sobel(d->edge, d->src, 0);
+}
+
+static void op_edge_canny(data_t *d)
+{
+    cvl_edge_canny(d->edge, d->src, 0, 1.0f, 0.1f, 0.3f);
+}
+
+/* Miscellaneous */
+
+static void op_reduce_min(data_t *d)
+{
+    float r[4];
+    cvl_reduce(d->src, CVL_REDUCE_MIN, -1, r);
+}
+
+static void op_reduce_max(data_t *d)
+{
+    float r[4];
+    cvl_reduce(d->src, CVL_REDUCE_MAX, -1, r);
+}
+
+static void op_reduce_sum(data_t *d)
+{
+    float r[4];
+    cvl_reduce(d->src, CVL_REDUCE_SUM, -1, r);
+}
+
+static void op_sort(data_t *d)
+{
+    cvl_sort(d->dst, d->src, 0);
+}
+
+static void op_sort_bitonic(data_t *d)
+{
+    cvl_sort_using(d->dst, d->src, 0, CVL_SORT_BITONIC);
+}
+
+static void op_sort_radix(data_t *d)
+{
+    cvl_sort_using(d->dst, d->src, 0, CVL_SORT_RADIX);
+}
+
+static void op_quantil(data_t *d)
+{
+    float r[4];
+    cvl_quantil(d->src, 0, 0.5f, r);
+}
+
+static void op_quantiles(data_t *d)
+{
+    const float q[5] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
+    float r[4 * 5];
+    cvl_quantiles(d->src, -1, q, 5, r);
+}
+
+static void op_statistics(data_t *d)
+{
+    float min[4], max[4], median[4], mean[4], stddev[4];
+    cvl_statistics(d->src, min, max, median, mean, stddev, NULL);
+}
+
+static void op_histogram(data_t *d)
+{
+    const float min = 0.0f, max = 1.0f;
+    int histogram[256];
+    cvl_histogram(d->src, 0, 256, &min, &max, histogram);
+}
+
+static void op_diff(data_t *d)
+{
+    cvl_diff(d->dst, d->src, d->src2);
+}
+
+static void op_pyramid_gaussian(data_t *d)
+{
+    cvl_pyramid_gaussian(d->src, 4, d->out);
+}
+
+/* Color */
+
+static void op_convert_format(data_t *d)
+{
+    cvl_convert_format(d->xyz_dst, d->src);
+}
+
+static void op_invert(data_t *d)
+{
+    cvl_invert(d->dst, d->src);
+}
+
+static void op_gamma_correct(data_t *d)
+{
+    cvl_gamma_correct(d->dst, d->src, 2.2f);
+}
+
+static void op_color_adjust(data_t *d)
+{
+    cvl_color_adjust(d->hsl_dst, d->hsl, 0.1f, 0.1f, 0.1f, 0.1f);
+}
+
+static void op_transform_linear(data_t *d)
+{
+    cvl_transform_linear(d->dst, d->src, -1, 0.1f, 0.9f);
+}
+
+static void op_threshold(data_t *d)
+{
+    cvl_threshold(d->dst, d->src, 0, 0.5f);
+}
+
+static void op_luminance_range(data_t *d)
+{
+    cvl_luminance_range(d->xyz_dst, d->xyz, 0.0f, 150.0f);
+}
+
+/* Tone mapping */
+
+static void op_log_avg_lum(data_t *d)
+{
+    cvl_log_avg_lum(d->xyz, d->tmp4, 150.0f);
+}
+
+static void op_lum_statistics(data_t *d)
+{
+    float min_lum, max_lum, avg_lum, log_avg_lum, channel_avg[3];
+    cvl_lum_statistics(d->xyz, 150.0f, &min_lum, &max_lum, &avg_lum, &log_avg_lum, channel_avg);
+}
+
+static void op_tonemap_schlick94(data_t *d)
+{
+    cvl_tonemap_schlick94(d->xyz_dst, d->xyz, 100.0f);
+}
+
+static void op_tonemap_tumblin99(data_t *d)
+{
+    float log_avg_lum = cvl_log_avg_lum(d->xyz, d->tmp4, 150.0f);
+    cvl_tonemap_tumblin99(d->xyz_dst, d->xyz, 150.0f, log_avg_lum, 100.0f, 70.0f);
+}
+
+static void op_tonemap_drago03(data_t *d)
+{
+    cvl_tonemap_drago03(d->xyz_dst, d->xyz, 150.0f, 0.85f, 200.0f);
+}
+
+static void prepare_tonemap_lut_drago03(data_t *d)
+{
+    d->out[0] = cvl_frame_new(4096, 1, 1, CVL_LUM, CVL_FLOAT, CVL_MEM);
+    cvl_tonemap_lut_drago03(d->out[0], 150.0f, 0.85f, 200.0f);
+    cvl_frame_texture(d->out[0]);
+}
+
+static void op_tonemap_lut_drago03(data_t *d)
+{
+    cvl_tonemap_lut(d->xyz_dst, d->xyz, d->out[0]);
+}
+
+static void op_tonemap_reinhard05(data_t *d)
+{
+    float min_lum, avg_lum, log_avg_lum;
+    float channel_avg[3];
+    cvl_lum_statistics(d->xyz, 1.0f, &min_lum, NULL, &avg_lum, &log_avg_lum, channel_avg);
+    cvl_convert_format(d->rgb_tmp, d->xyz);
+    cvl_tonemap_reinhard05(d->xyz_dst, d->xyz, min_lum, avg_lum, log_avg_lum,
+	    d->rgb_tmp, channel_avg, 0.0f, 0.5f, 0.5f);
+}
+
+static void op_tonemap_ashikhmin02(data_t *d)
+{
+    cvl_tonemap_ashikhmin02(d->xyz_dst, d->xyz, 0.01f, 150.0f, d->tmp4, 0.5f);
+}
+
+static void op_tonemap_durand02(data_t *d)
+{
+    cvl_tonemap_durand02(d->xyz_dst, d->xyz, 150.0f, d->tmp4, 4, 0.3f, 0.4f, 3.0f);
+}
+
+static void op_tonemap_durand02_s16(data_t *d)
+{
+    cvl_tonemap_durand02(d->xyz_dst, d->xyz, 150.0f, d->tmp4, cvl_gauss_sigma_to_k(16.0f), 16.0f, 0.4f, 3.0f);
+}
+
+static void op_tonemap_reinhard02(data_t *d)
+{
+    float log_avg_lum = cvl_log_avg_lum(d->xyz, d->tmp4, 1.0f);
+    cvl_tonemap_reinhard02(d->xyz_dst, d->xyz, d->tmp4, log_avg_lum, 0.1f, 1.0f, 10.0f, 0.5f);
+}
+
+/* Wavelets */
+
+static void op_wavelets_dwt(data_t *d)
+{
+    cvl_wavelets_dwt(d->fdst, d->src, d->ftmp, 4, 1);
+}
+
+static void op_wavelets_dwt_cpu(data_t *d)
+{
+    cvl_wavelets_dwt_using(d->fdst, d->src, d->ftmp, 4, 1, CVL_WAVELETS_CPU);
+}
+
+static void op_wavelets_idwt(data_t *d)
+{
+    cvl_wavelets_idwt(d->fdst, d->src, d->ftmp, 4, 1);
+}
+
+static void op_wavelets_idwt_cpu(data_t *d)
+{
+    cvl_wavelets_idwt_using(d->fdst, d->src, d->ftmp, 4, 1, CVL_WAVELETS_CPU);
+}
+
+static void op_wavelets_hard_thresholding(data_t *d)
+{
+    const float T[4] = { 0.1f, 0.1f, 0.1f, 0.1f };
+    cvl_wavelets_hard_thresholding(d->fdst, d->src, 1, T);
+}
+
+static void op_wavelets_soft_thresholding(data_t *d)
+{
+    const float T[4] = { 0.1f, 0.1f, 0.1f, 0.1f };
+    cvl_wavelets_soft_thresholding(d->fdst, d->src, 1, T);
+}
+
+/* Fourier transform */
+
+static void op_fft(data_t *d)
+{
+    cvl_fft(d->fdst, d->ftmp, d->src);
+}
+
+static void op_fft_cpu(data_t *d)
+{
+    cvl_fft_using(d->fdst, d->ftmp, d->src, CVL_FFT_CPU);
+}
+
+/* Transformations */
+
+static void op_flip(data_t *d)
+{
+    cvl_flip(d->dst, d->src);
+}
+
+static void op_flop(data_t *d)
+{
+    cvl_flop(d->dst, d->src);
+}
+
+static void op_scale_half(data_t *d)
+{
+    d->out[0] = cvl_scale(d->src, cvl_frame_width(d->src) / 2, cvl_frame_height(d->src) / 2, CVL_BILINEAR);
+}
+
+static void op_scale_double(data_t *d)
+{
+    d->out[0] = cvl_scale(d->src, cvl_frame_width(d->src) * 2, cvl_frame_height(d->src) * 2, CVL_BILINEAR);
+}
+
+static void op_rotate(data_t *d)
+{
+    const float fillval[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    d->out[0] = cvl_rotate(d->src, mh_deg_to_rad(30.0f), CVL_BICUBIC, fillval);
+}
+
+static void op_shear(data_t *d)
+{
+    const float fillval[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    d->out[0] = cvl_shear(d->src, mh_deg_to_rad(10.0f), mh_deg_to_rad(10.0f), CVL_BILINEAR, fillval);
+}
+
+/* Mixing */
+
+static void op_mix(data_t *d)
+{
+    cvl_frame_t *srcs[2] = { d->src, d->src2 };
+    const float w[2] = { 0.3f, 0.7f };
+    cvl_mix(d->dst, srcs, w, 2);
+}
+
+static void op_layer_max(data_t *d)
+{
+    cvl_frame_t *layers[2] = { d->src, d->src2 };
+    cvl_layer(d->dst, layers, 2, CVL_LAYER_MAX);
+}
+
+static void op_blend(data_t *d)
+{
+    cvl_blend(d->dst, 0, 0, d->src2, d->alpha);
+}
+
+/* Input/Output and transfers */
+
+static void op_write_pnm(data_t *d)
+{
+    rewind(d->file);
+    cvl_write_pnm(d->file, d->src);
+    fflush(d->file);
+}
+
+static void prepare_read_pnm(data_t *d)
+{
+    op_write_pnm(d);
+    rewind(d->file);
+}
+
+static void op_read_pnm(data_t *d)
+{
+    cvl_read_pnm(d->file, &(d->out[0]));
+}
+
+static void op_write_pfs(data_t *d)
+{
+    rewind(d->file);
+    cvl_write_pfs(d->file, d->src);
+    fflush(d->file);
+}
+
+static void prepare_read_pfs(data_t *d)
+{
+    op_write_pfs(d);
+    rewind(d->file);
+}
+
+static void op_read_pfs(data_t *d)
+{
+    cvl_read_pfs(d->file, &(d->out[0]));
+}
+
+static void prepare_upload(data_t *d)
+{
+    cvl_frame_t *src = d->src;
+    int memchannels = (cvl_frame_format(src) == CVL_LUM ? 1 : cvl_frame_format(src) == CVL_UNKNOWN ? 4 : 3);
+    int typesize = (cvl_frame_type(src) == CVL_UINT8 ? sizeof(uint8_t) : sizeof(float));
+    d->out[0] = cvl_frame_new(cvl_frame_width(src), cvl_frame_height(src),
+	    cvl_frame_channels(src), cvl_frame_format(src), cvl_frame_type(src), CVL_MEM);
+    memcpy(cvl_frame_pointer(d->out[0]), cvl_frame_pointer(src),
+	    (size_t)cvl_frame_size(src) * memchannels * typesize);
+}
+
+static void op_upload(data_t *d)
+{
+    cvl_frame_texture(d->out[0]);
+}
+
+static void prepare_download(data_t *d)
+{
+    d->out[0] = cvl_frame_new_tpl(d->src);
+    cvl_copy(d->out[0], d->src);
+}
+
+static void op_download(data_t *d)
+{
+    cvl_frame_pointer(d->out[0]);
+}
+
+
+static const op_t ops[] =
+{
+    { "convolve_3x3",			"filter",	0,	NULL,	op_convolve },
+    { "convolve_15x15_rank1",		"filter",	0,	NULL,	op_convolve_15x15_rank1 },
+    { "convolve_31x31",			"filter",	0,	NULL,	op_convolve_31x31 },
+    { "gauss_k2",			"filter",	0,	NULL,	op_gauss_k2 },
+    { "gauss_k8",			"filter",	0,	NULL,	op_gauss_k8 },
+    { "gauss_k64",			"filter",	0,	NULL,	op_gauss_k64 },
+    { "gauss3d_k2",			"filter",	0,	NULL,	op_gauss3d_k2 },
+    { "mean_k2",			"filter",	0,	NULL,	op_mean_k2 },
+    { "mean_k8",			"filter",	0,	NULL,	op_mean_k8 },
+    { "mean_k32",			"filter",	0,	NULL,	op_mean_k32 },
+    { "integral_image",		"filter",	0,	NULL,	op_integral_image },
+    { "integral_image_cpu",		"filter",	0,	NULL,	op_integral_image_cpu },
+    { "mean3d_k2",			"filter",	0,	NULL,	op_mean3d_k2 },
+    { "min_k2",				"filter",	0,	NULL,	op_min_k2 },
+    { "max_k2",				"filter",	0,	NULL,	op_max_k2 },
+    { "min_k64",			"filter",	0,	NULL,	op_min_k64 },
+    { "opening_k64",			"filter",	0,	NULL,	op_opening_k64 },
+    { "bilateral_s16",			"filter",	0,	NULL,	op_bilateral_s16 },
+    { "median_k1",			"filter",	0,	NULL,	op_median_k1 },
+    { "median_k2",			"filter",	0,	NULL,	op_median_k2 },
+    { "median_k8",			"filter",	0,	NULL,	op_median_k8 },
+    { "median_separated_k2",		"filter",	0,	NULL,	op_median_separated_k2 },
+    { "median3d_k1",			"filter",	0,	NULL,	op_median3d_k1 },
+    { "laplace",			"filter",	0,	NULL,	op_laplace },
+    { "unsharpmask",			"filter",	0,	NULL,	op_unsharpmask },
+    { "edge_sobel",			"filter",	0,	NULL,	op_edge_sobel },
+    { "edge_canny",			"filter",	0,	NULL,	op_edge_canny },
+    { "reduce_min",			"reduce",	0,	NULL,	op_reduce_min },
+    { "reduce_max",			"reduce",	0,	NULL,	op_reduce_max },
+    { "reduce_sum",			"reduce",	0,	NULL,	op_reduce_sum },
+    { "sort",				"sort",		0,	NULL,	op_sort },
+    { "sort_bitonic",			"sort",		0,	NULL,	op_sort_bitonic },
+    { "sort_radix",			"sort",		0,	NULL,	op_sort_radix },
+    { "quantil",			"sort",		0,	NULL,	op_quantil },
+    { "quantiles",			"sort",		0,	NULL,	op_quantiles },
+    { "statistics",			"sort",		0,	NULL,	op_statistics },
+    { "histogram",			"misc",		0,	NULL,	op_histogram },
+    { "diff",				"misc",		0,	NULL,	op_diff },
+    { "pyramid_gaussian",		"misc",		0,	NULL,	op_pyramid_gaussian },
+    { "convert_format",			"color",	OP_IMAGE, NULL,	op_convert_format },
+    { "invert",				"color",	OP_IMAGE, NULL,	op_invert },
+    { "gamma_correct",			"color",	OP_IMAGE, NULL,	op_gamma_correct },
+    { "color_adjust",			"color",	OP_HSL,	NULL,	op_color_adjust },
+    { "transform_linear",		"color",	0,	NULL,	op_transform_linear },
+    { "threshold",			"color",	0,	NULL,	op_threshold },
+    { "luminance_range",		"tonemap",	OP_XYZ,	NULL,	op_luminance_range },
+    { "log_avg_lum",			"tonemap",	OP_XYZ,	NULL,	op_log_avg_lum },
+    { "lum_statistics",			"tonemap",	OP_XYZ,	NULL,	op_lum_statistics },
+    { "tonemap_schlick94",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_schlick94 },
+    { "tonemap_tumblin99",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_tumblin99 },
+    { "tonemap_drago03",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_drago03 },
+    { "tonemap_lut_drago03",		"tonemap",	OP_XYZ,	prepare_tonemap_lut_drago03, op_tonemap_lut_drago03 },
+    { "tonemap_reinhard05",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_reinhard05 },
+    { "tonemap_ashikhmin02",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_ashikhmin02 },
+    { "tonemap_durand02",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_durand02 },
+    { "tonemap_durand02_s16",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_durand02_s16 },
+    { "tonemap_reinhard02",		"tonemap",	OP_XYZ,	NULL,	op_tonemap_reinhard02 },
+    { "wavelets_dwt",			"wavelets",	0,	NULL,	op_wavelets_dwt },
+    { "wavelets_dwt_cpu",		"wavelets",	0,	NULL,	op_wavelets_dwt_cpu },
+    { "wavelets_idwt",			"wavelets",	0,	NULL,	op_wavelets_idwt },
+    { "wavelets_idwt_cpu",		"wavelets",	0,	NULL,	op_wavelets_idwt_cpu },
+    { "wavelets_hard_thresholding",	"wavelets",	0,	NULL,	op_wavelets_hard_thresholding },
+    { "wavelets_soft_thresholding",	"wavelets",	0,	NULL,	op_wavelets_soft_thresholding },
+    { "fft",				"fft",		0,	NULL,	op_fft },
+    { "fft_cpu",			"fft",		0,	NULL,	op_fft_cpu },
+    { "flip",				"transform",	0,	NULL,	op_flip },
+    { "flop",				"transform",	0,	NULL,	op_flop },
+    { "scale_half",			"transform",	0,	NULL,	op_scale_half },
+    { "scale_double",			"transform",	0,	NULL,	op_scale_double },
+    { "rotate",				"transform",	0,	NULL,	op_rotate },
+    { "shear",				"transform",	0,	NULL,	op_shear },
+    { "mix",				"mix",		0,	NULL,	op_mix },
+    { "layer_max",			"mix",		0,	NULL,	op_layer_max },
+    { "blend",				"mix",		0,	NULL,	op_blend },
+    { "write_pnm",			"io",		0,	NULL,	op_write_pnm },
+    { "read_pnm",			"io",		0,	prepare_read_pnm, op_read_pnm },
+    { "write_pfs",			"io",		0,	NULL,	op_write_pfs },
+    { "read_pfs",			"io",		0,	prepare_read_pfs, op_read_pfs },
+    { "upload",				"io",		0,	prepare_upload,	op_upload },
+    { "download",			"io",		0,	prepare_download, op_download },
+    { NULL, NULL, 0, NULL, NULL }
+};
+
+
+static void free_out(data_t *d)
+{
+    for (int i = 0; i < 8; i++)
+    {
+	cvl_frame_free(d->out[i]);
+	d->out[i] = NULL;
+    }
+}
+
+static void data_free(data_t *d)
+{
+    free_out(d);
+    cvl_frame_free(d->src);
+    cvl_frame_free(d->src2);
+    cvl_frame_free(d->dst);
+    cvl_frame_free(d->fdst);
+    cvl_frame_free(d->ftmp);
+    cvl_frame_free(d->tmp4);
+    cvl_frame_free(d->edge);
+    cvl_frame_free(d->alpha);
+    cvl_frame_free(d->xyz);
+    cvl_frame_free(d->xyz_dst);
+    cvl_frame_free(d->hsl);
+    cvl_frame_free(d->hsl_dst);
+    cvl_frame_free(d->rgb_tmp);
+    if (d->file)
+	fclose(d->file);
+    memset(d, 0, sizeof(data_t));
+}
+
+static bool data_init(data_t *d, int size, cvl_type_t type, cvl_format_t format)
+{
+    int channels = (format == CVL_LUM ? 1 : format == CVL_UNKNOWN ? 4 : 3);
+    memset(d, 0, sizeof(data_t));
+    d->src = bench_frame_new(size, size, channels, format, type);
+    d->src2 = bench_frame_new(size, size, channels, format, type);
+    d->dst = cvl_frame_new(size, size, channels, format, type, CVL_TEXTURE);
+    d->fdst = cvl_frame_new(size, size, channels, format, CVL_FLOAT, CVL_TEXTURE);
+    d->ftmp = cvl_frame_new(size, size, channels, format, CVL_FLOAT, CVL_TEXTURE);
+    d->tmp4 = cvl_frame_new(size, size, 4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
+    d->edge = cvl_frame_new(size, size, 2, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
+    d->alpha = bench_frame_new(size, size, 1, CVL_LUM, CVL_FLOAT);
+    if (format == CVL_LUM || format == CVL_RGB)
+    {
+	d->xyz = cvl_frame_new(size, size, 3, CVL_XYZ, type, CVL_TEXTURE);
+	cvl_convert_format(d->xyz, d->src);
+	d->xyz_dst = cvl_frame_new_tpl(d->xyz);
+	d->hsl = cvl_frame_new(size, size, 3, CVL_HSL, type, CVL_TEXTURE);
+	cvl_convert_format(d->hsl, d->src);
+	d->hsl_dst = cvl_frame_new_tpl(d->hsl);
+	d->rgb_tmp = cvl_frame_new(size, size, 3, CVL_RGB, CVL_FLOAT, CVL_TEXTURE);
+    }
+    if (!(d->file = tmpfile()))
+    {
+	mh_msg_err("Cannot create temporary file: %s", strerror(errno));
+	return false;
+    }
+    glFinish();
+    return !cvl_error();
+}
+
+/* Run one operation and return its result, or false on error. */
+static bool run_op(const op_t *op, data_t *d, int warmup, int repetitions, bench_result_t *result)
+{
+    mh_timer_t start, stop;
+
+    for (int i = 0; i < warmup + repetitions && !cvl_error(); i++)
+    {
+	if (op->prepare)
+	    op->prepare(d);
+	glFinish();
+	mh_timer_set(MH_TIMER_REAL, &start);
+	op->run(d);
+	glFinish();
+	mh_timer_set(MH_TIMER_REAL, &stop);
+	free_out(d);
+	if (i >= warmup)
+	    result->times[i - warmup] = mh_timer_get(&start, &stop);
+    }
+    return !cvl_error();
+}
+
+static void print_help(void)
+{
+    mh_msg_fmt_req(
+	    "Usage: cvl-bench [-s|--sizes=<s1,s2,...>] [-t|--types=<t1,t2,...>] [-f|--formats=<f1,f2,...>] "
+	    "[-o|--ops=<o1,o2,...>] [-w|--warmup=<n>] [-r|--repetitions=<n>] [-R|--report=csv|json] "
+	    "[-c|--compare=<baseline.json>] [-T|--threshold=<p>%%] [-l|--list]\n"
+	    "\n"
+	    "Benchmark CVL operations on synthetic square frames, and print the median and 95th percentile "
+	    "time and the throughput of each operation for each combination of size, type, and format.\n"
+	    "Sizes default to 256,512,1024,2048,4096,8192; sizes beyond the maximum texture size are skipped. "
+	    "Types can be uint8, float16, float (all by default). Formats can be lum, rgb, unknown (all by default), "
+	    "as well as xyz and hsl. The operations can be selected by name or by category; see --list. "
+	    "The default is 2 warm-up runs and 10 repetitions. The report is CSV by default.\n"
+	    "With --compare, each result is compared to the result with the same operation, size, type, and format "
+	    "in a JSON report from an earlier run. A result is a regression if its median time is larger than the "
+	    "baseline median by more than the threshold (default 5%%), and if a Mann-Whitney U test over the "
+	    "repetitions shows that the slowdown is significant. The exit status is 2 if there were regressions.");
+}
+
+static void print_list(void)
+{
+    for (int i = 0; ops[i].name; i++)
+	mh_msg_req("%-28s %s", ops[i].name, ops[i].category);
+}
+
+int main(int argc, char *argv[])
+{
+    mh_option_int_array_t sizes = { NULL, 0, NULL, 1, NULL };
+    mh_option_string_t types = { NULL, NULL };
+    mh_option_string_t formats = { NULL, NULL };
+    mh_option_string_t opnames = { NULL, NULL };
+    mh_option_int_t warmup = { 2, 0, 1000 };
+    mh_option_int_t repetitions = { 10, 1, 100000 };
+    mh_option_name_t report = { BENCH_REPORT_CSV, bench_report_names };
+    mh_option_info_t help = { false, print_help };
+    mh_option_info_t list = { false, print_list };
+    mh_option_string_t compare = { NULL, NULL };
+    mh_option_string_t threshold = { NULL, NULL };
+    mh_option_t options[] =
+    {
+	{ "sizes",       's', MH_OPTION_INT_ARRAY, &sizes,       false },
+	{ "types",       't', MH_OPTION_STRING,    &types,       false },
+	{ "formats",     'f', MH_OPTION_STRING,    &formats,     false },
+	{ "ops",         'o', MH_OPTION_STRING,    &opnames,     false },
+	{ "warmup",      'w', MH_OPTION_INT,       &warmup,      false },
+	{ "repetitions", 'r', MH_OPTION_INT,       &repetitions, false },
+	{ "report",      'R', MH_OPTION_NAME,      &report,      false },
+	{ "help",       '\0', MH_OPTION_INFO,      &help,        false },
+	{ "compare",     'c', MH_OPTION_STRING,    &compare,     false },
+	{ "threshold",   'T', MH_OPTION_STRING,    &threshold,   false },
+	{ "list",        'l', MH_OPTION_INFO,      &list,        false },
+	mh_option_null
+    };
+    const int default_sizes[] = { 256, 512, 1024, 2048, 4096, 8192 };
+    bool type_flags[3] = { true, true, true };
+    bool format_flags[5] = { true, false, true, false, true };
+
+    mh_msg_set_program_name("cvl-bench");
+    mh_msg_set_output_level(MH_MSG_INF);
+    mh_msg_fmt_set_columns_from_env();
+    if (!mh_getopt(argc, argv, options, 0, 0, NULL))
+	return 1;
+    if (help.value || list.value)
+	return 0;
+    if (types.value && !bench_parse_names(types.value, bench_type_names, type_flags))
+    {
+	mh_msg_err("invalid list of types: %s", types.value);
+	return 1;
+    }
+    if (formats.value && !bench_parse_names(formats.value, bench_format_names, format_flags))
+    {
+	mh_msg_err("invalid list of formats: %s", formats.value);
+	return 1;
+    }
+    int nsizes = (sizes.value ? sizes.value_sizes[0] : 6);
+    const int *size_list = (sizes.value ? sizes.value : default_sizes);
+    for (int i = 0; i < nsizes; i++)
+    {
+	if (size_list[i] < 2 || size_list[i] % 2 != 0)
+	{
+	    mh_msg_err("invalid size %d: sizes must be even and at least 2", size_list[i]);
+	    return 1;
+	}
+    }
+    double threshold_value = 0.05;
+    if (threshold.value)
+    {
+	char *end;
+	threshold_value = strtod(threshold.value, &end) / 100.0;
+	if (end == threshold.value || (*end != '\0' && strcmp(end, "%") != 0) || !(threshold_value >= 0.0))
+	{
+	    mh_msg_err("invalid threshold: %s", threshold.value);
+	    return 1;
+	}
+    }
+    bench_baseline_t *baseline = NULL;
+    if (compare.value && !(baseline = bench_baseline_load(compare.value)))
+	return 1;
+    if (opnames.value)
+    {
+	int n = 0;
+	for (int i = 0; ops[i].name; i++)
+	    if (bench_list_contains(opnames.value, ops[i].name) || bench_list_contains(opnames.value, ops[i].category))
+		n++;
+	if (n == 0)
+	{
+	    mh_msg_err("no operations match %s", opnames.value);
+	    return 1;
+	}
+    }
+
+    cvl_gl_context_t *ctx = bench_init();
+    if (!ctx)
+	return 1;
+    GLint max_tex_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_tex_size);
+
+    bool error = false;
+    int compared = 0;
+    int regressions = 0;
+    bench_result_t result;
+    result.repetitions = repetitions.value;
+    result.times = mh_alloc(mh_alloc_mul(repetitions.value, sizeof(double)));
+    bench_report_begin(stdout, report.value);
+    for (int s = 0; s < nsizes; s++)
+    {
+	int size = size_list[s];
+	if (size > max_tex_size)
+	{
+	    mh_msg_wrn("skipping size %d: exceeds the maximum texture size %d", size, max_tex_size);
+	    continue;
+	}
+	for (int t = 0; t < 3; t++)
+	{
+	    if (!type_flags[t])
+		continue;
+	    for (int f = 0; f < 5; f++)
+	    {
+		if (!format_flags[f])
+		    continue;
+		data_t d;
+		if (!data_init(&d, size, t, f))
+		{
+		    mh_msg_err("%dx%d %s %s: %s", size, size, bench_type_names[t], bench_format_names[f],
+			    cvl_error() ? cvl_error_msg() : "cannot create frames");
+		    cvl_error_reset();
+		    data_free(&d);
+		    error = true;
+		    continue;
+		}
+		for (int o = 0; ops[o].name; o++)
+		{
+		    if (opnames.value && !bench_list_contains(opnames.value, ops[o].name)
+			    && !bench_list_contains(opnames.value, ops[o].category))
+			continue;
+		    if ((ops[o].flags & (OP_IMAGE | OP_XYZ | OP_HSL)) && f != CVL_LUM && f != CVL_RGB)
+			continue;
+		    mh_msg_dbg("%s %dx%d %s %s", ops[o].name, size, size, bench_type_names[t], bench_format_names[f]);
+		    if (!run_op(&(ops[o]), &d, warmup.value, repetitions.value, &result))
+		    {
+			mh_msg_err("%s %dx%d %s %s: %s", ops[o].name, size, size,
+				bench_type_names[t], bench_format_names[f], cvl_error_msg());
+			cvl_error_reset();
+			free_out(&d);
+			error = true;
+			continue;
+		    }
+		    result.op = ops[o].name;
+		    result.width = size;
+		    result.height = size;
+		    result.type = bench_type_names[t];
+		    result.format = bench_format_names[f];
+		    result.pixels = (long long)size * size;
+		    bench_report_result(stdout, report.value, &result);
+		    const bench_result_t *base;
+		    double change;
+		    if (baseline && (base = bench_baseline_find(baseline, &result)))
+		    {
+			compared++;
+			if (bench_compare(base, &result, threshold_value, &change))
+			{
+			    mh_msg_wrn("regression: %s %dx%d %s %s: %.4f ms -> %.4f ms (%+.1f%%)",
+				    result.op, size, size, result.type, result.format,
+				    bench_median(base->times, base->repetitions) * 1e3,
+				    bench_median(result.times, result.repetitions) * 1e3,
+				    change * 100.0);
+			    regressions++;
+			}
+			else
+			{
+			    mh_msg_dbg("%s %dx%d %s %s: %+.1f%%", result.op, size, size,
+				    result.type, result.format, change * 100.0);
+			}
+		    }
+		}
+		data_free(&d);
+	    }
+	}
+    }
+    bench_report_end(stdout, report.value);
+    free(result.times);
+    bench_deinit(ctx);
+    if (baseline)
+    {
+	mh_msg_inf("%d of %d results compared to the baseline are regressions", regressions, compared);
+	bench_baseline_free(baseline);
+    }
+
+    return error ? 1 : regressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,529 @@
+/*
+ * cvl-iobench.c
+ *
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <cvl/cvl.h>
+
+#include "mh.h"
+#include "bench.h"
+
+
+/* The stream subformats. The encoded input is generated by this program, so
+ * that subformats which cvl_write() does not produce (PBM, 16 bit, PAM with
+ * two channels) can be measured, too. The PAM tuple types are the ones that
+ * cvl_write() uses. */
+typedef struct
+{
+    const char *name;
+    cvl_stream_type_t stream;
+    int channels;
+    int maxval;			/* PNM only: 1 for PBM, 255, or 65535 */
+    const char *channel_names;	/* PFS only: one character per channel */
+    int tags;			/* PFS only: number of frame tags */
+} subformat_t;
+
+static const subformat_t subformats[] =
+{
+    { "pbm",		CVL_PNM,	1,	1,	NULL,	0 },
+    { "pgm",		CVL_PNM,	1,	255,	NULL,	0 },
+    { "pgm16",		CVL_PNM,	1,	65535,	NULL,	0 },
+    { "pam2",		CVL_PNM,	2,	255,	NULL,	0 },
+    { "pam2_16",	CVL_PNM,	2,	65535,	NULL,	0 },
+    { "ppm",		CVL_PNM,	3,	255,	NULL,	0 },
+    { "ppm16",		CVL_PNM,	3,	65535,	NULL,	0 },
+    { "pam4",		CVL_PNM,	4,	255,	NULL,	0 },
+    { "pam4_16",	CVL_PNM,	4,	65535,	NULL,	0 },
+    { "pfs1",		CVL_PFS,	1,	0,	"Y",	0 },
+    { "pfs2",		CVL_PFS,	2,	0,	"UV",	0 },
+    { "pfs3",		CVL_PFS,	3,	0,	"XYZ",	0 },
+    { "pfs4",		CVL_PFS,	4,	0,	"ABCD",	0 },
+    { "pfs3_tags",	CVL_PFS,	3,	0,	"XYZ",	1000 },
+    { NULL,		0,		0,	0,	NULL,	0 }
+};
+
+/* The sources and destinations of the streams. */
+typedef enum
+{
+    SOURCE_MEM = 0,
+    SOURCE_FILE = 1
+} source_t;
+
+static const char *source_names[] = { "mem", "file", NULL };
+
+/* The measured stages. For each source, reading is measured as a whole and
+ * split into parsing (the header and the raw data) and conversion (to the
+ * frame memory layout); the split is taken from the CVL profiler. Writing is
+ * measured from a frame in memory. Uploading the frame to a texture does not
+ * depend on the source and is measured separately. */
+typedef enum
+{
+    STAGE_READ = 0,
+    STAGE_PARSE = 1,
+    STAGE_CONVERT = 2,
+    STAGE_WRITE = 3,
+    STAGES = 4
+} stage_t;
+
+static const char *stage_names[2][STAGES] =
+{
+    { "read_mem", "read_mem_parse", "read_mem_convert", "write_mem" },
+    { "read_file", "read_file_parse", "read_file_convert", "write_file" }
+};
+
+/* An encoded input stream. */
+typedef struct
+{
+    char *buf;			/* The encoded stream */
+    size_t size;		/* Its size */
+    FILE *file;			/* A temporary file with the same contents */
+    char *outbuf;		/* Buffer for writing to memory */
+    size_t outsize;		/* Its size */
+    FILE *outfile;		/* Temporary file for writing */
+} input_t;
+
+
+/* A simple linear congruential generator, to get reproducible input. */
+static uint32_t lcg(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/* Write a synthetic frame in the given subformat to f. */
+static bool encode(FILE *f, const subformat_t *sf, int width, int height)
+{
+    uint32_t state = 42;
+    size_t size = (size_t)width * height;
+
+    if (sf->stream == CVL_PNM)
+    {
+	size_t rowsize = (sf->maxval == 1 ? (size_t)(width - 1) / 8 + 1
+		: (size_t)width * sf->channels * (sf->maxval > 255 ? 2 : 1));
+	uint8_t *row = mh_alloc(rowsize);
+	if (sf->maxval == 1)
+	    fprintf(f, "P4\n%d %d\n", width, height);
+	else if (sf->channels == 1)
+	    fprintf(f, "P5\n%d %d\n%d\n", width, height, sf->maxval);
+	else if (sf->channels == 3)
+	    fprintf(f, "P6\n%d %d\n%d\n", width, height, sf->maxval);
+	else
+	    fprintf(f, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL %d\nTUPLTYPE %s\nENDHDR\n",
+		    width, height, sf->channels, sf->maxval,
+		    sf->channels == 2 ? "RG" : "RGBA");
+	for (int y = 0; y < height; y++)
+	{
+	    if (sf->maxval > 255)
+	    {
+		for (size_t i = 0; i < rowsize; i += 2)
+		{
+		    uint32_t v = lcg(&state) % (uint32_t)(sf->maxval + 1);
+		    row[i] = v >> 8;
+		    row[i + 1] = v & 0xff;
+		}
+	    }
+	    else
+	    {
+		for (size_t i = 0; i < rowsize; i++)
+		    row[i] = lcg(&state) & 0xff;
+	    }
+	    fwrite(row, 1, rowsize, f);
+	}
+	free(row);
+    }
+    else
+    {
+	float *channel = mh_alloc(mh_alloc_mul(size, sizeof(float)));
+	fprintf(f, "PFS1\n%d %d\n%d\n%d\n", width, height, sf->channels, sf->tags);
+	for (int i = 0; i < sf->tags; i++)
+	    fprintf(f, "TAG%d=value of tag %d\n", i, i);
+	for (int c = 0; c < sf->channels; c++)
+	    fprintf(f, "%c\n0\n", sf->channel_names[c]);
+	fputs("ENDH", f);
+	for (int c = 0; c < sf->channels; c++)
+	{
+	    for (size_t i = 0; i < size; i++)
+		channel[i] = (float)lcg(&state) / (float)(1 << 24);
+	    fwrite(channel, sizeof(float), size, f);
+	}
+	free(channel);
+    }
+    return !ferror(f);
+}
+
+static void input_free(input_t *in)
+{
+    free(in->buf);
+    free(in->outbuf);
+    if (in->file)
+	fclose(in->file);
+    if (in->outfile)
+	fclose(in->outfile);
+}
+
+/* Encode the input in both a memory buffer and a temporary file, and prepare
+ * the destinations for writing. */
+static bool input_init(input_t *in, const subformat_t *sf, int width, int height)
+{
+    in->buf = NULL;
+    in->outbuf = NULL;
+    in->outfile = NULL;
+    if (!(in->file = tmpfile())
+	    || !(in->outfile = tmpfile())
+	    || !encode(in->file, sf, width, height)
+	    || fflush(in->file) != 0)
+    {
+	mh_msg_err("cannot create temporary file: %s", strerror(errno));
+	input_free(in);
+	return false;
+    }
+    in->size = ftell(in->file);
+    in->buf = mh_alloc(in->size);
+    rewind(in->file);
+    if (fread(in->buf, 1, in->size, in->file) != in->size)
+    {
+	mh_msg_err("cannot read temporary file: %s", strerror(errno));
+	input_free(in);
+	return false;
+    }
+    /* Four float channels and a generous amount of header space are enough
+     * for everything that cvl_write() produces. */
+    in->outsize = mh_alloc_mul((size_t)width * height, 4 * sizeof(float)) + 65536;
+    in->outbuf = mh_alloc(in->outsize);
+    return true;
+}
+
+/* Open the input or output stream for one repetition. */
+static FILE *stream_open(input_t *in, source_t source, bool output)
+{
+    FILE *f;
+    if (source == SOURCE_FILE)
+    {
+	f = (output ? in->outfile : in->file);
+	rewind(f);
+    }
+    else
+    {
+#ifdef HAVE_FMEMOPEN
+	f = (output ? fmemopen(in->outbuf, in->outsize, "w") : fmemopen(in->buf, in->size, "r"));
+#else
+	f = NULL;
+	errno = ENOSYS;
+#endif
+    }
+    return f;
+}
+
+static void stream_close(FILE *f, source_t source)
+{
+    if (source == SOURCE_MEM)
+	fclose(f);
+}
+
+/* Return the wall time of the profiled operation with the given name. */
+static double profile_time(const char *name)
+{
+    cvl_profile_op_t op;
+    for (int i = 0; i < cvl_profile_ops(); i++)
+    {
+	cvl_profile_op(i, &op);
+	if (strcmp(op.name, name) == 0)
+	    return op.wall_time;
+    }
+    return 0.0;
+}
+
+/* Measure reading and writing from one source. The times of each stage are
+ * stored in times[stage][repetition], and the type of the frames that were
+ * read is stored in type. */
+static bool run_source(input_t *in, const subformat_t *sf, source_t source,
+	int warmup, int repetitions, double *times[STAGES], cvl_type_t *type)
+{
+    const char *parse_name = (sf->stream == CVL_PNM ? "cvl_read_pnm parse" : "cvl_read_pfs parse");
+    const char *convert_name = (sf->stream == CVL_PNM ? "cvl_read_pnm convert" : "cvl_read_pfs convert");
+    mh_timer_t start, stop;
+
+    for (int i = 0; i < warmup + repetitions; i++)
+    {
+	cvl_frame_t *frame = NULL;
+	FILE *f;
+
+	if (!(f = stream_open(in, source, false)))
+	{
+	    mh_msg_err("cannot open %s stream: %s", source_names[source], strerror(errno));
+	    return false;
+	}
+	cvl_profile_reset();
+	mh_timer_set(MH_TIMER_REAL, &start);
+	cvl_read(f, NULL, &frame);
+	mh_timer_set(MH_TIMER_REAL, &stop);
+	stream_close(f, source);
+	if (cvl_error() || !frame)
+	{
+	    mh_msg_err("cannot read %s stream: %s", source_names[source],
+		    cvl_error() ? cvl_error_msg() : "no frame");
+	    cvl_error_reset();
+	    return false;
+	}
+	*type = cvl_frame_type(frame);
+	if (i >= warmup)
+	{
+	    times[STAGE_READ][i - warmup] = mh_timer_get(&start, &stop);
+	    times[STAGE_PARSE][i - warmup] = profile_time(parse_name);
+	    times[STAGE_CONVERT][i - warmup] = profile_time(convert_name);
+	}
+
+	if (!(f = stream_open(in, source, true)))
+	{
+	    mh_msg_err("cannot open %s stream: %s", source_names[source], strerror(errno));
+	    cvl_frame_free(frame);
+	    return false;
+	}
+	mh_timer_set(MH_TIMER_REAL, &start);
+	cvl_write(f, sf->stream, frame);
+	fflush(f);
+	mh_timer_set(MH_TIMER_REAL, &stop);
+	stream_close(f, source);
+	cvl_frame_free(frame);
+	if (cvl_error())
+	{
+	    mh_msg_err("cannot write %s stream: %s", source_names[source], cvl_error_msg());
+	    cvl_error_reset();
+	    return false;
+	}
+	if (i >= warmup)
+	    times[STAGE_WRITE][i - warmup] = mh_timer_get(&start, &stop);
+    }
+    return true;
+}
+
+/* Measure uploading frames read from the input to textures. The type of the
+ * frames is stored in type. */
+static bool run_upload(input_t *in, int warmup, int repetitions, double *times, cvl_type_t *type)
+{
+    mh_timer_t start, stop;
+
+    for (int i = 0; i < warmup + repetitions; i++)
+    {
+	cvl_frame_t *frame = NULL;
+	rewind(in->file);
+	cvl_read(in->file, NULL, &frame);
+	if (!cvl_error() && frame)
+	{
+	    *type = cvl_frame_type(frame);
+	    glFinish();
+	    mh_timer_set(MH_TIMER_REAL, &start);
+	    cvl_frame_texture(frame);
+	    glFinish();
+	    mh_timer_set(MH_TIMER_REAL, &stop);
+	    cvl_frame_free(frame);
+	}
+	if (cvl_error())
+	{
+	    mh_msg_err("cannot upload frame: %s", cvl_error_msg());
+	    cvl_error_reset();
+	    return false;
+	}
+	if (i >= warmup)
+	    times[i - warmup] = mh_timer_get(&start, &stop);
+    }
+    return true;
+}
+
+static void print_help(void)
+{
+    mh_msg_fmt_req(
+	    "Usage: cvl-iobench [-s|--sizes=<s1,s2,...>] [-f|--formats=<f1,f2,...>] [-S|--sources=mem,file] "
+	    "[-w|--warmup=<n>] [-r|--repetitions=<n>] [-R|--report=csv|json] [-l|--list]\n"
+	    "\n"
+	    "Benchmark the CVL input/output functions on synthetic square frames in each stream subformat, "
+	    "read from and written to memory buffers and temporary files, and print the median and "
+	    "95th percentile time and the throughput of each stage.\n"
+	    "The stages are reading (read_mem, read_file), its split into parsing the header and the raw "
+	    "data (read_*_parse) and converting the data to the frame layout (read_*_convert), writing "
+	    "(write_mem, write_file), and uploading the frame to a texture (upload). The format column "
+	    "of the report is the subformat, and the type column is the type of the frame that was read.\n"
+	    "Sizes default to 256,1024,4096; sizes beyond the maximum texture size are skipped. "
+	    "All subformats are measured by default; see --list. Memory streams are only available "
+	    "if the system supports fmemopen(). The default is 2 warm-up runs and 10 repetitions. "
+	    "The report is CSV by default.");
+}
+
+static void print_list(void)
+{
+    for (int i = 0; subformats[i].name; i++)
+	mh_msg_req("%s", subformats[i].name);
+}
+
+int main(int argc, char *argv[])
+{
+    mh_option_int_array_t sizes = { NULL, 0, NULL, 1, NULL };
+    mh_option_string_t formats = { NULL, NULL };
+    mh_option_string_t sources = { NULL, NULL };
+    mh_option_int_t warmup = { 2, 0, 1000 };
+    mh_option_int_t repetitions = { 10, 1, 100000 };
+    mh_option_name_t report = { BENCH_REPORT_CSV, bench_report_names };
+    mh_option_info_t help = { false, print_help };
+    mh_option_info_t list = { false, print_list };
+    mh_option_t options[] =
+    {
+	{ "sizes",       's', MH_OPTION_INT_ARRAY, &sizes,       false },
+	{ "formats",     'f', MH_OPTION_STRING,    &formats,     false },
+	{ "sources",     'S', MH_OPTION_STRING,    &sources,     false },
+	{ "warmup",      'w', MH_OPTION_INT,       &warmup,      false },
+	{ "repetitions", 'r', MH_OPTION_INT,       &repetitions, false },
+	{ "report",      'R', MH_OPTION_NAME,      &report,      false },
+	{ "help",       '\0', MH_OPTION_INFO,      &help,        false },
+	{ "list",        'l', MH_OPTION_INFO,      &list,        false },
+	mh_option_null
+    };
+    const int default_sizes[] = { 256, 1024, 4096 };
+    const char *subformat_names[sizeof(subformats) / sizeof(subformats[0])];
+    bool subformat_flags[sizeof(subformats) / sizeof(subformats[0])];
+    bool source_flags[2] = { true, true };
+
+    for (size_t i = 0; i < sizeof(subformats) / sizeof(subformats[0]); i++)
+    {
+	subformat_names[i] = subformats[i].name;
+	subformat_flags[i] = true;
+    }
+    mh_msg_set_program_name("cvl-iobench");
+    mh_msg_set_output_level(MH_MSG_INF);
+    mh_msg_fmt_set_columns_from_env();
+    if (!mh_getopt(argc, argv, options, 0, 0, NULL))
+	return 1;
+    if (help.value || list.value)
+	return 0;
+    if (formats.value && !bench_parse_names(formats.value, subformat_names, subformat_flags))
+    {
+	mh_msg_err("invalid list of formats: %s", formats.value);
+	return 1;
+    }
+    if (sources.value && !bench_parse_names(sources.value, source_names, source_flags))
+    {
+	mh_msg_err("invalid list of sources: %s", sources.value);
+	return 1;
+    }
+#ifndef HAVE_FMEMOPEN
+    if (source_flags[SOURCE_MEM])
+    {
+	mh_msg_wrn("skipping memory streams: fmemopen() is not available");
+	source_flags[SOURCE_MEM] = false;
+    }
+#endif
+    int nsizes = (sizes.value ? sizes.value_sizes[0] : 3);
+    const int *size_list = (sizes.value ? sizes.value : default_sizes);
+    for (int i = 0; i < nsizes; i++)
+    {
+	if (size_list[i] < 1)
+	{
+	    mh_msg_err("invalid size %d: sizes must be at least 1", size_list[i]);
+	    return 1;
+	}
+    }
+
+    cvl_gl_context_t *ctx = bench_init();
+    if (!ctx)
+	return 1;
+    GLint max_tex_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_tex_size);
+    cvl_profile_enable(true);
+
+    bool error = false;
+    double *times[STAGES];
+    for (int j = 0; j < STAGES; j++)
+	times[j] = mh_alloc(mh_alloc_mul(repetitions.value, sizeof(double)));
+    bench_result_t result;
+    result.repetitions = repetitions.value;
+    bench_report_begin(stdout, report.value);
+    for (int s = 0; s < nsizes; s++)
+    {
+	int size = size_list[s];
+	if (size > max_tex_size)
+	{
+	    mh_msg_wrn("skipping size %d: exceeds the maximum texture size %d", size, max_tex_size);
+	    continue;
+	}
+	result.width = size;
+	result.height = size;
+	result.pixels = (long long)size * size;
+	for (int f = 0; subformats[f].name; f++)
+	{
+	    if (!subformat_flags[f])
+		continue;
+	    const subformat_t *sf = &(subformats[f]);
+	    cvl_type_t type = CVL_UINT8;
+	    input_t in;
+	    if (!input_init(&in, sf, size, size))
+	    {
+		error = true;
+		continue;
+	    }
+	    result.format = sf->name;
+	    for (int src = 0; src < 2; src++)
+	    {
+		if (!source_flags[src])
+		    continue;
+		mh_msg_dbg("%s %dx%d %s", sf->name, size, size, source_names[src]);
+		if (!run_source(&in, sf, src, warmup.value, repetitions.value, times, &type))
+		{
+		    mh_msg_err("%s %dx%d: benchmark failed", sf->name, size, size);
+		    error = true;
+		    continue;
+		}
+		result.type = bench_type_names[type];
+		for (int j = 0; j < STAGES; j++)
+		{
+		    result.op = stage_names[src][j];
+		    result.times = times[j];
+		    bench_report_result(stdout, report.value, &result);
+		}
+	    }
+	    if (!run_upload(&in, warmup.value, repetitions.value, times[0], &type))
+	    {
+		mh_msg_err("%s %dx%d: benchmark failed", sf->name, size, size);
+		error = true;
+	    }
+	    else
+	    {
+		result.op = "upload";
+		result.type = bench_type_names[type];
+		result.times = times[0];
+		bench_report_result(stdout, report.value, &result);
+	    }
+	    input_free(&in);
+	}
+    }
+    bench_report_end(stdout, report.value);
+    for (int j = 0; j < STAGES; j++)
+	free(times[j]);
+    cvl_profile_enable(false);
+    bench_deinit(ctx);
+
+    return error ? 1 : 0;
+}
@@ -59,7 +59,10 @@ extern "C"
 #include "cvl_features.h"
 #include "cvl_hdr.h"
 #include "cvl_wavelets.h"
+#include "cvl_fft.h"
 #include "cvl_visualization.h"
+#include "cvl_parallel.h"
+#include "cvl_profile.h"
 
 #ifdef __cplusplus
 }
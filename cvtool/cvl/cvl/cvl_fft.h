@@ -0,0 +1,38 @@
+/*
+ * cvl_fft.h
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CVL_FFT_H
+#define CVL_FFT_H
+
+typedef enum
+{
+    CVL_FFT_AUTO			= 0,
+    CVL_FFT_GPU				= 1,
+    CVL_FFT_CPU				= 2
+} cvl_fft_method_t;
+
+extern CVL_EXPORT void cvl_fft(cvl_frame_t *re, cvl_frame_t *im, cvl_frame_t *src);
+extern CVL_EXPORT void cvl_fft_using(cvl_frame_t *re, cvl_frame_t *im, cvl_frame_t *src, cvl_fft_method_t method);
+extern CVL_EXPORT void cvl_ifft(cvl_frame_t *dst, cvl_frame_t *re, cvl_frame_t *im);
+extern CVL_EXPORT void cvl_ifft_using(cvl_frame_t *dst, cvl_frame_t *re, cvl_frame_t *im, cvl_fft_method_t method);
+
+#endif
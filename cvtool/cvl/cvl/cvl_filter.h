@@ -31,6 +31,16 @@ extern CVL_EXPORT void cvl_convolve3d(cvl_frame_t *dst, cvl_frame_t **srcs,
 extern CVL_EXPORT void cvl_convolve3d_separable(cvl_frame_t *dst, cvl_frame_t **srcs, 
 	const float *h, int h_len, const float *v, int v_len, const float *t, int t_len);
 
+typedef enum
+{
+    CVL_INTEGRAL_AUTO			= 0,
+    CVL_INTEGRAL_GPU			= 1,
+    CVL_INTEGRAL_CPU			= 2
+} cvl_integral_method_t;
+
+extern CVL_EXPORT void cvl_integral_image(cvl_frame_t *dst, cvl_frame_t *src);
+extern CVL_EXPORT void cvl_integral_image_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_integral_method_t method);
+
 extern CVL_EXPORT void cvl_mean(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
 extern CVL_EXPORT void cvl_mean3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t);
 
@@ -40,17 +50,40 @@ extern CVL_EXPORT void cvl_gauss(cvl_frame_t *dst, cvl_frame_t *src, int k_h, in
 extern CVL_EXPORT void cvl_gauss3d(cvl_frame_t *dst, cvl_frame_t **srcs, 
 	int k_h, int k_v, int k_t, float sigma_h, float sigma_v, float sigma_t);
 
+extern CVL_EXPORT void cvl_bilateral(cvl_frame_t *dst, cvl_frame_t *src, float sigma_spatial, float sigma_range);
+
 extern CVL_EXPORT void cvl_min(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
 extern CVL_EXPORT void cvl_min3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t);
 
 extern CVL_EXPORT void cvl_max(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
 extern CVL_EXPORT void cvl_max3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t);
 
+extern CVL_EXPORT void cvl_opening(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
+extern CVL_EXPORT void cvl_closing(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
+
 extern CVL_EXPORT void cvl_median(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
 extern CVL_EXPORT void cvl_median3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t);
 extern CVL_EXPORT void cvl_median_separated(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v);
 extern CVL_EXPORT void cvl_median3d_separated(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t);
 
+typedef enum
+{
+    CVL_TEMPORAL_MEAN = 0,
+    CVL_TEMPORAL_GAUSS = 1,
+    CVL_TEMPORAL_MIN = 2,
+    CVL_TEMPORAL_MAX = 3,
+    CVL_TEMPORAL_MEDIAN = 4,
+    CVL_TEMPORAL_MEDIAN_SEPARATED = 5
+} cvl_temporal_filter_type_t;
+
+typedef unsigned long cvl_temporal_filter_t;
+
+extern CVL_EXPORT cvl_temporal_filter_t *cvl_temporal_filter_new(cvl_temporal_filter_type_t type,
+	int k_h, int k_v, int k_t, float sigma_h, float sigma_v, float sigma_t);
+extern CVL_EXPORT void cvl_temporal_filter_free(cvl_temporal_filter_t *filter);
+extern CVL_EXPORT void cvl_temporal_filter_put(cvl_temporal_filter_t *filter, cvl_frame_t *frame);
+extern CVL_EXPORT cvl_frame_t *cvl_temporal_filter_get(cvl_temporal_filter_t *filter);
+
 extern CVL_EXPORT void cvl_laplace(cvl_frame_t *dst, cvl_frame_t *src, float c);
 extern CVL_EXPORT void cvl_unsharpmask(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *smoothed, float c);
 
@@ -82,5 +82,6 @@ extern CVL_EXPORT GLuint cvl_frame_texture(cvl_frame_t *frame);
 
 extern CVL_EXPORT void cvl_transform(cvl_frame_t *dst, cvl_frame_t *src);
 extern CVL_EXPORT void cvl_transform_multi(cvl_frame_t **dsts, int ndsts, cvl_frame_t **srcs, int nsrcs, const char *textures_name);
+extern CVL_EXPORT void cvl_transform_array(cvl_frame_t *dst, cvl_frame_t **srcs, int nsrcs, const char *array_name);
 
 #endif
@@ -48,6 +48,7 @@ extern CVL_EXPORT char *cvl_gl_srcprep(char *src, const char *defines, ...) __at
 #else
 extern CVL_EXPORT char *cvl_gl_srcprep(char *src, const char *defines, ...);
 #endif
+extern CVL_EXPORT char *cvl_gl_srcinsert(char *src, const char *name, const char *code);
 extern CVL_EXPORT GLuint cvl_gl_shader(const char *name, GLenum type, const char *src);
 extern CVL_EXPORT GLuint cvl_gl_program_new(const char *name, GLuint vshader, GLuint fshader);
 extern CVL_EXPORT GLuint cvl_gl_program_new_src(const char *name, const char *vshader_src, const char *fshader_src);
@@ -24,6 +24,19 @@
 
 extern CVL_EXPORT float cvl_log_avg_lum(cvl_frame_t *frame, cvl_frame_t *tmp, float max_abs_lum);
 
+extern CVL_EXPORT void cvl_lum_statistics(cvl_frame_t *frame, float max_abs_lum,
+	float *min_lum, float *max_lum, float *avg_lum, float *log_avg_lum, float *channel_avg);
+
+typedef unsigned long cvl_lum_adaptation_t;
+
+extern CVL_EXPORT cvl_lum_adaptation_t *cvl_lum_adaptation_new(float time_constant);
+extern CVL_EXPORT void cvl_lum_adaptation_free(cvl_lum_adaptation_t *adaptation);
+extern CVL_EXPORT void cvl_lum_adaptation_put(cvl_lum_adaptation_t *adaptation, cvl_frame_t *frame, float max_abs_lum);
+extern CVL_EXPORT void cvl_lum_adaptation_put_statistics(cvl_lum_adaptation_t *adaptation,
+	float min_lum, float max_lum, float avg_lum, float log_avg_lum, const float *channel_avg);
+extern CVL_EXPORT void cvl_lum_adaptation_get(cvl_lum_adaptation_t *adaptation,
+	float *min_lum, float *max_lum, float *avg_lum, float *log_avg_lum, float *channel_avg);
+
 extern CVL_EXPORT void cvl_tonemap_schlick94(cvl_frame_t *dst, cvl_frame_t *src, float p);
 
 extern CVL_EXPORT void cvl_tonemap_tumblin99(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
@@ -31,6 +44,12 @@ extern CVL_EXPORT void cvl_tonemap_tumblin99(cvl_frame_t *dst, cvl_frame_t *src,
 
 extern CVL_EXPORT void cvl_tonemap_drago03(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum, float bias, float max_disp_lum);
 
+extern CVL_EXPORT void cvl_tonemap_lut_schlick94(cvl_frame_t *lut, float p);
+extern CVL_EXPORT void cvl_tonemap_lut_tumblin99(cvl_frame_t *lut, float max_abs_lum,
+	float log_avg_lum, float display_adaptation_level, float max_displayable_contrast);
+extern CVL_EXPORT void cvl_tonemap_lut_drago03(cvl_frame_t *lut, float max_abs_lum, float bias, float max_disp_lum);
+extern CVL_EXPORT void cvl_tonemap_lut(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *lut);
+
 extern CVL_EXPORT void cvl_tonemap_reinhard05(cvl_frame_t *dst, cvl_frame_t *src, 
 	float min_lum, float avg_lum, float log_avg_lum,
 	cvl_frame_t *rgb, const float channel_avg[3],
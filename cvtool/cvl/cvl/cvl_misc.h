@@ -34,14 +34,32 @@ typedef enum
     CVL_REDUCE_SUM			= 6
 } cvl_reduce_mode_t;
 
+typedef enum
+{
+    CVL_SORT_AUTO			= 0,
+    CVL_SORT_BITONIC			= 1,
+    CVL_SORT_RADIX			= 2
+} cvl_sort_method_t;
+
+typedef enum
+{
+    CVL_HISTOGRAM_AUTO			= 0,
+    CVL_HISTOGRAM_GPU			= 1,
+    CVL_HISTOGRAM_CPU			= 2
+} cvl_histogram_method_t;
+
 extern CVL_EXPORT void cvl_resize_seq(cvl_frame_t *dst, cvl_frame_t *src, const float *fillvalue);
 
 extern CVL_EXPORT void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *result);
 
 extern CVL_EXPORT void cvl_sort(cvl_frame_t *dst, cvl_frame_t *src, int channel);
 
+extern CVL_EXPORT void cvl_sort_using(cvl_frame_t *dst, cvl_frame_t *src, int channel, cvl_sort_method_t method);
+
 extern CVL_EXPORT void cvl_quantil(cvl_frame_t *frame, int channel, float q, float *result);
 
+extern CVL_EXPORT void cvl_quantiles(cvl_frame_t *frame, int channel, const float *q, int n, float *result);
+
 extern CVL_EXPORT void cvl_statistics(cvl_frame_t *frame, float *min, float *max, float *median, 
 	float *mean, float *stddev, float *dynrange);
 
@@ -53,4 +71,7 @@ extern CVL_EXPORT void cvl_pyramid_laplacian(cvl_frame_t **gaussian_pyramid, int
 
 extern CVL_EXPORT void cvl_histogram(cvl_frame_t *frame, int channel, int bins, const float *min, const float *max, int *histogram);
 
+extern CVL_EXPORT void cvl_histogram_using(cvl_frame_t *frame, int channel, int bins, const float *min, const float *max,
+	int *histogram, cvl_histogram_method_t method);
+
 #endif
@@ -0,0 +1,40 @@
+/*
+ * cvl_parallel.h
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CVL_PARALLEL_H
+#define CVL_PARALLEL_H
+
+#include <stdbool.h>
+
+typedef unsigned long cvl_parallel_t;
+
+typedef cvl_frame_t *(*cvl_parallel_func_t)(cvl_frame_t *frame, void *data);
+
+extern CVL_EXPORT cvl_parallel_t *cvl_parallel_new(const char *display_name, int jobs,
+	cvl_parallel_func_t func, void *data);
+extern CVL_EXPORT void cvl_parallel_free(cvl_parallel_t *parallel);
+
+extern CVL_EXPORT void cvl_parallel_put(cvl_parallel_t *parallel, cvl_frame_t *frame);
+extern CVL_EXPORT cvl_frame_t *cvl_parallel_get(cvl_parallel_t *parallel, bool wait);
+extern CVL_EXPORT int cvl_parallel_pending(cvl_parallel_t *parallel);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * cvl_profile.h
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CVL_PROFILE_H
+#define CVL_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    const char *name;
+    int calls;
+    double wall_time;
+    double gpu_time;
+    long long pixels;
+    long long bytes;
+} cvl_profile_op_t;
+
+extern CVL_EXPORT void cvl_profile_enable(bool enable);
+extern CVL_EXPORT bool cvl_profile_enabled(void);
+extern CVL_EXPORT void cvl_profile_reset(void);
+extern CVL_EXPORT int cvl_profile_ops(void);
+extern CVL_EXPORT void cvl_profile_op(int index, cvl_profile_op_t *op);
+
+extern CVL_EXPORT void cvl_profile_trace_start(FILE *f);
+extern CVL_EXPORT void cvl_profile_trace_stop(void);
+
+#endif
@@ -23,8 +23,19 @@
 #ifndef CVL_WAVELETS_H
 #define CVL_WAVELETS_H
 
+typedef enum
+{
+    CVL_WAVELETS_AUTO			= 0,
+    CVL_WAVELETS_GPU			= 1,
+    CVL_WAVELETS_CPU			= 2
+} cvl_wavelets_method_t;
+
 extern CVL_EXPORT void cvl_wavelets_dwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level);
+extern CVL_EXPORT void cvl_wavelets_dwt_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level,
+	cvl_wavelets_method_t method);
 extern CVL_EXPORT void cvl_wavelets_idwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level);
+extern CVL_EXPORT void cvl_wavelets_idwt_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level,
+	cvl_wavelets_method_t method);
 extern CVL_EXPORT void cvl_wavelets_hard_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int level, const float *T);
 extern CVL_EXPORT void cvl_wavelets_soft_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int level, const float *T);
 
@@ -105,12 +105,15 @@ void cvl_fill_rect(cvl_frame_t *frame, int x, int y, int w, int h, const float *
     float yt = fy * 2.0f - 1.0f;
     float yb = (fy + fh) * 2.0f - 1.0f;
     glUseProgram(0);
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glVertex3f(xl, yt, 0.0f);
     glVertex3f(xr, yt, 0.0f);
     glVertex3f(xr, yb, 0.0f);
     glVertex3f(xl, yb, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)w * h);
     cvl_check_errors();
     glEnable(GL_TEXTURE_2D);
 }
@@ -157,6 +160,8 @@ void cvl_copy_rect(cvl_frame_t *dst, int dst_x, int dst_y,
     float dst_ytf = dst_yf * 2.0f - 1.0f;
     float dst_ybf = (dst_yf + dst_hf) * 2.0f - 1.0f;
     glUseProgram(0);
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(src_xlf, src_ytf);
     glVertex3f(dst_xlf, dst_ytf, 0.0f);
@@ -167,6 +172,7 @@ void cvl_copy_rect(cvl_frame_t *dst, int dst_x, int dst_y,
     glTexCoord2f(src_xlf, src_ybf);
     glVertex3f(dst_xlf, dst_ybf, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)rwidth * rheight);
     cvl_check_errors();
 }
 
@@ -50,6 +50,7 @@
 #include "glsl/color/rgb_to_lum.glsl.h"
 #include "glsl/color/rgb_to_xyz.glsl.h"
 #include "glsl/color/xyz_to_rgb.glsl.h"
+#include "glsl/color/xyz_to_rgb_func.glsl.h"
 #include "glsl/color/rgb_to_hsl.glsl.h"
 #include "glsl/color/hsl_to_rgb.glsl.h"
 #include "glsl/color/channel_combine.glsl.h"
@@ -902,8 +903,11 @@ static void cvl_xyz_to_rgb(cvl_frame_t *dst, cvl_frame_t *src)
     GLuint prg;
     if ((prg = cvl_gl_program_cache_get("cvl_xyz_to_rgb")) == 0)
     {
-	prg = cvl_gl_program_new_src("cvl_xyz_to_rgb", NULL, CVL_XYZ_TO_RGB_GLSL_STR);
+	char *src = cvl_gl_srcinsert(cvl_strdup(CVL_XYZ_TO_RGB_GLSL_STR),
+		"$xyz_to_rgb_func", CVL_XYZ_TO_RGB_FUNC_GLSL_STR);
+	prg = cvl_gl_program_new_src("cvl_xyz_to_rgb", NULL, src);
 	cvl_gl_program_cache_put("cvl_xyz_to_rgb", prg);
+	free(src);
     }
     glUseProgram(prg);
     cvl_transform(dst, src);
@@ -1021,7 +1025,10 @@ void cvl_channel_combine(cvl_frame_t *dst,
     glUniform1i(glGetUniformLocation(prg, "have_c1"), c1 ? 1 : 0);
     glUniform1i(glGetUniformLocation(prg, "have_c2"), c2 ? 1 : 0);
     glUniform1i(glGetUniformLocation(prg, "have_c3"), c3 ? 1 : 0);
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glDrawArrays(GL_QUADS, 0, 4);
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(dst));
     glActiveTexture(GL_TEXTURE0);
     cvl_check_errors();
 }
@@ -0,0 +1,517 @@
+/*
+ * cvl_fft.c
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file cvl_fft.h
+ * \brief Fourier transform.
+ *
+ * The discrete Fourier transform of frames. A frame in the frequency domain
+ * is represented by two frames of type #CVL_FLOAT that hold the real and the
+ * imaginary parts of each channel. The transform is computed either on the
+ * GPU with the radix-2 Stockham algorithm, which needs widths and heights that
+ * are powers of two, or on the CPU with a mixed radix algorithm, which accepts
+ * any size.
+ */
+
+/**
+ * \typedef cvl_fft_method_t
+ * The method used to compute a Fourier transform.
+ */
+/** \var CVL_FFT_AUTO
+ * Choose the method based on the frame size. */
+/** \var CVL_FFT_GPU
+ * Transform on the GPU. */
+/** \var CVL_FFT_CPU
+ * Transform on the CPU. */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+#define CVL_BUILD
+#include "cvl_intern.h"
+#include "cvl/cvl.h"
+
+#include "glsl/fft/fft_stockham.glsl.h"
+
+
+static bool cvl_fft_is_pow2(int x)
+{
+    return (x > 0 && (x & (x - 1)) == 0);
+}
+
+/* Transforms (re_src, im_src) into (re_dst, im_dst). If im_src is NULL, the
+ * input is real. The result of the inverse transform is multiplied with
+ * scale. All frames must have the same size. */
+static void cvl_fft_2d(cvl_frame_t *re_dst, cvl_frame_t *im_dst,
+	cvl_frame_t *re_src, cvl_frame_t *im_src, bool inverse, float scale)
+{
+    int width = cvl_frame_width(re_dst);
+    int height = cvl_frame_height(re_dst);
+    int passes = 0;
+    for (int n = 1; n < width; n *= 2)
+	passes++;
+    for (int n = 1; n < height; n *= 2)
+	passes++;
+    if (passes == 0)
+    {
+	/* A 1x1 frame is its own transform */
+	cvl_copy(re_dst, re_src);
+	if (im_src)
+	    cvl_copy(im_dst, im_src);
+	else
+	{
+	    const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	    cvl_fill_rect(im_dst, 0, 0, 1, 1, zero);
+	}
+	return;
+    }
+
+    /* Choose the first frames so that the last pass renders into the
+     * destination */
+    cvl_frame_t *tmp_re = cvl_frame_new_tpl(re_dst);
+    cvl_frame_t *tmp_im = cvl_frame_new_tpl(im_dst);
+    cvl_frame_t *frames[2][2] = { { re_dst, im_dst }, { tmp_re, tmp_im } };
+    int current = (passes + 1) % 2;
+
+    GLuint prg;
+    if ((prg = cvl_gl_program_cache_get("cvl_fft_stockham")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_fft_stockham", NULL, CVL_FFT_STOCKHAM_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_fft_stockham", prg);
+    }
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "size"), width, height);
+    glUniform1f(glGetUniformLocation(prg, "dir_sign"), inverse ? +1.0f : -1.0f);
+    int pass = 0;
+    for (int horizontal = 1; horizontal >= 0; horizontal--)
+    {
+	int n = (horizontal ? width : height);
+	glUniform2f(glGetUniformLocation(prg, "dir"), horizontal ? 1.0f : 0.0f, horizontal ? 0.0f : 1.0f);
+	glUniform1f(glGetUniformLocation(prg, "n"), n);
+	for (int ns = 1; ns < n; ns *= 2)
+	{
+	    cvl_frame_t *srcs[2];
+	    if (pass == 0)
+	    {
+		srcs[0] = re_src;
+		srcs[1] = (im_src ? im_src : re_src);
+	    }
+	    else
+	    {
+		srcs[0] = frames[1 - current][0];
+		srcs[1] = frames[1 - current][1];
+	    }
+	    glUniform1f(glGetUniformLocation(prg, "real_input"), (pass == 0 && !im_src) ? 1.0f : 0.0f);
+	    glUniform1f(glGetUniformLocation(prg, "ns"), ns);
+	    glUniform1f(glGetUniformLocation(prg, "scale"), (inverse && pass == passes - 1) ? scale : 1.0f);
+	    cvl_transform_multi(frames[current], 2, srcs, 2, "textures");
+	    current = 1 - current;
+	    pass++;
+	}
+    }
+    cvl_frame_free(tmp_re);
+    cvl_frame_free(tmp_im);
+    cvl_check_errors();
+}
+
+/* A complex number of the CPU transform */
+typedef struct
+{
+    float re;
+    float im;
+} cvl_fft_complex_t;
+
+/* The factors of a transform length and its twiddle factors
+ * exp(sign * 2 pi i k / n) for k = 0, ..., n-1. */
+typedef struct
+{
+    int n;
+    int factors[32];
+    cvl_fft_complex_t *twiddles;
+} cvl_fft_plan_t;
+
+static bool cvl_fft_plan_init(cvl_fft_plan_t *plan, int n, bool inverse)
+{
+    plan->n = n;
+    /* Radix 4 butterflies are the cheapest per element, then 2, 3, and 5.
+     * Other prime factors use a generic butterfly. */
+    int i = 0;
+    int m = n;
+    while (m % 4 == 0)
+    {
+	plan->factors[i++] = 4;
+	m /= 4;
+    }
+    for (int p = 2; m > 1; p++)
+    {
+	while (m % p == 0)
+	{
+	    plan->factors[i++] = p;
+	    m /= p;
+	}
+    }
+    if (i == 0)
+	plan->factors[i++] = 1;
+    plan->twiddles = malloc(n * sizeof(cvl_fft_complex_t));
+    if (!plan->twiddles)
+	return false;
+    for (int k = 0; k < n; k++)
+    {
+	double angle = (inverse ? +2.0 : -2.0) * M_PI * k / n;
+	plan->twiddles[k].re = cos(angle);
+	plan->twiddles[k].im = sin(angle);
+    }
+    return true;
+}
+
+static inline cvl_fft_complex_t cvl_fft_mul(cvl_fft_complex_t a, cvl_fft_complex_t b)
+{
+    cvl_fft_complex_t r = { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    return r;
+}
+
+/* Transforms the n values in[0], in[stride], ... into out[0..n-1] with mixed
+ * radix decimation in time: the first factor p splits the input into p
+ * interleaved sequences, which are transformed recursively, and p-point
+ * butterflies combine them. tw_stride is plan->n / n. The buffer t must hold
+ * the largest factor. */
+static void cvl_fft_cpu_1d(cvl_fft_complex_t *out, const cvl_fft_complex_t *in, int stride,
+	int n, const int *factors, const cvl_fft_plan_t *plan, int tw_stride, cvl_fft_complex_t *t)
+{
+    const int p = factors[0];
+    const int m = n / p;
+    const cvl_fft_complex_t *tw = plan->twiddles;
+
+    if (m == 1)
+    {
+	for (int r = 0; r < p; r++)
+	    out[r] = in[r * stride];
+    }
+    else
+    {
+	for (int r = 0; r < p; r++)
+	    cvl_fft_cpu_1d(out + r * m, in + r * stride, stride * p, m, factors + 1, plan, tw_stride * p, t);
+    }
+    if (p == 1)
+	return;
+
+    for (int k = 0; k < m; k++)
+    {
+	t[0] = out[k];
+	for (int r = 1; r < p; r++)
+	    t[r] = cvl_fft_mul(out[r * m + k], tw[r * k * tw_stride]);
+	if (p == 2)
+	{
+	    out[k].re = t[0].re + t[1].re;
+	    out[k].im = t[0].im + t[1].im;
+	    out[m + k].re = t[0].re - t[1].re;
+	    out[m + k].im = t[0].im - t[1].im;
+	}
+	else if (p == 4)
+	{
+	    /* The twiddle factor of a quarter period is -i (forward) or +i
+	     * (inverse), which is tw[m * tw_stride]. */
+	    float sign = tw[m * tw_stride].im;
+	    cvl_fft_complex_t a0 = { t[0].re + t[2].re, t[0].im + t[2].im };
+	    cvl_fft_complex_t a1 = { t[0].re - t[2].re, t[0].im - t[2].im };
+	    cvl_fft_complex_t a2 = { t[1].re + t[3].re, t[1].im + t[3].im };
+	    cvl_fft_complex_t a3 = { -sign * (t[1].im - t[3].im), sign * (t[1].re - t[3].re) };
+	    out[k].re = a0.re + a2.re;
+	    out[k].im = a0.im + a2.im;
+	    out[m + k].re = a1.re + a3.re;
+	    out[m + k].im = a1.im + a3.im;
+	    out[2 * m + k].re = a0.re - a2.re;
+	    out[2 * m + k].im = a0.im - a2.im;
+	    out[3 * m + k].re = a1.re - a3.re;
+	    out[3 * m + k].im = a1.im - a3.im;
+	}
+	else
+	{
+	    for (int q = 0; q < p; q++)
+	    {
+		cvl_fft_complex_t s = t[0];
+		for (int r = 1; r < p; r++)
+		{
+		    cvl_fft_complex_t v = cvl_fft_mul(t[r], tw[(r * q % p) * m * tw_stride]);
+		    s.re += v.re;
+		    s.im += v.im;
+		}
+		out[q * m + k] = s;
+	    }
+	}
+    }
+}
+
+/* A part of the CPU transform: the lines first to last-1 of data are
+ * transformed. A line is a row or a column of one channel. */
+typedef struct
+{
+    cvl_fft_complex_t *data;
+    int width;
+    int height;
+    bool columns;
+    int first;
+    int last;
+    const cvl_fft_plan_t *plan;
+    cvl_fft_complex_t *buf;
+} cvl_fft_job_t;
+
+static void *cvl_fft_worker(void *arg)
+{
+    cvl_fft_job_t *job = arg;
+    const int n = job->plan->n;
+    cvl_fft_complex_t *line = job->buf;
+    cvl_fft_complex_t *out = job->buf + n;
+    cvl_fft_complex_t *t = job->buf + 2 * n;
+
+    for (int l = job->first; l < job->last; l++)
+    {
+	if (job->columns)
+	{
+	    /* Column x of channel c */
+	    int c = l / job->width;
+	    int x = l % job->width;
+	    cvl_fft_complex_t *base = job->data + (size_t)c * job->width * job->height + x;
+	    for (int y = 0; y < n; y++)
+		line[y] = base[(size_t)y * job->width];
+	    cvl_fft_cpu_1d(out, line, 1, n, job->plan->factors, job->plan, 1, t);
+	    for (int y = 0; y < n; y++)
+		base[(size_t)y * job->width] = out[y];
+	}
+	else
+	{
+	    cvl_fft_complex_t *base = job->data + (size_t)l * job->width;
+	    cvl_fft_cpu_1d(out, base, 1, n, job->plan->factors, job->plan, 1, t);
+	    memcpy(base, out, n * sizeof(cvl_fft_complex_t));
+	}
+    }
+    return NULL;
+}
+
+/* Transforms (re_src, im_src) into (re_dst, im_dst) on the CPU, like
+ * cvl_fft_2d(). The frames can have any size. re_dst or im_dst may be NULL if
+ * that part of the result is not needed. */
+static void cvl_fft_2d_cpu(cvl_frame_t *re_dst, cvl_frame_t *im_dst,
+	cvl_frame_t *re_src, cvl_frame_t *im_src, bool inverse, float scale)
+{
+    int width = cvl_frame_width(re_src);
+    int height = cvl_frame_height(re_src);
+    int channels = (cvl_frame_format(re_src) == CVL_LUM ? 1 : cvl_frame_format(re_src) == CVL_UNKNOWN ? 4 : 3);
+    GLint glformat = (cvl_frame_format(re_src) == CVL_LUM ? GL_LUMINANCE 
+	    : cvl_frame_format(re_src) == CVL_UNKNOWN ? GL_RGBA : GL_RGB);
+    size_t size = (size_t)width * height;
+    int threads = cvl_cpu_threads(channels * cvl_maxi(width, height), 64);
+    size_t bufsize = 3 * (size_t)cvl_maxi(width, height);
+    cvl_fft_plan_t plans[2] = { { 0, { 0 }, NULL }, { 0, { 0 }, NULL } };
+    cvl_fft_complex_t *data = malloc(channels * size * sizeof(cvl_fft_complex_t));
+    cvl_fft_complex_t *buf = malloc(threads * bufsize * sizeof(cvl_fft_complex_t));
+    float *ptr = malloc(channels * size * sizeof(float));
+    if (!data || !buf || !ptr 
+	    || !cvl_fft_plan_init(&plans[0], width, inverse)
+	    || !cvl_fft_plan_init(&plans[1], height, inverse))
+    {
+	free(data);
+	free(buf);
+	free(ptr);
+	free(plans[0].twiddles);
+	free(plans[1].twiddles);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+
+    /* The channels are stored one after the other */
+    for (int part = 0; part < 2; part++)
+    {
+	cvl_frame_t *src = (part == 0 ? re_src : im_src);
+	if (src)
+	{
+	    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+	    glGetTexImage(GL_TEXTURE_2D, 0, glformat, GL_FLOAT, ptr);
+	}
+	for (int c = 0; c < channels; c++)
+	    for (size_t i = 0; i < size; i++)
+		*(part == 0 ? &data[c * size + i].re : &data[c * size + i].im) 
+		    = (src ? ptr[i * channels + c] : 0.0f);
+    }
+
+    cvl_fft_job_t jobs[CVL_CPU_MAX_THREADS];
+    for (int columns = 0; columns < 2; columns++)
+    {
+	int lines = channels * (columns ? width : height);
+	for (int t = 0; t < threads; t++)
+	{
+	    jobs[t].data = data;
+	    jobs[t].width = width;
+	    jobs[t].height = height;
+	    jobs[t].columns = columns;
+	    jobs[t].first = (long long)lines * t / threads;
+	    jobs[t].last = (long long)lines * (t + 1) / threads;
+	    jobs[t].plan = &plans[columns];
+	    jobs[t].buf = buf + t * bufsize;
+	}
+	cvl_cpu_run(cvl_fft_worker, jobs, sizeof(cvl_fft_job_t), threads);
+    }
+    free(buf);
+    free(ptr);
+    free(plans[0].twiddles);
+    free(plans[1].twiddles);
+
+    for (int part = 0; part < 2; part++)
+    {
+	cvl_frame_t *dst = (part == 0 ? re_dst : im_dst);
+	if (!dst)
+	    continue;
+	cvl_frame_t *frame = cvl_frame_new(width, height, cvl_frame_channels(re_src), cvl_frame_format(re_src),
+		CVL_FLOAT, CVL_MEM);
+	if (cvl_error())
+	    break;
+	float *p = cvl_frame_pointer(frame);
+	for (int c = 0; c < channels; c++)
+	    for (size_t i = 0; i < size; i++)
+		p[i * channels + c] = scale * (part == 0 ? data[c * size + i].re : data[c * size + i].im);
+	cvl_copy(dst, frame);
+	cvl_frame_free(frame);
+    }
+    free(data);
+}
+
+/* Chooses the method for a frame of the given size. */
+static cvl_fft_method_t cvl_fft_method(cvl_frame_t *frame, cvl_fft_method_t method)
+{
+    bool pow2 = (cvl_fft_is_pow2(cvl_frame_width(frame)) && cvl_fft_is_pow2(cvl_frame_height(frame)));
+    if (method == CVL_FFT_AUTO)
+	method = (pow2 ? CVL_FFT_GPU : CVL_FFT_CPU);
+    cvl_assert(method != CVL_FFT_GPU || pow2);
+    return method;
+}
+
+/**
+ * \param re		The real part of the result.
+ * \param im		The imaginary part of the result.
+ * \param src		The source frame.
+ *
+ * Computes the discrete Fourier transform of \a src, separately for each
+ * channel. The frames \a re and \a im must have the same size and the same
+ * number of channels as \a src, and they must be of type #CVL_FLOAT. The zero
+ * frequency is stored at (0,0).
+ * See also cvl_ifft().\n
+ * This function is equivalent to cvl_fft_using() with #CVL_FFT_AUTO.
+ */
+void cvl_fft(cvl_frame_t *re, cvl_frame_t *im, cvl_frame_t *src)
+{
+    cvl_fft_using(re, im, src, CVL_FFT_AUTO);
+}
+
+/**
+ * \param re		The real part of the result.
+ * \param im		The imaginary part of the result.
+ * \param src		The source frame.
+ * \param method	The method.
+ *
+ * Computes the discrete Fourier transform like cvl_fft(), using the given
+ * \a method. #CVL_FFT_GPU needs log2(width)+log2(height) passes, and the width
+ * and height must be powers of two. #CVL_FFT_CPU downloads the frame and
+ * transforms its rows and columns with parallel threads. It accepts any size,
+ * but is fastest if the width and height have only the prime factors 2, 3,
+ * and 5. #CVL_FFT_AUTO chooses the GPU if the size allows it.
+ */
+void cvl_fft_using(cvl_frame_t *re, cvl_frame_t *im, cvl_frame_t *src, cvl_fft_method_t method)
+{
+    cvl_assert(re != NULL);
+    cvl_assert(im != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(re != im && re != src && im != src);
+    cvl_assert(cvl_frame_type(re) == CVL_FLOAT);
+    cvl_assert(cvl_frame_type(im) == CVL_FLOAT);
+    cvl_assert(cvl_frame_width(re) == cvl_frame_width(src) && cvl_frame_height(re) == cvl_frame_height(src));
+    cvl_assert(cvl_frame_width(im) == cvl_frame_width(src) && cvl_frame_height(im) == cvl_frame_height(src));
+    if (cvl_error())
+	return;
+
+    if (cvl_fft_method(src, method) == CVL_FFT_CPU)
+	cvl_fft_2d_cpu(re, im, src, NULL, false, 1.0f);
+    else
+	cvl_fft_2d(re, im, src, NULL, false, 1.0f);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param re		The real part of the frequency domain frame.
+ * \param im		The imaginary part of the frequency domain frame.
+ *
+ * Computes the inverse discrete Fourier transform of (\a re, \a im), and
+ * stores its real part in \a dst. The frames must have the same size and the
+ * same number of channels, and \a re and \a im must be of type #CVL_FLOAT.
+ * See also cvl_fft().\n
+ * This function is equivalent to cvl_ifft_using() with #CVL_FFT_AUTO.
+ */
+void cvl_ifft(cvl_frame_t *dst, cvl_frame_t *re, cvl_frame_t *im)
+{
+    cvl_ifft_using(dst, re, im, CVL_FFT_AUTO);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param re		The real part of the frequency domain frame.
+ * \param im		The imaginary part of the frequency domain frame.
+ * \param method	The method.
+ *
+ * Computes the inverse discrete Fourier transform like cvl_ifft(), using the
+ * given \a method. See cvl_fft_using() for the methods.
+ */
+void cvl_ifft_using(cvl_frame_t *dst, cvl_frame_t *re, cvl_frame_t *im, cvl_fft_method_t method)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(re != NULL);
+    cvl_assert(im != NULL);
+    cvl_assert(re != im && dst != re && dst != im);
+    cvl_assert(cvl_frame_type(re) == CVL_FLOAT);
+    cvl_assert(cvl_frame_type(im) == CVL_FLOAT);
+    cvl_assert(cvl_frame_width(re) == cvl_frame_width(dst) && cvl_frame_height(re) == cvl_frame_height(dst));
+    cvl_assert(cvl_frame_width(im) == cvl_frame_width(dst) && cvl_frame_height(im) == cvl_frame_height(dst));
+    if (cvl_error())
+	return;
+
+    float scale = 1.0f / ((float)cvl_frame_width(dst) * (float)cvl_frame_height(dst));
+    if (cvl_fft_method(dst, method) == CVL_FFT_CPU)
+    {
+	cvl_fft_2d_cpu(dst, NULL, re, im, true, scale);
+	return;
+    }
+
+    /* The transform needs float frames as render targets */
+    bool direct = (cvl_frame_type(dst) == CVL_FLOAT);
+    cvl_frame_t *result_re = (direct ? dst : cvl_frame_new_tpl(re));
+    cvl_frame_t *result_im = cvl_frame_new_tpl(im);
+    cvl_fft_2d(result_re, result_im, re, im, true, scale);
+    if (!direct)
+    {
+	cvl_copy(dst, result_re);
+	cvl_frame_free(result_re);
+    }
+    cvl_frame_free(result_im);
+}
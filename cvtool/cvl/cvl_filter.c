@@ -27,9 +27,24 @@
  * Filtering frames.
  */
 
+/**
+ * \typedef cvl_integral_method_t
+ * The method used to compute an integral image.
+ */
+/** \var CVL_INTEGRAL_AUTO
+ * Choose the method automatically. */
+/** \var CVL_INTEGRAL_GPU
+ * Compute the prefix sums on the GPU. */
+/** \var CVL_INTEGRAL_CPU
+ * Compute the prefix sums on the CPU. */
+
 #include "config.h"
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
 
 #include <GL/glew.h>
 
@@ -37,21 +52,316 @@
 #include "cvl_intern.h"
 #include "cvl/cvl.h"
 
+#include "glsl/filter/bilateral_grid_blur.glsl.h"
+#include "glsl/filter/bilateral_grid_slice.glsl.h"
+#include "glsl/filter/bilateral_grid_splat.glsl.h"
 #include "glsl/filter/convolve.glsl.h"
 #include "glsl/filter/convolve_separable.glsl.h"
 #include "glsl/filter/convolve3d.glsl.h"
 #include "glsl/filter/convolve3d_separable.glsl.h"
+#include "glsl/filter/convolve_fft_multiply.glsl.h"
+#include "glsl/filter/convolve_fft_shift.glsl.h"
+#include "glsl/filter/convolve_lowrank_h.glsl.h"
+#include "glsl/filter/convolve_lowrank_v.glsl.h"
+#include "glsl/filter/gauss_recursive.glsl.h"
+#include "glsl/filter/integral_init.glsl.h"
+#include "glsl/filter/integral_scan.glsl.h"
+#include "glsl/filter/mean_integral.glsl.h"
 #include "glsl/filter/min.glsl.h"
 #include "glsl/filter/min3d.glsl.h"
 #include "glsl/filter/max.glsl.h"
 #include "glsl/filter/max3d.glsl.h"
+#include "glsl/filter/minmax_block.glsl.h"
+#include "glsl/filter/minmax_block_scan.glsl.h"
 #include "glsl/filter/median.glsl.h"
+#include "glsl/filter/median_count.glsl.h"
 #include "glsl/filter/median3d.glsl.h"
 #include "glsl/filter/median_separated.glsl.h"
 #include "glsl/filter/median3d_separated.glsl.h"
 #include "glsl/filter/laplace.glsl.h"
 #include "glsl/filter/unsharpmask.glsl.h"
+#include "glsl/filter/temporal.glsl.h"
+
+
+/* The 3D filters need the frames of their temporal window as textures. If
+ * there are more frames than texture units, they are passed as a texture
+ * array instead, if the GL supports this. */
+static bool cvl_filter_use_texture_array(int t_len)
+{
+    cvl_context_t *ctx = cvl_context();
+    return (t_len > ctx->cvl_gl_max_texture_units && ctx->cvl_gl_max_texture_array_layers > 0);
+}
+
+static void cvl_filter_transform_window(cvl_frame_t *dst, cvl_frame_t **framebuf, int t_len, bool array)
+{
+    if (array)
+	cvl_transform_array(dst, framebuf, t_len, "textures");
+    else
+	cvl_transform_multi(&dst, 1, framebuf, t_len, "textures");
+}
+
+
+/* Returns the smallest size of at least n that is a power of two, or that has
+ * no prime factors other than 2, 3, and 5. */
+static int cvl_convolve_fft_size(int n, bool pow2)
+{
+    for (int size = n; ; size++)
+    {
+	int m = size;
+	while (m % 2 == 0)
+	    m /= 2;
+	if (!pow2)
+	{
+	    while (m % 3 == 0)
+		m /= 3;
+	    while (m % 5 == 0)
+		m /= 5;
+	}
+	if (m == 1)
+	    return size;
+    }
+}
+
+/* Applies a convolution kernel with the FFT: the source is padded with k_h
+ * and k_v clamped pixels on each side and to a size that the FFT handles
+ * well, and the kernel is mirrored and wrapped around so that its center is at
+ * (0,0). The product of both spectra is the cyclic convolution, and the
+ * padding makes sure that the wrap-around does not affect the result. The cost
+ * grows with log(w*h) per pixel instead of h_len*v_len. Returns false if the
+ * padded frame is too large.
+ * The GPU transform needs power of two sizes. If sizes with the factors 2, 3,
+ * and 5 save at least a quarter of the pixels, the CPU transform is used
+ * instead. */
+static bool cvl_convolve_fft(cvl_frame_t *dst, cvl_frame_t *src,
+	const float *kernel, int h_len, int v_len, float factor)
+{
+    cvl_context_t *ctx = cvl_context();
+    int k_h = h_len / 2;
+    int k_v = v_len / 2;
+    int width = cvl_convolve_fft_size(cvl_frame_width(src) + 2 * k_h, true);
+    int height = cvl_convolve_fft_size(cvl_frame_height(src) + 2 * k_v, true);
+    int smooth_width = cvl_convolve_fft_size(cvl_frame_width(src) + 2 * k_h, false);
+    int smooth_height = cvl_convolve_fft_size(cvl_frame_height(src) + 2 * k_v, false);
+    if (4 * (long long)smooth_width * smooth_height <= 3 * (long long)width * height)
+    {
+	width = smooth_width;
+	height = smooth_height;
+    }
+    if (width > ctx->cvl_gl_max_tex_size || height > ctx->cvl_gl_max_tex_size
+	    || ctx->cvl_gl_max_render_targets < 2 || ctx->cvl_gl_max_texture_units < 4)
+	return false;
+
+    cvl_frame_t *kern = cvl_frame_new(width, height, 1, CVL_LUM, CVL_FLOAT, CVL_MEM);
+    float *k = cvl_frame_pointer(kern);
+    memset(k, 0, width * height * sizeof(float));
+    for (int r = -k_v; r <= k_v; r++)
+	for (int c = -k_h; c <= k_h; c++)
+	    k[((height - r) % height) * width + (width - c) % width] = kernel[(r + k_v) * h_len + (c + k_h)];
+    cvl_frame_t *kern_re = cvl_frame_new_tpl(kern);
+    cvl_frame_t *kern_im = cvl_frame_new_tpl(kern);
+    cvl_fft(kern_re, kern_im, kern);
+    cvl_frame_free(kern);
+
+    cvl_frame_t *padded = cvl_frame_new(width, height, cvl_frame_channels(src),
+	    cvl_frame_format(src), CVL_FLOAT, CVL_TEXTURE);
+    GLuint prg;
+    if ((prg = cvl_gl_program_cache_get("cvl_convolve_fft_shift")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_convolve_fft_shift", NULL, CVL_CONVOLVE_FFT_SHIFT_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_convolve_fft_shift", prg);
+    }
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), width, height);
+    glUniform2f(glGetUniformLocation(prg, "tex_size"), cvl_frame_width(src), cvl_frame_height(src));
+    glUniform2f(glGetUniformLocation(prg, "shift"), k_h, k_v);
+    glUniform1f(glGetUniformLocation(prg, "factor"), 1.0f);
+    cvl_transform(padded, src);
+    cvl_frame_t *re = cvl_frame_new_tpl(padded);
+    cvl_frame_t *im = cvl_frame_new_tpl(padded);
+    cvl_fft(re, im, padded);
+
+    if ((prg = cvl_gl_program_cache_get("cvl_convolve_fft_multiply")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_convolve_fft_multiply", NULL, CVL_CONVOLVE_FFT_MULTIPLY_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_convolve_fft_multiply", prg);
+    }
+    glUseProgram(prg);
+    cvl_frame_t *product_re = padded;
+    cvl_frame_t *product_im = cvl_frame_new_tpl(padded);
+    cvl_frame_t *srcs[4] = { re, im, kern_re, kern_im };
+    cvl_frame_t *dsts[2] = { product_re, product_im };
+    cvl_transform_multi(dsts, 2, srcs, 4, "textures");
+    cvl_frame_free(kern_re);
+    cvl_frame_free(kern_im);
+    cvl_ifft(re, product_re, product_im);
+
+    prg = cvl_gl_program_cache_get("cvl_convolve_fft_shift");
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), cvl_frame_width(dst), cvl_frame_height(dst));
+    glUniform2f(glGetUniformLocation(prg, "tex_size"), width, height);
+    glUniform2f(glGetUniformLocation(prg, "shift"), -k_h, -k_v);
+    glUniform1f(glGetUniformLocation(prg, "factor"), factor);
+    cvl_transform(dst, re);
+
+    cvl_frame_free(re);
+    cvl_frame_free(im);
+    cvl_frame_free(product_re);
+    cvl_frame_free(product_im);
+    cvl_check_errors();
+    return true;
+}
+
+/* Approximates factor * kernel by a sum of at most max_rank separable kernels,
+ * so that the sum of the absolute values of the remaining kernel is at most
+ * tolerance. This bounds the error of the result for values in [0,1]. The
+ * separable kernels are found one after the other: power iteration gives the
+ * dominant singular vectors of the remaining kernel matrix, and their outer
+ * product is subtracted from it. The horizontal vectors are stored in h and
+ * the vertical vectors in v. Returns the number of separable kernels, or 0 if
+ * max_rank of them are not enough. */
+static int cvl_convolve_lowrank_decompose(const float *kernel, int h_len, int v_len, float factor,
+	int max_rank, float tolerance, float *h, float *v)
+{
+    double *a = malloc(h_len * v_len * sizeof(double));
+    double *x = malloc(h_len * sizeof(double));
+    double *y = malloc(v_len * sizeof(double));
+    double *z = malloc(h_len * sizeof(double));
+    if (!a || !x || !y || !z)
+    {
+	free(a);
+	free(x);
+	free(y);
+	free(z);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return 0;
+    }
+    for (int i = 0; i < h_len * v_len; i++)
+	a[i] = factor * kernel[i];
+
+    int rank = 0;
+    for (;;)
+    {
+	double error = 0.0;
+	double max_norm = 0.0;
+	int max_row = 0;
+	for (int r = 0; r < v_len; r++)
+	{
+	    double norm = 0.0;
+	    for (int c = 0; c < h_len; c++)
+	    {
+		error += fabs(a[r * h_len + c]);
+		norm += a[r * h_len + c] * a[r * h_len + c];
+	    }
+	    if (norm > max_norm)
+	    {
+		max_norm = norm;
+		max_row = r;
+	    }
+	}
+	if (error <= tolerance)
+	    break;
+	if (rank == max_rank)
+	{
+	    rank = 0;
+	    break;
+	}
+	/* Start with the largest row of the remaining kernel. */
+	for (int c = 0; c < h_len; c++)
+	    x[c] = a[max_row * h_len + c] / sqrt(max_norm);
+	for (int iteration = 0; iteration < 100; iteration++)
+	{
+	    for (int r = 0; r < v_len; r++)
+	    {
+		y[r] = 0.0;
+		for (int c = 0; c < h_len; c++)
+		    y[r] += a[r * h_len + c] * x[c];
+	    }
+	    double norm = 0.0;
+	    for (int c = 0; c < h_len; c++)
+	    {
+		z[c] = 0.0;
+		for (int r = 0; r < v_len; r++)
+		    z[c] += a[r * h_len + c] * y[r];
+		norm += z[c] * z[c];
+	    }
+	    norm = sqrt(norm);
+	    double change = 0.0;
+	    for (int c = 0; c < h_len; c++)
+	    {
+		change = fmax(change, fabs(z[c] / norm - x[c]));
+		x[c] = z[c] / norm;
+	    }
+	    if (change < 1e-12)
+		break;
+	}
+	for (int r = 0; r < v_len; r++)
+	{
+	    y[r] = 0.0;
+	    for (int c = 0; c < h_len; c++)
+		y[r] += a[r * h_len + c] * x[c];
+	}
+	for (int r = 0; r < v_len; r++)
+	    for (int c = 0; c < h_len; c++)
+		a[r * h_len + c] -= y[r] * x[c];
+	for (int c = 0; c < h_len; c++)
+	    h[rank * h_len + c] = x[c];
+	for (int r = 0; r < v_len; r++)
+	    v[rank * v_len + r] = y[r];
+	rank++;
+    }
+
+    free(a);
+    free(x);
+    free(y);
+    free(z);
+    return rank;
+}
+
+/* Applies the sum of rank separable kernels with the horizontal vectors h and
+ * the vertical vectors v in two passes: the horizontal pass writes the result
+ * of each horizontal vector to its own render target, and the vertical pass
+ * applies the vertical vectors to them and sums up. */
+static void cvl_convolve_lowrank(cvl_frame_t *dst, cvl_frame_t *src,
+	const float *h, int h_len, const float *v, int v_len, int rank)
+{
+    cvl_frame_t *tmps[rank];
+    for (int j = 0; j < rank; j++)
+	tmps[j] = cvl_frame_new(cvl_frame_width(src), cvl_frame_height(src), cvl_frame_channels(src),
+		cvl_frame_format(src), CVL_FLOAT, CVL_TEXTURE);
+
+    GLuint prg;
+    char *prgname = cvl_asprintf("cvl_convolve_lowrank_h_k=%d_rank=%d", h_len / 2, rank);
+    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    {
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_CONVOLVE_LOWRANK_H_GLSL_STR), "$k=%d, $rank=%d", h_len / 2, rank);
+	prg = cvl_gl_program_new_src(prgname, NULL, src);
+	cvl_gl_program_cache_put(prgname, prg);
+	free(src);
+    }
+    free(prgname);
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "step"), 1.0f / (float)cvl_frame_width(src), 0.0f);
+    glUniform1fv(glGetUniformLocation(prg, "mask"), rank * h_len, h);
+    cvl_transform_multi(tmps, rank, &src, 1, "textures");
+
+    prgname = cvl_asprintf("cvl_convolve_lowrank_v_k=%d_rank=%d", v_len / 2, rank);
+    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    {
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_CONVOLVE_LOWRANK_V_GLSL_STR), "$k=%d, $rank=%d", v_len / 2, rank);
+	prg = cvl_gl_program_new_src(prgname, NULL, src);
+	cvl_gl_program_cache_put(prgname, prg);
+	free(src);
+    }
+    free(prgname);
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "step"), 0.0f, 1.0f / (float)cvl_frame_height(src));
+    glUniform1fv(glGetUniformLocation(prg, "mask"), rank * v_len, v);
+    cvl_transform_multi(&dst, 1, tmps, rank, "textures");
 
+    for (int j = 0; j < rank; j++)
+	cvl_frame_free(tmps[j]);
+    cvl_check_errors();
+}
 
 /**
  * \param dst		The destination frame.
@@ -83,6 +393,73 @@ void cvl_convolve(cvl_frame_t *dst, cvl_frame_t *src, const float *kernel, int h
 	factor += kernel[i];
     factor = 1.0f / factor;
 
+    GLint max_uniforms;
+    glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &max_uniforms);
+
+    /* Kernels of low rank are applied as a sum of separable kernels if that
+     * needs clearly less texture reads. The remaining error is below the
+     * quantization step of 8 bit frames. */
+    cvl_context_t *ctx = cvl_context();
+    const float lowrank_tolerance = 1.0f / 1024.0f;
+    int max_rank = cvl_min3i(4, ctx->cvl_gl_max_render_targets, ctx->cvl_gl_max_texture_units);
+    while (max_rank > 0 && (2 * max_rank * (h_len + v_len) > h_len * v_len
+		|| max_rank * cvl_maxi(h_len, v_len) > max_uniforms - 16))
+	max_rank--;
+    if (max_rank > 0 && isfinite(factor))
+    {
+	/* The decomposition is remembered, so that applying the same kernel
+	 * to a stream of frames computes it only once. */
+	if (!ctx->cvl_convolve_lowrank_kernel
+		|| ctx->cvl_convolve_lowrank_h_len != h_len
+		|| ctx->cvl_convolve_lowrank_v_len != v_len
+		|| ctx->cvl_convolve_lowrank_max_rank != max_rank
+		|| memcmp(ctx->cvl_convolve_lowrank_kernel, kernel, h_len * v_len * sizeof(float)) != 0)
+	{
+	    free(ctx->cvl_convolve_lowrank_kernel);
+	    free(ctx->cvl_convolve_lowrank_h);
+	    free(ctx->cvl_convolve_lowrank_v);
+	    ctx->cvl_convolve_lowrank_kernel = malloc(h_len * v_len * sizeof(float));
+	    ctx->cvl_convolve_lowrank_h = malloc(max_rank * h_len * sizeof(float));
+	    ctx->cvl_convolve_lowrank_v = malloc(max_rank * v_len * sizeof(float));
+	    if (!ctx->cvl_convolve_lowrank_kernel
+		    || !ctx->cvl_convolve_lowrank_h || !ctx->cvl_convolve_lowrank_v)
+	    {
+		free(ctx->cvl_convolve_lowrank_kernel);
+		ctx->cvl_convolve_lowrank_kernel = NULL;
+		cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+		return;
+	    }
+	    memcpy(ctx->cvl_convolve_lowrank_kernel, kernel, h_len * v_len * sizeof(float));
+	    ctx->cvl_convolve_lowrank_h_len = h_len;
+	    ctx->cvl_convolve_lowrank_v_len = v_len;
+	    ctx->cvl_convolve_lowrank_max_rank = max_rank;
+	    ctx->cvl_convolve_lowrank_rank = cvl_convolve_lowrank_decompose(kernel,
+		    h_len, v_len, factor, max_rank, lowrank_tolerance,
+		    ctx->cvl_convolve_lowrank_h, ctx->cvl_convolve_lowrank_v);
+	    if (cvl_error())
+	    {
+		free(ctx->cvl_convolve_lowrank_kernel);
+		ctx->cvl_convolve_lowrank_kernel = NULL;
+		return;
+	    }
+	}
+	int rank = ctx->cvl_convolve_lowrank_rank;
+	if (rank > 0)
+	{
+	    cvl_convolve_lowrank(dst, src, ctx->cvl_convolve_lowrank_h, h_len,
+		    ctx->cvl_convolve_lowrank_v, v_len, rank);
+	    return;
+	}
+    }
+
+    /* The shader loops over the whole kernel, which is passed in uniform
+     * variables. Large kernels are faster with the FFT, and kernels that do
+     * not fit into the uniform variables need it. */
+    const int min_fft_size = 25 * 25;
+    if ((h_len * v_len >= min_fft_size || h_len * v_len > max_uniforms - 16)
+	    && cvl_convolve_fft(dst, src, kernel, h_len, v_len, factor))
+	return;
+
     GLuint prg;
     char *prgname = cvl_asprintf("cvl_convolve_hk=%d_vk=%d", k_h, k_v);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
@@ -242,12 +619,13 @@ void cvl_convolve3d(cvl_frame_t *dst, cvl_frame_t **srcs,
 	    framebuf[i] = srcs[last_known];
     }
 
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_convolve3d_k_h=%d_k_v=%d_k_t=%d", k_h, k_v, k_t);
+    char *prgname = cvl_asprintf("cvl_convolve3d_k_h=%d_k_v=%d_k_t=%d_array=%d", k_h, k_v, k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
 	char *src = cvl_gl_srcprep(cvl_strdup(CVL_CONVOLVE3D_GLSL_STR),
-		"$k_h=%d, $k_v=%d, $k_t=%d", k_h, k_v, k_t);
+		"$k_h=%d, $k_v=%d, $k_t=%d, $array=%d", k_h, k_v, k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
@@ -256,7 +634,9 @@ void cvl_convolve3d(cvl_frame_t *dst, cvl_frame_t **srcs,
     glUseProgram(prg);
     glUniform1fv(glGetUniformLocation(prg, "kernel"), h_len * v_len * t_len, kernel);
     glUniform1f(glGetUniformLocation(prg, "factor"), factor);
-    cvl_transform_multi(&dst, 1, framebuf, t_len, "textures");
+    glUniform1f(glGetUniformLocation(prg, "step_h"), 1.0f / (float)cvl_frame_width(srcs[t_len / 2]));
+    glUniform1f(glGetUniformLocation(prg, "step_v"), 1.0f / (float)cvl_frame_height(srcs[t_len / 2]));
+    cvl_filter_transform_window(dst, framebuf, t_len, array);
     cvl_check_errors();
 }
 
@@ -278,6 +658,8 @@ void cvl_convolve3d(cvl_frame_t *dst, cvl_frame_t **srcs,
  * greater than \a t_len / 2) can be limited; in this case, some array entries
  * can be NULL. This function will use clamping in the t direction to compensate that.
  * The dimensions \a h_len, \a v_len, \a t_len must all be odd.
+ * If \a t_len exceeds the number of texture units, the frames are passed to
+ * the GL as a texture array; see cvl_transform_array().
  */
 void cvl_convolve3d_separable(cvl_frame_t *dst, cvl_frame_t **srcs, 
 	const float *h, int h_len, const float *v, int v_len, const float *t, int t_len)
@@ -330,11 +712,13 @@ void cvl_convolve3d_separable(cvl_frame_t *dst, cvl_frame_t **srcs,
     }
 
     /* t */
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_convolve3d_separable_k_t=%d", k_t);
+    char *prgname = cvl_asprintf("cvl_convolve3d_separable_k_t=%d_array=%d", k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_CONVOLVE3D_SEPARABLE_GLSL_STR), "$k_t=%d", k_t);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_CONVOLVE3D_SEPARABLE_GLSL_STR),
+		"$k_t=%d, $array=%d", k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
@@ -343,7 +727,7 @@ void cvl_convolve3d_separable(cvl_frame_t *dst, cvl_frame_t **srcs,
     glUseProgram(prg);
     glUniform1fv(glGetUniformLocation(prg, "mask_t"), t_len, t);
     glUniform1f(glGetUniformLocation(prg, "factor_t"), factor_t);
-    cvl_transform_multi(&tmpframe, 1, framebuf, t_len, "textures");
+    cvl_filter_transform_window(tmpframe, framebuf, t_len, array);
     cvl_check_errors();
 
     /* h, v */
@@ -352,6 +736,232 @@ void cvl_convolve3d_separable(cvl_frame_t *dst, cvl_frame_t **srcs,
 }
 
 
+/* A part of the CPU integral image computation: the rows first to last-1 of
+ * data are initialized from src and summed up, or the columns first to last-1
+ * of data are summed up. */
+typedef struct
+{
+    float *data;
+    const float *src;
+    int width;
+    int height;
+    int src_width;
+    int src_height;
+    int channels;
+    int shift_h;
+    int shift_v;
+    bool zero_border;
+    float offset;
+    bool columns;
+    int first;
+    int last;
+} cvl_integral_job_t;
+
+static void *cvl_integral_worker(void *arg)
+{
+    cvl_integral_job_t *job = arg;
+    const int channels = job->channels;
+
+    if (job->columns)
+    {
+	/* Each row adds the previous one, which keeps the memory accesses
+	 * sequential and lets the compiler vectorize the inner loop. */
+	for (int y = 1; y < job->height; y++)
+	{
+	    float *restrict row = job->data + (size_t)y * job->width * channels;
+	    const float *restrict prev = row - job->width * channels;
+	    for (int i = job->first * channels; i < job->last * channels; i++)
+		row[i] += prev[i];
+	}
+	return NULL;
+    }
+
+    for (int y = job->first; y < job->last; y++)
+    {
+	float *row = job->data + (size_t)y * job->width * channels;
+	const float *src_row = job->src 
+	    + (size_t)cvl_clampi(y - job->shift_v, 0, job->src_height - 1) * job->src_width * channels;
+	double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+	for (int x = 0; x < job->width; x++)
+	{
+	    const float *p = src_row + cvl_clampi(x - job->shift_h, 0, job->src_width - 1) * channels;
+	    bool inside = !job->zero_border || (x > 0 && y > 0);
+	    for (int c = 0; c < channels; c++)
+	    {
+		if (inside)
+		    sum[c] += p[c] - job->offset;
+		row[x * channels + c] = sum[c];
+	    }
+	}
+    }
+    return NULL;
+}
+
+/* Computes the integral image like cvl_integral(), on the CPU. */
+static void cvl_integral_cpu(cvl_frame_t *dst, cvl_frame_t *src,
+	int shift_h, int shift_v, bool zero_border, float offset)
+{
+    int width = cvl_frame_width(dst);
+    int height = cvl_frame_height(dst);
+    int src_width = cvl_frame_width(src);
+    int src_height = cvl_frame_height(src);
+    int channels = (cvl_frame_format(src) == CVL_LUM ? 1 : cvl_frame_format(src) == CVL_UNKNOWN ? 4 : 3);
+    GLint glformat = (cvl_frame_format(src) == CVL_LUM ? GL_LUMINANCE 
+	    : cvl_frame_format(src) == CVL_UNKNOWN ? GL_RGBA : GL_RGB);
+    cvl_frame_t *frame = cvl_frame_new(width, height, cvl_frame_channels(src), cvl_frame_format(src),
+	    CVL_FLOAT, CVL_MEM);
+    if (cvl_error())
+	return;
+    float *data = cvl_frame_pointer(frame);
+    float *ptr = malloc((size_t)src_width * src_height * channels * sizeof(float));
+    if (!ptr)
+    {
+	cvl_frame_free(frame);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+    glGetTexImage(GL_TEXTURE_2D, 0, glformat, GL_FLOAT, ptr);
+
+    cvl_integral_job_t jobs[CVL_CPU_MAX_THREADS];
+    for (int pass = 0; pass < 2; pass++)
+    {
+	int lines = (pass == 0 ? height : width);
+	// Do not start threads for less than 64K pixels each
+	int threads = cvl_cpu_threads(width * height, 65536);
+	for (int t = 0; t < threads; t++)
+	{
+	    jobs[t].data = data;
+	    jobs[t].src = ptr;
+	    jobs[t].width = width;
+	    jobs[t].height = height;
+	    jobs[t].src_width = src_width;
+	    jobs[t].src_height = src_height;
+	    jobs[t].channels = channels;
+	    jobs[t].shift_h = shift_h;
+	    jobs[t].shift_v = shift_v;
+	    jobs[t].zero_border = zero_border;
+	    jobs[t].offset = offset;
+	    jobs[t].columns = (pass == 1);
+	    jobs[t].first = (long long)lines * t / threads;
+	    jobs[t].last = (long long)lines * (t + 1) / threads;
+	}
+	cvl_cpu_run(cvl_integral_worker, jobs, sizeof(cvl_integral_job_t), threads);
+    }
+    free(ptr);
+
+    cvl_copy(dst, frame);
+    cvl_frame_free(frame);
+}
+
+/* Computes the integral image of src in dst. Pixel (x,y) of dst is first set
+ * to pixel (x-shift_h,y-shift_v) of src (clamped to the borders) minus the
+ * offset, or to zero if zero_border is set and x or y is zero. The prefix sums
+ * are then computed with log2(width)+log2(height) passes that each add the
+ * value at a distance of 1, 2, 4, ... pixels (Hillis and Steele), or on the
+ * CPU. */
+static void cvl_integral(cvl_frame_t *dst, cvl_frame_t *src,
+	int shift_h, int shift_v, bool zero_border, float offset, cvl_integral_method_t method)
+{
+    if (method == CVL_INTEGRAL_CPU)
+    {
+	cvl_integral_cpu(dst, src, shift_h, shift_v, zero_border, offset);
+	return;
+    }
+
+    int width = cvl_frame_width(dst);
+    int height = cvl_frame_height(dst);
+    int passes = 0;
+    for (int s = 1; s < width; s *= 2)
+	passes++;
+    for (int s = 1; s < height; s *= 2)
+	passes++;
+    /* Choose the first frame so that the last pass renders into dst */
+    cvl_frame_t *tmp = cvl_frame_new_tpl(dst);
+    cvl_frame_t *frames[2] = { dst, tmp };
+    int current = passes % 2;
+
+    GLuint prg;
+    if ((prg = cvl_gl_program_cache_get("cvl_integral_init")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_integral_init", NULL, CVL_INTEGRAL_INIT_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_integral_init", prg);
+    }
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "src_size"), cvl_frame_width(src), cvl_frame_height(src));
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), width, height);
+    glUniform2f(glGetUniformLocation(prg, "shift"), shift_h, shift_v);
+    glUniform1f(glGetUniformLocation(prg, "zero_border"), zero_border ? 1.0f : 0.0f);
+    glUniform1f(glGetUniformLocation(prg, "offset"), offset);
+    cvl_transform(frames[current], src);
+
+    if ((prg = cvl_gl_program_cache_get("cvl_integral_scan")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_integral_scan", NULL, CVL_INTEGRAL_SCAN_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_integral_scan", prg);
+    }
+    glUseProgram(prg);
+    for (int s = 1; s < width; s *= 2)
+    {
+	glUniform2f(glGetUniformLocation(prg, "stride"), (float)s / (float)width, 0.0f);
+	cvl_transform(frames[1 - current], frames[current]);
+	current = 1 - current;
+    }
+    for (int s = 1; s < height; s *= 2)
+    {
+	glUniform2f(glGetUniformLocation(prg, "stride"), 0.0f, (float)s / (float)height);
+	cvl_transform(frames[1 - current], frames[current]);
+	current = 1 - current;
+    }
+    cvl_frame_free(tmp);
+    cvl_check_errors();
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ *
+ * Computes the integral image (summed-area table) of \a src: each pixel of
+ * \a dst is the sum of all pixels of \a src above and left of it, including
+ * the pixel itself, computed separately for each channel.\n
+ * \a dst must have the same size as \a src and must be of type #CVL_FLOAT.
+ * The sum over any rectangle can then be computed from four pixels of \a dst.\n
+ * This function is equivalent to cvl_integral_image_using() with
+ * #CVL_INTEGRAL_AUTO.
+ */
+void cvl_integral_image(cvl_frame_t *dst, cvl_frame_t *src)
+{
+    cvl_integral_image_using(dst, src, CVL_INTEGRAL_AUTO);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param method	The method.
+ *
+ * Computes the integral image like cvl_integral_image(), using the given
+ * \a method. #CVL_INTEGRAL_GPU needs log2(width)+log2(height) passes.
+ * #CVL_INTEGRAL_CPU downloads the frame and sums up the rows and then the
+ * columns with parallel threads; the row sums are accumulated in double
+ * precision. #CVL_INTEGRAL_AUTO chooses the GPU, so that the frame does not
+ * need to be downloaded. The cvl-bench operations integral_image and
+ * integral_image_cpu compare both methods.
+ */
+void cvl_integral_image_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_integral_method_t method)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(cvl_frame_type(dst) == CVL_FLOAT);
+    cvl_assert(cvl_frame_width(dst) == cvl_frame_width(src));
+    cvl_assert(cvl_frame_height(dst) == cvl_frame_height(src));
+    if (cvl_error())
+	return;
+
+    cvl_integral(dst, src, 0, 0, false, 0.0f, method);
+}
+
+
 /**
  * \param dst		The destination frame.
  * \param src		The source frame.
@@ -372,6 +982,43 @@ void cvl_mean(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
     if (cvl_error())
 	return;
     
+    /* For small masks, the separable convolution is faster than the integral
+     * image. Very large masks need the integral image, since the convolution
+     * mask must fit into the uniform variables of the shader. */
+    const int min_integral_k = 16;
+    cvl_context_t *ctx = cvl_context();
+    int sat_width = cvl_frame_width(src) + 2 * k_h + 1;
+    int sat_height = cvl_frame_height(src) + 2 * k_v + 1;
+    if (k_h + k_v >= 2 * min_integral_k
+	    && sat_width <= ctx->cvl_gl_max_tex_size && sat_height <= ctx->cvl_gl_max_tex_size)
+    {
+	/* The integral image is padded with k_h and k_v clamped pixels on each
+	 * side, so that the borders are handled like in the convolution, and
+	 * with a leading zero row and column, so that each box sum needs exactly
+	 * four lookups. Values are centered around 0.5 to reduce cancellation in
+	 * the differences of large sums. */
+	const float offset = 0.5f;
+	cvl_frame_t *sat = cvl_frame_new(sat_width, sat_height, cvl_frame_channels(src),
+		cvl_frame_format(src), CVL_FLOAT, CVL_TEXTURE);
+	cvl_integral(sat, src, k_h + 1, k_v + 1, true, offset, CVL_INTEGRAL_AUTO);
+	GLuint prg;
+	if ((prg = cvl_gl_program_cache_get("cvl_mean_integral")) == 0)
+	{
+	    prg = cvl_gl_program_new_src("cvl_mean_integral", NULL, CVL_MEAN_INTEGRAL_GLSL_STR);
+	    cvl_gl_program_cache_put("cvl_mean_integral", prg);
+	}
+	glUseProgram(prg);
+	glUniform2f(glGetUniformLocation(prg, "dst_size"), cvl_frame_width(dst), cvl_frame_height(dst));
+	glUniform2f(glGetUniformLocation(prg, "tex_size"), sat_width, sat_height);
+	glUniform2f(glGetUniformLocation(prg, "window"), 2 * k_h + 1, 2 * k_v + 1);
+	glUniform1f(glGetUniformLocation(prg, "factor"), 1.0f / (float)((2 * k_h + 1) * (2 * k_v + 1)));
+	glUniform1f(glGetUniformLocation(prg, "offset"), offset);
+	cvl_transform(dst, sat);
+	cvl_frame_free(sat);
+	cvl_check_errors();
+	return;
+    }
+
     float m_h[2 * k_h + 1];
     for (int i = 0; i < 2 * k_h + 1; i++)
 	m_h[i] = 1.0f;
@@ -420,6 +1067,156 @@ void cvl_mean3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t)
 }
 
 
+/**
+ * \param dst			The destination frame.
+ * \param src			The source frame.
+ * \param sigma_spatial		Spatial sigma, in pixels.
+ * \param sigma_range		Range sigma, in channel values.
+ *
+ * Applies a bilateral filter: each pixel becomes the average of its
+ * neighborhood, weighted both by the spatial distance (a Gauss function with
+ * \a sigma_spatial) and by the difference of the values (a Gauss function
+ * with \a sigma_range). All channels are filtered independently.\n
+ * The filter is implemented with the bilateral grid, so its cost does not
+ * depend on \a sigma_spatial, and it grows linearly with the value range of
+ * the frame divided by \a sigma_range. See also:
+ * S. Paris and F. Durand, A Fast Approximation of the Bilateral Filter using
+ * a Signal Processing Approach, Proc. ECCV 2006, pp. 568-580.
+ * J. Chen, S. Paris, and F. Durand, Real-time Edge-Aware Image Processing
+ * with the Bilateral Grid, Proc. ACM SIGGRAPH 2007.
+ */
+void cvl_bilateral(cvl_frame_t *dst, cvl_frame_t *src, float sigma_spatial, float sigma_range)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(sigma_spatial > 0.0f);
+    cvl_assert(sigma_range > 0.0f);
+    if (cvl_error())
+	return;
+
+    /* The grid samples the spatial dimensions and the value range with the
+     * sigma values, but with at least one pixel and with at most
+     * max_depth slices. The Gauss blur of the grid then has a sigma of
+     * one cell, or less if the sampling had to be coarser. The slices are
+     * stored as tiles of a texture, which must not exceed the maximum texture
+     * size. The grid also must not have more than max_cells cells, so that
+     * its four textures need at most as much memory as four 2048x2048
+     * frames. Both sampling distances are increased until the grid fits. */
+    const int max_depth = 256;
+    const long long max_cells = 2048 * 2048;
+    cvl_context_t *ctx = cvl_context();
+    float range_min[4], range_max[4];
+    cvl_reduce(src, CVL_REDUCE_MIN, -1, range_min);
+    cvl_reduce(src, CVL_REDUCE_MAX, -1, range_max);
+    float range = 0.0f;
+    for (int c = 0; c < cvl_frame_channels(src); c++)
+	range = cvl_maxf(range, range_max[c] - range_min[c]);
+    float sampling_spatial = cvl_maxf(1.0f, sigma_spatial);
+    float sampling_range = cvl_maxf(sigma_range, range / (float)(max_depth - 2));
+    int grid_width, grid_height, grid_depth;
+    int tiles_per_row, tex_width, tex_height;
+    for (;;)
+    {
+	grid_width = (int)((cvl_frame_width(src) - 0.5f) / sampling_spatial) + 2;
+	grid_height = (int)((cvl_frame_height(src) - 0.5f) / sampling_spatial) + 2;
+	grid_depth = (int)(range / sampling_range) + 2;
+	tiles_per_row = cvl_maxi(1, cvl_mini(grid_depth, ctx->cvl_gl_max_tex_size / grid_width));
+	int tile_rows = (grid_depth + tiles_per_row - 1) / tiles_per_row;
+	tex_width = tiles_per_row * grid_width;
+	tex_height = tile_rows * grid_height;
+	if (tex_width <= ctx->cvl_gl_max_tex_size && tex_height <= ctx->cvl_gl_max_tex_size
+		&& (long long)grid_width * grid_height * grid_depth <= max_cells)
+	    break;
+	sampling_spatial *= 1.25f;
+	sampling_range *= 1.25f;
+    }
+
+    cvl_frame_t *grid[2][2];
+    for (int i = 0; i < 2; i++)
+	for (int j = 0; j < 2; j++)
+	    grid[i][j] = cvl_frame_new(tex_width, tex_height, cvl_frame_channels(src), 
+		    cvl_frame_format(src), CVL_FLOAT, CVL_TEXTURE);
+
+    /* Splat */
+    GLuint prg;
+    int n = (int)ceilf(sampling_spatial);
+    char *prgname = cvl_asprintf("cvl_bilateral_grid_splat_n=%d", n);
+    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    {
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_BILATERAL_GRID_SPLAT_GLSL_STR), "$n=%d", n);
+	prg = cvl_gl_program_new_src(prgname, NULL, src);
+	cvl_gl_program_cache_put(prgname, prg);
+	free(src);
+    }
+    free(prgname);
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), tex_width, tex_height);
+    glUniform2f(glGetUniformLocation(prg, "tex_size"), cvl_frame_width(src), cvl_frame_height(src));
+    glUniform3f(glGetUniformLocation(prg, "grid_size"), grid_width, grid_height, grid_depth);
+    glUniform1f(glGetUniformLocation(prg, "tiles_per_row"), tiles_per_row);
+    glUniform1f(glGetUniformLocation(prg, "sampling_spatial"), sampling_spatial);
+    glUniform1f(glGetUniformLocation(prg, "sampling_range"), sampling_range);
+    glUniform4fv(glGetUniformLocation(prg, "range_min"), 1, range_min);
+    cvl_transform_multi(grid[0], 2, &src, 1, "textures");
+
+    /* Blur */
+    const float dirs[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    int current = 0;
+    for (int d = 0; d < 3; d++)
+    {
+	float sigma = (d < 2 ? sigma_spatial / sampling_spatial : sigma_range / sampling_range);
+	int k = cvl_gauss_sigma_to_k(sigma);
+	float mask[2 * k + 1];
+	cvl_gauss_mask(k, sigma, mask, NULL);
+	prgname = cvl_asprintf("cvl_bilateral_grid_blur_k=%d", k);
+	if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_BILATERAL_GRID_BLUR_GLSL_STR), "$k=%d", k);
+	    prg = cvl_gl_program_new_src(prgname, NULL, src);
+	    cvl_gl_program_cache_put(prgname, prg);
+	    free(src);
+	}
+	free(prgname);
+	glUseProgram(prg);
+	glUniform2f(glGetUniformLocation(prg, "dst_size"), tex_width, tex_height);
+	glUniform3f(glGetUniformLocation(prg, "grid_size"), grid_width, grid_height, grid_depth);
+	glUniform1f(glGetUniformLocation(prg, "tiles_per_row"), tiles_per_row);
+	glUniform3fv(glGetUniformLocation(prg, "dir"), 1, dirs[d]);
+	glUniform1fv(glGetUniformLocation(prg, "mask"), 2 * k + 1, mask);
+	cvl_transform_multi(grid[1 - current], 2, grid[current], 2, "textures");
+	current = 1 - current;
+    }
+
+    /* Slice */
+    prgname = cvl_asprintf("cvl_bilateral_grid_slice_channels=%d", cvl_frame_channels(src));
+    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    {
+	char *src_str = cvl_gl_srcprep(cvl_strdup(CVL_BILATERAL_GRID_SLICE_GLSL_STR), 
+		"$channels=%d", cvl_frame_channels(src));
+	prg = cvl_gl_program_new_src(prgname, NULL, src_str);
+	cvl_gl_program_cache_put(prgname, prg);
+	free(src_str);
+    }
+    free(prgname);
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), cvl_frame_width(dst), cvl_frame_height(dst));
+    glUniform2f(glGetUniformLocation(prg, "grid_tex_size"), tex_width, tex_height);
+    glUniform3f(glGetUniformLocation(prg, "grid_size"), grid_width, grid_height, grid_depth);
+    glUniform1f(glGetUniformLocation(prg, "tiles_per_row"), tiles_per_row);
+    glUniform1f(glGetUniformLocation(prg, "sampling_spatial"), sampling_spatial);
+    glUniform1f(glGetUniformLocation(prg, "sampling_range"), sampling_range);
+    glUniform4fv(glGetUniformLocation(prg, "range_min"), 1, range_min);
+    cvl_frame_t *srcs[3] = { src, grid[current][0], grid[current][1] };
+    cvl_transform_multi(&dst, 1, srcs, 3, "textures");
+
+    for (int i = 0; i < 2; i++)
+	for (int j = 0; j < 2; j++)
+	    cvl_frame_free(grid[i][j]);
+    cvl_check_errors();
+}
+
+
 /**
  * \param k		The parameter k of cvl_gauss()
  * \return		Sigma.
@@ -445,6 +1242,205 @@ int cvl_gauss_sigma_to_k(float sigma)
 }
 
 
+/* Use the recursive Gauss filter for sigma values from this minimum. Its cost
+ * does not depend on sigma, but it needs one rendering step per block of
+ * columns and rows, so the convolution is faster for smaller masks. Above the
+ * maximum, the rounding errors of the single precision recursion become
+ * visible, so larger sigma values are split into several passes with smaller
+ * sigma values (the squares of the sigma values add up). */
+static const float cvl_gauss_recursive_min_sigma = 20.0f;
+static const float cvl_gauss_recursive_max_sigma = 48.0f;
+
+/* Computes the coefficients of the recursive Gauss filter of Young and van
+ * Vliet ("Recursive implementation of the Gaussian filter", Signal Processing
+ * 44, 1995): y[n] = b x[n] + a[0] y[n-1] + a[1] y[n-2] + a[2] y[n-3] for the
+ * causal filter, and the same in reverse direction for the anti-causal
+ * filter. For large sigma, the poles of this filter are close to 1, and
+ * rounding a[] to single precision changes the filter noticeably. The shader
+ * therefore uses the equivalent form
+ * y[n] = y[n-1] + b (x[n] - y[n-1]) + c[0] d1 + c[1] d2
+ * with the first and second differences d1 = y[n-1] - y[n-2] and
+ * d2 = y[n-1] - 2 y[n-2] + y[n-3].
+ * The anti-causal filter starts with the values y[N], y[N+1], y[N+2] beyond the
+ * end of the signal. If the input is continued with its last value u, they
+ * are u + boundary[j] . (w[N-1] - u, w[N-2] - u, w[N-3] - u), where w are the
+ * causal results (Triggs and Sdika, "Boundary conditions for Young-van Vliet
+ * recursive filtering", IEEE Trans. Signal Processing 54, 2006). Instead of
+ * using the closed form, the factors are determined numerically by continuing
+ * both filters far enough beyond the end. */
+static void cvl_gauss_recursive_coefficients(float sigma, float *b, float *c, float *boundary)
+{
+    double q = (sigma >= 2.5f ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma));
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    double b3 = 0.422205 * q * q * q;
+    double aa[3] = { b1 / b0, b2 / b0, b3 / b0 };
+    double bb = 1.57825 / b0;
+    *b = bb;
+    c[0] = -(b2 + 2.0 * b3) / b0;
+    c[1] = b3 / b0;
+
+    /* The impulse responses decay with exp(-n/sigma) */
+    int l = 20 * (int)ceil(sigma) + 100;
+    double *w = malloc((l + 3) * sizeof(double));
+    double *y = malloc((l + 3) * sizeof(double));
+    if (!w || !y)
+    {
+	free(w);
+	free(y);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+	/* w[2-i] = w[N-1-i], so that w[3+n] = w[N+n]; u = 0 */
+	for (int i = 0; i < 3; i++)
+	    w[2 - i] = (k == i ? 1.0 : 0.0);
+	for (int n = 3; n < l; n++)
+	    w[n] = aa[0] * w[n - 1] + aa[1] * w[n - 2] + aa[2] * w[n - 3];
+	for (int n = l; n < l + 3; n++)
+	    y[n] = 0.0;
+	for (int n = l - 1; n >= 3; n--)
+	    y[n] = bb * w[n] + aa[0] * y[n + 1] + aa[1] * y[n + 2] + aa[2] * y[n + 3];
+	for (int j = 0; j < 3; j++)
+	    boundary[3 * j + k] = y[3 + j];
+    }
+    free(w);
+    free(y);
+}
+
+/* Returns the number of recursive passes for the given sigma value. */
+static int cvl_gauss_recursive_passes_needed(float sigma)
+{
+    return cvl_maxi(1, (int)ceilf(sigma * sigma 
+		/ (cvl_gauss_recursive_max_sigma * cvl_gauss_recursive_max_sigma)));
+}
+
+/* Applies the recursive Gauss filter in one direction. The recursion is
+ * sequential, so this needs one step per block of columns (horizontal) or
+ * rows, and each step processes all rows or columns in parallel. The frames
+ * tmp0 and tmp1 are used as buffers; all frames except src must be float
+ * frames, and all must be different. */
+static void cvl_gauss_recursive(cvl_frame_t *dst, cvl_frame_t *src,
+	cvl_frame_t *tmp0, cvl_frame_t *tmp1, bool horizontal, float sigma)
+{
+    /* Each position of a block repeats the recursion from the start of the
+     * block, which is cheaper than a separate step for each position. */
+    const int block = 8;
+    int width = cvl_frame_width(src);
+    int height = cvl_frame_height(src);
+    int len = (horizontal ? width : height);
+    int steps = (len + block - 1) / block;
+    float b, c[2], boundary[9];
+    cvl_gauss_recursive_coefficients(sigma, &b, c, boundary);
+    if (cvl_error())
+	return;
+
+    for (int causal = 1; causal >= 0; causal--)
+    {
+	GLuint prg;
+	char *prgname = cvl_asprintf("cvl_gauss_recursive_causal=%d_horizontal=%d_block=%d",
+		causal, horizontal, block);
+	if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_GAUSS_RECURSIVE_GLSL_STR),
+		    "$causal=%s, $horizontal=%s, $block=%d",
+		    causal ? "true" : "false", horizontal ? "true" : "false", block);
+	    prg = cvl_gl_program_new_src(prgname, NULL, src);
+	    cvl_gl_program_cache_put(prgname, prg);
+	    free(src);
+	}
+	free(prgname);
+	glUseProgram(prg);
+	glUniform1i(glGetUniformLocation(prg, "src"), 0);
+	glUniform1i(glGetUniformLocation(prg, "prev"), 1);
+	glUniform1i(glGetUniformLocation(prg, "causal_result"), 2);
+	glUniform2f(glGetUniformLocation(prg, "size"), width, height);
+	glUniform1f(glGetUniformLocation(prg, "len"), len);
+	glUniform1f(glGetUniformLocation(prg, "b"), b);
+	glUniform2fv(glGetUniformLocation(prg, "c"), 1, c);
+	glUniform3fv(glGetUniformLocation(prg, "boundary"), 3, boundary);
+	GLint n_loc = glGetUniformLocation(prg, "n");
+
+	/* The causal filter alternates between tmp0 and tmp1 and leaves its
+	 * result in buf[(steps - 1) % 2]. The anti-causal filter alternates
+	 * between the other one and dst, and ends in dst. */
+	cvl_frame_t *buf[2];
+	cvl_frame_t *causal_result = ((steps - 1) % 2 == 0 ? tmp0 : tmp1);
+	if (causal)
+	{
+	    buf[0] = tmp0;
+	    buf[1] = tmp1;
+	}
+	else
+	{
+	    buf[(steps - 1) % 2] = dst;
+	    buf[steps % 2] = (causal_result == tmp0 ? tmp1 : tmp0);
+	}
+	for (int i = 0; i < 2; i++)
+	{
+	    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(buf[i]));
+	    cvl_gl_set_texture_state();
+	}
+	if (!causal)
+	{
+	    glActiveTexture(GL_TEXTURE2);
+	    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(causal_result));
+	    cvl_gl_set_texture_state();
+	    glActiveTexture(GL_TEXTURE0);
+	}
+	glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+	cvl_gl_set_texture_state();
+
+	cvl_profile_pass_t pass;
+	cvl_profile_pass_begin(&pass);
+	for (int step = 0; step < steps; step++)
+	{
+	    /* Each step computes the block starting at n and copies the
+	     * previous block */
+	    int n = (causal ? step * block : len - 1 - step * block);
+	    int first = (causal ? cvl_maxi(0, n - block) : cvl_maxi(0, n - block + 1));
+	    int last = (causal ? cvl_mini(len - 1, n + block - 1) : cvl_mini(len - 1, n + block));
+	    cvl_frame_t *target = buf[step % 2];
+	    cvl_frame_t *prev = buf[(step + 1) % 2];
+	    glActiveTexture(GL_TEXTURE1);
+	    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(prev));
+	    glActiveTexture(GL_TEXTURE0);
+	    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+		    GL_TEXTURE_2D, cvl_frame_texture(target), 0);
+	    if (horizontal)
+		glViewport(first, 0, last - first + 1, height);
+	    else
+		glViewport(0, first, width, last - first + 1);
+	    glUniform1f(n_loc, n);
+	    glDrawArrays(GL_QUADS, 0, 4);
+	}
+	cvl_profile_pass_end(&pass, (long long)width * height);
+    }
+    cvl_check_errors();
+}
+
+/* Applies the recursive Gauss filter in one direction, with as many passes as
+ * necessary to keep the sigma value of each pass at most
+ * cvl_gauss_recursive_max_sigma. The frames are used like in
+ * cvl_gauss_recursive(); the frame spare is an additional buffer that is only
+ * used for more than one pass. */
+static void cvl_gauss_recursive_passes(cvl_frame_t *dst, cvl_frame_t *src,
+	cvl_frame_t *tmp0, cvl_frame_t *tmp1, cvl_frame_t *spare, bool horizontal, float sigma)
+{
+    int passes = cvl_gauss_recursive_passes_needed(sigma);
+    float pass_sigma = sigma / sqrtf(passes);
+    cvl_frame_t *in = src;
+    for (int p = 0; p < passes; p++)
+    {
+	/* Alternate between spare and dst, so that the last pass ends in dst */
+	cvl_frame_t *out = ((passes - 1 - p) % 2 == 0 ? dst : spare);
+	cvl_gauss_recursive(out, in, tmp0, tmp1, horizontal, pass_sigma);
+	in = out;
+    }
+}
+
 /**
  * \param dst		The destination frame.
  * \param src		The source frame.
@@ -474,7 +1470,45 @@ void cvl_gauss(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v, float sigma
     float m_v[2 * k_v + 1];
     cvl_gauss_mask(k_v, sigma_v, m_v, NULL);
     
-    cvl_convolve_separable(dst, src, m_h, 2 * k_h + 1, m_v, 2 * k_v + 1);
+    /* The recursive filter approximates the complete Gauss function, so it is
+     * only used if the mask is not truncated more than usual. */
+    bool recursive_h = (sigma_h >= cvl_gauss_recursive_min_sigma
+	    && k_h >= cvl_gauss_sigma_to_k(sigma_h) && cvl_frame_width(src) >= 4);
+    bool recursive_v = (sigma_v >= cvl_gauss_recursive_min_sigma
+	    && k_v >= cvl_gauss_sigma_to_k(sigma_v) && cvl_frame_height(src) >= 4);
+    if (!recursive_h && !recursive_v)
+    {
+	cvl_convolve_separable(dst, src, m_h, 2 * k_h + 1, m_v, 2 * k_v + 1);
+	return;
+    }
+
+    /* The intermediate results are kept in float frames. The fifth frame is
+     * only needed for more than one recursive pass. */
+    bool cascade = ((recursive_h && cvl_gauss_recursive_passes_needed(sigma_h) > 1)
+	    || (recursive_v && cvl_gauss_recursive_passes_needed(sigma_v) > 1));
+    int n_tmp = (cascade ? 5 : 4);
+    cvl_frame_t *tmp[5] = { NULL, NULL, NULL, NULL, NULL };
+    for (int i = 0; i < n_tmp; i++)
+	tmp[i] = cvl_frame_new(cvl_frame_width(src), cvl_frame_height(src),
+		cvl_frame_channels(src), cvl_frame_format(src), CVL_FLOAT, CVL_TEXTURE);
+    const float one = 1.0f;
+    if (recursive_h)
+	cvl_gauss_recursive_passes(tmp[0], src, tmp[1], tmp[2], tmp[4], true, sigma_h);
+    else
+	cvl_convolve_separable(tmp[0], src, m_h, 2 * k_h + 1, &one, 1);
+    if (recursive_v)
+    {
+	bool direct = (cvl_frame_type(dst) == CVL_FLOAT && cvl_frame_format(dst) == cvl_frame_format(src));
+	cvl_gauss_recursive_passes(direct ? dst : tmp[3], tmp[0], tmp[1], tmp[2], tmp[4], false, sigma_v);
+	if (!direct)
+	    cvl_copy(dst, tmp[3]);
+    }
+    else
+    {
+	cvl_convolve_separable(dst, tmp[0], &one, 1, m_v, 2 * k_v + 1);
+    }
+    for (int i = 0; i < n_tmp; i++)
+	cvl_frame_free(tmp[i]);
 }
 
 
@@ -520,60 +1554,151 @@ void cvl_gauss3d(cvl_frame_t *dst, cvl_frame_t **srcs,
 }
 
 
-/**
- * \param dst		The destination frame.
- * \param src		The source frame.
- * \param k_h		Mask size in horizontal direction.
- * \param k_v		Mask size in vertical direction.
- *
- * Applies Minimum filtering to a frame.
- * The number of matrix columns will be 2k_h+1, the number of rows will
- * be 2k_v+1.
- */
-void cvl_min(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
+/* Applies the minimum or maximum filter of van Herk and Gil-Werman in one
+ * direction ("A fast algorithm for local minimum and maximum filters on
+ * rectangular and octagonal kernels", Pattern Recognition Letters 13, 1992).
+ * The source is padded with k clamped pixels on both sides and divided into
+ * blocks of 2k+1 pixels, and the prefix and suffix results within each block
+ * are computed. Each window then needs one prefix and one suffix value. On the
+ * GPU, the block scans need log4(2k+1) steps, so the cost grows only
+ * logarithmically with k. Returns false if the padded frame is too large. */
+static bool cvl_minmax_block(cvl_frame_t *dst, cvl_frame_t *src, int k, bool horizontal, bool maximum)
 {
-    cvl_assert(dst != NULL);
-    cvl_assert(src != NULL);
-    cvl_assert(dst != src);
-    cvl_assert(k_h >= 0);
-    cvl_assert(k_v >= 0);
-    if (cvl_error())
-	return;
-    
-    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
-    
-    /* h */
+    cvl_context_t *ctx = cvl_context();
+    int width = cvl_frame_width(src) + (horizontal ? 2 * k : 0);
+    int height = cvl_frame_height(src) + (horizontal ? 0 : 2 * k);
+    if (width > ctx->cvl_gl_max_tex_size || height > ctx->cvl_gl_max_tex_size
+	    || ctx->cvl_gl_max_render_targets < 2)
+	return false;
+    int block = 2 * k + 1;
+    float dir_h = (horizontal ? 1.0f : 0.0f);
+    float dir_v = (horizontal ? 0.0f : 1.0f);
+
+    /* Block scans. The first step reads the source; the padding is done by
+     * clamping. */
+    cvl_frame_t *scans[2][2];
+    for (int i = 0; i < 2; i++)
+	for (int j = 0; j < 2; j++)
+	    scans[i][j] = cvl_frame_new(width, height, cvl_frame_channels(src),
+		    cvl_frame_format(src), cvl_frame_type(src), CVL_TEXTURE);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_min_k=%d", k_h);
+    char *prgname = cvl_asprintf("cvl_minmax_block_scan_maximum=%d", maximum);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MIN_GLSL_STR), "$k=%d", k_h);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MINMAX_BLOCK_SCAN_GLSL_STR),
+		"$maximum=%s", maximum ? "true" : "false");
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
     }
     free(prgname);
     glUseProgram(prg);
-    glUniform2f(glGetUniformLocation(prg, "step"), 1.0f / (float)cvl_frame_width(src), 0.0f);
-    cvl_transform(tmpframe, src);
-    /* v */
-    prgname = cvl_asprintf("cvl_min_k=%d", k_v);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), width, height);
+    glUniform2f(glGetUniformLocation(prg, "dir"), dir_h, dir_v);
+    glUniform1f(glGetUniformLocation(prg, "block"), block);
+    int current = 0;
+    for (int d = 1; d < block; d *= 4)
+    {
+	cvl_frame_t *srcs[2];
+	if (d == 1)
+	{
+	    srcs[0] = src;
+	    srcs[1] = src;
+	    glUniform2f(glGetUniformLocation(prg, "tex_size"), cvl_frame_width(src), cvl_frame_height(src));
+	    glUniform1f(glGetUniformLocation(prg, "shift"), k);
+	}
+	else
+	{
+	    srcs[0] = scans[0][current];
+	    srcs[1] = scans[1][current];
+	    glUniform2f(glGetUniformLocation(prg, "tex_size"), width, height);
+	    glUniform1f(glGetUniformLocation(prg, "shift"), 0.0f);
+	    current = 1 - current;
+	}
+	glUniform1f(glGetUniformLocation(prg, "d"), d);
+	cvl_frame_t *dsts[2] = { scans[0][current], scans[1][current] };
+	cvl_transform_multi(dsts, 2, srcs, 2, "textures");
+    }
+
+    /* Combination */
+    prgname = cvl_asprintf("cvl_minmax_block_maximum=%d", maximum);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MIN_GLSL_STR), "$k=%d", k_v);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MINMAX_BLOCK_GLSL_STR),
+		"$maximum=%s", maximum ? "true" : "false");
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
     }
     free(prgname);
     glUseProgram(prg);
-    glUniform2f(glGetUniformLocation(prg, "step"), 0.0f, 1.0f / (float)cvl_frame_height(src));
-    cvl_transform(dst, tmpframe);
+    glUniform2f(glGetUniformLocation(prg, "dst_size"), cvl_frame_width(dst), cvl_frame_height(dst));
+    glUniform2f(glGetUniformLocation(prg, "tex_size"), width, height);
+    glUniform2f(glGetUniformLocation(prg, "dir"), dir_h, dir_v);
+    glUniform1f(glGetUniformLocation(prg, "k"), k);
+    cvl_frame_t *srcs[2] = { scans[0][current], scans[1][current] };
+    cvl_transform_multi(&dst, 1, srcs, 2, "textures");
 
-    cvl_frame_free(tmpframe);
+    for (int i = 0; i < 2; i++)
+	for (int j = 0; j < 2; j++)
+	    cvl_frame_free(scans[i][j]);
+    cvl_check_errors();
+    return true;
+}
+
+/* Applies the minimum or maximum filter in one direction. Small windows are
+ * scanned completely, which is faster than the block scans. */
+static void cvl_minmax(cvl_frame_t *dst, cvl_frame_t *src, int k, bool horizontal, bool maximum)
+{
+    const int min_block_k = 32;
+    if (k >= min_block_k && cvl_minmax_block(dst, src, k, horizontal, maximum))
+	return;
+
+    GLuint prg;
+    char *prgname = cvl_asprintf("cvl_%s_k=%d", maximum ? "max" : "min", k);
+    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    {
+	char *src = cvl_gl_srcprep(cvl_strdup(maximum ? CVL_MAX_GLSL_STR : CVL_MIN_GLSL_STR), "$k=%d", k);
+	prg = cvl_gl_program_new_src(prgname, NULL, src);
+	cvl_gl_program_cache_put(prgname, prg);
+	free(src);
+    }
+    free(prgname);
+    glUseProgram(prg);
+    if (horizontal)
+	glUniform2f(glGetUniformLocation(prg, "step"), 1.0f / (float)cvl_frame_width(src), 0.0f);
+    else
+	glUniform2f(glGetUniformLocation(prg, "step"), 0.0f, 1.0f / (float)cvl_frame_height(src));
+    cvl_transform(dst, src);
     cvl_check_errors();
 }
 
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param k_h		Mask size in horizontal direction.
+ * \param k_v		Mask size in vertical direction.
+ *
+ * Applies Minimum filtering to a frame.
+ * The number of matrix columns will be 2k_h+1, the number of rows will
+ * be 2k_v+1.
+ */
+void cvl_min(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(k_h >= 0);
+    cvl_assert(k_v >= 0);
+    if (cvl_error())
+	return;
+    
+    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
+    cvl_minmax(tmpframe, src, k_h, true, false);
+    cvl_minmax(dst, tmpframe, k_v, false, false);
+    cvl_frame_free(tmpframe);
+}
+
 
 /**
  * \param dst		The destination frame.
@@ -625,18 +1750,19 @@ void cvl_min3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t)
     }
 
     /* t */
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_min3d_k_t=%d", k_t);
+    char *prgname = cvl_asprintf("cvl_min3d_k_t=%d_array=%d", k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MIN3D_GLSL_STR), "$k_t=%d", k_t);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MIN3D_GLSL_STR), "$k_t=%d, $array=%d", k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
     }
     free(prgname);
     glUseProgram(prg);
-    cvl_transform_multi(&tmpframe, 1, framebuf, t_len, "textures");
+    cvl_filter_transform_window(tmpframe, framebuf, t_len, array);
     cvl_check_errors();
 
     /* h, v */
@@ -664,39 +1790,11 @@ void cvl_max(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
     cvl_assert(k_v >= 0);
     if (cvl_error())
 	return;
-
-    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
     
-    /* h */
-    GLuint prg;
-    char *prgname = cvl_asprintf("cvl_max_k=%d", k_h);
-    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
-    {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MAX_GLSL_STR), "$k=%d", k_h);
-	prg = cvl_gl_program_new_src(prgname, NULL, src);
-	cvl_gl_program_cache_put(prgname, prg);
-	free(src);
-    }
-    free(prgname);
-    glUseProgram(prg);
-    glUniform2f(glGetUniformLocation(prg, "step"), 1.0f / (float)cvl_frame_width(src), 0.0f);
-    cvl_transform(tmpframe, src);
-    /* v */
-    prgname = cvl_asprintf("cvl_max_k=%d", k_v);
-    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
-    {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MAX_GLSL_STR), "$k=%d", k_v);
-	prg = cvl_gl_program_new_src(prgname, NULL, src);
-	cvl_gl_program_cache_put(prgname, prg);
-	free(src);
-    }
-    free(prgname);
-    glUseProgram(prg);
-    glUniform2f(glGetUniformLocation(prg, "step"), 0.0f, 1.0f / (float)cvl_frame_height(src));
-    cvl_transform(dst, tmpframe);
-
+    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
+    cvl_minmax(tmpframe, src, k_h, true, true);
+    cvl_minmax(dst, tmpframe, k_v, false, true);
     cvl_frame_free(tmpframe);
-    cvl_check_errors();
 }
 
 
@@ -750,18 +1848,19 @@ void cvl_max3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t)
     }
 
     /* t */
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_max3d_k_t=%d", k_t);
+    char *prgname = cvl_asprintf("cvl_max3d_k_t=%d_array=%d", k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MAX3D_GLSL_STR), "$k_t=%d", k_t);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MAX3D_GLSL_STR), "$k_t=%d, $array=%d", k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
     }
     free(prgname);
     glUseProgram(prg);
-    cvl_transform_multi(&tmpframe, 1, framebuf, t_len, "textures");
+    cvl_filter_transform_window(tmpframe, framebuf, t_len, array);
     cvl_check_errors();
 
     /* h, v */
@@ -776,10 +1875,216 @@ void cvl_max3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_t)
  * \param k_h		Mask size in horizontal direction.
  * \param k_v		Mask size in vertical direction.
  *
- * Applies Median filtering to a frame.
+ * Applies a morphological opening with a rectangular structuring element:
+ * Minimum filtering followed by Maximum filtering. This removes bright
+ * structures that are smaller than the mask.
  * The number of matrix columns will be 2k_h+1, the number of rows will
  * be 2k_v+1.
  */
+void cvl_opening(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(k_h >= 0);
+    cvl_assert(k_v >= 0);
+    if (cvl_error())
+	return;
+
+    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
+    cvl_min(tmpframe, src, k_h, k_v);
+    cvl_max(dst, tmpframe, k_h, k_v);
+    cvl_frame_free(tmpframe);
+}
+
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param k_h		Mask size in horizontal direction.
+ * \param k_v		Mask size in vertical direction.
+ *
+ * Applies a morphological closing with a rectangular structuring element:
+ * Maximum filtering followed by Minimum filtering. This removes dark
+ * structures that are smaller than the mask.
+ * The number of matrix columns will be 2k_h+1, the number of rows will
+ * be 2k_v+1.
+ */
+void cvl_closing(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(k_h >= 0);
+    cvl_assert(k_v >= 0);
+    if (cvl_error())
+	return;
+
+    cvl_frame_t *tmpframe = cvl_frame_new_tpl(src);
+    cvl_max(tmpframe, src, k_h, k_v);
+    cvl_min(dst, tmpframe, k_h, k_v);
+    cvl_frame_free(tmpframe);
+}
+
+
+/* A part of the CPU median computation for 8 bit frames: the rows first to
+ * last-1 of dst are computed from src. */
+typedef struct
+{
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    int height;
+    int channels;
+    int k_h;
+    int k_v;
+    int first;
+    int last;
+} cvl_median_job_t;
+
+/* Updates the median m of a histogram h of n values, given the number lt of
+ * values less than m, after values were added or removed. */
+static inline void cvl_median_update(const int *h, int n, int *m, int *lt)
+{
+    int half = n / 2;
+    while (*lt > half)
+    {
+	(*m)--;
+	*lt -= h[*m];
+    }
+    while (*lt + h[*m] <= half)
+    {
+	*lt += h[*m];
+	(*m)++;
+    }
+}
+
+/* Slides a window histogram along each row. Moving one pixel to the right
+ * replaces one window column, and the median is then found by stepping from
+ * the previous one, so the cost per pixel depends on the window height, but
+ * hardly on its width. */
+static void *cvl_median_worker(void *arg)
+{
+    cvl_median_job_t *job = arg;
+    const int w = job->width;
+    const int channels = job->channels;
+    const int n = (2 * job->k_h + 1) * (2 * job->k_v + 1);
+    int histogram[4][256];
+    int m[4], lt[4];
+
+    for (int y = job->first; y < job->last; y++)
+    {
+	memset(histogram, 0, sizeof(histogram));
+	for (int r = -job->k_v; r <= job->k_v; r++)
+	{
+	    const uint8_t *row = job->src + (size_t)cvl_clampi(y + r, 0, job->height - 1) * w * channels;
+	    for (int c = -job->k_h; c <= job->k_h; c++)
+	    {
+		const uint8_t *p = row + cvl_clampi(c, 0, w - 1) * channels;
+		for (int i = 0; i < channels; i++)
+		    histogram[i][p[i]]++;
+	    }
+	}
+	for (int i = 0; i < channels; i++)
+	{
+	    m[i] = 0;
+	    lt[i] = 0;
+	    cvl_median_update(histogram[i], n, &m[i], &lt[i]);
+	}
+	uint8_t *out = job->dst + (size_t)y * w * channels;
+	for (int x = 0; x < w; x++)
+	{
+	    if (x > 0)
+	    {
+		int x_out = cvl_clampi(x - job->k_h - 1, 0, w - 1) * channels;
+		int x_in = cvl_clampi(x + job->k_h, 0, w - 1) * channels;
+		for (int r = -job->k_v; r <= job->k_v; r++)
+		{
+		    const uint8_t *row = job->src + (size_t)cvl_clampi(y + r, 0, job->height - 1) * w * channels;
+		    for (int i = 0; i < channels; i++)
+		    {
+			int v_out = row[x_out + i];
+			int v_in = row[x_in + i];
+			histogram[i][v_out]--;
+			histogram[i][v_in]++;
+			lt[i] += (v_in < m[i]) - (v_out < m[i]);
+		    }
+		}
+		for (int i = 0; i < channels; i++)
+		    cvl_median_update(histogram[i], n, &m[i], &lt[i]);
+	    }
+	    for (int i = 0; i < channels; i++)
+		out[x * channels + i] = m[i];
+	}
+    }
+    return NULL;
+}
+
+/* Computes the median of an 8 bit frame on the CPU. */
+static void cvl_median_cpu(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
+{
+    int width = cvl_frame_width(src);
+    int height = cvl_frame_height(src);
+    int channels = (cvl_frame_format(src) == CVL_LUM ? 1 : cvl_frame_format(src) == CVL_UNKNOWN ? 4 : 3);
+    GLint glformat = (cvl_frame_format(src) == CVL_LUM ? GL_LUMINANCE 
+	    : cvl_frame_format(src) == CVL_UNKNOWN ? GL_RGBA : GL_RGB);
+    cvl_frame_t *frame = cvl_frame_new(width, height, cvl_frame_channels(src), cvl_frame_format(src),
+	    CVL_UINT8, CVL_MEM);
+    if (cvl_error())
+	return;
+    uint8_t *out = cvl_frame_pointer(frame);
+    uint8_t *ptr = malloc((size_t)width * height * channels);
+    if (!ptr)
+    {
+	cvl_frame_free(frame);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+    glGetTexImage(GL_TEXTURE_2D, 0, glformat, GL_UNSIGNED_BYTE, ptr);
+
+    // Do not start threads for less than 16 rows each
+    int threads = cvl_cpu_threads(height, 16);
+    cvl_median_job_t jobs[CVL_CPU_MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+	jobs[t].src = ptr;
+	jobs[t].dst = out;
+	jobs[t].width = width;
+	jobs[t].height = height;
+	jobs[t].channels = channels;
+	jobs[t].k_h = k_h;
+	jobs[t].k_v = k_v;
+	jobs[t].first = (long long)height * t / threads;
+	jobs[t].last = (long long)height * (t + 1) / threads;
+    }
+    cvl_cpu_run(cvl_median_worker, jobs, sizeof(cvl_median_job_t), threads);
+    free(ptr);
+
+    cvl_copy(dst, frame);
+    cvl_frame_free(frame);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param k_h		Mask size in horizontal direction.
+ * \param k_v		Mask size in vertical direction.
+ *
+ * Applies Median filtering to a frame.
+ * The number of matrix columns will be 2k_h+1, the number of rows will
+ * be 2k_v+1.\n
+ * Small windows are sorted. For larger windows, 8 bit frames are filtered on
+ * the CPU with a histogram that slides along each row, which needs time
+ * proportional to the window height per pixel. For other types, the median is
+ * selected by counting the window values below a threshold that is refined by
+ * a fixed number of bisection steps; the distinct values that remain in the
+ * final interval are then visited one at a time. Each step reads the whole
+ * window, so the cost is usually a small multiple of the window size, but
+ * grows to its square in the worst case of a window with many distinct values
+ * that are too close to be separated by bisection.
+ * The result is exact in all cases.
+ */
 void cvl_median(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
 {
     cvl_assert(dst != NULL);
@@ -790,14 +2095,40 @@ void cvl_median(cvl_frame_t *dst, cvl_frame_t *src, int k_h, int k_v)
     if (cvl_error())
 	return;
     
+    /* Sorting is faster up to this window size */
+    const int max_sort_size = 9;
+    if ((2 * k_h + 1) * (2 * k_v + 1) > max_sort_size && cvl_frame_type(src) == CVL_UINT8)
+    {
+	cvl_median_cpu(dst, src, k_h, k_v);
+	return;
+    }
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_median_k_h=%d_k_v=%d", k_h, k_v);
-    if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+    char *prgname;
+    if ((2 * k_h + 1) * (2 * k_v + 1) <= max_sort_size)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN_GLSL_STR), "$k_h=%d, $k_v=%d", k_h, k_v);
-	prg = cvl_gl_program_new_src(prgname, NULL, src);
-	cvl_gl_program_cache_put(prgname, prg);
-	free(src);
+	prgname = cvl_asprintf("cvl_median_k_h=%d_k_v=%d", k_h, k_v);
+	if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN_GLSL_STR), "$k_h=%d, $k_v=%d", k_h, k_v);
+	    prg = cvl_gl_program_new_src(prgname, NULL, src);
+	    cvl_gl_program_cache_put(prgname, prg);
+	    free(src);
+	}
+    }
+    else
+    {
+	/* More bisection steps reduce the number of distinct values that
+	 * are visited afterwards. */
+	const int iterations = 16;
+	prgname = cvl_asprintf("cvl_median_count_k_h=%d_k_v=%d_iterations=%d", k_h, k_v, iterations);
+	if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN_COUNT_GLSL_STR),
+		    "$k_h=%d, $k_v=%d, $iterations=%d", k_h, k_v, iterations);
+	    prg = cvl_gl_program_new_src(prgname, NULL, src);
+	    cvl_gl_program_cache_put(prgname, prg);
+	    free(src);
+	}
     }
     free(prgname);
     glUseProgram(prg);
@@ -855,12 +2186,13 @@ void cvl_median3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_
 	    framebuf[i] = srcs[last_known];
     }
 
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_median3d_k_h=%d_k_v=%d_k_t=%d", k_h, k_v, k_t);
+    char *prgname = cvl_asprintf("cvl_median3d_k_h=%d_k_v=%d_k_t=%d_array=%d", k_h, k_v, k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
 	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN3D_GLSL_STR), 
-	    	"$k_h=%d, $k_v=%d, $k_t=%d", k_h, k_v, k_t);
+	    	"$k_h=%d, $k_v=%d, $k_t=%d, $array=%d", k_h, k_v, k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
@@ -869,7 +2201,7 @@ void cvl_median3d(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k_v, int k_
     glUseProgram(prg);
     glUniform1f(glGetUniformLocation(prg, "step_h"), 1.0f / (float)cvl_frame_width(srcs[t_len / 2]));
     glUniform1f(glGetUniformLocation(prg, "step_v"), 1.0f / (float)cvl_frame_height(srcs[t_len / 2]));
-    cvl_transform_multi(&dst, 1, framebuf, t_len, "textures");
+    cvl_filter_transform_window(dst, framebuf, t_len, array);
     cvl_check_errors();
 }
 
@@ -983,18 +2315,19 @@ void cvl_median3d_separated(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k
     }
 
     /* t */
+    bool array = cvl_filter_use_texture_array(t_len);
     GLuint prg;
-    char *prgname = cvl_asprintf("cvl_median3d_separated_k_t=%d", k_t);
+    char *prgname = cvl_asprintf("cvl_median3d_separated_k_t=%d_array=%d", k_t, array);
     if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN3D_SEPARATED_GLSL_STR), "$k_t=%d", k_t);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_MEDIAN3D_SEPARATED_GLSL_STR), "$k_t=%d, $array=%d", k_t, array);
 	prg = cvl_gl_program_new_src(prgname, NULL, src);
 	cvl_gl_program_cache_put(prgname, prg);
 	free(src);
     }
     free(prgname);
     glUseProgram(prg);
-    cvl_transform_multi(&tmpframe, 1, framebuf, t_len, "textures");
+    cvl_filter_transform_window(tmpframe, framebuf, t_len, array);
     cvl_check_errors();
 
     /* h, v */
@@ -1003,6 +2336,400 @@ void cvl_median3d_separated(cvl_frame_t *dst, cvl_frame_t **srcs, int k_h, int k
 }
 
 
+/**
+ * \typedef cvl_temporal_filter_type_t
+ * Type of a temporal filter.
+ */
+/** \var CVL_TEMPORAL_MEAN
+ * Mean filter. See cvl_mean3d(). */
+/** \var CVL_TEMPORAL_GAUSS
+ * Gauss filter. See cvl_gauss3d(). */
+/** \var CVL_TEMPORAL_MIN
+ * Minimum filter. See cvl_min3d(). */
+/** \var CVL_TEMPORAL_MAX
+ * Maximum filter. See cvl_max3d(). */
+/** \var CVL_TEMPORAL_MEDIAN
+ * Median filter. See cvl_median3d(). */
+/** \var CVL_TEMPORAL_MEDIAN_SEPARATED
+ * Approximated median filter. See cvl_median3d_separated(). */
+
+/**
+ * \typedef cvl_temporal_filter_t
+ * A streaming filter for frame sequences.
+ */
+
+/* Recompute the running sum of the mean filter from scratch after this many
+ * incremental updates, so that rounding errors cannot accumulate. */
+#define CVL_TEMPORAL_FILTER_RESYNC 64
+
+typedef struct
+{
+    cvl_temporal_filter_type_t type;
+    int k_h;
+    int k_v;
+    int k_t;
+    float sigma_h;
+    float sigma_v;
+    float *mask_t;
+    /* Ring buffer with the spatially filtered frames. Frame i of the stream
+     * is stored at index i % ring_len, together with the type and tag list of
+     * the original frame. */
+    int ring_len;
+    cvl_frame_t **ring;
+    cvl_type_t *ring_types;
+    cvl_taglist_t **ring_taglists;
+    int frames_in;
+    int frames_out;
+    bool eof;
+    /* Running sum for the mean filter (ping-pong). */
+    cvl_frame_t *sum[2];
+    int sum_current;
+    int sum_age;
+    /* Accumulators for multi-pass combinations (ping-pong). */
+    cvl_frame_t *acc[2];
+} cvl__temporal_filter_t;
+
+
+/* Makes sure that *frame is a texture frame with the properties of tpl and the
+ * given type, reusing the existing frame if possible. */
+static cvl_frame_t *cvl_temporal_filter_frame(cvl_frame_t **frame, cvl_frame_t *tpl, cvl_type_t type)
+{
+    if (*frame && (cvl_frame_width(*frame) != cvl_frame_width(tpl)
+		|| cvl_frame_height(*frame) != cvl_frame_height(tpl)
+		|| cvl_frame_channels(*frame) != cvl_frame_channels(tpl)
+		|| cvl_frame_format(*frame) != cvl_frame_format(tpl)
+		|| cvl_frame_type(*frame) != type))
+    {
+	cvl_frame_free(*frame);
+	*frame = NULL;
+    }
+    if (!*frame)
+    {
+	*frame = cvl_frame_new(cvl_frame_width(tpl), cvl_frame_height(tpl),
+		cvl_frame_channels(tpl), cvl_frame_format(tpl), type, CVL_TEXTURE);
+	if (cvl_frame_format(tpl) == CVL_UNKNOWN)
+	{
+	    for (int c = 0; c < cvl_frame_channels(tpl); c++)
+	    {
+		cvl_frame_set_channel_name(*frame, c, cvl_frame_channel_name(tpl, c));
+	    }
+	}
+    }
+    return *frame;
+}
+
+/* Combines n frames into dst: mode 0 computes the weighted sum, mode 1 the
+ * minimum, and mode 2 the maximum. If n exceeds the number of texture units,
+ * several passes are used, each of which takes the previous result as input. */
+static void cvl_temporal_filter_combine(cvl__temporal_filter_t *tf, cvl_frame_t *dst,
+	cvl_frame_t **frames, const float *weights, int n, int mode)
+{
+    int units = cvl_context()->cvl_gl_max_texture_units;
+    cvl_frame_t *prev = NULL;
+    int acc = 0;
+    int i = 0;
+
+    while (i < n && !cvl_error())
+    {
+	int m = (prev ? 1 : 0);
+	int chunk = cvl_mini(n - i, units - m);
+	cvl_frame_t *textures[m + chunk];
+	float w[m + chunk];
+	if (prev)
+	{
+	    textures[0] = prev;
+	    w[0] = 1.0f;
+	}
+	for (int j = 0; j < chunk; j++)
+	{
+	    textures[m + j] = frames[i + j];
+	    w[m + j] = weights ? weights[i + j] : 0.0f;
+	}
+	i += chunk;
+	cvl_frame_t *target = (i == n ? dst : cvl_temporal_filter_frame(&(tf->acc[acc]), dst, CVL_FLOAT));
+
+	GLuint prg;
+	char *prgname = cvl_asprintf("cvl_temporal_mode=%d_n=%d", mode, m + chunk);
+	if ((prg = cvl_gl_program_cache_get(prgname)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_TEMPORAL_GLSL_STR), "$mode=%d, $n=%d", mode, m + chunk);
+	    prg = cvl_gl_program_new_src(prgname, NULL, src);
+	    cvl_gl_program_cache_put(prgname, prg);
+	    free(src);
+	}
+	free(prgname);
+	glUseProgram(prg);
+	glUniform1fv(glGetUniformLocation(prg, "weights"), m + chunk, w);
+	cvl_transform_multi(&target, 1, textures, m + chunk, "textures");
+	prev = target;
+	acc = 1 - acc;
+    }
+    cvl_check_errors();
+}
+
+/**
+ * \param type		The filter type.
+ * \param k_h		Mask size in horizontal direction.
+ * \param k_v		Mask size in vertical direction.
+ * \param k_t		Mask size in temporal direction.
+ * \param sigma_h	Sigma value in horizontal direction (only for #CVL_TEMPORAL_GAUSS).
+ * \param sigma_v	Sigma value in vertical direction (only for #CVL_TEMPORAL_GAUSS).
+ * \param sigma_t	Sigma value in temporal direction (only for #CVL_TEMPORAL_GAUSS).
+ * \return		The temporal filter.
+ *
+ * Creates a filter that applies 3D filtering to a stream of frames. It gives
+ * the same results as cvl_mean3d(), cvl_gauss3d(), cvl_min3d(), cvl_max3d(),
+ * cvl_median3d(), or cvl_median3d_separated() applied to a window of 2k_t+1
+ * frames around each frame, with clamping at the start and end of the stream.
+ * It is more efficient though: each frame is filtered spatially only once,
+ * when it enters the window, and the filter keeps a ring buffer of these
+ * results. The mean filter additionally keeps a running sum, so that its cost
+ * per frame does not depend on \a k_t. The temporal window is combined in
+ * several passes if it is larger than the number of available texture units.\n
+ * Use cvl_temporal_filter_put() and cvl_temporal_filter_get() to process a
+ * stream.
+ */
+cvl_temporal_filter_t *cvl_temporal_filter_new(cvl_temporal_filter_type_t type,
+	int k_h, int k_v, int k_t, float sigma_h, float sigma_v, float sigma_t)
+{
+    cvl_assert(type >= CVL_TEMPORAL_MEAN && type <= CVL_TEMPORAL_MEDIAN_SEPARATED);
+    cvl_assert(k_h >= 0);
+    cvl_assert(k_v >= 0);
+    cvl_assert(k_t >= 0);
+    cvl_assert(type != CVL_TEMPORAL_GAUSS || (sigma_h > 0.0f && sigma_v > 0.0f && sigma_t > 0.0f));
+    if (cvl_error())
+	return NULL;
+
+    cvl__temporal_filter_t *tf;
+    int ring_len = 2 * k_t + 2;
+
+    if (!(tf = calloc(1, sizeof(cvl__temporal_filter_t)))
+	    || !(tf->mask_t = malloc((2 * k_t + 1) * sizeof(float)))
+	    || !(tf->ring = calloc(ring_len, sizeof(cvl_frame_t *)))
+	    || !(tf->ring_types = calloc(ring_len, sizeof(cvl_type_t)))
+	    || !(tf->ring_taglists = calloc(ring_len, sizeof(cvl_taglist_t *))))
+    {
+	if (tf)
+	{
+	    free(tf->mask_t);
+	    free(tf->ring);
+	    free(tf->ring_types);
+	    free(tf);
+	}
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return NULL;
+    }
+    tf->type = type;
+    tf->k_h = k_h;
+    tf->k_v = k_v;
+    tf->k_t = k_t;
+    tf->sigma_h = sigma_h;
+    tf->sigma_v = sigma_v;
+    if (type == CVL_TEMPORAL_GAUSS)
+    {
+	float weight_sum = 0.0f;
+	cvl_gauss_mask(k_t, sigma_t, tf->mask_t, NULL);
+	for (int i = 0; i < 2 * k_t + 1; i++)
+	    weight_sum += tf->mask_t[i];
+	for (int i = 0; i < 2 * k_t + 1; i++)
+	    tf->mask_t[i] /= weight_sum;
+    }
+    tf->ring_len = ring_len;
+    tf->frames_in = 0;
+    tf->frames_out = 0;
+    tf->eof = false;
+    tf->sum_current = -1;
+    tf->sum_age = 0;
+    return (cvl_temporal_filter_t *)tf;
+}
+
+/**
+ * \param filter	The temporal filter.
+ *
+ * Frees a temporal filter.
+ */
+void cvl_temporal_filter_free(cvl_temporal_filter_t *filter)
+{
+    cvl__temporal_filter_t *tf = (cvl__temporal_filter_t *)filter;
+
+    if (tf)
+    {
+	for (int i = 0; i < tf->ring_len; i++)
+	{
+	    cvl_frame_free(tf->ring[i]);
+	    cvl_taglist_free(tf->ring_taglists[i]);
+	}
+	cvl_frame_free(tf->sum[0]);
+	cvl_frame_free(tf->sum[1]);
+	cvl_frame_free(tf->acc[0]);
+	cvl_frame_free(tf->acc[1]);
+	free(tf->ring);
+	free(tf->ring_types);
+	free(tf->ring_taglists);
+	free(tf->mask_t);
+	free(tf);
+    }
+}
+
+/**
+ * \param filter	The temporal filter.
+ * \param frame		The next frame of the stream, or NULL.
+ *
+ * Puts the next \a frame of the stream into the temporal filter. The frame is
+ * not modified, and the caller keeps ownership of it. When the stream ends,
+ * call this function with \a frame set to NULL.\n
+ * Before putting a new frame into the filter, all available results must have
+ * been retrieved with cvl_temporal_filter_get().
+ */
+void cvl_temporal_filter_put(cvl_temporal_filter_t *filter, cvl_frame_t *frame)
+{
+    cvl__temporal_filter_t *tf = (cvl__temporal_filter_t *)filter;
+
+    cvl_assert(tf != NULL);
+    if (cvl_error())
+	return;
+    cvl_assert(!tf->eof);
+    cvl_assert(tf->frames_out >= tf->frames_in - tf->k_t);
+    if (cvl_error())
+	return;
+
+    if (!frame)
+    {
+	tf->eof = true;
+	return;
+    }
+
+    int slot = tf->frames_in % tf->ring_len;
+    cvl_type_t ring_type = cvl_frame_type(frame);
+    if ((tf->type == CVL_TEMPORAL_MEAN || tf->type == CVL_TEMPORAL_GAUSS) && ring_type == CVL_UINT8)
+    {
+	/* Keep the precision of the intermediate results */
+	ring_type = CVL_FLOAT16;
+    }
+    cvl_frame_t *filtered = cvl_temporal_filter_frame(&(tf->ring[slot]), frame, ring_type);
+    switch (tf->type)
+    {
+    case CVL_TEMPORAL_MEAN:
+	cvl_mean(filtered, frame, tf->k_h, tf->k_v);
+	break;
+    case CVL_TEMPORAL_GAUSS:
+	cvl_gauss(filtered, frame, tf->k_h, tf->k_v, tf->sigma_h, tf->sigma_v);
+	break;
+    case CVL_TEMPORAL_MIN:
+	cvl_min(filtered, frame, tf->k_h, tf->k_v);
+	break;
+    case CVL_TEMPORAL_MAX:
+	cvl_max(filtered, frame, tf->k_h, tf->k_v);
+	break;
+    case CVL_TEMPORAL_MEDIAN:
+    case CVL_TEMPORAL_MEDIAN_SEPARATED:
+	/* These cannot be separated into a spatial and a temporal part */
+	cvl_copy(filtered, frame);
+	break;
+    }
+    tf->ring_types[slot] = cvl_frame_type(frame);
+    cvl_taglist_free(tf->ring_taglists[slot]);
+    tf->ring_taglists[slot] = cvl_taglist_copy(cvl_frame_taglist(frame));
+    tf->frames_in++;
+}
+
+/**
+ * \param filter	The temporal filter.
+ * \return		The next result frame, or NULL.
+ *
+ * Returns the next result of the temporal filter, or NULL if more input frames
+ * are needed (or if the end of the stream was reached). The result frame
+ * has the type and the tags of the corresponding input frame. The caller must
+ * free it.
+ */
+cvl_frame_t *cvl_temporal_filter_get(cvl_temporal_filter_t *filter)
+{
+    cvl__temporal_filter_t *tf = (cvl__temporal_filter_t *)filter;
+
+    cvl_assert(tf != NULL);
+    if (cvl_error())
+	return NULL;
+
+    int t = tf->frames_out;
+    int k_t = tf->k_t;
+    int t_len = 2 * k_t + 1;
+    int last = tf->frames_in - 1;
+    if (t > last || (!tf->eof && t + k_t > last))
+	return NULL;
+
+    cvl_frame_t *window[t_len];
+    for (int i = 0; i < t_len; i++)
+	window[i] = tf->ring[cvl_clampi(t - k_t + i, 0, last) % tf->ring_len];
+    int slot = t % tf->ring_len;
+    cvl_frame_t *center = tf->ring[slot];
+    cvl_frame_t *dst = cvl_frame_new(cvl_frame_width(center), cvl_frame_height(center),
+	    cvl_frame_channels(center), cvl_frame_format(center), tf->ring_types[slot], CVL_TEXTURE);
+    if (cvl_frame_format(center) == CVL_UNKNOWN)
+    {
+	for (int c = 0; c < cvl_frame_channels(center); c++)
+	{
+	    cvl_frame_set_channel_name(dst, c, cvl_frame_channel_name(center, c));
+	}
+    }
+    cvl_frame_set_taglist(dst, tf->ring_taglists[slot]);
+    tf->ring_taglists[slot] = NULL;
+
+    switch (tf->type)
+    {
+    case CVL_TEMPORAL_MEAN:
+	if (tf->sum_current < 0 || tf->sum_age >= CVL_TEMPORAL_FILTER_RESYNC)
+	{
+	    float ones[t_len];
+	    for (int i = 0; i < t_len; i++)
+		ones[i] = 1.0f;
+	    tf->sum_current = 0;
+	    tf->sum_age = 0;
+	    cvl_temporal_filter_combine(tf, cvl_temporal_filter_frame(&(tf->sum[0]), center, CVL_FLOAT),
+		    window, ones, t_len, 0);
+	}
+	else
+	{
+	    /* Slide the window: add the new frame, subtract the old one */
+	    const float weights[3] = { 1.0f, 1.0f, -1.0f };
+	    cvl_frame_t *terms[3] = { tf->sum[tf->sum_current], window[t_len - 1],
+		tf->ring[cvl_clampi(t - k_t - 1, 0, last) % tf->ring_len] };
+	    tf->sum_current = 1 - tf->sum_current;
+	    tf->sum_age++;
+	    cvl_temporal_filter_combine(tf, cvl_temporal_filter_frame(&(tf->sum[tf->sum_current]), center, CVL_FLOAT),
+		    terms, weights, 3, 0);
+	}
+	{
+	    float factor = 1.0f / (float)t_len;
+	    cvl_temporal_filter_combine(tf, dst, &(tf->sum[tf->sum_current]), &factor, 1, 0);
+	}
+	break;
+    case CVL_TEMPORAL_GAUSS:
+	cvl_temporal_filter_combine(tf, dst, window, tf->mask_t, t_len, 0);
+	break;
+    case CVL_TEMPORAL_MIN:
+	cvl_temporal_filter_combine(tf, dst, window, NULL, t_len, 1);
+	break;
+    case CVL_TEMPORAL_MAX:
+	cvl_temporal_filter_combine(tf, dst, window, NULL, t_len, 2);
+	break;
+    case CVL_TEMPORAL_MEDIAN:
+	cvl_median3d(dst, window, tf->k_h, tf->k_v, k_t);
+	break;
+    case CVL_TEMPORAL_MEDIAN_SEPARATED:
+	cvl_median3d_separated(dst, window, tf->k_h, tf->k_v, k_t);
+	break;
+    }
+    tf->frames_out++;
+
+    if (cvl_error())
+    {
+	cvl_frame_free(dst);
+	return NULL;
+    }
+    return dst;
+}
+
+
 /**
  * \param dst		The destination frame.
  * \param src		The source frame.
@@ -145,13 +145,18 @@ cvl_frame_t *cvl_frame_new(int width, int height, int channels, cvl_format_t for
 	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
 	    return NULL;
 	}
+	frame->tex = 0;
     }
     else
     {
+	double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
 	glGenTextures(1, &(frame->tex));
 	glBindTexture(GL_TEXTURE_2D, frame->tex);
 	glTexImage2D(GL_TEXTURE_2D, 0, ctx->cvl_gl_texture_formats[type][channels - 1],
 		width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	if (cvl_profile_active())
+	    glFinish();
+	cvl_profile_span("cvl_frame_new", NULL, ctx->cvl_profile_frame, start, width * height, 0);
 	cvl_check_errors();
 	frame->ptr = NULL;
     }
@@ -470,9 +475,13 @@ void *cvl_frame_pointer(cvl_frame_t *frame)
 	GLint glformat = (cvl_frame_format(frame) == CVL_LUM ? GL_LUMINANCE 
 		: cvl_frame_format(frame) == CVL_UNKNOWN ? GL_RGBA : GL_RGB);
 	GLint gltype = (cvl_frame_type(frame) == CVL_UINT8 ? GL_UNSIGNED_BYTE : GL_FLOAT);
+	double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
 	glBindTexture(GL_TEXTURE_2D, frame->tex);
 	glGetTexImage(GL_TEXTURE_2D, 0, glformat, gltype, frame->ptr);
 	glDeleteTextures(1, &(frame->tex));
+	frame->tex = 0;
+	cvl_profile_span("cvl_frame_pointer", NULL, cvl_context()->cvl_profile_frame,
+		start, cvl_frame_size(frame), (long long)cvl_frame_size(frame) * channels * typesize);
 	cvl_check_errors();
     }
 
@@ -501,12 +510,18 @@ GLuint cvl_frame_texture(cvl_frame_t *frame)
 		: cvl_frame_format(frame) == CVL_UNKNOWN ? 4 : 3);
 	GLint gltype = (cvl_frame_type(frame) == CVL_UINT8 ? GL_UNSIGNED_BYTE : GL_FLOAT);
 	cvl_type_t type = cvl_frame_type(frame);
+	int typesize = (type == CVL_UINT8 ? sizeof(uint8_t) : sizeof(float));
 
+	double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
 	glGenTextures(1, &(frame->tex));
 	glBindTexture(GL_TEXTURE_2D, frame->tex);
 	glTexImage2D(GL_TEXTURE_2D, 0, ctx->cvl_gl_texture_formats[type][channels - 1],
 		cvl_frame_width(frame), cvl_frame_height(frame), 0,
 		glformat, gltype, frame->ptr);
+	if (cvl_profile_active())
+	    glFinish();
+	cvl_profile_span("cvl_frame_texture", NULL, ctx->cvl_profile_frame,
+		start, cvl_frame_size(frame), (long long)cvl_frame_size(frame) * channels * typesize);
 	cvl_check_errors();
 	free(frame->ptr);
 	frame->ptr = NULL;
@@ -538,7 +553,10 @@ void cvl_transform(cvl_frame_t *dst, cvl_frame_t *src)
     glViewport(0, 0, cvl_frame_width(dst), cvl_frame_height(dst));
     glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
     cvl_gl_set_texture_state();
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glDrawArrays(GL_QUADS, 0, 4);
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(dst));
 
     cvl_check_errors();
 }
@@ -608,10 +626,125 @@ void cvl_transform_multi(cvl_frame_t **dsts, int ndsts, cvl_frame_t **srcs, int
 
     // Render
     glViewport(0, 0, cvl_frame_width(dsts[0]), cvl_frame_height(dsts[0]));
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glDrawArrays(GL_QUADS, 0, 4);
+    cvl_profile_pass_end(&pass, (long long)ndsts * cvl_frame_size(dsts[0]));
 
-    // Cleanup
+    // Cleanup. Detach the additional render targets, so that they can be used
+    // as textures in later steps, and so that later steps with a different
+    // frame size use a complete framebuffer.
     cvl_check_errors();
     glActiveTexture(GL_TEXTURE0);
     glDrawBuffers(1, draw_buffers);
+    for (int i = 1; i < ndsts; i++)
+    {
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT + i, 
+		GL_TEXTURE_2D, 0, 0);
+    }
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param srcs		The source frames.
+ * \param nsrcs		The number of source frames.
+ * \param array_name	Name of the uniform sampler2DArray variable.
+ *
+ * Renders the frames \a srcs 1:1 into the frame \a dst, like
+ * cvl_transform_multi(), but the sources are made available to the active
+ * program as the layers of a single 2D texture array instead of an array of
+ * textures. This needs only one texture unit, so the number of sources is
+ * not limited by the number of texture units, only by the maximum number of
+ * texture array layers.\n
+ * All source frames must have the same dimensions, format, and type.
+ * The active program must use the GL_EXT_texture_array extension. The name of
+ * its sampler2DArray uniform variable must be given in \a array_name.
+ */
+void cvl_transform_array(cvl_frame_t *dst, cvl_frame_t **srcs, int nsrcs, const char *array_name)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(srcs != NULL);
+    cvl_assert(nsrcs > 0);
+    cvl_assert(array_name != NULL);
+    for (int i = 1; i < nsrcs; i++)
+    {
+	cvl_assert(cvl_frame_width(srcs[i]) == cvl_frame_width(srcs[0]));
+	cvl_assert(cvl_frame_height(srcs[i]) == cvl_frame_height(srcs[0]));
+	cvl_assert(cvl_frame_channels(srcs[i]) == cvl_frame_channels(srcs[0]));
+	cvl_assert(cvl_frame_format(srcs[i]) == cvl_frame_format(srcs[0]));
+	cvl_assert(cvl_frame_type(srcs[i]) == cvl_frame_type(srcs[0]));
+    }
+    if (cvl_error())
+	return;
+
+    cvl_context_t *ctx = cvl_context();
+
+    // Check if we can perform the operation
+    if (ctx->cvl_gl_max_texture_array_layers == 0)
+    {
+	cvl_error_set(CVL_ERROR_GL, "OpenGL extension GL_EXT_texture_array is not available");
+	return;
+    }
+    if (nsrcs > ctx->cvl_gl_max_texture_array_layers)
+    {
+	cvl_error_set(CVL_ERROR_GL, "%d texture array layers needed, but only %d available",
+		nsrcs, ctx->cvl_gl_max_texture_array_layers);
+	return;
+    }
+
+    // Setup the texture array. It is kept in the context and reused as long as
+    // it is large enough.
+    int width = cvl_frame_width(srcs[0]);
+    int height = cvl_frame_height(srcs[0]);
+    int channels = cvl_frame_channels(srcs[0]);
+    GLint format = ctx->cvl_gl_texture_formats[cvl_frame_type(srcs[0])][channels - 1];
+    if (ctx->cvl_gl_texture_array == 0
+	    || ctx->cvl_gl_texture_array_width != width
+	    || ctx->cvl_gl_texture_array_height != height
+	    || ctx->cvl_gl_texture_array_layers < nsrcs
+	    || ctx->cvl_gl_texture_array_format != format)
+    {
+	if (ctx->cvl_gl_texture_array == 0)
+	    glGenTextures(1, &(ctx->cvl_gl_texture_array));
+	glBindTexture(GL_TEXTURE_2D_ARRAY_EXT, ctx->cvl_gl_texture_array);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY_EXT, 0, format, width, height, nsrcs, 0,
+		GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	ctx->cvl_gl_texture_array_width = width;
+	ctx->cvl_gl_texture_array_height = height;
+	ctx->cvl_gl_texture_array_layers = nsrcs;
+	ctx->cvl_gl_texture_array_format = format;
+    }
+
+    // Copy the sources into the layers
+    for (int i = 0; i < nsrcs; i++)
+    {
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, 
+		GL_TEXTURE_2D, cvl_frame_texture(srcs[i]), 0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY_EXT, ctx->cvl_gl_texture_array);
+	glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY_EXT, 0, 0, 0, i, 0, 0, width, height);
+    }
+
+    // Setup destination
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(dst));
+    cvl_gl_set_texture_state();
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, 
+	    GL_TEXTURE_2D, cvl_frame_texture(dst), 0);
+
+    // Setup source
+    GLint prg;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prg);
+    glUniform1i(glGetUniformLocation(prg, array_name), 0);
+
+    // Render
+    glViewport(0, 0, cvl_frame_width(dst), cvl_frame_height(dst));
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
+    glDrawArrays(GL_QUADS, 0, 4);
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(dst));
+
+    cvl_check_errors();
 }
@@ -514,6 +514,33 @@ char *cvl_gl_srcprep(char *src, const char *defines, ...)
     return src;
 }
 
+/**
+ * \param src		The shader source code.
+ * \param name		The name of the placeholder.
+ * \param code		The code to insert.
+ *
+ * Inserts shader code that is shared by several shaders, such as a function,
+ * into a shader source code string: all occurences of the placeholder \a name
+ * (for example "$xyz_to_rgb_func") in \a src are replaced with \a code.
+ * This must be done before cvl_gl_srcprep() is called.
+ * The string \a src must be allocated.
+ */
+char *cvl_gl_srcinsert(char *src, const char *name, const char *code)
+{
+    cvl_assert(src != NULL);
+    cvl_assert(name != NULL);
+    cvl_assert(code != NULL);
+    if (cvl_error())
+	return NULL;
+
+    if (!(src = cvl_str_replace(src, name, code)))
+    {
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return NULL;
+    }
+    return src;
+}
+
 /**
  * \param name		The shader name.
  * \param type		GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
@@ -594,6 +621,10 @@ GLuint cvl_gl_program_new(const char *name, GLuint vshader, GLuint fshader)
 	glAttachShader(program, vshader);
     if (fshader != 0)
 	glAttachShader(program, fshader);
+#ifdef GL_ARB_get_program_binary
+    if (cvl_context()->cvl_gl_program_binaries)
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
     glLinkProgram(program);
 
     char *log;
@@ -647,12 +678,15 @@ GLuint cvl_gl_program_new_src(const char *name, const char *vshader_src, const c
     if (cvl_error())
 	return 0;
 
+    double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
     GLuint vshader = 0, fshader = 0;
     if (vshader_src)
 	vshader = cvl_gl_shader(name, GL_VERTEX_SHADER, vshader_src);
     if (fshader_src)
 	fshader = cvl_gl_shader(name, GL_FRAGMENT_SHADER, fshader_src);
-    return cvl_gl_program_new(name, vshader, fshader);
+    GLuint program = cvl_gl_program_new(name, vshader, fshader);
+    cvl_profile_span("cvl_gl_program_new_src", name, cvl_context()->cvl_profile_frame, start, 0, 0);
+    return program;
 }
 
 /**
@@ -714,7 +748,16 @@ GLuint cvl_gl_program_cache_get(const char *name)
 	else
 	    return ctx->cvl_gl_program_cache_values[c];
     }
-    return 0;    
+    if (ctx->cvl_gl_program_binaries)
+    {
+	GLuint program = cvl_gl_program_binaries_get(name);
+	if (program != 0)
+	{
+	    cvl_gl_program_cache_put(name, program);
+	    return program;
+	}
+    }
+    return 0;
 }
 
 /**
@@ -773,6 +816,134 @@ void cvl_gl_program_cache_put(const char *name, GLuint program)
     }
     ctx->cvl_gl_program_cache_values[a] = program;
     ctx->cvl_gl_program_cache_length++;
+    if (ctx->cvl_gl_program_binaries)
+	cvl_gl_program_binaries_put(name, program);
+}
+
+/* Binary search in the shared program binaries. The mutex must be locked.
+ * Returns the index of the entry, or -(insertion index)-1. */
+static int cvl_gl_program_binaries_find(cvl_gl_program_binaries_t *pb, const char *name)
+{
+    int a = 0;
+    int b = pb->length - 1;
+    while (b >= a)
+    {
+	int c = (a + b) / 2;
+	int cmp = strcmp(pb->names[c], name);
+	if (cmp < 0)
+	    a = c + 1;
+	else if (cmp > 0)
+	    b = c - 1;
+	else
+	    return c;
+    }
+    return -a - 1;
+}
+
+/* Create the program with the given name from the binaries that another CVL
+ * context stored. Returns 0 if there is no such binary, or if the GL
+ * implementation does not accept it. */
+GLuint cvl_gl_program_binaries_get(const char *name)
+{
+    GLuint program = 0;
+#ifdef GL_ARB_get_program_binary
+    cvl_gl_program_binaries_t *pb = cvl_context()->cvl_gl_program_binaries;
+#if HAVE_PTHREAD
+    pthread_mutex_lock(&pb->mutex);
+#endif
+    int i = cvl_gl_program_binaries_find(pb, name);
+    if (i >= 0)
+    {
+	GLint e;
+	program = glCreateProgram();
+	glProgramBinary(program, pb->formats[i], pb->binaries[i], pb->lengths[i]);
+	glGetProgramiv(program, GL_LINK_STATUS, &e);
+	if (e != GL_TRUE)
+	{
+	    glDeleteProgram(program);
+	    program = 0;
+	}
+    }
+#if HAVE_PTHREAD
+    pthread_mutex_unlock(&pb->mutex);
+#endif
+    /* A rejected binary may leave a GL error behind; it is not a CVL error
+     * because we can still compile the program from source. */
+    if (program == 0)
+	while (glGetError() != GL_NO_ERROR);
+#endif
+    return program;
+}
+
+/* Store the binary of the given program so that other CVL contexts do not
+ * need to compile it again. */
+void cvl_gl_program_binaries_put(const char *name, GLuint program)
+{
+#ifdef GL_ARB_get_program_binary
+    cvl_gl_program_binaries_t *pb = cvl_context()->cvl_gl_program_binaries;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+	return;
+#if HAVE_PTHREAD
+    pthread_mutex_lock(&pb->mutex);
+#endif
+    int i = cvl_gl_program_binaries_find(pb, name);
+    if (i < 0)
+    {
+	i = -i - 1;
+	void *binary = malloc(length);
+	char *namecopy = strdup(name);
+	bool have_space = (pb->length < pb->size);
+	if (!have_space)
+	{
+	    /* Each array that could be enlarged replaces the old one, which
+	     * remains valid for the old size. The size only grows if all arrays
+	     * could be enlarged. */
+	    int size = pb->size + 20;
+	    char **names = realloc(pb->names, size * sizeof(char *));
+	    if (names)
+		pb->names = names;
+	    GLenum *formats = realloc(pb->formats, size * sizeof(GLenum));
+	    if (formats)
+		pb->formats = formats;
+	    GLsizei *lengths = realloc(pb->lengths, size * sizeof(GLsizei));
+	    if (lengths)
+		pb->lengths = lengths;
+	    void **binaries = realloc(pb->binaries, size * sizeof(void *));
+	    if (binaries)
+		pb->binaries = binaries;
+	    if (names && formats && lengths && binaries)
+	    {
+		pb->size = size;
+		have_space = true;
+	    }
+	}
+	if (!binary || !namecopy || !have_space)
+	{
+	    free(binary);
+	    free(namecopy);
+	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	}
+	else
+	{
+	    for (int j = pb->length; j > i; j--)
+	    {
+		pb->names[j] = pb->names[j - 1];
+		pb->formats[j] = pb->formats[j - 1];
+		pb->lengths[j] = pb->lengths[j - 1];
+		pb->binaries[j] = pb->binaries[j - 1];
+	    }
+	    glGetProgramBinary(program, length, &(pb->lengths[i]), &(pb->formats[i]), binary);
+	    pb->names[i] = namecopy;
+	    pb->binaries[i] = binary;
+	    pb->length++;
+	}
+    }
+#if HAVE_PTHREAD
+    pthread_mutex_unlock(&pb->mutex);
+#endif
+#endif
 }
 
 
@@ -48,17 +48,23 @@
 #include "cvl_intern.h"
 #include "cvl/cvl.h"
 
+#include "glsl/color/xyz_to_rgb_func.glsl.h"
 #include "glsl/hdr/log_avg_lum.glsl.h"
+#include "glsl/hdr/lum_statistics.glsl.h"
 #include "glsl/hdr/tonemap_schlick94.glsl.h"
 #include "glsl/hdr/tonemap_tumblin99.glsl.h"
 #include "glsl/hdr/tonemap_drago03.glsl.h"
 #include "glsl/hdr/tonemap_reinhard05.glsl.h"
+#include "glsl/hdr/tonemap_lut.glsl.h"
+#include "glsl/hdr/tonemap_scales_downsample.glsl.h"
+#include "glsl/hdr/tonemap_scales_blur.glsl.h"
 #include "glsl/hdr/tonemap_ashikhmin02_step1.glsl.h"
 #include "glsl/hdr/tonemap_ashikhmin02_step2.glsl.h"
+#include "glsl/hdr/tonemap_durand02_combine.glsl.h"
+#include "glsl/hdr/tonemap_durand02_log.glsl.h"
 #include "glsl/hdr/tonemap_durand02_step1.glsl.h"
 #include "glsl/hdr/tonemap_durand02_step2.glsl.h"
-#include "glsl/hdr/tonemap_reinhard02_step1.glsl.h"
-#include "glsl/hdr/tonemap_reinhard02_step2.glsl.h"
+#include "glsl/hdr/tonemap_reinhard02.glsl.h"
 
 
 /**
@@ -96,6 +102,264 @@ float cvl_log_avg_lum(cvl_frame_t *frame, cvl_frame_t *tmp, float max_abs_lum)
 }
 
 
+/**
+ * \param frame		The frame.
+ * \param max_abs_lum	Maximum absolute luminance.
+ * \param min_lum	Pointer to the minimum luminance, or NULL.
+ * \param max_lum	Pointer to the maximum luminance, or NULL.
+ * \param avg_lum	Pointer to the average luminance, or NULL.
+ * \param log_avg_lum	Pointer to the log average luminance, or NULL.
+ * \param channel_avg	Pointer to 3 floats for the average RGB channel values, or NULL.
+ *
+ * Computes the statistics that tone mapping operators need from the #CVL_XYZ
+ * frame \a frame in a single reduction: the minimum, maximum, and average
+ * luminance, the log average luminance with respect to the given maximum
+ * absolute luminance (see cvl_log_avg_lum()), and the average channel values
+ * of the #CVL_RGB version of \a frame (see cvl_tonemap_reinhard05()).\n
+ * If any of the result pointers is NULL, the corresponding value is not stored.
+ */
+void cvl_lum_statistics(cvl_frame_t *frame, float max_abs_lum,
+	float *min_lum, float *max_lum, float *avg_lum, float *log_avg_lum, float *channel_avg)
+{
+    cvl_assert(frame != NULL);
+    cvl_assert(cvl_frame_format(frame) == CVL_XYZ);
+    cvl_assert(max_abs_lum > 0.0f);
+    if (cvl_error())
+	return;
+
+    float size = (float)cvl_frame_size(frame);
+    float lum[4];
+    float rgb[4];
+
+    if (cvl_context()->cvl_gl_max_render_targets < 2)
+    {
+	cvl_frame_t *tmp = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
+		3, CVL_RGB, CVL_FLOAT, CVL_TEXTURE);
+	cvl_reduce(frame, CVL_REDUCE_MIN, 1, &(lum[0]));
+	cvl_reduce(frame, CVL_REDUCE_MAX, 1, &(lum[1]));
+	cvl_reduce(frame, CVL_REDUCE_SUM, 1, &(lum[2]));
+	lum[3] = logf(cvl_log_avg_lum(frame, tmp, max_abs_lum)) * size;
+	cvl_convert_format(tmp, frame);
+	cvl_reduce(tmp, CVL_REDUCE_SUM, -1, rgb);
+	cvl_frame_free(tmp);
+    }
+    else
+    {
+	cvl_frame_t *srcs[2] = { frame };
+	cvl_frame_t *dsts[2];
+	int src_w = cvl_frame_width(frame);
+	int src_h = cvl_frame_height(frame);
+	bool first = true;
+	do
+	{
+	    int dst_w = (src_w + 1) / 2;
+	    int dst_h = (src_h + 1) / 2;
+	    for (int i = 0; i < 2; i++)
+		dsts[i] = cvl_frame_new(dst_w, dst_h, 4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
+	    GLuint prg;
+	    const char *prg_name = first ? "cvl_lum_statistics_first" : "cvl_lum_statistics";
+	    if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+	    {
+		char *src = cvl_gl_srcinsert(cvl_strdup(CVL_LUM_STATISTICS_GLSL_STR),
+			"$xyz_to_rgb_func", CVL_XYZ_TO_RGB_FUNC_GLSL_STR);
+		src = cvl_gl_srcprep(src, "$first=%s", first ? "true" : "false");
+		prg = cvl_gl_program_new_src(prg_name, NULL, src);
+		cvl_gl_program_cache_put(prg_name, prg);
+		free(src);
+	    }
+	    glUseProgram(prg);
+	    glUniform2f(glGetUniformLocation(prg, "src_size"), src_w, src_h);
+	    glUniform2f(glGetUniformLocation(prg, "dst_size"), dst_w, dst_h);
+	    glUniform1f(glGetUniformLocation(prg, "max_abs_lum"), max_abs_lum);
+	    cvl_transform_multi(dsts, 2, srcs, first ? 1 : 2, "textures");
+	    for (int i = 0; i < 2; i++)
+	    {
+		if (!first)
+		    cvl_frame_free(srcs[i]);
+		srcs[i] = dsts[i];
+	    }
+	    src_w = dst_w;
+	    src_h = dst_h;
+	    first = false;
+	}
+	while (src_w > 1 || src_h > 1);
+
+	float *results[2] = { lum, rgb };
+	for (int i = 0; i < 2; i++)
+	{
+	    const float *p = cvl_frame_pointer(srcs[i]);
+	    if (p)
+		memcpy(results[i], p, 4 * sizeof(float));
+	    cvl_frame_free(srcs[i]);
+	}
+    }
+    if (cvl_error())
+	return;
+
+    if (min_lum)
+	*min_lum = lum[0];
+    if (max_lum)
+	*max_lum = lum[1];
+    if (avg_lum)
+	*avg_lum = lum[2] / size;
+    if (log_avg_lum)
+	*log_avg_lum = expf(lum[3] / size);
+    if (channel_avg)
+    {
+	for (int c = 0; c < 3; c++)
+	    channel_avg[c] = rgb[c] / size;
+    }
+    cvl_check_errors();
+}
+
+
+typedef struct
+{
+    float alpha;
+    bool empty;
+    float min_lum;
+    float max_lum;
+    float avg_lum;
+    float log_log_avg_lum;
+    float channel_avg[3];
+} cvl__lum_adaptation_t;
+
+/**
+ * \param time_constant	The time constant, in frames.
+ * \return		The adaptation state.
+ *
+ * Creates a new luminance adaptation state for tone mapping of HDR videos.
+ * Tone mapping each frame of a video with statistics computed from that frame
+ * alone leads to flickering whenever these statistics change abruptly.
+ * Instead, the statistics of each new frame given to
+ * cvl_lum_adaptation_put() are blended into the current adaptation state
+ * with exponential smoothing, so that a sudden change of the input is
+ * reflected in the state after approximately \a time_constant frames.
+ * A time constant of zero disables smoothing.\n
+ * The log average luminance is smoothed in the logarithmic domain.\n
+ * The adaptation state must be freed with cvl_lum_adaptation_free().
+ */
+cvl_lum_adaptation_t *cvl_lum_adaptation_new(float time_constant)
+{
+    cvl_assert(time_constant >= 0.0f);
+    if (cvl_error())
+	return NULL;
+
+    cvl__lum_adaptation_t *la;
+    if (!(la = calloc(1, sizeof(cvl__lum_adaptation_t))))
+    {
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return NULL;
+    }
+    la->alpha = (time_constant > 0.0f ? 1.0f - expf(-1.0f / time_constant) : 1.0f);
+    la->empty = true;
+    return (cvl_lum_adaptation_t *)la;
+}
+
+/**
+ * \param adaptation	The adaptation state.
+ *
+ * Frees a luminance adaptation state.
+ */
+void cvl_lum_adaptation_free(cvl_lum_adaptation_t *adaptation)
+{
+    free(adaptation);
+}
+
+/**
+ * \param adaptation	The adaptation state.
+ * \param frame		The next frame.
+ * \param max_abs_lum	Maximum absolute luminance.
+ *
+ * Computes the luminance statistics of \a frame with cvl_lum_statistics() and
+ * updates the adaptation state with them. The first frame initializes the
+ * state.
+ */
+void cvl_lum_adaptation_put(cvl_lum_adaptation_t *adaptation, cvl_frame_t *frame, float max_abs_lum)
+{
+    cvl_assert(adaptation != NULL);
+    cvl_assert(frame != NULL);
+    cvl_assert(cvl_frame_format(frame) == CVL_XYZ);
+    cvl_assert(max_abs_lum > 0.0f);
+    if (cvl_error())
+	return;
+
+    float min_lum, max_lum, avg_lum, log_avg_lum, channel_avg[3];
+    cvl_lum_statistics(frame, max_abs_lum, &min_lum, &max_lum, &avg_lum, &log_avg_lum, channel_avg);
+    if (cvl_error())
+	return;
+    cvl_lum_adaptation_put_statistics(adaptation, min_lum, max_lum, avg_lum, log_avg_lum, channel_avg);
+}
+
+/**
+ * \param adaptation	The adaptation state.
+ * \param min_lum	The minimum luminance of the next frame.
+ * \param max_lum	The maximum luminance of the next frame.
+ * \param avg_lum	The average luminance of the next frame.
+ * \param log_avg_lum	The log average luminance of the next frame.
+ * \param channel_avg	The 3 average RGB channel values of the next frame.
+ *
+ * Updates the adaptation state with luminance statistics that were already
+ * computed with cvl_lum_statistics(), e.g. because they are shared by several
+ * adaptation states. The first frame initializes the state.
+ */
+void cvl_lum_adaptation_put_statistics(cvl_lum_adaptation_t *adaptation,
+	float min_lum, float max_lum, float avg_lum, float log_avg_lum, const float *channel_avg)
+{
+    cvl_assert(adaptation != NULL);
+    cvl_assert(log_avg_lum > 0.0f);
+    cvl_assert(channel_avg != NULL);
+    if (cvl_error())
+	return;
+
+    cvl__lum_adaptation_t *la = (cvl__lum_adaptation_t *)adaptation;
+    float a = (la->empty ? 1.0f : la->alpha);
+    la->min_lum += a * (min_lum - la->min_lum);
+    la->max_lum += a * (max_lum - la->max_lum);
+    la->avg_lum += a * (avg_lum - la->avg_lum);
+    la->log_log_avg_lum += a * (logf(log_avg_lum) - la->log_log_avg_lum);
+    for (int c = 0; c < 3; c++)
+	la->channel_avg[c] += a * (channel_avg[c] - la->channel_avg[c]);
+    la->empty = false;
+}
+
+/**
+ * \param adaptation	The adaptation state.
+ * \param min_lum	Pointer to the minimum luminance, or NULL.
+ * \param max_lum	Pointer to the maximum luminance, or NULL.
+ * \param avg_lum	Pointer to the average luminance, or NULL.
+ * \param log_avg_lum	Pointer to the log average luminance, or NULL.
+ * \param channel_avg	Pointer to 3 floats for the average RGB channel values, or NULL.
+ *
+ * Gets the adapted luminance statistics. See cvl_lum_statistics() for their
+ * meaning. At least one frame must have been given to cvl_lum_adaptation_put()
+ * before.
+ */
+void cvl_lum_adaptation_get(cvl_lum_adaptation_t *adaptation,
+	float *min_lum, float *max_lum, float *avg_lum, float *log_avg_lum, float *channel_avg)
+{
+    cvl_assert(adaptation != NULL);
+    cvl_assert(!((cvl__lum_adaptation_t *)adaptation)->empty);
+    if (cvl_error())
+	return;
+
+    cvl__lum_adaptation_t *la = (cvl__lum_adaptation_t *)adaptation;
+    if (min_lum)
+	*min_lum = la->min_lum;
+    if (max_lum)
+	*max_lum = la->max_lum;
+    if (avg_lum)
+	*avg_lum = la->avg_lum;
+    if (log_avg_lum)
+	*log_avg_lum = expf(la->log_log_avg_lum);
+    if (channel_avg)
+    {
+	for (int c = 0; c < 3; c++)
+	    channel_avg[c] = la->channel_avg[c];
+    }
+}
+
+
 /**
  * \param dst		The destination frame.
  * \param src		The source frame.
@@ -141,6 +405,18 @@ static float cvl_tonemap_tumblin_gamma(float L)
     return (L > 100.0f) ? 2.655f : 1.855f + 0.4f * logf(L + 2.3e-5f) / logf(10.0f);
 }
 
+// Helper function
+static void cvl_tonemap_tumblin99_params(float log_avg_lum,
+	float display_adaptation_level, float max_displayable_contrast,
+	float *gamma_w, float *gamma_d, float *m)
+{
+    float world_adaptation_level = log_avg_lum;
+    *gamma_d = cvl_tonemap_tumblin_gamma(display_adaptation_level);
+    *gamma_w = cvl_tonemap_tumblin_gamma(world_adaptation_level);
+    float gamma_wd = *gamma_w / (1.855f + 0.4f * logf(display_adaptation_level) / logf(10.0f));
+    *m = powf(sqrtf(max_displayable_contrast), gamma_wd - 1.0f);
+}
+
 /**
  * \param dst				The destination frame.
  * \param src				The source frame.
@@ -175,10 +451,9 @@ void cvl_tonemap_tumblin99(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum
 	return;
 
     float world_adaptation_level = log_avg_lum;
-    float gamma_d = cvl_tonemap_tumblin_gamma(display_adaptation_level);
-    float gamma_w = cvl_tonemap_tumblin_gamma(world_adaptation_level);
-    float gamma_wd = gamma_w / (1.855f + 0.4f * logf(display_adaptation_level) / logf(10.0f));
-    float m = powf(sqrtf(max_displayable_contrast), gamma_wd - 1.0f);
+    float gamma_w, gamma_d, m;
+    cvl_tonemap_tumblin99_params(log_avg_lum, display_adaptation_level, max_displayable_contrast,
+	    &gamma_w, &gamma_d, &m);
     GLuint prg;
     if ((prg = cvl_gl_program_cache_get("cvl_tonemap_tumblin99")) == 0)
     {
@@ -245,6 +520,166 @@ void cvl_tonemap_drago03(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
 }
 
 
+/* The luminance range covered by tone mapping lookup tables, in log2 units.
+ * Luminance values outside this range are mapped like the nearest border. */
+#define CVL_TONEMAP_LUT_LOG2_MIN (-32.0f)
+#define CVL_TONEMAP_LUT_LOG2_MAX (1.0f)
+
+// Helper function: check the lookup table frame and get its entries.
+static float *cvl_tonemap_lut_pointer(cvl_frame_t *lut)
+{
+    cvl_assert(lut != NULL);
+    cvl_assert(cvl_frame_width(lut) >= 2);
+    cvl_assert(cvl_frame_height(lut) == 1);
+    cvl_assert(cvl_frame_format(lut) == CVL_LUM);
+    cvl_assert(cvl_frame_type(lut) == CVL_FLOAT);
+    if (cvl_error())
+	return NULL;
+    return cvl_frame_pointer(lut);
+}
+
+// Helper function: the luminance value sampled by entry i of a lookup table.
+static float cvl_tonemap_lut_lum(cvl_frame_t *lut, int i)
+{
+    float t = (float)i / (float)(cvl_frame_width(lut) - 1);
+    return exp2f(CVL_TONEMAP_LUT_LOG2_MIN + t * (CVL_TONEMAP_LUT_LOG2_MAX - CVL_TONEMAP_LUT_LOG2_MIN));
+}
+
+/**
+ * \param lut		The lookup table.
+ * \param p		Parameter.
+ *
+ * Bakes the tone mapping curve of cvl_tonemap_schlick94() into the lookup
+ * table \a lut, for use with cvl_tonemap_lut().\n
+ * See cvl_tonemap_lut() for the requirements on \a lut.
+ */
+void cvl_tonemap_lut_schlick94(cvl_frame_t *lut, float p)
+{
+    cvl_assert(p >= 1.0f);
+    float *ptr = cvl_tonemap_lut_pointer(lut);
+    if (!ptr)
+	return;
+
+    for (int i = 0; i < cvl_frame_width(lut); i++)
+    {
+	float old_Y = cvl_tonemap_lut_lum(lut, i);
+	float new_Y = (p * old_Y) / ((p - 1.0f) * old_Y + 1.0f);
+	ptr[i] = cvl_clampf(new_Y, 0.00001f, 1.0f);
+    }
+}
+
+/**
+ * \param lut				The lookup table.
+ * \param max_abs_lum			Maximum absolute luminance.
+ * \param log_avg_lum			The log-average luminance.
+ * \param display_adaptation_level	Display adaptation level.
+ * \param max_displayable_contrast	Maximum displayable contrast.
+ *
+ * Bakes the tone mapping curve of cvl_tonemap_tumblin99() into the lookup
+ * table \a lut, for use with cvl_tonemap_lut().\n
+ * See cvl_tonemap_tumblin99() for the parameters, and cvl_tonemap_lut() for
+ * the requirements on \a lut.
+ */
+void cvl_tonemap_lut_tumblin99(cvl_frame_t *lut, float max_abs_lum,
+	float log_avg_lum, float display_adaptation_level, float max_displayable_contrast)
+{
+    cvl_assert(max_abs_lum > 0.0f);
+    cvl_assert(display_adaptation_level > 0.0f);
+    cvl_assert(max_displayable_contrast > 0.0f);
+    float *ptr = cvl_tonemap_lut_pointer(lut);
+    if (!ptr)
+	return;
+
+    float gamma_w, gamma_d, m;
+    cvl_tonemap_tumblin99_params(log_avg_lum, display_adaptation_level, max_displayable_contrast,
+	    &gamma_w, &gamma_d, &m);
+    for (int i = 0; i < cvl_frame_width(lut); i++)
+    {
+	float old_Y = max_abs_lum * cvl_tonemap_lut_lum(lut, i);
+	float new_Y = m * display_adaptation_level * powf(old_Y / log_avg_lum, gamma_w / gamma_d) / 1000.0f;
+	ptr[i] = cvl_clampf(new_Y, 0.00001f, 1.0f);
+    }
+}
+
+/**
+ * \param lut			The lookup table.
+ * \param max_abs_lum		Maximum absolute luminance.
+ * \param bias			Bias.
+ * \param max_disp_lum		Maximum display luminance.
+ *
+ * Bakes the tone mapping curve of cvl_tonemap_drago03() into the lookup
+ * table \a lut, for use with cvl_tonemap_lut().\n
+ * See cvl_tonemap_drago03() for the parameters, and cvl_tonemap_lut() for the
+ * requirements on \a lut.
+ */
+void cvl_tonemap_lut_drago03(cvl_frame_t *lut, float max_abs_lum, float bias, float max_disp_lum)
+{
+    cvl_assert(max_abs_lum > 0.0f);
+    cvl_assert(bias >= 0.0f && bias <= 1.0f);
+    cvl_assert(max_disp_lum > 0.0f);
+    float *ptr = cvl_tonemap_lut_pointer(lut);
+    if (!ptr)
+	return;
+
+    float factor = (max_disp_lum / 100.0f) / logf(1.0f + max_abs_lum);
+    float bias_cooked = logf(bias) / logf(0.5f);
+    for (int i = 0; i < cvl_frame_width(lut); i++)
+    {
+	float old_Y = max_abs_lum * cvl_tonemap_lut_lum(lut, i);
+	float new_Y = factor * (logf(1.0f + old_Y) / logf(2.0f + 8.0f * powf(old_Y, bias_cooked)));
+	ptr[i] = cvl_clampf(new_Y, 0.00001f, 1.0f);
+    }
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param lut		The lookup table.
+ *
+ * Applies a global tone mapping curve that was baked into the lookup table
+ * \a lut to the high dynamic range frame \a src and writes the result to
+ * \a dst. Input and output must be in #CVL_XYZ format.\n
+ * The lookup table must be a #CVL_LUM frame of type #CVL_FLOAT with a height
+ * of 1 and a width of at least 2; a width of 4096 is recommended. It samples
+ * the curve at luminance values that are evenly spaced in the log domain.
+ * It is filled by cvl_tonemap_lut_schlick94(), cvl_tonemap_lut_tumblin99(),
+ * or cvl_tonemap_lut_drago03().\n
+ * The curve only depends on the parameters of the tone mapping operator, so
+ * the lookup table can be reused for all frames as long as these parameters
+ * do not change. This avoids evaluating the operator per pixel.
+ */
+void cvl_tonemap_lut(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *lut)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(cvl_frame_format(dst) == CVL_XYZ);
+    cvl_assert(cvl_frame_format(src) == CVL_XYZ);
+    cvl_assert(lut != NULL);
+    cvl_assert(cvl_frame_width(lut) >= 2);
+    cvl_assert(cvl_frame_height(lut) == 1);
+    if (cvl_error())
+	return;
+
+    GLuint prg;
+    if ((prg = cvl_gl_program_cache_get("cvl_tonemap_lut")) == 0)
+    {
+	prg = cvl_gl_program_new_src("cvl_tonemap_lut", NULL, 
+		CVL_TONEMAP_LUT_GLSL_STR);
+	cvl_gl_program_cache_put("cvl_tonemap_lut", prg);
+    }
+    glUseProgram(prg);
+    float scale = (float)(cvl_frame_width(lut) - 1) / (CVL_TONEMAP_LUT_LOG2_MAX - CVL_TONEMAP_LUT_LOG2_MIN);
+    glUniform1f(glGetUniformLocation(prg, "lut_size"), cvl_frame_width(lut));
+    glUniform1f(glGetUniformLocation(prg, "scale"), scale);
+    glUniform1f(glGetUniformLocation(prg, "offset"), - CVL_TONEMAP_LUT_LOG2_MIN * scale);
+    cvl_frame_t *srcs[2] = { src, lut };
+    cvl_transform_multi(&dst, 1, srcs, 2, "textures");
+
+    cvl_check_errors();
+}
+
+
 /**
  * \param dst			The destination frame.
  * \param src			The source frame.
@@ -439,6 +874,8 @@ void cvl_tonemap_ashikhmin02(cvl_frame_t *dst, cvl_frame_t *src,
  * #CVL_FLOAT16.
  * The sigma values must be greater than zero, and the \a base_contrast
  * parameter must be grater than 1.\n
+ * Masks larger than 9x9 (\a k > 4) use cvl_bilateral(), whose cost does not
+ * depend on the mask size.\n
  * See also:
  * F. Durand and J. Dorsey, Fast Bilateral Filtering for the Display of 
  * High-Dynamic-Range Images, Proc. ACM SIGGRAPH 2002, pp. 257-266.
@@ -455,17 +892,16 @@ void cvl_tonemap_durand02(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
     cvl_assert(cvl_frame_channels(tmp) == 4);
     cvl_assert(cvl_frame_type(tmp) == CVL_FLOAT || cvl_frame_type(tmp) == CVL_FLOAT16);
     cvl_assert(max_abs_lum > 0.0f);
-    cvl_assert(k >= 0 && k <= 32);
+    cvl_assert(k >= 0);
     cvl_assert(sigma_spatial > 0.0f);
     cvl_assert(sigma_luminance > 0.0f);
     cvl_assert(base_contrast > 1.0f);
     if (cvl_error())
 	return;
 
-    // Bilateral filtering is not separable. We implement it directly, which
-    // limits us to mask sizes of up to 9x9. Larger masks cannot be handled by
-    // current graphics hardware. But it turns out that we only need 3x3 or 5x5
-    // masks for this method, so this should be tolerable.
+    // Bilateral filtering is not separable. Small masks are implemented
+    // directly. Larger masks use the bilateral grid, which allows the large
+    // spatial sigmas that the paper recommends.
     //
     // The following paper suggests that separating the bilateral filter is
     // good enough as an approximation in many cases:
@@ -476,26 +912,57 @@ void cvl_tonemap_durand02(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
     
     GLuint prg;
     char *prg_name;
-    float mask[2 * k + 1];
 
-    cvl_gauss_mask(k, sigma_spatial, mask, NULL);
-
-    prg_name = cvl_asprintf("cvl_tonemap_durand02_step1_k=%d", k);
-    if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+    if (k > 4)
     {
-	char *src = cvl_gl_srcprep(cvl_strdup(CVL_TONEMAP_DURAND02_STEP1_GLSL_STR), "$k=%d", k);
-	prg = cvl_gl_program_new_src(prg_name, NULL, src);
-	cvl_gl_program_cache_put(prg_name, prg);
-	free(src);
+	cvl_frame_t *log_lum = cvl_frame_new(cvl_frame_width(src), cvl_frame_height(src),
+		1, CVL_LUM, CVL_FLOAT, CVL_TEXTURE);
+	cvl_frame_t *log_base = cvl_frame_new_tpl(log_lum);
+	if ((prg = cvl_gl_program_cache_get("cvl_tonemap_durand02_log")) == 0)
+	{
+	    prg = cvl_gl_program_new_src("cvl_tonemap_durand02_log", NULL, 
+		    CVL_TONEMAP_DURAND02_LOG_GLSL_STR);
+	    cvl_gl_program_cache_put("cvl_tonemap_durand02_log", prg);
+	}
+	glUseProgram(prg);
+	glUniform1f(glGetUniformLocation(prg, "max_abs_lum"), max_abs_lum);
+	cvl_transform(log_lum, src);
+	cvl_bilateral(log_base, log_lum, sigma_spatial, sigma_luminance);
+	if ((prg = cvl_gl_program_cache_get("cvl_tonemap_durand02_combine")) == 0)
+	{
+	    prg = cvl_gl_program_new_src("cvl_tonemap_durand02_combine", NULL, 
+		    CVL_TONEMAP_DURAND02_COMBINE_GLSL_STR);
+	    cvl_gl_program_cache_put("cvl_tonemap_durand02_combine", prg);
+	}
+	glUseProgram(prg);
+	glUniform1f(glGetUniformLocation(prg, "max_abs_lum"), max_abs_lum);
+	cvl_frame_t *srcs[2] = { src, log_base };
+	cvl_transform_multi(&tmp, 1, srcs, 2, "textures");
+	cvl_frame_free(log_lum);
+	cvl_frame_free(log_base);
+    }
+    else
+    {
+	float mask[2 * k + 1];
+	cvl_gauss_mask(k, sigma_spatial, mask, NULL);
+
+	prg_name = cvl_asprintf("cvl_tonemap_durand02_step1_k=%d", k);
+	if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_TONEMAP_DURAND02_STEP1_GLSL_STR), "$k=%d", k);
+	    prg = cvl_gl_program_new_src(prg_name, NULL, src);
+	    cvl_gl_program_cache_put(prg_name, prg);
+	    free(src);
+	}
+	free(prg_name);
+	glUseProgram(prg);
+	glUniform1f(glGetUniformLocation(prg, "step_h"), 1.0f / (float)cvl_frame_width(src));
+	glUniform1f(glGetUniformLocation(prg, "step_v"), 1.0f / (float)cvl_frame_height(src));
+	glUniform1fv(glGetUniformLocation(prg, "mask"), 2 * k + 1, mask);
+	glUniform1f(glGetUniformLocation(prg, "max_abs_lum"), max_abs_lum);
+	glUniform1f(glGetUniformLocation(prg, "sigma_luminance"), sigma_luminance);
+	cvl_transform(tmp, src);
     }
-    free(prg_name);
-    glUseProgram(prg);
-    glUniform1f(glGetUniformLocation(prg, "step_h"), 1.0f / (float)cvl_frame_width(src));
-    glUniform1f(glGetUniformLocation(prg, "step_v"), 1.0f / (float)cvl_frame_height(src));
-    glUniform1fv(glGetUniformLocation(prg, "mask"), 2 * k + 1, mask);
-    glUniform1f(glGetUniformLocation(prg, "max_abs_lum"), max_abs_lum);
-    glUniform1f(glGetUniformLocation(prg, "sigma_luminance"), sigma_luminance);
-    cvl_transform(tmp, src);
 
     float min_log_base, max_log_base;
     cvl_reduce(tmp, CVL_REDUCE_MIN, 1, &min_log_base);
@@ -522,6 +989,207 @@ void cvl_tonemap_durand02(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
 }
 
 
+/*
+ * Multi-scale luminance for cvl_tonemap_reinhard02().
+ *
+ * Scale i is the luminance of the source smoothed with a gaussian of standard
+ * deviation sigma[i]. Instead of applying large masks at full resolution, each
+ * scale is computed on the coarsest level of a luminance pyramid on which the
+ * remaining gaussian still has a standard deviation of at least one pixel, and
+ * the tone mapping shader upsamples it with bilinear interpolation.
+ * Each pyramid level is filtered with the binomial weights 1 3 3 1 around
+ * blocks of 2x2 pixels of the previous level. This filter has a variance of
+ * 3/4 pixels of the previous level, so level l has a variance of (4^l - 1) / 4
+ * in source pixels. Unlike plain averaging of 2x2 blocks, it is close to a
+ * gaussian and suppresses aliasing, so that the coarse levels do not alias
+ * fine details into the large scales. Bilinear upsampling adds a variance of
+ * 4^l / 6.
+ * The remaining variance is applied with a separable gaussian on level l.
+ * Scales on the same level share the filter passes, up to four at a time.
+ */
+
+// Helper function: the pyramid level for a scale, and the standard deviation
+// of the gaussian that must be applied on that level.
+static int cvl_tonemap_scale_level(float sigma, int max_level, float *level_sigma)
+{
+    int level = 0;
+    *level_sigma = sigma;
+    for (int l = 1; l <= max_level; l++)
+    {
+	float f2 = exp2f(2 * l);
+	float r2 = (sigma * sigma - (f2 - 1.0f) / 4.0f - f2 / 6.0f) / f2;
+	if (r2 < 1.0f)
+	    break;
+	level = l;
+	*level_sigma = sqrtf(r2);
+    }
+    return level;
+}
+
+// Helper function: compute n scales of the luminance of src. Scale i is stored
+// in channel channel[i] of frames[i] on pyramid level level[i]. Different
+// scales may share a frame. The frames have the given type. If tmp has the
+// size of src, it is used for temporary results.
+static void cvl_tonemap_scales(cvl_frame_t *src, cvl_frame_t *tmp, cvl_type_t type,
+	int n, const float *sigma, cvl_frame_t **frames, int *level, int *channel)
+{
+    int w = cvl_frame_width(src);
+    int h = cvl_frame_height(src);
+    int max_level = cvl_log2(cvl_maxi(w, h));
+    float level_sigma[n];
+    int levels = 0;
+    for (int i = 0; i < n; i++)
+    {
+	level[i] = cvl_tonemap_scale_level(sigma[i], max_level, &(level_sigma[i]));
+	levels = cvl_maxi(levels, level[i] + 1);
+	frames[i] = NULL;
+    }
+
+    GLuint prg;
+    char *prg_name;
+    cvl_frame_t *pyramid[levels];
+    pyramid[0] = src;
+    for (int l = 1; l < levels; l++)
+    {
+	int src_w = cvl_frame_width(pyramid[l - 1]);
+	int src_h = cvl_frame_height(pyramid[l - 1]);
+	int dst_w = (src_w + 1) / 2;
+	int dst_h = (src_h + 1) / 2;
+	pyramid[l] = cvl_frame_new(dst_w, dst_h, 1, CVL_LUM, CVL_FLOAT, CVL_TEXTURE);
+	prg_name = cvl_asprintf("cvl_tonemap_scales_downsample_first=%d", l == 1 ? 1 : 0);
+	if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_TONEMAP_SCALES_DOWNSAMPLE_GLSL_STR), 
+		    "$first=%s", l == 1 ? "true" : "false");
+	    prg = cvl_gl_program_new_src(prg_name, NULL, src);
+	    cvl_gl_program_cache_put(prg_name, prg);
+	    free(src);
+	}
+	free(prg_name);
+	glUseProgram(prg);
+	glUniform2f(glGetUniformLocation(prg, "src_size"), src_w, src_h);
+	glUniform2f(glGetUniformLocation(prg, "dst_size"), dst_w, dst_h);
+	cvl_transform(pyramid[l], pyramid[l - 1]);
+    }
+
+    for (int l = 0; l < levels; l++)
+    {
+	for (;;)
+	{
+	    // Collect up to four scales on this level that have no frame yet.
+	    int group[4];
+	    int m = 0;
+	    int k = 1;
+	    for (int i = 0; i < n && m < 4; i++)
+	    {
+		if (level[i] == l && !frames[i])
+		{
+		    group[m++] = i;
+		    k = cvl_maxi(k, cvl_gauss_sigma_to_k(level_sigma[i]));
+		}
+	    }
+	    if (m == 0)
+		break;
+
+	    float mask[4 * (2 * k + 1)];
+	    float c_mask[2 * k + 1];
+	    memset(mask, 0, sizeof(mask));
+	    for (int c = 0; c < m; c++)
+	    {
+		float weight_sum;
+		cvl_gauss_mask(k, level_sigma[group[c]], c_mask, &weight_sum);
+		for (int j = 0; j < 2 * k + 1; j++)
+		    mask[4 * j + c] = c_mask[j] / weight_sum;
+	    }
+
+	    int lw = cvl_frame_width(pyramid[l]);
+	    int lh = cvl_frame_height(pyramid[l]);
+	    cvl_frame_t *hblur;
+	    if (l == 0 && tmp && cvl_frame_width(tmp) == lw && cvl_frame_height(tmp) == lh)
+		hblur = tmp;
+	    else
+		hblur = cvl_frame_new(lw, lh, 4, CVL_UNKNOWN, type, CVL_TEXTURE);
+	    cvl_frame_t *result = cvl_frame_new(lw, lh, 4, CVL_UNKNOWN, type, CVL_TEXTURE);
+	    for (int pass = 0; pass < 2; pass++)
+	    {
+		int mode = (pass == 1 ? 2 : l == 0 ? 0 : 1);
+		prg_name = cvl_asprintf("cvl_tonemap_scales_blur_mode=%d_k=%d", mode, k);
+		if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+		{
+		    char *src = cvl_gl_srcprep(cvl_strdup(CVL_TONEMAP_SCALES_BLUR_GLSL_STR), 
+			    "$mode=%d, $k=%d", mode, k);
+		    prg = cvl_gl_program_new_src(prg_name, NULL, src);
+		    cvl_gl_program_cache_put(prg_name, prg);
+		    free(src);
+		}
+		free(prg_name);
+		glUseProgram(prg);
+		glUniform4fv(glGetUniformLocation(prg, "mask"), 2 * k + 1, mask);
+		if (pass == 0)
+		{
+		    glUniform2f(glGetUniformLocation(prg, "step"), 1.0f / (float)lw, 0.0f);
+		    cvl_transform(hblur, pyramid[l]);
+		}
+		else
+		{
+		    glUniform2f(glGetUniformLocation(prg, "step"), 0.0f, 1.0f / (float)lh);
+		    cvl_transform(result, hblur);
+		}
+	    }
+	    if (hblur != tmp)
+		cvl_frame_free(hblur);
+	    for (int c = 0; c < m; c++)
+	    {
+		frames[group[c]] = result;
+		channel[group[c]] = c;
+	    }
+	}
+    }
+
+    for (int l = 1; l < levels; l++)
+	cvl_frame_free(pyramid[l]);
+}
+
+// Helper function: set the uniforms that the tone mapping shader needs to
+// access the scales computed by cvl_tonemap_scales().
+static void cvl_tonemap_scales_uniforms(GLuint prg, cvl_frame_t *src,
+	int n, cvl_frame_t **frames, const int *level, const int *channel)
+{
+    float level_size[2 * n];
+    float level_factor[n];
+    float level_channel[4 * n];
+    for (int i = 0; i < n; i++)
+    {
+	level_size[2 * i + 0] = cvl_frame_width(frames[i]);
+	level_size[2 * i + 1] = cvl_frame_height(frames[i]);
+	level_factor[i] = exp2f(level[i]);
+	for (int c = 0; c < 4; c++)
+	    level_channel[4 * i + c] = (c == channel[i] ? 1.0f : 0.0f);
+    }
+    glUniform2f(glGetUniformLocation(prg, "size"), cvl_frame_width(src), cvl_frame_height(src));
+    glUniform2fv(glGetUniformLocation(prg, "level_size"), n, level_size);
+    glUniform1fv(glGetUniformLocation(prg, "level_factor"), n, level_factor);
+    glUniform4fv(glGetUniformLocation(prg, "level_channel"), n, level_channel);
+}
+
+// Helper function: free the frames computed by cvl_tonemap_scales().
+static void cvl_tonemap_scales_free(int n, cvl_frame_t **frames)
+{
+    for (int i = 0; i < n; i++)
+    {
+	bool shared = false;
+	for (int j = 0; j < i; j++)
+	    if (frames[j] == frames[i])
+		shared = true;
+	if (!shared)
+	    cvl_frame_free(frames[i]);
+    }
+}
+
+
+/* The number of gaussian scales that cvl_tonemap_reinhard02() selects from. */
+#define CVL_TONEMAP_REINHARD02_SCALES 4
+
 /**
  * \param dst			The destination frame.
  * \param src			The source frame.
@@ -542,6 +1210,10 @@ void cvl_tonemap_durand02(cvl_frame_t *dst, cvl_frame_t *src, float max_abs_lum,
  * The \a white parameter must be from [0,100).
  * The \a sharpness parameter must be from [0,100).
  * The \a threshold parameter must be from [0,1].\n
+ * The local adaptation luminance is selected from several gaussian smoothed
+ * versions of the luminance. Each of these scales is computed on the coarsest
+ * level of a luminance pyramid that still resolves it, and is then upsampled,
+ * so that large scales do not need large masks at full resolution.\n
  * See also:
  * E. Reinhard and M. Stark and P. Shirley and J. Ferwerda.
  * Photographic Tone Reproduction for Digital Images.
@@ -566,68 +1238,37 @@ void cvl_tonemap_reinhard02(cvl_frame_t *dst, cvl_frame_t *src,
     if (cvl_error())
 	return;
 
-    GLuint prg;
-    const int k[4] = { 3, 6, 9, 12 };
-    const float sigma[4] = { 2.4f, 4.8f, 7.2f, 9.6f };
-    float mask0[2 * k[0] + 1];
-    float mask0_weightsum;
-    float mask1[2 * k[1] + 1];
-    float mask1_weightsum;
-    float mask2[2 * k[2] + 1];
-    float mask2_weightsum;
-    float mask3[2 * k[3] + 1];
-    float mask3_weightsum;
+    const int n = CVL_TONEMAP_REINHARD02_SCALES;
+    const float sigma[CVL_TONEMAP_REINHARD02_SCALES] = { 2.4f, 4.8f, 7.2f, 9.6f };
+    cvl_frame_t *frames[CVL_TONEMAP_REINHARD02_SCALES];
+    int level[CVL_TONEMAP_REINHARD02_SCALES];
+    int channel[CVL_TONEMAP_REINHARD02_SCALES];
+    cvl_tonemap_scales(src, tmp, cvl_frame_type(tmp), n, sigma, frames, level, channel);
 
-    cvl_gauss_mask(k[0], sigma[0], mask0, &mask0_weightsum);
-    cvl_gauss_mask(k[1], sigma[1], mask1, &mask1_weightsum);
-    cvl_gauss_mask(k[2], sigma[2], mask2, &mask2_weightsum);
-    cvl_gauss_mask(k[3], sigma[3], mask3, &mask3_weightsum);
-    
-    if ((prg = cvl_gl_program_cache_get("cvl_tonemap_reinhard02_step1")) == 0)
-    {
-	prg = cvl_gl_program_new_src("cvl_tonemap_reinhard02_step1", NULL, 
-		CVL_TONEMAP_REINHARD02_STEP1_GLSL_STR);
-	cvl_gl_program_cache_put("cvl_tonemap_reinhard02_step1", prg);
-    }
-    glUseProgram(prg);
-    glUniform1fv(glGetUniformLocation(prg, "mask_0"), 2 * k[0] + 1, mask0);
-    glUniform1fv(glGetUniformLocation(prg, "mask_1"), 2 * k[1] + 1, mask1);
-    glUniform1fv(glGetUniformLocation(prg, "mask_2"), 2 * k[2] + 1, mask2);
-    glUniform1fv(glGetUniformLocation(prg, "mask_3"), 2 * k[3] + 1, mask3);
-    glUniform1f(glGetUniformLocation(prg, "factor_0"), 1.0f / mask0_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_1"), 1.0f / mask1_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_2"), 1.0f / mask2_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_3"), 1.0f / mask3_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "xstep"), 1.0f / (float)cvl_frame_width(src));
-    cvl_transform(tmp, src);
-    
-    if ((prg = cvl_gl_program_cache_get("cvl_tonemap_reinhard02_step2")) == 0)
+    GLuint prg;
+    char *prg_name = cvl_asprintf("cvl_tonemap_reinhard02_n=%d", n);
+    if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
     {
-	prg = cvl_gl_program_new_src("cvl_tonemap_reinhard02_step2", NULL, 
-		CVL_TONEMAP_REINHARD02_STEP2_GLSL_STR);
-	cvl_gl_program_cache_put("cvl_tonemap_reinhard02_step2", prg);
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_TONEMAP_REINHARD02_GLSL_STR), "$n=%d", n);
+	prg = cvl_gl_program_new_src(prg_name, NULL, src);
+	cvl_gl_program_cache_put(prg_name, prg);
+	free(src);
     }
+    free(prg_name);
     glUseProgram(prg);
-    glUniform1fv(glGetUniformLocation(prg, "mask_0"), 2 * k[0] + 1, mask0);
-    glUniform1fv(glGetUniformLocation(prg, "mask_1"), 2 * k[1] + 1, mask1);
-    glUniform1fv(glGetUniformLocation(prg, "mask_2"), 2 * k[2] + 1, mask2);
-    glUniform1fv(glGetUniformLocation(prg, "mask_3"), 2 * k[3] + 1, mask3);
-    glUniform1f(glGetUniformLocation(prg, "factor_0"), 1.0f / mask0_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_1"), 1.0f / mask1_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_2"), 1.0f / mask2_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "factor_3"), 1.0f / mask3_weightsum);
-    glUniform1f(glGetUniformLocation(prg, "s_0"), sigma[0]);
-    glUniform1f(glGetUniformLocation(prg, "s_1"), sigma[1]);
-    glUniform1f(glGetUniformLocation(prg, "s_2"), sigma[2]);
-    glUniform1f(glGetUniformLocation(prg, "s_3"), sigma[3]);
-    glUniform1f(glGetUniformLocation(prg, "ystep"), 1.0f / (float)cvl_frame_height(tmp));
+    cvl_tonemap_scales_uniforms(prg, src, n, frames, level, channel);
+    glUniform1fv(glGetUniformLocation(prg, "s"), n, sigma);
     glUniform1f(glGetUniformLocation(prg, "log_avg_lum"), log_avg_lum);
     glUniform1f(glGetUniformLocation(prg, "brightness"), brightness);
     glUniform1f(glGetUniformLocation(prg, "white"), white);
     glUniform1f(glGetUniformLocation(prg, "sharpness"), sharpness);
     glUniform1f(glGetUniformLocation(prg, "threshold"), threshold);
-    cvl_frame_t *srcs[2] = { src, tmp };
-    cvl_transform_multi(&dst, 1, srcs, 2, "textures");
+    cvl_frame_t *srcs[CVL_TONEMAP_REINHARD02_SCALES + 1];
+    srcs[0] = src;
+    for (int i = 0; i < n; i++)
+	srcs[i + 1] = frames[i];
+    cvl_transform_multi(&dst, 1, srcs, n + 1, "textures");
+    cvl_tonemap_scales_free(n, frames);
 
     cvl_check_errors();
 }
@@ -91,6 +91,17 @@ void cvl_init(void)
     ctx->cvl_gl_program_cache_size = 0;
     ctx->cvl_gl_program_cache_names = NULL;
     ctx->cvl_gl_program_cache_values = NULL;
+    ctx->cvl_gl_program_binaries = NULL;
+    ctx->cvl_gl_texture_array = 0;
+    ctx->cvl_convolve_lowrank_kernel = NULL;
+    ctx->cvl_convolve_lowrank_h = NULL;
+    ctx->cvl_convolve_lowrank_v = NULL;
+    ctx->cvl_gl_profile_queries[0] = 0;
+    ctx->cvl_gl_profile_queries[1] = 0;
+    ctx->cvl_profile_tid = cvl_profile_new_tid();
+    ctx->cvl_profile_frame = -1;
+    ctx->cvl_profile_frames_read = 0;
+    ctx->cvl_profile_frames_written = 0;
 
     /* Check GL version and extensions */
     GLenum err = glewInit();
@@ -183,6 +194,18 @@ void cvl_init(void)
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &(ctx->cvl_gl_max_tex_size));
     glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &(ctx->cvl_gl_max_texture_units));
     glGetIntegerv(GL_MAX_DRAW_BUFFERS, &(ctx->cvl_gl_max_render_targets));
+    ctx->cvl_gl_max_texture_array_layers = 0;
+    if (glewIsSupported("GL_EXT_texture_array"))
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS_EXT, &(ctx->cvl_gl_max_texture_array_layers));
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &(ctx->cvl_gl_max_vertex_texture_units));
+    ctx->cvl_gl_have_float_blending = (glewIsSupported("GL_VERSION_3_0")
+	    || glewIsSupported("GL_ARB_color_buffer_float"));
+    ctx->cvl_gl_have_timer_query = glewIsSupported("GL_ARB_timer_query");
+
+    /* Profiling */
+    const char *profile = getenv("CVL_PROFILE");
+    if (profile && strcmp(profile, "1") == 0)
+	cvl_profile_enable(true);
 
     /* Initialize program cache */
     ctx->cvl_gl_program_cache_length = 0;
@@ -208,6 +231,13 @@ void cvl_deinit(void)
 	    glDeleteFramebuffersEXT(1, &(ctx->cvl_gl_fbo));
 	if (ctx->cvl_gl_std_quad_initialized)
 	    glDeleteBuffersARB(1, &(ctx->cvl_gl_std_quad));
+	if (ctx->cvl_gl_texture_array != 0)
+	    glDeleteTextures(1, &(ctx->cvl_gl_texture_array));
+	free(ctx->cvl_convolve_lowrank_kernel);
+	free(ctx->cvl_convolve_lowrank_h);
+	free(ctx->cvl_convolve_lowrank_v);
+	if (ctx->cvl_gl_profile_queries[0] != 0)
+	    glDeleteQueries(2, ctx->cvl_gl_profile_queries);
 	for (int i = 0; i < ctx->cvl_gl_program_cache_length; i++)
 	{
 	    free(ctx->cvl_gl_program_cache_names[i]);
@@ -25,7 +25,11 @@
 
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdbool.h>
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include <GL/glew.h>
 #ifdef W32_NATIVE
@@ -52,6 +56,21 @@ typedef struct
 #endif
 } cvl__gl_context_t;
 
+/* GL program binaries, shared between CVL contexts that work in parallel.
+ * See cvl_parallel.c. */
+typedef struct
+{
+#if HAVE_PTHREAD
+    pthread_mutex_t mutex;
+#endif
+    int length;
+    int size;
+    char **names;
+    GLenum *formats;
+    GLsizei *lengths;
+    void **binaries;
+} cvl_gl_program_binaries_t;
+
 typedef struct
 {
     /* Error status. */
@@ -69,17 +88,67 @@ typedef struct
     GLint cvl_gl_max_tex_size;
     GLint cvl_gl_max_render_targets;
     GLint cvl_gl_max_texture_units;
+    GLint cvl_gl_max_texture_array_layers;	// 0 if texture arrays are not supported
+    GLint cvl_gl_max_vertex_texture_units;
+    bool cvl_gl_have_float_blending;
+    bool cvl_gl_have_timer_query;
+    /* The texture array used by cvl_transform_array(). */
+    GLuint cvl_gl_texture_array;
+    int cvl_gl_texture_array_width;
+    int cvl_gl_texture_array_height;
+    int cvl_gl_texture_array_layers;
+    GLint cvl_gl_texture_array_format;
+    /* The last low rank decomposition computed by cvl_convolve(), with the
+     * kernel it belongs to. The kernel is NULL if there is none. */
+    float *cvl_convolve_lowrank_kernel;
+    int cvl_convolve_lowrank_h_len;
+    int cvl_convolve_lowrank_v_len;
+    int cvl_convolve_lowrank_max_rank;
+    int cvl_convolve_lowrank_rank;
+    float *cvl_convolve_lowrank_h;
+    float *cvl_convolve_lowrank_v;
     /* The GL program cache. */
     int cvl_gl_program_cache_length;
     int cvl_gl_program_cache_size;
     char **cvl_gl_program_cache_names;
     GLuint *cvl_gl_program_cache_values;
+    /* The shared GL program binaries, or NULL. */
+    cvl_gl_program_binaries_t *cvl_gl_program_binaries;
+    /* The timestamp queries used for profiling, or 0. */
+    GLuint cvl_gl_profile_queries[2];
+    /* Trace information: thread id, current frame, frame counters. */
+    int cvl_profile_tid;
+    long cvl_profile_frame;
+    long cvl_profile_frames_read;
+    long cvl_profile_frames_written;
 } cvl_context_t;
 
 cvl_context_t *cvl_context(void);
 
 void cvl_gl_set_texture_state(void);
 
+GLuint cvl_gl_program_binaries_get(const char *name);
+void cvl_gl_program_binaries_put(const char *name, GLuint program);
+
+/* Profiling. See cvl_profile.c. */
+typedef struct
+{
+    bool active;
+    double start;
+    const char *function;
+} cvl_profile_pass_t;
+double cvl_profile_time(void);
+bool cvl_profile_active(void);
+int cvl_profile_new_tid(void);
+/* Passes without a GL program are named after the calling function. */
+#define cvl_profile_pass_begin(pass) cvl_profile_pass_begin_function(pass, __func__)
+void cvl_profile_pass_begin_function(cvl_profile_pass_t *pass, const char *function);
+void cvl_profile_pass_end(cvl_profile_pass_t *pass, long long pixels);
+void cvl_profile_interval(const char *name, const char *detail, long frame,
+	double start, double stop, long long pixels, long long bytes);
+void cvl_profile_span(const char *name, const char *detail, long frame,
+	double start, long long pixels, long long bytes);
+
 #define cvl_assert(condition) \
     if (!cvl_error() && !(condition)) \
     { \
@@ -151,6 +220,11 @@ static inline float cvl_max4f(float a, float b, float c, float d)
     return cvl_maxf(cvl_maxf(a, b), cvl_maxf(c, d));
 }
 
+static inline float cvl_clampf(float x, float min, float max)
+{
+    return cvl_minf(max, cvl_maxf(min, x));
+}
+
 static inline int cvl_mini(int a, int b)
 {
     return a < b ? a : b;
@@ -209,4 +283,10 @@ static inline int cvl_log2(int x)
 
 void cvl_gauss_mask(int k, float s, float *mask, float *weight_sum);
 
+/* CPU code paths split their work among at most this many threads.
+ * See cvl_misc.c. */
+#define CVL_CPU_MAX_THREADS 16
+int cvl_cpu_threads(int n, int min_items);
+void cvl_cpu_run(void *(*func)(void *), void *jobs, size_t job_size, int n);
+
 #endif
@@ -56,6 +56,27 @@
  * PNM input/output
  */
 
+/* Returns the current time if profiling is active, for cvl_io_profile(). */
+static inline double cvl_io_time(void)
+{
+    return (cvl_profile_active() ? cvl_profile_time() : 0.0);
+}
+
+/* Records the time spent parsing the input (from start until parsed) and the
+ * time spent converting the data to the frame layout (from parsed until now)
+ * as separate operations, so that they can be measured independently. */
+static void cvl_io_profile(const char *name, double start, double parsed, long long pixels)
+{
+    if (!cvl_profile_active())
+	return;
+    char parse_name[32], convert_name[32];
+    long frame = cvl_context()->cvl_profile_frames_read;
+    snprintf(parse_name, sizeof(parse_name), "%s parse", name);
+    snprintf(convert_name, sizeof(convert_name), "%s convert", name);
+    cvl_profile_interval(parse_name, NULL, frame, start, parsed, pixels, 0);
+    cvl_profile_interval(convert_name, NULL, frame, parsed, cvl_profile_time(), pixels, 0);
+}
+
 // Skip whitespace and optional comments.
 static bool cvl_pnm_skip(FILE *f)
 {
@@ -103,6 +124,8 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 	return;
 
     const char errmsg[] = "Cannot read PNM frame";
+    double start = cvl_io_time();
+    double parsed = 0.0;
     typedef enum { PBM, PGM, RG, PPM, RGBA } subformat_t;
     subformat_t subformat;
     int width, height, size, maxval;
@@ -289,6 +312,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 	    free(pbmdata);
 	    return;
 	}
+	parsed = cvl_io_time();
 	for (int y = 0; y < height; y++)
 	{
 	    for (int x = 0; x < width; x += 8)
@@ -325,6 +349,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		cvl_error_set(CVL_ERROR_DATA, "%s: %s", errmsg, "EOF or input error in PGM data");
 		return;
 	    }
+	    parsed = cvl_io_time();
 	}
 	else
 	{
@@ -345,6 +370,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		free(pgmdata);
 		return;
 	    }
+	    parsed = cvl_io_time();
 	    for (size_t i = 0; i < (size_t)size; i++)
 	    {
 		ptr[i] = (float)(((int)pgmdata[i * 2] << 8) | (int)pgmdata[i * 2 + 1]) / 65535.0f;
@@ -371,6 +397,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 	    free(rgdata);
 	    return;
 	}
+	parsed = cvl_io_time();
 	if (maxval < 256)
 	{
 	    uint8_t *ptr = cvl_frame_pointer(*frame);
@@ -409,6 +436,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		cvl_error_set(CVL_ERROR_DATA, "%s: %s", errmsg, "EOF or input error in PPM data");
 		return;
 	    }
+	    parsed = cvl_io_time();
 	}
 	else
 	{
@@ -429,6 +457,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		free(ppmdata);
 		return;
 	    }
+	    parsed = cvl_io_time();
 	    for (size_t i = 0; i < (size_t)size; i++)
 	    {
 		ptr[3 * i + 0] = (float)(((int)ppmdata[(3 * i + 0) * 2 + 0] << 8) | (int)ppmdata[(3 * i + 0) * 2 + 1]) / 65535.0f;
@@ -450,6 +479,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		cvl_error_set(CVL_ERROR_DATA, "%s: %s", errmsg, "EOF or input error in RGBA data");
 		return;
 	    }
+	    parsed = cvl_io_time();
 	}
 	else
 	{
@@ -470,6 +500,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 		free(rgbadata);
 		return;
 	    }
+	    parsed = cvl_io_time();
 	    for (size_t i = 0; i < (size_t)size; i++)
 	    {
 		ptr[4 * i + 0] = (float)(((int)rgbadata[(4 * i + 0) * 2 + 0] << 8) | (int)rgbadata[(4 * i + 0) * 2 + 1]) / 65535.0f;
@@ -484,6 +515,7 @@ void cvl_read_pnm(FILE *f, cvl_frame_t **frame)
 	cvl_frame_set_channel_name(*frame, 2, "B");
 	cvl_frame_set_channel_name(*frame, 3, "A");
     }
+    cvl_io_profile("cvl_read_pnm", start, parsed, size);
 }
 
 /**
@@ -888,6 +920,8 @@ void cvl_read_pfs(FILE *f, cvl_frame_t **frame)
 	return;
 
     const char errmsg[] = "Cannot read PFS frame";
+    double start = cvl_io_time();
+    double parsed = 0.0;
     cvl_read_pfs_errtype_t errtype;
     int width, height, channel_count, frame_tag_count, channel_tag_count;
     size_t size;
@@ -982,6 +1016,7 @@ void cvl_read_pfs(FILE *f, cvl_frame_t **frame)
 	    errtype = (ferror(f) ? CVL_PFS_INPUT_ERROR : CVL_PFS_EOF_IN_DATA);
 	    goto error_exit;
 	}
+	parsed = cvl_io_time();
 	if (strcmp(channel_name[0], "Y") != 0)
 	{
 	    cvl_frame_set_format(*frame, CVL_UNKNOWN);
@@ -1002,6 +1037,7 @@ void cvl_read_pfs(FILE *f, cvl_frame_t **frame)
 		goto error_exit;
 	    }
 	}
+	parsed = cvl_io_time();
 	if (channel_count == 2)
 	{
 	    *frame = cvl_frame_new(width, height, 2, CVL_UNKNOWN, CVL_FLOAT, CVL_MEM);
@@ -1119,6 +1155,7 @@ void cvl_read_pfs(FILE *f, cvl_frame_t **frame)
     free(channel[1]);
     free(channel[2]);
     free(channel[3]);
+    cvl_io_profile("cvl_read_pfs", start, parsed, size);
 
     return;
 
@@ -1313,6 +1350,7 @@ void cvl_read(FILE *f, cvl_stream_type_t *type, cvl_frame_t **frame)
 	return;
 
     const char *errmsg = "Cannot read frame";
+    double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
     int c;
 
     // Detect the stream type before calling cvl_read_pnm() or cvl_read_pfs().
@@ -1354,6 +1392,14 @@ void cvl_read(FILE *f, cvl_stream_type_t *type, cvl_frame_t **frame)
 	    *type = CVL_PNM;
 	cvl_read_pnm(f, frame);
     }
+    if (*frame)
+    {
+	cvl_context_t *ctx = cvl_context();
+	cvl_profile_span("cvl_read", NULL, ctx->cvl_profile_frames_read++, start, cvl_frame_size(*frame), 0);
+	/* The work that follows belongs to the next output frame. Filters that
+	 * read ahead (temporal filters) produce it from older input frames. */
+	ctx->cvl_profile_frame = ctx->cvl_profile_frames_written;
+    }
 }
 
 /**
@@ -1371,10 +1417,14 @@ void cvl_write(FILE *f, cvl_stream_type_t type, cvl_frame_t *frame)
     if (cvl_error())
 	return;
 
+    double start = (cvl_profile_active() ? cvl_profile_time() : 0.0);
     if (type == CVL_PNM)
 	cvl_write_pnm(f, frame);
     else
 	cvl_write_pfs(f, frame);
+    cvl_context_t *ctx = cvl_context();
+    cvl_profile_span("cvl_write", NULL, ctx->cvl_profile_frames_written++, start, cvl_frame_size(frame), 0);
+    ctx->cvl_profile_frame = ctx->cvl_profile_frames_written;
 }
 
 /**
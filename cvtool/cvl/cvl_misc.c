@@ -31,9 +31,14 @@
 
 #include <math.h>
 #include <float.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include <GL/glew.h>
 
@@ -43,6 +48,8 @@
 
 #include "glsl/misc/resize_seq.glsl.h"
 #include "glsl/misc/reduce.glsl.h"
+#include "glsl/misc/reduce_statistics.glsl.h"
+#include "glsl/misc/histogram.glsl.h"
 #include "glsl/misc/sort.glsl.h"
 #include "glsl/misc/pyramid_gaussian.glsl.h"
 
@@ -66,6 +73,84 @@
 /** \var CVL_REDUCE_SUM
  * Reduce to the sum of all values. */
 
+/**
+ * \typedef cvl_sort_method_t
+ * The sorting method.
+ */
+/** \var CVL_SORT_AUTO
+ * Choose the method based on the frame size. */
+/** \var CVL_SORT_BITONIC
+ * Bitonic sorting network on the GPU. */
+/** \var CVL_SORT_RADIX
+ * Parallel radix sort on the CPU. */
+
+/**
+ * \typedef cvl_histogram_method_t
+ * The histogram method.
+ */
+/** \var CVL_HISTOGRAM_AUTO
+ * Choose the method based on the capabilities of the GL implementation. */
+/** \var CVL_HISTOGRAM_GPU
+ * Scatter the values into the bins with a vertex shader. */
+/** \var CVL_HISTOGRAM_CPU
+ * Count the downloaded values with multiple threads. */
+
+
+/* Returns the number of threads to use for n work items, such that each
+ * thread gets at least min_items items. */
+int cvl_cpu_threads(int n, int min_items)
+{
+    int threads = 1;
+#if HAVE_PTHREAD && defined _SC_NPROCESSORS_ONLN
+    threads = cvl_maxi(1, cvl_mini(sysconf(_SC_NPROCESSORS_ONLN), CVL_CPU_MAX_THREADS));
+#endif
+    return cvl_maxi(1, cvl_mini(threads, n / min_items));
+}
+
+/* Runs func on each of the n jobs in the array jobs, whose elements have the
+ * size job_size. The first job runs in the current thread, the others in their
+ * own threads. If a thread cannot be started, or if there are no POSIX
+ * threads, its job runs in the current thread, too. */
+void cvl_cpu_run(void *(*func)(void *), void *jobs, size_t job_size, int n)
+{
+    int started = 0;
+#if HAVE_PTHREAD
+    pthread_t threads[CVL_CPU_MAX_THREADS];
+
+    for (int t = 1; t < n; t++)
+    {
+	if (pthread_create(&(threads[t]), NULL, func, (char *)jobs + t * job_size) != 0)
+	    break;
+	started++;
+    }
+#endif
+    func(jobs);
+    for (int t = 1 + started; t < n; t++)
+	func((char *)jobs + t * job_size);
+#if HAVE_PTHREAD
+    for (int t = 1; t <= started; t++)
+	pthread_join(threads[t], NULL);
+#endif
+}
+
+
+/* Maps a float to an unsigned integer key that has the same order. */
+static inline uint32_t cvl_float_to_key(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+/* Inverse of cvl_float_to_key(). */
+static inline float cvl_key_to_float(uint32_t k)
+{
+    uint32_t u = (k & 0x80000000u) ? (k & 0x7fffffffu) : ~k;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
 
 /**
  * \param dst		The destination frame.
@@ -146,7 +231,6 @@ void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *
 
     const char *mode_names[] = { "min", "mingz", "absmin", "absmingz", "max", "absmax", "sum" };
     const char *channel_names[] = { "r", "g", "b", "a" };
-    cvl_frame_t *input_frame;
 
     GLint internalformat;
     if (mode == CVL_REDUCE_SUM || cvl_frame_type(frame) == CVL_FLOAT)
@@ -156,131 +240,14 @@ void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *
     else
 	internalformat = GL_RGBA;
     
-    int src_w = cvl_next_power_of_two(cvl_frame_width(frame));
-    int src_h = cvl_next_power_of_two(cvl_frame_height(frame));
-    if (src_w != cvl_frame_width(frame) || src_h != cvl_frame_height(frame))
-    {
-	if (src_w > 32 && src_h > 32)
-	{
-	    // Divide the frame into up to four rectangles: upper left, upper
-	    // right, lower left, lower right. Then apply reduction recursively
-	    // and combine the results. This is much more memory efficient than
-	    // just creating a new frame of size src_w x src_h.
-	    int rectangles;
-	    cvl_frame_t *rect;
-	    float rect_result[4][4];
-	    if (src_w != cvl_frame_width(frame) && src_h != cvl_frame_height(frame))
-	    {
-		// Case 1: four rectangles
-		rectangles = 4;
-		rect = cvl_frame_new(src_w / 2, src_h / 2,
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, 0, 0, src_w / 2, src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[0]);
-		cvl_frame_free(rect);
-		rect = cvl_frame_new(cvl_frame_width(frame) - src_w / 2, src_h / 2,
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, src_w / 2, 0, cvl_frame_width(frame) - src_w / 2, src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[1]);
-      		cvl_frame_free(rect);
-		rect = cvl_frame_new(src_w / 2, cvl_frame_height(frame) - src_h / 2,
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, 0, src_h / 2, src_w / 2, cvl_frame_height(frame) - src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[2]);
-  		cvl_frame_free(rect);
-		rect = cvl_frame_new(cvl_frame_width(frame) - src_w / 2, cvl_frame_height(frame) - src_h / 2,
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, src_w / 2, src_h / 2, 
-			cvl_frame_width(frame) - src_w / 2, cvl_frame_height(frame) - src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[3]);
-   		cvl_frame_free(rect);
-	    }
-	    else if (src_w != cvl_frame_width(frame))
-	    {
-		// Case 2: two rectangles, left/right
-		rectangles = 2;
-		rect = cvl_frame_new(src_w / 2, src_h, 
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, 0, 0, src_w / 2, src_h);
-		cvl_reduce(rect, mode, channel, rect_result[0]);
-		cvl_frame_free(rect);
-		rect = cvl_frame_new(cvl_frame_width(frame) - src_w / 2, src_h, 
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, src_w / 2, 0, cvl_frame_width(frame) - src_w / 2, src_h);
-		cvl_reduce(rect, mode, channel, rect_result[1]);
-		cvl_frame_free(rect);
-	    }
-	    else
-	    {
-		// Case 3: two rectangles, top/bottom
-		rectangles = 2;
-		rect = cvl_frame_new(src_w, src_h / 2, 
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, 0, 0, src_w, src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[0]);
-		cvl_frame_free(rect);
-		rect = cvl_frame_new(src_w, cvl_frame_height(frame) - src_h / 2, 
-			cvl_frame_channels(frame), cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-		cvl_copy_rect(rect, 0, 0, frame, 0, src_h / 2, src_w, cvl_frame_height(frame) - src_h / 2);
-		cvl_reduce(rect, mode, channel, rect_result[1]);
-		cvl_frame_free(rect);
-	    }
-	    // Combine the results
-	    for (int c = 0; c < (channel == -1 ? 4 : 1); c++)
-	    {
-		if (mode == CVL_REDUCE_MIN
-			|| mode == CVL_REDUCE_MIN_GREATER_ZERO
-			|| mode == CVL_REDUCE_ABSMIN
-			|| mode == CVL_REDUCE_ABSMIN_GREATER_ZERO)
-		{
-		    if (rectangles == 2)
-			result[c] = cvl_minf(rect_result[0][c], rect_result[1][c]);
-		    else
-			result[c] = cvl_min4f(rect_result[0][c], rect_result[1][c],
-				rect_result[2][c], rect_result[3][c]);
-		}
-		else if (mode == CVL_REDUCE_MAX || mode == CVL_REDUCE_ABSMAX)
-		{
-		    if (rectangles == 2)
-			result[c] = cvl_maxf(rect_result[0][c], rect_result[1][c]);
-		    else
-			result[c] = cvl_max4f(rect_result[0][c], rect_result[1][c],
-				rect_result[2][c], rect_result[3][c]);
-		}
-		else // mode == CVL_REDUCE_SUM
-		{
-		    if (rectangles == 2)
-			result[c] = rect_result[0][c] + rect_result[1][c];
-		    else
-			result[c] = rect_result[0][c] + rect_result[1][c]
-			    + rect_result[2][c] + rect_result[3][c];
-		}
-	    }
-	    return;
-	}
-	else
-	{
-	    const float neutral_min[4] = {  FLT_MAX,  FLT_MAX,  FLT_MAX,  FLT_MAX };
-	    const float neutral_max[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
-	    const float neutral_sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	    const float *neutral_element;
-	    if (mode == CVL_REDUCE_MIN || mode == CVL_REDUCE_MIN_GREATER_ZERO 
-		    || mode == CVL_REDUCE_ABSMIN || mode == CVL_REDUCE_ABSMIN_GREATER_ZERO)
-		neutral_element = neutral_min;
-	    else if (mode == CVL_REDUCE_MAX || mode == CVL_REDUCE_ABSMAX)
-		neutral_element = neutral_max;
-	    else
-		neutral_element = neutral_sum;
-	    input_frame = cvl_frame_new(src_w, src_h, cvl_frame_channels(frame), 
-		    cvl_frame_format(frame), cvl_frame_type(frame), CVL_TEXTURE);
-	    cvl_resize_seq(input_frame, frame, neutral_element);
-	}
-    }
-    else
-    {
-	input_frame = frame;
-    }
-    GLuint src_tex = cvl_frame_texture(input_frame);
+    // Each step reduces blocks of 2x2 pixels. The destination size is rounded
+    // up, and the shader ignores the parts of blocks that lie outside of the
+    // source, so that frames of arbitrary size need neither padding nor
+    // splitting. At least one step is done, so that the mode is applied to
+    // single pixel frames, too.
+    int src_w = cvl_frame_width(frame);
+    int src_h = cvl_frame_height(frame);
+    GLuint src_tex = cvl_frame_texture(frame);
 
     GLuint prg;
     char *prg_name = cvl_asprintf("cvl_reduce_mode=%s_channel=%s", 
@@ -306,10 +273,10 @@ void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *
     free(prg_name);
     glUseProgram(prg);
 
-    while (src_w > 1 || src_h > 1)
+    do
     {
-	int dst_w = cvl_maxi(1, src_w / 2);
-	int dst_h = cvl_maxi(1, src_h / 2);
+	int dst_w = (src_w + 1) / 2;
+	int dst_h = (src_h + 1) / 2;
 	GLuint dst_tex;
 	glGenTextures(1, &dst_tex);
 	glBindTexture(GL_TEXTURE_2D, dst_tex);
@@ -319,17 +286,19 @@ void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *
 	glViewport(0, 0, dst_w, dst_h);
 	glBindTexture(GL_TEXTURE_2D, src_tex);
 	cvl_gl_set_texture_state();
-	glUniform1f(glGetUniformLocation(prg, "step_h"), 1.0f / (float)src_w);
-	glUniform1f(glGetUniformLocation(prg, "step_v"), 1.0f / (float)src_h);
-	glUniform1i(glGetUniformLocation(prg, "reduce_case"), 
-		(dst_w < src_w && dst_h < src_h) ? 0 : (dst_w < src_w) ? 1 : 2);
+	glUniform2f(glGetUniformLocation(prg, "src_size"), src_w, src_h);
+	glUniform2f(glGetUniformLocation(prg, "dst_size"), dst_w, dst_h);
+	cvl_profile_pass_t pass;
+	cvl_profile_pass_begin(&pass);
 	glDrawArrays(GL_QUADS, 0, 4);
-	if (src_tex != cvl_frame_texture(input_frame))
+	cvl_profile_pass_end(&pass, (long long)dst_w * dst_h);
+	if (src_tex != cvl_frame_texture(frame))
 	    glDeleteTextures(1, &src_tex);
 	src_tex = dst_tex;
 	src_w = dst_w;
 	src_h = dst_h;
     }
+    while (src_w > 1 || src_h > 1);
 
     glBindTexture(GL_TEXTURE_2D, src_tex);
     glGetTexImage(GL_TEXTURE_2D, 0, 
@@ -341,39 +310,13 @@ void cvl_reduce(cvl_frame_t *frame, cvl_reduce_mode_t mode, int channel, float *
 
     if (src_tex != cvl_frame_texture(frame))
 	glDeleteTextures(1, &src_tex);
-    if (input_frame != frame)
-	cvl_frame_free(input_frame);
 }
 
 
-/**
- * \param dst		The destination frame.
- * \param src		The source frame.
- * \param channel	The sorting key.
- *
- * Sorts the frame \a src: The top left pixel will contain the smallest
- * values, and the bottom right pixel will contain the largest values.\n
- * The given \a channel (0-3) sets the sorting key. For \a channel -1, all 
- * channels are sorted separately.\n
- * Source frames with format #CVL_FLOAT or #CVL_FLOAT16 must only contain 
- * finite floats that are smaller than the maximum representable float 
- * value.
- */
-void cvl_sort(cvl_frame_t *dst, cvl_frame_t *src, int channel)
+/* Sorts with a bitonic sorting network on the GPU. The frame is padded to
+ * power-of-two dimensions. */
+static void cvl_sort_bitonic(cvl_frame_t *dst, cvl_frame_t *src, int channel)
 {
-    cvl_assert(dst != NULL);
-    cvl_assert(src != NULL);
-    cvl_assert(dst != src);
-    cvl_assert(channel >= -1 && channel <= 3);
-    if (cvl_error())
-	return;
-
-    if (cvl_frame_size(src) == 1)
-    {
-	cvl_copy(dst, src);
-	return;
-    }
-
     cvl_frame_t *input_frame;
     const char *channel_names[] = { "r", "g", "b", "a" };
     GLuint srctex, dsttex;
@@ -423,7 +366,10 @@ void cvl_sort(cvl_frame_t *dst, cvl_frame_t *src, int channel)
 	    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, dsttex, 0);
 	    glBindTexture(GL_TEXTURE_2D, srctex);
 	    cvl_gl_set_texture_state();
+	    cvl_profile_pass_t pass;
+	    cvl_profile_pass_begin(&pass);
 	    glDrawArrays(GL_QUADS, 0, 4);
+	    cvl_profile_pass_end(&pass, (long long)width * height);
 	    dsttex = (dsttex == cvl_frame_texture(buf1) ? cvl_frame_texture(buf2) : cvl_frame_texture(buf1));
 	    srctex = (dsttex == cvl_frame_texture(buf1) ? cvl_frame_texture(buf2) : cvl_frame_texture(buf1));
 	}
@@ -438,6 +384,214 @@ void cvl_sort(cvl_frame_t *dst, cvl_frame_t *src, int channel)
 }
 
 
+/* One part of a radix sort pass: the keys first to last-1 are counted, or
+ * moved to their place. */
+typedef struct
+{
+    const uint32_t *keys;
+    const uint32_t *values;
+    uint32_t *keys_out;
+    uint32_t *values_out;
+    int first;
+    int last;
+    int shift;
+    int offsets[256];
+} cvl_sort_job_t;
+
+static void *cvl_sort_count_worker(void *arg)
+{
+    cvl_sort_job_t *job = arg;
+    memset(job->offsets, 0, sizeof(job->offsets));
+    for (int i = job->first; i < job->last; i++)
+	job->offsets[(job->keys[i] >> job->shift) & 0xff]++;
+    return NULL;
+}
+
+static void *cvl_sort_scatter_worker(void *arg)
+{
+    cvl_sort_job_t *job = arg;
+    for (int i = job->first; i < job->last; i++)
+    {
+	int j = job->offsets[(job->keys[i] >> job->shift) & 0xff]++;
+	job->keys_out[j] = job->keys[i];
+	if (job->values)
+	    job->values_out[j] = job->values[i];
+    }
+    return NULL;
+}
+
+/* Sorts the n keys, and the values if they are not NULL, with a stable LSD
+ * radix sort with four passes of 8 bits. Each pass counts the digits in
+ * parallel, computes the target offset of each part of the array, and then
+ * moves the parts in parallel. Passes in which all keys have the same digit
+ * are skipped. The buffers keys_tmp and values_tmp must have space for n
+ * elements. */
+static void cvl_sort_radix_keys(uint32_t *keys, uint32_t *values, uint32_t *keys_tmp, uint32_t *values_tmp, int n)
+{
+    cvl_sort_job_t jobs[CVL_CPU_MAX_THREADS];
+    // Do not start threads for less than 64K keys each
+    int threads = cvl_cpu_threads(n, 65536);
+    uint32_t *k_in = keys, *k_out = keys_tmp;
+    uint32_t *v_in = values, *v_out = values_tmp;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+	for (int t = 0; t < threads; t++)
+	{
+	    jobs[t].keys = k_in;
+	    jobs[t].values = v_in;
+	    jobs[t].keys_out = k_out;
+	    jobs[t].values_out = v_out;
+	    jobs[t].first = (long long)n * t / threads;
+	    jobs[t].last = (long long)n * (t + 1) / threads;
+	    jobs[t].shift = shift;
+	}
+	cvl_cpu_run(cvl_sort_count_worker, jobs, sizeof(cvl_sort_job_t), threads);
+	int offset = 0;
+	bool skip = false;
+	for (int d = 0; d < 256; d++)
+	{
+	    int digit_count = 0;
+	    for (int t = 0; t < threads; t++)
+	    {
+		int c = jobs[t].offsets[d];
+		jobs[t].offsets[d] = offset;
+		offset += c;
+		digit_count += c;
+	    }
+	    if (digit_count == n)
+		skip = true;
+	}
+	if (skip)
+	    continue;
+	cvl_cpu_run(cvl_sort_scatter_worker, jobs, sizeof(cvl_sort_job_t), threads);
+	uint32_t *tmp;
+	tmp = k_in; k_in = k_out; k_out = tmp;
+	tmp = v_in; v_in = v_out; v_out = tmp;
+    }
+    if (k_in != keys)
+    {
+	memcpy(keys, k_in, n * sizeof(uint32_t));
+	if (values)
+	    memcpy(values, v_in, n * sizeof(uint32_t));
+    }
+}
+
+/* Sorts on the CPU with a parallel radix sort. Frames of any size can be
+ * sorted without padding. */
+static void cvl_sort_radix(cvl_frame_t *dst, cvl_frame_t *src, int channel)
+{
+    int n = cvl_frame_size(src);
+    cvl_frame_t *sorted = cvl_frame_new(cvl_frame_width(src), cvl_frame_height(src),
+	    4, CVL_UNKNOWN, CVL_FLOAT, CVL_MEM);
+    if (cvl_error())
+	return;
+    float *ptr = cvl_frame_pointer(sorted);
+    float *data = (channel == -1 ? NULL : malloc((size_t)n * 4 * sizeof(float)));
+    uint32_t *keys = malloc((size_t)n * 2 * sizeof(uint32_t));
+    uint32_t *values = (channel == -1 ? NULL : malloc((size_t)n * 2 * sizeof(uint32_t)));
+    if ((channel != -1 && (!data || !values)) || !keys)
+    {
+	free(data);
+	free(keys);
+	free(values);
+	cvl_frame_free(sorted);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, channel == -1 ? ptr : data);
+
+    if (channel == -1)
+    {
+	// Sort the channels independently
+	for (int c = 0; c < 4; c++)
+	{
+	    for (int i = 0; i < n; i++)
+		keys[i] = cvl_float_to_key(ptr[4 * i + c]);
+	    cvl_sort_radix_keys(keys, NULL, keys + n, NULL, n);
+	    for (int i = 0; i < n; i++)
+		ptr[4 * i + c] = cvl_key_to_float(keys[i]);
+	}
+    }
+    else
+    {
+	// Sort the pixel indices by the key channel, then move the pixels
+	for (int i = 0; i < n; i++)
+	{
+	    keys[i] = cvl_float_to_key(data[4 * i + channel]);
+	    values[i] = i;
+	}
+	cvl_sort_radix_keys(keys, values, keys + n, values + n, n);
+	for (int i = 0; i < n; i++)
+	    memcpy(ptr + 4 * i, data + 4 * values[i], 4 * sizeof(float));
+    }
+    free(data);
+    free(keys);
+    free(values);
+
+    cvl_copy(dst, sorted);
+    cvl_frame_free(sorted);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param channel	The sorting key.
+ *
+ * Sorts the frame \a src: The top left pixel will contain the smallest
+ * values, and the bottom right pixel will contain the largest values.\n
+ * The given \a channel (0-3) sets the sorting key. For \a channel -1, all 
+ * channels are sorted separately.\n
+ * Source frames with format #CVL_FLOAT or #CVL_FLOAT16 must only contain 
+ * finite floats that are smaller than the maximum representable float 
+ * value.\n
+ * This function is equivalent to cvl_sort_using() with #CVL_SORT_AUTO.
+ */
+void cvl_sort(cvl_frame_t *dst, cvl_frame_t *src, int channel)
+{
+    cvl_sort_using(dst, src, channel, CVL_SORT_AUTO);
+}
+
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param channel	The sorting key.
+ * \param method	The sorting method.
+ *
+ * Sorts the frame \a src like cvl_sort(), using the given \a method.
+ * #CVL_SORT_BITONIC uses a bitonic sorting network on the GPU. It needs
+ * log2(n) * (log2(n) + 1) / 2 passes over the frame padded to power-of-two
+ * dimensions, and is only suitable for small frames. #CVL_SORT_RADIX
+ * downloads the frame and sorts it with a parallel radix sort on the CPU.
+ * It needs no padding and is stable, i.e. pixels with equal keys keep
+ * their order. #CVL_SORT_AUTO chooses the radix sort: the cvl-bench
+ * operations sort_bitonic and sort_radix show that it is faster for all
+ * frame sizes, starting from 8x8 pixels, even though it reads the frame back.
+ */
+void cvl_sort_using(cvl_frame_t *dst, cvl_frame_t *src, int channel, cvl_sort_method_t method)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(channel >= -1 && channel <= 3);
+    if (cvl_error())
+	return;
+
+    if (cvl_frame_size(src) == 1)
+    {
+	cvl_copy(dst, src);
+	return;
+    }
+
+    if (method == CVL_SORT_BITONIC)
+	cvl_sort_bitonic(dst, src, channel);
+    else
+	cvl_sort_radix(dst, src, channel);
+}
+
+
 /**
  * \param frame		The sorted frame.
  * \param channel	The channel.
@@ -466,6 +620,247 @@ void cvl_quantil(cvl_frame_t *frame, int channel, float q, float *result)
 }
 
 
+static int cvl_quantiles_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x < y ? -1 : x > y ? +1 : 0);
+}
+
+/* Selects the keys with the given ranks from the unsorted array keys, by
+ * refining histograms of 11, 11, and 10 key bits in three passes. All ranks
+ * share the passes: each pass computes one histogram for each distinct key
+ * prefix that was selected by the previous pass. Returns false if memory is
+ * exhausted. */
+static bool cvl_quantiles_select(const uint32_t *keys, int nkeys, const int *ranks, int n, uint32_t *result)
+{
+    const int digit_bits[3] = { 11, 11, 10 };
+    uint32_t *prefixes;
+    int *rank;
+
+    if (!(prefixes = malloc(n * sizeof(uint32_t))) || !(rank = malloc(n * sizeof(int))))
+    {
+	free(prefixes);
+	return false;
+    }
+    for (int i = 0; i < n; i++)
+    {
+	result[i] = 0;
+	rank[i] = ranks[i];
+    }
+    int shift = 32;
+    for (int d = 0; d < 3; d++)
+    {
+	int bits = digit_bits[d];
+	int bins = 1 << bits;
+	int prefix_shift = shift;
+	shift -= bits;
+	// The sorted list of distinct prefixes; the prefix of a key is 0 in the
+	// first pass.
+	memcpy(prefixes, result, n * sizeof(uint32_t));
+	qsort(prefixes, n, sizeof(uint32_t), cvl_quantiles_cmp);
+	int nprefixes = 1;
+	for (int i = 1; i < n; i++)
+	    if (prefixes[i] != prefixes[nprefixes - 1])
+		prefixes[nprefixes++] = prefixes[i];
+	int *histograms;
+	if (!(histograms = calloc((size_t)nprefixes * bins, sizeof(int))))
+	{
+	    free(prefixes);
+	    free(rank);
+	    return false;
+	}
+	for (int j = 0; j < nkeys; j++)
+	{
+	    uint32_t prefix = (prefix_shift == 32 ? 0 : keys[j] >> prefix_shift);
+	    const uint32_t *p = (nprefixes == 1 
+		    ? (prefix == prefixes[0] ? prefixes : NULL)
+		    : bsearch(&prefix, prefixes, nprefixes, sizeof(uint32_t), cvl_quantiles_cmp));
+	    if (p)
+		histograms[(p - prefixes) * bins + ((keys[j] >> shift) & (bins - 1))]++;
+	}
+	for (int i = 0; i < n; i++)
+	{
+	    const uint32_t *p = bsearch(&(result[i]), prefixes, nprefixes, sizeof(uint32_t), cvl_quantiles_cmp);
+	    const int *histogram = histograms + (p - prefixes) * bins;
+	    int b = 0;
+	    while (rank[i] >= histogram[b])
+		rank[i] -= histogram[b++];
+	    result[i] = (result[i] << bits) | (uint32_t)b;
+	}
+	free(histograms);
+    }
+    free(prefixes);
+    free(rank);
+    return true;
+}
+
+/**
+ * \param frame		The frame.
+ * \param channel	The channel.
+ * \param q		The quantiles.
+ * \param n		The number of quantiles.
+ * \param result	A buffer.
+ *
+ * Computes the \a n quantiles given by \a q from the unsorted frame \a frame.
+ * Each quantile must be from [0,1]. The result for quantile q is the value that
+ * would be at index round(q * (m - 1)) if the m finite values of the channel
+ * were sorted, i.e. the same value that cvl_quantil() would get from a frame
+ * sorted with cvl_sort(). Non-finite values are ignored; if a channel does not
+ * have finite values, its results are NaN.\n
+ * If \a channel is 0, 1, 2, or 3, then \a n floats are stored in \a result. If
+ * \a channel is -1, then four floats per quantile, one for each channel, are
+ * stored in \a result: result[4 * i + c] is quantile \a q[i] of channel c.\n
+ * The values are selected by radix refinement of histograms of their bit
+ * patterns. This is exact, and it needs only three passes over the frame
+ * data, regardless of \a n.
+ */
+void cvl_quantiles(cvl_frame_t *frame, int channel, const float *q, int n, float *result)
+{
+    cvl_assert(frame != NULL);
+    cvl_assert(channel >= -1 && channel <= 3);
+    cvl_assert(q != NULL);
+    cvl_assert(n > 0);
+    for (int i = 0; i < n; i++)
+	cvl_assert(q[i] >= 0.0f && q[i] <= 1.0f);
+    cvl_assert(result != NULL);
+    if (cvl_error())
+	return;
+
+    int s = cvl_frame_size(frame);
+    int channels = (channel == -1 ? 4 : 1);
+    float *ptr = malloc((size_t)s * channels * sizeof(float));
+    uint32_t *keys = malloc((size_t)s * sizeof(uint32_t));
+    int *ranks = malloc(n * sizeof(int));
+    uint32_t *selected = malloc(n * sizeof(uint32_t));
+    if (!ptr || !keys || !ranks || !selected)
+    {
+	free(ptr);
+	free(keys);
+	free(ranks);
+	free(selected);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
+    glGetTexImage(GL_TEXTURE_2D, 0, 
+	    channel == -1 ? GL_RGBA 
+	    : channel == 0 ? GL_RED : channel == 1 ? GL_GREEN : channel == 2 ? GL_BLUE : GL_ALPHA, 
+	    GL_FLOAT, ptr);
+    for (int c = 0; c < channels; c++)
+    {
+	int nkeys = 0;
+	for (int i = 0; i < s; i++)
+	{
+	    float v = ptr[i * channels + c];
+	    if (isfinite(v))
+		keys[nkeys++] = cvl_float_to_key(v);
+	}
+	if (nkeys == 0)
+	{
+	    for (int i = 0; i < n; i++)
+		result[i * channels + c] = NAN;
+	    continue;
+	}
+	for (int i = 0; i < n; i++)
+	    ranks[i] = cvl_iroundf(q[i] * (float)(nkeys - 1));
+	if (!cvl_quantiles_select(keys, nkeys, ranks, n, selected))
+	{
+	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	    break;
+	}
+	for (int i = 0; i < n; i++)
+	    result[i * channels + c] = cvl_key_to_float(selected[i]);
+    }
+    free(ptr);
+    free(keys);
+    free(ranks);
+    free(selected);
+}
+
+
+/* Computes, for each channel, the minimum, the smallest value greater than the
+ * minimum, the maximum, the sum, the sum of squares, and the number of finite
+ * values in one reduction, using multiple render targets. Non-finite values are
+ * ignored. If a channel has no value greater than its minimum, its min2 entry
+ * is at least 3.4e38. Without enough render targets, the values are computed
+ * with separate reductions, and non-finite values are not detected. */
+static void cvl_reduce_statistics(cvl_frame_t *frame, float *min1, float *min2, float *max1,
+	float *sum, float *sumsq, float *count)
+{
+    cvl_context_t *ctx = cvl_context();
+    if (ctx->cvl_gl_max_render_targets < 6 || ctx->cvl_gl_max_texture_units < 6)
+    {
+	cvl_reduce(frame, CVL_REDUCE_MIN, -1, min1);
+	cvl_reduce(frame, CVL_REDUCE_MAX, -1, max1);
+	cvl_reduce(frame, CVL_REDUCE_SUM, -1, sum);
+	cvl_frame_t *layers[2] = { frame, frame };
+	cvl_frame_t *tmpframe = cvl_frame_new_tpl(frame);
+	cvl_layer(tmpframe, layers, 2, CVL_LAYER_MUL);
+	cvl_reduce(tmpframe, CVL_REDUCE_SUM, -1, sumsq);
+	float summand[4];
+	for (int c = 0; c < 4; c++)
+	    summand[c] = - min1[c];
+	cvl_add(tmpframe, frame, summand);
+	cvl_reduce(tmpframe, CVL_REDUCE_MIN_GREATER_ZERO, -1, min2);
+	cvl_frame_free(tmpframe);
+	for (int c = 0; c < 4; c++)
+	{
+	    min2[c] = (min2[c] > 0.0f ? min1[c] + min2[c] : FLT_MAX);
+	    count[c] = cvl_frame_size(frame);
+	}
+	return;
+    }
+
+    float *results[6] = { min1, min2, max1, sum, sumsq, count };
+    cvl_frame_t *srcs[6] = { frame };
+    cvl_frame_t *dsts[6];
+    int src_w = cvl_frame_width(frame);
+    int src_h = cvl_frame_height(frame);
+    bool first = true;
+    do
+    {
+	int dst_w = (src_w + 1) / 2;
+	int dst_h = (src_h + 1) / 2;
+	for (int i = 0; i < 6; i++)
+	    dsts[i] = cvl_frame_new(dst_w, dst_h, 4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
+	GLuint prg;
+	const char *prg_name = first ? "cvl_reduce_statistics_first" : "cvl_reduce_statistics";
+	if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+	{
+	    char *src = cvl_gl_srcprep(cvl_strdup(CVL_REDUCE_STATISTICS_GLSL_STR), 
+		    "$first=%s", first ? "true" : "false");
+	    prg = cvl_gl_program_new_src(prg_name, NULL, src);
+	    cvl_gl_program_cache_put(prg_name, prg);
+	    free(src);
+	}
+	glUseProgram(prg);
+	glUniform2f(glGetUniformLocation(prg, "src_size"), src_w, src_h);
+	glUniform2f(glGetUniformLocation(prg, "dst_size"), dst_w, dst_h);
+	cvl_transform_multi(dsts, 6, srcs, first ? 1 : 6, "textures");
+	for (int i = 0; i < 6; i++)
+	{
+	    if (!first)
+		cvl_frame_free(srcs[i]);
+	    srcs[i] = dsts[i];
+	}
+	src_w = dst_w;
+	src_h = dst_h;
+	first = false;
+    }
+    while (src_w > 1 || src_h > 1);
+
+    for (int i = 0; i < 6; i++)
+    {
+	const float *p = cvl_frame_pointer(srcs[i]);
+	if (p)
+	    memcpy(results[i], p, 4 * sizeof(float));
+	cvl_frame_free(srcs[i]);
+    }
+    cvl_check_errors();
+}
+
+
 /**
  * \param frame		The frame.
  * \param min		Pointer to 4 floats.
@@ -478,9 +873,16 @@ void cvl_quantil(cvl_frame_t *frame, int channel, float q, float *result)
  * Computes some simple statistics for the frame \a frame.
  * The minimum, maximum, median, and mean values are stored in \a min, \a max,
  * \a median, \a mean respectively. The standard deviation is stored in \a stddev.\n
- * The dynamic range of each channel is stored in \a dynrange.
+ * The dynamic range of each channel is stored in \a dynrange: this is the ratio
+ * of the difference between the maximum and the minimum to the smallest
+ * difference between a value and the minimum, or 1 if all values are equal.
  * If any of \a min, \a max, \a median, \a mean, \a stddev, \a dynrange 
- * is NULL, then the corresponding computation will not be executed.
+ * is NULL, then the corresponding computation will not be executed.\n
+ * Non-finite values in #CVL_FLOAT and #CVL_FLOAT16 frames are ignored. If a
+ * channel contains no finite values at all, its minimum, maximum, mean, and
+ * standard deviation are 0, and its dynamic range is 1.\n
+ * All statistics except the median are computed in a single reduction; the
+ * median is selected with cvl_quantiles().
  */
 void cvl_statistics(cvl_frame_t *frame, float *min, float *max, float *median, 
 	float *mean, float *stddev, float *dynrange)
@@ -489,82 +891,39 @@ void cvl_statistics(cvl_frame_t *frame, float *min, float *max, float *median,
     if (cvl_error())
 	return;
 
-    float sum[4];
-
-    if (min)
-    {
-	cvl_reduce(frame, CVL_REDUCE_MIN, -1, min);
-    }
-    if (max)
-    {
-	cvl_reduce(frame, CVL_REDUCE_MAX, -1, max);
-    }
-    if (median)
-    {
-	cvl_frame_t *sorted = cvl_frame_new_tpl(frame);
-	cvl_sort(sorted, frame, -1);
-	cvl_quantil(sorted, -1, 0.5, median);
-	cvl_frame_free(sorted);
-    }
-    if (mean || stddev)
-    {
-	cvl_reduce(frame, CVL_REDUCE_SUM, -1, sum);
-    }
-    if (mean)
+    if (min || max || mean || stddev || dynrange)
     {
+	float min1[4], min2[4], max1[4], sum[4], sumsq[4], count[4];
+	cvl_reduce_statistics(frame, min1, min2, max1, sum, sumsq, count);
 	for (int c = 0; c < 4; c++)
 	{
-	    mean[c] = sum[c] / (float)cvl_frame_size(frame);
-	}
-    }
-    if (stddev)
-    {
-	if (cvl_frame_size(frame) == 1)
-	{
-	    for (int c = 0; c < 4; c++)
+	    if (count[c] < 1.0f)
 	    {
-		stddev[c] = 0.0f;
+		min1[c] = 0.0f;
+		max1[c] = 0.0f;
+		sum[c] = 0.0f;
+		sumsq[c] = 0.0f;
+		count[c] = 1.0f;
 	    }
-	}
-	else
-	{
-	    float sumsq[4];
-	    cvl_frame_t *layers[2] = { frame, frame };
-	    cvl_frame_t *squared = cvl_frame_new_tpl(frame);
-	    cvl_layer(squared, layers, 2, CVL_LAYER_MUL);
-	    cvl_reduce(squared, CVL_REDUCE_SUM, -1, sumsq);
-	    cvl_frame_free(squared);
-
-	    for (int c = 0; c < 4; c++)
+	    if (min)
+		min[c] = min1[c];
+	    if (max)
+		max[c] = max1[c];
+	    if (mean)
+		mean[c] = sum[c] / count[c];
+	    if (stddev)
 	    {
-		float radicand = (sumsq[c] - sum[c] * sum[c] / (float)cvl_frame_size(frame)) / (float)(cvl_frame_size(frame) - 1);
-		stddev[c] = (radicand > 0.0f) ? sqrtf(radicand) : 0.0f;
+		float radicand = (sumsq[c] - sum[c] * sum[c] / count[c]) / (count[c] - 1.0f);
+		stddev[c] = (count[c] > 1.0f && radicand > 0.0f) ? sqrtf(radicand) : 0.0f;
 	    }
+	    if (dynrange)
+		dynrange[c] = (min2[c] < 3.4e38f ? (max1[c] - min1[c]) / (min2[c] - min1[c]) : 1.0f);
 	}
     }
-    if (dynrange)
+    if (median)
     {
-	float drmin[4], summand[4], drmax[4], mingz[4];
-	cvl_frame_t *tmpframe;
-
-	if (min)
-	{
-	    for (int c = 0; c < 4; c++)
-		drmin[c] = min[c];
-	}
-     	else
-	{
-    	    cvl_reduce(frame, CVL_REDUCE_MIN, -1, drmin);
-	}
-	for (int c = 0; c < 4; c++)
-	    summand[c] = - min[c];
-	tmpframe = cvl_frame_new_tpl(frame);
-	cvl_add(tmpframe, frame, summand);
-	cvl_reduce(tmpframe, CVL_REDUCE_MIN_GREATER_ZERO, -1, mingz);
-	cvl_reduce(tmpframe, CVL_REDUCE_MAX, -1, drmax);
-	cvl_frame_free(tmpframe);
-	for (int c = 0; c < 4; c++)
-	    dynrange[c] = drmax[c] / mingz[c];
+	const float half = 0.5f;
+	cvl_quantiles(frame, -1, &half, 1, median);
     }
 }
 
@@ -677,6 +1036,216 @@ void cvl_pyramid_laplacian(cvl_frame_t **gaussian_pyramid, int n, cvl_frame_t **
 }
 
 
+/* A part of the CPU histogram computation: the pixels first to last-1 of data
+ * are counted in the sub-histogram of a thread. */
+typedef struct
+{
+    const float *data;
+    int channels;
+    int first;
+    int last;
+    int bins;
+    const float *lo;
+    const float *hi;
+    const float *scale;
+    int *histogram;
+} cvl_histogram_job_t;
+
+static void *cvl_histogram_worker(void *arg)
+{
+    cvl_histogram_job_t *job = arg;
+    const int channels = job->channels;
+    const int last_bin = job->bins - 1;
+    float lo[4], hi[4], scale[4];
+    int *histogram[4];
+
+    for (int c = 0; c < channels; c++)
+    {
+	lo[c] = job->lo[c];
+	hi[c] = job->hi[c];
+	scale[c] = job->scale[c];
+	histogram[c] = job->histogram + c * job->bins;
+    }
+    memset(job->histogram, 0, channels * job->bins * sizeof(int));
+    for (int i = job->first; i < job->last; i++)
+    {
+	const float *p = job->data + i * channels;
+	for (int c = 0; c < channels; c++)
+	{
+	    if (isfinite(p[c]) && p[c] >= lo[c] && p[c] <= hi[c])
+	    {
+		int b = (p[c] - lo[c]) * scale[c];
+		histogram[c][b < last_bin ? b : last_bin]++;
+	    }
+	}
+    }
+    return NULL;
+}
+
+/* Computes the histogram on the CPU, with one sub-histogram per thread. */
+static void cvl_histogram_cpu(cvl_frame_t *frame, int channel, int bins, 
+	const float *lo, const float *hi, const float *scale, int *histogram)
+{
+    int s = cvl_frame_size(frame);
+    int channels = (channel == -1 ? 4 : 1);
+    // Do not start threads for less than 64K pixels each
+    int threads = cvl_cpu_threads(s, 65536);
+
+    float *ptr = malloc((size_t)s * channels * sizeof(float));
+    int *sub_histograms = malloc((size_t)threads * channels * bins * sizeof(int));
+    if (!ptr || !sub_histograms)
+    {
+	free(ptr);
+	free(sub_histograms);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
+    glGetTexImage(GL_TEXTURE_2D, 0, 
+	    channel == -1 ? GL_RGBA 
+	    : channel == 0 ? GL_RED : channel == 1 ? GL_GREEN : channel == 2 ? GL_BLUE : GL_ALPHA, 
+	    GL_FLOAT, ptr);
+
+    cvl_histogram_job_t jobs[CVL_CPU_MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+	jobs[t].data = ptr;
+	jobs[t].channels = channels;
+	jobs[t].first = (long long)s * t / threads;
+	jobs[t].last = (long long)s * (t + 1) / threads;
+	jobs[t].bins = bins;
+	jobs[t].lo = lo;
+	jobs[t].hi = hi;
+	jobs[t].scale = scale;
+	jobs[t].histogram = sub_histograms + t * channels * bins;
+    }
+    cvl_cpu_run(cvl_histogram_worker, jobs, sizeof(cvl_histogram_job_t), threads);
+
+    memcpy(histogram, sub_histograms, channels * bins * sizeof(int));
+    for (int t = 1; t < threads; t++)
+	for (int i = 0; i < channels * bins; i++)
+	    histogram[i] += sub_histograms[t * channels * bins + i];
+
+    free(ptr);
+    free(sub_histograms);
+}
+
+/* Computes the histogram on the GPU: each frame value is drawn as a point at
+ * the position of its bin, and additive blending counts the points. All
+ * channels are handled in the same draw calls, one per frame row. A float
+ * counter is exact only up to 2^24, so the counts are read back and added to
+ * the integer histogram after at most 2^24 values per channel. */
+static void cvl_histogram_gpu(cvl_frame_t *frame, int channel, int bins, 
+	const float *lo, const float *hi, const float *scale, int *histogram)
+{
+    cvl_context_t *ctx = cvl_context();
+    int width = cvl_frame_width(frame);
+    int height = cvl_frame_height(frame);
+    int channels = (channel == -1 ? 4 : 1);
+
+    GLfloat *vertices = malloc(width * channels * 2 * sizeof(GLfloat));
+    float *counts = malloc(bins * 4 * sizeof(float));
+    if (!vertices || !counts)
+    {
+	free(vertices);
+	free(counts);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    // Vertex (x, c) reads channel c of column x
+    float lo4[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float hi4[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float scale4[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int c = 0; c < channels; c++)
+    {
+	int fc = (channel == -1 ? c : channel);
+	lo4[fc] = lo[c];
+	hi4[fc] = hi[c];
+	scale4[fc] = scale[c];
+	for (int x = 0; x < width; x++)
+	{
+	    vertices[2 * (x * channels + c) + 0] = x;
+	    vertices[2 * (x * channels + c) + 1] = fc;
+	}
+    }
+    GLuint vbo;
+    glGenBuffersARB(1, &vbo);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, width * channels * 2 * sizeof(GLfloat), vertices, GL_STATIC_DRAW_ARB);
+    free(vertices);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, 0);
+
+    GLuint dst_tex;
+    glGenTextures(1, &dst_tex);
+    glBindTexture(GL_TEXTURE_2D, dst_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, bins, 1, 0, GL_RGBA, GL_FLOAT, NULL);
+    cvl_gl_set_texture_state();
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, dst_tex, 0);
+    glViewport(0, 0, bins, 1);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    GLuint prg;
+    char *prg_name = cvl_asprintf("cvl_histogram_bins=%d", bins);
+    if ((prg = cvl_gl_program_cache_get(prg_name)) == 0)
+    {
+	char *src = cvl_gl_srcprep(cvl_strdup(CVL_HISTOGRAM_GLSL_STR), "$bins=%d", bins);
+	prg = cvl_gl_program_new_src(prg_name, src, NULL);
+	cvl_gl_program_cache_put(prg_name, prg);
+	free(src);
+    }
+    free(prg_name);
+    glUseProgram(prg);
+    glUniform2f(glGetUniformLocation(prg, "size"), width, height);
+    glUniform4fv(glGetUniformLocation(prg, "lo"), 1, lo4);
+    glUniform4fv(glGetUniformLocation(prg, "hi"), 1, hi4);
+    glUniform4fv(glGetUniformLocation(prg, "scale"), 1, scale4);
+    GLint row_loc = glGetUniformLocation(prg, "row");
+    const int rows_per_readback = cvl_maxi(1, (1 << 24) / width);
+    memset(histogram, 0, channels * bins * sizeof(int));
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
+    cvl_gl_set_texture_state();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
+    for (int y0 = 0; y0 < height; y0 += rows_per_readback)
+    {
+	if (y0 > 0)
+	{
+	    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
+	    glClear(GL_COLOR_BUFFER_BIT);
+	}
+	for (int y = y0; y < cvl_mini(height, y0 + rows_per_readback); y++)
+	{
+	    glUniform1f(row_loc, y);
+	    glDrawArrays(GL_POINTS, 0, width * channels);
+	}
+	glBindTexture(GL_TEXTURE_2D, dst_tex);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, counts);
+	for (int c = 0; c < channels; c++)
+	{
+	    int fc = (channel == -1 ? c : channel);
+	    for (int b = 0; b < bins; b++)
+		histogram[c * bins + b] += counts[4 * b + fc];
+	}
+    }
+    cvl_profile_pass_end(&pass, (long long)width * height);
+    glDisable(GL_BLEND);
+
+    // Restore the standard quad
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, ctx->cvl_gl_std_quad);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, 0, 0);
+    glVertexPointer(3, GL_FLOAT, 0, (const GLvoid *)(8 * sizeof(float)));
+    glDeleteBuffersARB(1, &vbo);
+    glDeleteTextures(1, &dst_tex);
+    free(counts);
+    cvl_check_errors();
+}
+
+
 /**
  * \param frame		The frame.
  * \param channel	The channel.
@@ -690,64 +1259,58 @@ void cvl_pyramid_laplacian(cvl_frame_t **gaussian_pyramid, int n, cvl_frame_t **
  * \a histogram, which must have enough space for the requested bins and channels.
  * Frame values outside of [\a min, \a max] will be ignored. These values must be
  * given for all four channels (if \a channel is -1), or for the selected
- * channel.
+ * channel. They must be finite; non-finite frame values are ignored.\n
+ * This function is equivalent to cvl_histogram_using() with
+ * #CVL_HISTOGRAM_AUTO.
  */
 void cvl_histogram(cvl_frame_t *frame, int channel, int bins, const float *min, const float *max, int *histogram)
+{
+    cvl_histogram_using(frame, channel, bins, min, max, histogram, CVL_HISTOGRAM_AUTO);
+}
+
+/**
+ * \param frame		The frame.
+ * \param channel	The channel.
+ * \param bins		The number of bins.
+ * \param min		The minimum value(s).
+ * \param max		The maximum value(s).
+ * \param histogram	The histogram.
+ * \param method	The method.
+ *
+ * Computes the histogram like cvl_histogram(), using the given \a method.
+ * Both methods count all requested channels in one pass and give the same
+ * result. #CVL_HISTOGRAM_GPU needs a GL implementation that supports texture
+ * access in vertex shaders and blending into float textures, and at most
+ * the maximum texture size as \a bins. #CVL_HISTOGRAM_CPU downloads the frame
+ * and counts it with multiple threads. #CVL_HISTOGRAM_AUTO chooses the GPU if
+ * it is supported.
+ */
+void cvl_histogram_using(cvl_frame_t *frame, int channel, int bins, const float *min, const float *max,
+	int *histogram, cvl_histogram_method_t method)
 {
     cvl_assert(frame != NULL);
     cvl_assert(channel >= -1 && channel <= 3);
+    cvl_assert(bins > 0);
     cvl_assert(min != NULL);
     cvl_assert(max != NULL);
     cvl_assert(histogram != NULL);
     if (cvl_error())
 	return;
 
-    int s = cvl_frame_size(frame);
-    if (channel == -1)
-    {
-	float *ptr;
-	if (!(ptr = malloc(s * 4 * sizeof(float))))
-	{
-	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
-	    return;
-	}
-	glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
-	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, ptr);
-	memset(histogram, 0, 4 * bins * sizeof(int));
-	for (int i = 0; i < s; i++)
-	{
-	    float *p = ptr + 4 * i;
-	    for (int c = 0; c < 4; c++)
-	    {
-		if (!isfinite(p[c]) || p[c] < min[c] || p[c] > max[c])
-		    continue;
-		int hi = cvl_clampi((p[c] - min[c]) / (max[c] - min[c]) * (float)(bins - 1), 0, bins - 1);
-		histogram[c * bins + hi]++;
-	    }
-	}
-	free(ptr);
-    }
+    cvl_context_t *ctx = cvl_context();
+    bool have_gpu = (ctx->cvl_gl_max_vertex_texture_units > 0 && ctx->cvl_gl_have_float_blending
+	    && bins <= ctx->cvl_gl_max_tex_size);
+    if (method == CVL_HISTOGRAM_AUTO)
+	method = (have_gpu ? CVL_HISTOGRAM_GPU : CVL_HISTOGRAM_CPU);
+    cvl_assert(method != CVL_HISTOGRAM_GPU || have_gpu);
+    if (cvl_error())
+	return;
+
+    float scale[4];
+    for (int c = 0; c < (channel == -1 ? 4 : 1); c++)
+	scale[c] = (max[c] > min[c] ? (float)(bins - 1) / (max[c] - min[c]) : 0.0f);
+    if (method == CVL_HISTOGRAM_GPU)
+	cvl_histogram_gpu(frame, channel, bins, min, max, scale, histogram);
     else
-    {
-	float *ptr;
-	if (!(ptr = malloc(s * sizeof(float))))
-	{
-	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
-	    return;
-	}
-	glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(frame));
-	glGetTexImage(GL_TEXTURE_2D, 0, 
-		channel == 0 ? GL_RED : channel == 1 ? GL_GREEN : channel == 2 ? GL_BLUE : GL_ALPHA, 
-		GL_FLOAT, ptr);
-	memset(histogram, 0, bins * sizeof(int));
-	for (int i = 0; i < s; i++)
-	{
-	    float *p = ptr + i;
-	    if (!isfinite(p[0]) || p[0] < min[0] || p[0] > max[0])
-    		continue;
-	    int hi = cvl_clampi((p[0] - min[0]) / (max[0] - min[0]) * (float)(bins - 1), 0, bins - 1);
-	    histogram[hi]++;
-	}
-	free(ptr);
-    }
+	cvl_histogram_cpu(frame, channel, bins, min, max, scale, histogram);
 }
@@ -187,6 +187,8 @@ void cvl_blend(cvl_frame_t *frame, int dst_x, int dst_y,
     float dst_xrf = (dst_xf + dst_wf) * 2.0f - 1.0f;
     float dst_ytf = dst_yf * 2.0f - 1.0f;
     float dst_ybf = (dst_yf + dst_hf) * 2.0f - 1.0f;
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 0.0f);
     glVertex3f(dst_xlf, dst_ytf, 0.0f);
@@ -197,6 +199,7 @@ void cvl_blend(cvl_frame_t *frame, int dst_x, int dst_y,
     glTexCoord2f(0.0f, 1.0f);
     glVertex3f(dst_xlf, dst_ybf, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(block));
     glActiveTexture(GL_TEXTURE0);
     cvl_check_errors();
     cvl_frame_free(orig);
@@ -0,0 +1,450 @@
+/*
+ * cvl_parallel.c
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file cvl_parallel.h
+ * \brief Parallel processing of frame streams.
+ *
+ * Parallel processing of independent frames of a stream, using one OpenGL
+ * context and one CVL context per thread.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include <GL/glew.h>
+
+#define CVL_BUILD
+#include "cvl_intern.h"
+#include "cvl/cvl.h"
+
+
+/**
+ * \typedef cvl_parallel_t
+ * A parallel frame processor.
+ */
+
+/**
+ * \typedef cvl_parallel_func_t
+ * A function that processes one frame. It takes ownership of the frame that
+ * is passed to it, and returns the result frame (which may be the same frame).
+ * The second argument is the user data pointer that was given to
+ * cvl_parallel_new().
+ */
+
+#if HAVE_PTHREAD
+
+typedef enum
+{
+    CVL_PARALLEL_QUEUED = 0,
+    CVL_PARALLEL_RUNNING = 1,
+    CVL_PARALLEL_DONE = 2
+} cvl__parallel_state_t;
+
+typedef struct
+{
+    cvl__parallel_state_t state;
+    cvl_frame_t *frame;
+} cvl__parallel_job_t;
+
+typedef struct
+{
+    /* Everything below is protected by this mutex. Changes are broadcast. */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    /* Configuration */
+    char *display_name;
+    cvl_parallel_func_t func;
+    void *data;
+    /* Threads */
+    int threads_len;
+    pthread_t *threads;
+    int threads_ready;
+    bool quit;
+    /* Error status of the workers */
+    cvl_error_t error;
+    char *error_msg;
+    /* The jobs, in stream order. Job i has the sequence number jobs_first + i. */
+    int jobs_len;
+    int jobs_size;
+    long jobs_first;
+    cvl__parallel_job_t *jobs;
+    /* Program binaries shared by the worker contexts */
+    cvl_gl_program_binaries_t binaries;
+} cvl__parallel_t;
+
+
+/* Record the CVL error of the current (worker) context. The mutex must be locked. */
+static void cvl_parallel_record_error(cvl__parallel_t *p, cvl_error_t e, const char *msg)
+{
+    if (p->error == CVL_OK)
+    {
+	p->error = e;
+	p->error_msg = strdup(msg);
+    }
+}
+
+static void *cvl_parallel_worker(void *arg)
+{
+    cvl__parallel_t *p = arg;
+    cvl_gl_context_t *glctx;
+    bool ok = false;
+
+    /* Every worker has its own GL context and CVL context. They are
+     * initialized one after another, because GLEW initialization modifies
+     * global state. */
+    pthread_mutex_lock(&p->mutex);
+    glctx = cvl_gl_context_new(p->display_name);
+    if (glctx)
+    {
+	cvl_init();
+#ifdef GL_ARB_get_program_binary
+	if (!cvl_error() && glewIsSupported("GL_ARB_get_program_binary"))
+	{
+	    GLint formats = 0;
+	    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	    if (formats > 0)
+		cvl_context()->cvl_gl_program_binaries = &(p->binaries);
+	}
+#endif
+	ok = !cvl_error();
+    }
+    if (!glctx)
+	cvl_parallel_record_error(p, CVL_ERROR_GL, "Cannot create OpenGL context for parallel processing");
+    else if (!ok)
+	cvl_parallel_record_error(p, cvl_error(), cvl_error_msg());
+    p->threads_ready++;
+    pthread_cond_broadcast(&p->cond);
+
+    while (ok)
+    {
+	/* Wait for the next queued job. */
+	int i = 0;
+	for (;;)
+	{
+	    for (i = 0; i < p->jobs_len && p->jobs[i].state != CVL_PARALLEL_QUEUED; i++);
+	    if (p->quit || p->error || i < p->jobs_len)
+		break;
+	    pthread_cond_wait(&p->cond, &p->mutex);
+	}
+	if (p->quit || p->error)
+	    break;
+	long seq = p->jobs_first + i;
+	cvl_frame_t *frame = p->jobs[i].frame;
+	p->jobs[i].state = CVL_PARALLEL_RUNNING;
+	pthread_mutex_unlock(&p->mutex);
+	cvl_context()->cvl_profile_frame = seq;
+
+	/* Process it and bring the result into memory, so that the thread
+	 * that collects it can use it in its own context. */
+	frame = p->func(frame, p->data);
+	if (frame)
+	    cvl_frame_pointer(frame);
+	else
+	    cvl_error_set(CVL_ERROR_ASSERT, "%s(): frame function returned no frame", __func__);
+
+	pthread_mutex_lock(&p->mutex);
+	i = seq - p->jobs_first;
+	p->jobs[i].frame = frame;
+	p->jobs[i].state = CVL_PARALLEL_DONE;
+	if (cvl_error())
+	{
+	    cvl_parallel_record_error(p, cvl_error(), cvl_error_msg());
+	    ok = false;
+	}
+	pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    if (glctx)
+    {
+	cvl_deinit();
+	cvl_gl_context_free(glctx);
+    }
+    return NULL;
+}
+
+/**
+ * \param display_name	The X display to connect to (ignored on W32).
+ * \param jobs		The number of parallel jobs.
+ * \param func		The function that processes a frame.
+ * \param data		User data pointer that is passed to \a func.
+ * \return		The parallel frame processor.
+ *
+ * Creates a processor that applies \a func to frames in \a jobs parallel
+ * threads. Each thread has its own OpenGL context (see cvl_gl_context_new())
+ * and its own CVL context. Compiled GL programs are shared between these
+ * contexts if the GL implementation supports program binaries.\n
+ * The frames must be independent of each other, and \a func must not depend on
+ * the state of the calling context. Put frames into the processor with
+ * cvl_parallel_put(), and get the results in the same order with
+ * cvl_parallel_get().\n
+ * The current context is only used for error reporting and for moving frames
+ * into memory.
+ */
+cvl_parallel_t *cvl_parallel_new(const char *display_name, int jobs, cvl_parallel_func_t func, void *data)
+{
+    cvl_assert(jobs > 0);
+    cvl_assert(func != NULL);
+    if (cvl_error())
+	return NULL;
+
+    cvl__parallel_t *p;
+
+    if (!(p = malloc(sizeof(cvl__parallel_t)))
+	    || !(p->threads = malloc(jobs * sizeof(pthread_t))))
+    {
+	free(p);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return NULL;
+    }
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    p->display_name = display_name ? strdup(display_name) : NULL;
+    p->func = func;
+    p->data = data;
+    p->threads_len = 0;
+    p->threads_ready = 0;
+    p->quit = false;
+    p->error = CVL_OK;
+    p->error_msg = NULL;
+    p->jobs_len = 0;
+    p->jobs_size = 0;
+    p->jobs_first = 0;
+    p->jobs = NULL;
+    pthread_mutex_init(&p->binaries.mutex, NULL);
+    p->binaries.length = 0;
+    p->binaries.size = 0;
+    p->binaries.names = NULL;
+    p->binaries.formats = NULL;
+    p->binaries.lengths = NULL;
+    p->binaries.binaries = NULL;
+
+    for (int i = 0; i < jobs; i++)
+    {
+	int e = pthread_create(&(p->threads[i]), NULL, cvl_parallel_worker, p);
+	if (e != 0)
+	{
+	    cvl_error_set(CVL_ERROR_SYS, "Cannot create thread: %s", strerror(e));
+	    break;
+	}
+	p->threads_len++;
+    }
+    /* Wait until all workers have initialized their contexts, so that
+     * initialization errors are reported here. */
+    pthread_mutex_lock(&p->mutex);
+    while (p->threads_ready < p->threads_len)
+	pthread_cond_wait(&p->cond, &p->mutex);
+    if (!cvl_error() && p->error)
+	cvl_error_set(p->error, "%s", p->error_msg ? p->error_msg : "unknown");
+    pthread_mutex_unlock(&p->mutex);
+    if (cvl_error())
+    {
+	cvl_parallel_free((cvl_parallel_t *)p);
+	return NULL;
+    }
+
+    return (cvl_parallel_t *)p;
+}
+
+/**
+ * \param parallel	The parallel frame processor.
+ *
+ * Stops all threads of the parallel frame processor and frees it. Frames that
+ * were not retrieved with cvl_parallel_get() are discarded.
+ */
+void cvl_parallel_free(cvl_parallel_t *parallel)
+{
+    cvl__parallel_t *p = (cvl__parallel_t *)parallel;
+
+    if (p)
+    {
+	pthread_mutex_lock(&p->mutex);
+	p->quit = true;
+	pthread_cond_broadcast(&p->cond);
+	pthread_mutex_unlock(&p->mutex);
+	for (int i = 0; i < p->threads_len; i++)
+	    pthread_join(p->threads[i], NULL);
+	/* The remaining frames have no textures in any context anymore. */
+	for (int i = 0; i < p->jobs_len; i++)
+	    cvl_frame_free(p->jobs[i].frame);
+	free(p->jobs);
+	for (int i = 0; i < p->binaries.length; i++)
+	{
+	    free(p->binaries.names[i]);
+	    free(p->binaries.binaries[i]);
+	}
+	free(p->binaries.names);
+	free(p->binaries.formats);
+	free(p->binaries.lengths);
+	free(p->binaries.binaries);
+	pthread_mutex_destroy(&p->binaries.mutex);
+	pthread_cond_destroy(&p->cond);
+	pthread_mutex_destroy(&p->mutex);
+	free(p->error_msg);
+	free(p->display_name);
+	free(p->threads);
+	free(p);
+    }
+}
+
+/**
+ * \param parallel	The parallel frame processor.
+ * \param frame		The frame.
+ *
+ * Queues the \a frame for processing. The parallel frame processor takes
+ * ownership of the frame. Its memory representation is used to pass it to
+ * a worker thread.
+ */
+void cvl_parallel_put(cvl_parallel_t *parallel, cvl_frame_t *frame)
+{
+    cvl_assert(parallel != NULL);
+    cvl_assert(frame != NULL);
+    if (cvl_error())
+	return;
+
+    cvl__parallel_t *p = (cvl__parallel_t *)parallel;
+
+    cvl_frame_pointer(frame);
+    if (cvl_error())
+	return;
+    pthread_mutex_lock(&p->mutex);
+    if (p->jobs_len == p->jobs_size)
+    {
+	cvl__parallel_job_t *jobs = realloc(p->jobs, (p->jobs_size + 16) * sizeof(cvl__parallel_job_t));
+	if (!jobs)
+	{
+	    pthread_mutex_unlock(&p->mutex);
+	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	    return;
+	}
+	p->jobs = jobs;
+	p->jobs_size += 16;
+    }
+    p->jobs[p->jobs_len].state = CVL_PARALLEL_QUEUED;
+    p->jobs[p->jobs_len].frame = frame;
+    p->jobs_len++;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+/**
+ * \param parallel	The parallel frame processor.
+ * \param wait		Whether to wait for the next result.
+ * \return		The next result frame, or NULL.
+ *
+ * Returns the result for the oldest frame that was put into the processor and
+ * was not yet retrieved, so that the results have the same order as the
+ * input frames. If that result is not yet available, this function waits for
+ * it if \a wait is true, and returns NULL otherwise. If there are no pending
+ * frames at all, NULL is returned immediately.\n
+ * If a worker thread failed, the CVL error is set in the current context, and
+ * NULL is returned.
+ */
+cvl_frame_t *cvl_parallel_get(cvl_parallel_t *parallel, bool wait)
+{
+    cvl_assert(parallel != NULL);
+    if (cvl_error())
+	return NULL;
+
+    cvl__parallel_t *p = (cvl__parallel_t *)parallel;
+    cvl_frame_t *frame = NULL;
+
+    pthread_mutex_lock(&p->mutex);
+    while (wait && !p->error && p->jobs_len > 0 && p->jobs[0].state != CVL_PARALLEL_DONE)
+	pthread_cond_wait(&p->cond, &p->mutex);
+    if (p->error)
+    {
+	cvl_error_set(p->error, "%s", p->error_msg ? p->error_msg : "unknown");
+    }
+    else if (p->jobs_len > 0 && p->jobs[0].state == CVL_PARALLEL_DONE)
+    {
+	frame = p->jobs[0].frame;
+	memmove(p->jobs, p->jobs + 1, (p->jobs_len - 1) * sizeof(cvl__parallel_job_t));
+	p->jobs_len--;
+	p->jobs_first++;
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    return frame;
+}
+
+/**
+ * \param parallel	The parallel frame processor.
+ * \return		The number of pending frames.
+ *
+ * Returns the number of frames that were put into the processor but whose
+ * results were not yet retrieved with cvl_parallel_get().
+ */
+int cvl_parallel_pending(cvl_parallel_t *parallel)
+{
+    cvl_assert(parallel != NULL);
+    if (cvl_error())
+	return 0;
+
+    cvl__parallel_t *p = (cvl__parallel_t *)parallel;
+    int pending;
+
+    pthread_mutex_lock(&p->mutex);
+    pending = p->jobs_len;
+    pthread_mutex_unlock(&p->mutex);
+    return pending;
+}
+
+#else /* !HAVE_PTHREAD */
+
+/* Without POSIX threads, no parallel frame processor can be created. Callers
+ * must process the frames in the current context instead. */
+
+cvl_parallel_t *cvl_parallel_new(const char *display_name, int jobs,
+	cvl_parallel_func_t func, void *data)
+{
+    cvl_error_set(CVL_ERROR_SYS, "Parallel processing needs POSIX threads");
+    return NULL;
+}
+
+void cvl_parallel_free(cvl_parallel_t *parallel)
+{
+}
+
+void cvl_parallel_put(cvl_parallel_t *parallel, cvl_frame_t *frame)
+{
+    cvl_frame_free(frame);
+}
+
+cvl_frame_t *cvl_parallel_get(cvl_parallel_t *parallel, bool wait)
+{
+    return NULL;
+}
+
+int cvl_parallel_pending(cvl_parallel_t *parallel)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,422 @@
+/*
+ * cvl_profile.c
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010
+ * Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file cvl_profile.h
+ * \brief Profiling.
+ *
+ * Measuring where time goes inside CVL.
+ * When profiling is enabled, CVL records the wall time, the GPU time, and the
+ * number of processed pixels of each rendering pass, and the wall time and
+ * number of bytes of each transfer between frame memory and textures. The
+ * records are aggregated per operation. A rendering pass is attributed to the
+ * GL program that it uses; the names of these programs start with the name of
+ * the CVL function that created them. Transfers are attributed to
+ * cvl_frame_pointer() (downloads) and cvl_frame_texture() (uploads).\n
+ * Profiling is disabled by default. It is enabled with cvl_profile_enable() or
+ * by setting the environment variable CVL_PROFILE to 1 before cvl_init() is
+ * called. The records are shared between all CVL contexts of a process.\n
+ * Note that profiling slows down processing, because each measurement
+ * waits for the GL to finish its work.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if HAVE_PTHREAD
+# include <pthread.h>
+#endif
+#ifdef W32_NATIVE
+# include <sys/timeb.h>
+#else
+# include <time.h>
+#endif
+
+#include <GL/glew.h>
+
+#define CVL_BUILD
+#include "cvl_intern.h"
+#include "cvl/cvl.h"
+
+
+/**
+ * \struct cvl_profile_op_t
+ * \brief Profiling results for one operation.
+ *
+ * The profiling results that were aggregated for one operation.
+ * See cvl_profile_op().
+ */
+/** \var cvl_profile_op_t::name
+ *  The name of the operation. */
+/** \var cvl_profile_op_t::calls
+ *  The number of rendering passes or transfers. */
+/** \var cvl_profile_op_t::wall_time
+ *  The wall time in seconds. */
+/** \var cvl_profile_op_t::gpu_time
+ *  The GPU time in seconds, measured with GL_ARB_timer_query. This is
+ *  negative if the extension is not available, and zero for transfers. */
+/** \var cvl_profile_op_t::pixels
+ *  The number of pixels that were processed or transferred. */
+/** \var cvl_profile_op_t::bytes
+ *  The number of bytes that were transferred. */
+
+#if HAVE_PTHREAD
+static pthread_mutex_t cvl_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+# define cvl_profile_lock() pthread_mutex_lock(&cvl_profile_mutex)
+# define cvl_profile_unlock() pthread_mutex_unlock(&cvl_profile_mutex)
+#else
+# define cvl_profile_lock()
+# define cvl_profile_unlock()
+#endif
+static bool cvl_profile_is_enabled = false;
+static int cvl_profile_length = 0;
+static int cvl_profile_size = 0;
+static cvl_profile_op_t *cvl_profile_records = NULL;
+static int cvl_profile_tids = 0;
+static FILE *cvl_profile_trace_file = NULL;
+static long cvl_profile_trace_events = 0;
+static double cvl_profile_trace_start_time = 0.0;
+
+
+/**
+ * \param enable	Whether to enable profiling.
+ *
+ * Enables or disables profiling.
+ */
+void cvl_profile_enable(bool enable)
+{
+    cvl_profile_is_enabled = enable;
+}
+
+/**
+ * \return		Whether profiling is enabled.
+ *
+ * Returns whether profiling is enabled.
+ */
+bool cvl_profile_enabled(void)
+{
+    return cvl_profile_is_enabled;
+}
+
+/**
+ * Discards all profiling results.
+ */
+void cvl_profile_reset(void)
+{
+    cvl_profile_lock();
+    for (int i = 0; i < cvl_profile_length; i++)
+	free((char *)cvl_profile_records[i].name);
+    free(cvl_profile_records);
+    cvl_profile_length = 0;
+    cvl_profile_size = 0;
+    cvl_profile_records = NULL;
+    cvl_profile_unlock();
+}
+
+/**
+ * \return		The number of operations.
+ *
+ * Returns the number of operations for which profiling results were recorded.
+ */
+int cvl_profile_ops(void)
+{
+    cvl_profile_lock();
+    int ops = cvl_profile_length;
+    cvl_profile_unlock();
+    return ops;
+}
+
+/**
+ * \param index		The index of the operation.
+ * \param op		Buffer for the profiling results.
+ *
+ * Gets the profiling results of an operation. The \a index must be less than
+ * cvl_profile_ops(). The name of the operation stays valid until
+ * cvl_profile_reset() is called.
+ */
+void cvl_profile_op(int index, cvl_profile_op_t *op)
+{
+    cvl_assert(index >= 0);
+    cvl_assert(op != NULL);
+    if (cvl_error())
+	return;
+
+    cvl_profile_lock();
+    cvl_assert(index < cvl_profile_length);
+    if (!cvl_error())
+	*op = cvl_profile_records[index];
+    cvl_profile_unlock();
+}
+
+
+/**
+ * \param f		The trace file.
+ *
+ * Starts writing a trace to \a f. The trace contains one event for each
+ * measurement (see above), in the Trace Event JSON format that is understood
+ * by the Chrome and Perfetto trace viewers. Each CVL context appears as its
+ * own thread. The events of cvl_read() and cvl_write() carry the number of the
+ * frame that was read or written in their context. All other events carry the
+ * number of the output frame that is being computed, which is the number of
+ * frames written so far with cvl_write(); for temporal filters, this differs
+ * from the number of the frame that was read last. The frames that
+ * cvl_parallel_new() processes carry their stream position.
+ * Tracing is independent of cvl_profile_enable().
+ */
+void cvl_profile_trace_start(FILE *f)
+{
+    cvl_assert(f != NULL);
+    if (cvl_error())
+	return;
+
+    cvl_profile_lock();
+    cvl_profile_trace_file = f;
+    cvl_profile_trace_events = 0;
+    cvl_profile_trace_start_time = cvl_profile_time();
+    fputs("[", f);
+    cvl_profile_unlock();
+}
+
+/**
+ * Stops writing the trace that was started with cvl_profile_trace_start().
+ * The trace file is not closed.
+ */
+void cvl_profile_trace_stop(void)
+{
+    cvl_profile_lock();
+    if (cvl_profile_trace_file)
+    {
+	fputs("\n]\n", cvl_profile_trace_file);
+	if (fflush(cvl_profile_trace_file) != 0)
+	    cvl_error_set(CVL_ERROR_IO, "Cannot write trace: %s", strerror(errno));
+	cvl_profile_trace_file = NULL;
+    }
+    cvl_profile_unlock();
+}
+
+
+/* Internal functions, used by the rest of CVL. */
+
+/* Returns the current time in seconds, from an arbitrary starting point. */
+double cvl_profile_time(void)
+{
+#ifdef W32_NATIVE
+    struct _timeb tb;
+    _ftime(&tb);
+    return (double)tb.time + (double)tb.millitm / 1000.0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+/* Returns whether measurements are needed, for profiling or for tracing. */
+bool cvl_profile_active(void)
+{
+    return (cvl_profile_is_enabled || cvl_profile_trace_file);
+}
+
+/* Returns a new thread id for the trace. Each CVL context gets its own. */
+int cvl_profile_new_tid(void)
+{
+    cvl_profile_lock();
+    int tid = ++cvl_profile_tids;
+    cvl_profile_unlock();
+    return tid;
+}
+
+static void cvl_profile_trace_string(const char *s)
+{
+    fputc('"', cvl_profile_trace_file);
+    for (; *s; s++)
+    {
+	if (*s == '"' || *s == '\\')
+	    fputc('\\', cvl_profile_trace_file);
+	fputc(*s, cvl_profile_trace_file);
+    }
+    fputc('"', cvl_profile_trace_file);
+}
+
+/* Records a measurement. The mutex must be locked. */
+static void cvl_profile_record(const char *name, const char *detail, long frame,
+	double start, double stop, double gpu_time, long long pixels, long long bytes)
+{
+    if (cvl_profile_trace_file)
+    {
+	fputs(cvl_profile_trace_events == 0 ? "\n" : ",\n", cvl_profile_trace_file);
+	fputs("{\"name\":", cvl_profile_trace_file);
+	cvl_profile_trace_string(name);
+	fprintf(cvl_profile_trace_file, ",\"cat\":\"cvl\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+		"\"pid\":1,\"tid\":%d,\"args\":{",
+		(start - cvl_profile_trace_start_time) * 1e6, (stop - start) * 1e6,
+		cvl_context()->cvl_profile_tid);
+	if (frame >= 0)
+	    fprintf(cvl_profile_trace_file, "\"frame\":%ld,", frame);
+	if (detail)
+	{
+	    fputs("\"detail\":", cvl_profile_trace_file);
+	    cvl_profile_trace_string(detail);
+	    fputc(',', cvl_profile_trace_file);
+	}
+	if (gpu_time > 0.0)
+	    fprintf(cvl_profile_trace_file, "\"gpu_us\":%.3f,", gpu_time * 1e6);
+	fprintf(cvl_profile_trace_file, "\"pixels\":%lld,\"bytes\":%lld}}", pixels, bytes);
+	cvl_profile_trace_events++;
+    }
+
+    if (!cvl_profile_is_enabled)
+	return;
+    int i;
+    for (i = 0; i < cvl_profile_length; i++)
+    {
+	if (strcmp(cvl_profile_records[i].name, name) == 0)
+	    break;
+    }
+    if (i == cvl_profile_length)
+    {
+	if (cvl_profile_length == cvl_profile_size)
+	{
+	    int newsize = (cvl_profile_size == 0 ? 16 : 2 * cvl_profile_size);
+	    cvl_profile_op_t *newrecords = realloc(cvl_profile_records,
+		    newsize * sizeof(cvl_profile_op_t));
+	    if (!newrecords)
+	    {
+		cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+		return;
+	    }
+	    cvl_profile_records = newrecords;
+	    cvl_profile_size = newsize;
+	}
+	char *namecopy = strdup(name);
+	if (!namecopy)
+	{
+	    cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	    return;
+	}
+	cvl_profile_records[i].name = namecopy;
+	cvl_profile_records[i].calls = 0;
+	cvl_profile_records[i].wall_time = 0.0;
+	cvl_profile_records[i].gpu_time = 0.0;
+	cvl_profile_records[i].pixels = 0;
+	cvl_profile_records[i].bytes = 0;
+	cvl_profile_length++;
+    }
+    cvl_profile_records[i].calls++;
+    cvl_profile_records[i].wall_time += stop - start;
+    if (gpu_time < 0.0 || cvl_profile_records[i].gpu_time < 0.0)
+	cvl_profile_records[i].gpu_time = -1.0;
+    else
+	cvl_profile_records[i].gpu_time += gpu_time;
+    cvl_profile_records[i].pixels += pixels;
+    cvl_profile_records[i].bytes += bytes;
+}
+
+/* Returns the program cache name of the active GL program, or the given
+ * function name if the fixed function pipeline is active. */
+static const char *cvl_profile_program_name(const char *function)
+{
+    cvl_context_t *ctx = cvl_context();
+    GLint prg;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prg);
+    if (prg == 0)
+	return function;
+    for (int i = 0; i < ctx->cvl_gl_program_cache_length; i++)
+    {
+	if (ctx->cvl_gl_program_cache_values[i] == (GLuint)prg)
+	    return ctx->cvl_gl_program_cache_names[i];
+    }
+    return "unknown program";
+}
+
+/* Starts measuring a rendering pass. */
+void cvl_profile_pass_begin_function(cvl_profile_pass_t *pass, const char *function)
+{
+    pass->active = cvl_profile_active();
+    pass->function = function;
+    if (!pass->active)
+	return;
+
+    cvl_context_t *ctx = cvl_context();
+    glFinish();
+    pass->start = cvl_profile_time();
+    if (ctx->cvl_gl_have_timer_query)
+    {
+	if (ctx->cvl_gl_profile_queries[0] == 0)
+	    glGenQueries(2, ctx->cvl_gl_profile_queries);
+	glQueryCounter(ctx->cvl_gl_profile_queries[0], GL_TIMESTAMP);
+    }
+}
+
+/* Finishes measuring a rendering pass that wrote the given number of pixels,
+ * and records the result for the active GL program. */
+void cvl_profile_pass_end(cvl_profile_pass_t *pass, long long pixels)
+{
+    if (!pass->active)
+	return;
+
+    cvl_context_t *ctx = cvl_context();
+    double gpu_time = -1.0;
+    if (ctx->cvl_gl_have_timer_query)
+    {
+	GLuint64 ns0, ns1;
+	glQueryCounter(ctx->cvl_gl_profile_queries[1], GL_TIMESTAMP);
+	glGetQueryObjectui64v(ctx->cvl_gl_profile_queries[0], GL_QUERY_RESULT, &ns0);
+	glGetQueryObjectui64v(ctx->cvl_gl_profile_queries[1], GL_QUERY_RESULT, &ns1);
+	gpu_time = (double)(ns1 - ns0) / 1000000000.0;
+    }
+    glFinish();
+    double stop = cvl_profile_time();
+    cvl_profile_lock();
+    cvl_profile_record(cvl_profile_program_name(pass->function), NULL, ctx->cvl_profile_frame,
+	    pass->start, stop, gpu_time, pixels, 0);
+    cvl_profile_unlock();
+}
+
+/* Records an operation without GPU time measurement that took place between
+ * the given times. The detail string may be NULL; it only appears in the
+ * trace. The frame number is negative if unknown. */
+void cvl_profile_interval(const char *name, const char *detail, long frame,
+	double start, double stop, long long pixels, long long bytes)
+{
+    if (!cvl_profile_active())
+	return;
+
+    cvl_profile_lock();
+    cvl_profile_record(name, detail, frame, start, stop, 0.0, pixels, bytes);
+    cvl_profile_unlock();
+}
+
+/* Records an operation without GPU time measurement that started at the given
+ * time and ends now, for example a transfer between frame memory and a
+ * texture. */
+void cvl_profile_span(const char *name, const char *detail, long frame,
+	double start, long long pixels, long long bytes)
+{
+    if (!cvl_profile_active())
+	return;
+
+    cvl_profile_interval(name, detail, frame, start, cvl_profile_time(), pixels, bytes);
+}
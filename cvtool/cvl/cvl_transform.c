@@ -172,6 +172,8 @@ cvl_frame_t *cvl_affine(cvl_frame_t *frame, const float *matrix,
     }
     float nw = (float)new_width;
     float nh = (float)new_height;
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 0.0f);
     glVertex3f(((ep0x - minx) / nw) * 2.0f - 1.0f, ((ep0y - miny) / nh) * 2.0f - 1.0f, 0.0f);
@@ -182,6 +184,7 @@ cvl_frame_t *cvl_affine(cvl_frame_t *frame, const float *matrix,
     glTexCoord2f(0.0f, 1.0f);
     glVertex3f(((ep3x - minx) / nw) * 2.0f - 1.0f, ((ep3y - miny) / nh) * 2.0f - 1.0f, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)new_width * new_height);
     cvl_check_errors();
 
     return transformed;
@@ -291,6 +294,8 @@ void cvl_flip(cvl_frame_t *dst, cvl_frame_t *src)
     glViewport(0, 0, cvl_frame_width(dst), cvl_frame_height(dst));
     glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
     cvl_gl_set_texture_state();
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 1.0f);
     glVertex3f(-1.0f, -1.0f, 0.0f);
@@ -301,6 +306,7 @@ void cvl_flip(cvl_frame_t *dst, cvl_frame_t *src)
     glTexCoord2f(0.0f, 0.0f);
     glVertex3f(-1.0f, 1.0f, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(dst));
     cvl_check_errors();
 }
 
@@ -327,6 +333,8 @@ void cvl_flop(cvl_frame_t *dst, cvl_frame_t *src)
     glViewport(0, 0, cvl_frame_width(dst), cvl_frame_height(dst));
     glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
     cvl_gl_set_texture_state();
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 1.0f);
     glVertex3f(1.0f, 1.0f, 0.0f);
@@ -337,5 +345,6 @@ void cvl_flop(cvl_frame_t *dst, cvl_frame_t *src)
     glTexCoord2f(0.0f, 0.0f);
     glVertex3f(1.0f, -1.0f, 0.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)cvl_frame_size(dst));
     cvl_check_errors();
 }
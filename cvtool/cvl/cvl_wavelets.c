@@ -27,9 +27,22 @@
  * Functions to work with Wavelets.
  */
 
+/**
+ * \typedef cvl_wavelets_method_t
+ * The method used to compute a wavelet transform.
+ */
+/** \var CVL_WAVELETS_AUTO
+ * Choose the method based on the frame size. */
+/** \var CVL_WAVELETS_GPU
+ * Transform on the GPU. */
+/** \var CVL_WAVELETS_CPU
+ * Transform on the CPU, with the lifting scheme where possible. */
+
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #define CVL_BUILD
 #include "cvl_intern.h"
@@ -55,6 +68,8 @@ static void cvl_wavelets_dwt_helper(cvl_frame_t *pong, cvl_frame_t *ping, float
     glViewport(0, 0, cvl_frame_width(pong), cvl_frame_height(pong));
     glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(ping));
     cvl_gl_set_texture_state();
+    cvl_profile_pass_t pass;
+    cvl_profile_pass_begin(&pass);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 0.0f);
     glVertex2f(-1.0f, -1.0f);
@@ -65,45 +80,424 @@ static void cvl_wavelets_dwt_helper(cvl_frame_t *pong, cvl_frame_t *ping, float
     glTexCoord2f(0.0f, level_boundary);
     glVertex2f(-1.0f, 2.0f * level_boundary - 1.0f);
     glEnd();
+    cvl_profile_pass_end(&pass, (long long)(level_boundary * level_boundary * cvl_frame_size(pong)));
 }
 
-/**
- * \param dst		The destination frame.
- * \param src		The source frame.
- * \param tmp		A frame to store intermediate results.
- * \param D		The Daubechies wavelet to use.
- * \param level		The level.
- *
- * Performs a Discrete Wavelet Transform (DWT) on \a src and stores the result
- * in \a dst. The Daubechies wavelet can be selected from D2 (aka Haar wavelet)
- * to D20 (the parameter \a D must be even). Level 0 is the original image,
- * therefore the \a level parameter must be 1 or greater. The frame \a dst
- * should always be of type #CVL_FLOAT or #CVL_FLOAT16. The frame \a tmp
- * should have the same dimensions, type, and channels as \a dst. 
- * The dimensions of all frames must be divisible by two to the power of \a level.
- */
-void cvl_wavelets_dwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
+/* The CPU path transforms each level in place: first the rows and then the
+ * columns of the part of the frame that holds the approximation of the
+ * previous level. Neighbouring rows or columns are transformed together in
+ * blocks. A sample of a block is the vector of the channels of all its
+ * lines, so that the inner loops run over contiguous floats and can be
+ * vectorized by the compiler. */
+
+#define CVL_WAVELETS_ROW_BLOCK 4
+#define CVL_WAVELETS_COLUMN_BLOCK 64
+
+/* Loops over the L floats of a sample in chunks of constant size, so that the
+ * compiler vectorizes the loop body. L must be a multiple of the chunk size. */
+#define CVL_WAVELETS_CHUNK 16
+#define cvl_wavelets_for_lanes(l) \
+    for (int l##_chunk = 0; l##_chunk < L; l##_chunk += CVL_WAVELETS_CHUNK) \
+	for (int l = l##_chunk; l < l##_chunk + CVL_WAVELETS_CHUNK; l++)
+
+/* The approximation coefficients h of the Daubechies wavelets, as in
+ * glsl/wavelets/dwt_step1.glsl. The detail coefficients are
+ * g[c] = (-1)^c h[D-1-c]. */
+static const float cvl_wavelets_coeff[10][20] =
 {
-    cvl_assert(dst != NULL);
-    cvl_assert(src != NULL);
-    cvl_assert(tmp != NULL);
-    cvl_assert(dst != src);
-    cvl_assert(dst != tmp);
-    cvl_assert(src != tmp);
-    cvl_assert(cvl_frame_type(dst) != CVL_UINT8);
-    cvl_assert(cvl_frame_type(tmp) != CVL_UINT8);
-    cvl_assert(cvl_frame_channels(tmp) == cvl_frame_channels(dst));
-    cvl_assert(cvl_frame_width(src) == cvl_frame_width(tmp));
-    cvl_assert(cvl_frame_width(tmp) == cvl_frame_width(dst));
-    cvl_assert(cvl_frame_height(src) == cvl_frame_height(tmp));
-    cvl_assert(cvl_frame_height(tmp) == cvl_frame_height(dst));
-    cvl_assert(D >= 2 && D <= 20 && D % 2 == 0);
-    cvl_assert(level >= 1);
-    cvl_assert(cvl_frame_width(src) % cvl_powi(2, level) == 0);
-    cvl_assert(cvl_frame_height(src) % cvl_powi(2, level) == 0);
+    { /* D2 */
+	+0.70710678118654752443610414514f, +0.70710678118654752443610414514f
+    },
+    { /* D4 */
+	+0.48296291314453414337487159986f, +0.83651630373780790557529378092f,
+	+0.22414386804201338102597276224f, -0.12940952255126038117444941881f
+    },
+    { /* D6 */
+	+0.33267055295008261599851158914f, +0.80689150931109257649449360409f,
+	+0.45987750211849157009515194215f, -0.13501102001025458869638990670f,
+	-0.08544127388202666169281916918f, +0.03522629188570953660274066472f
+    },
+    { /* D8 */
+	+0.23037781330889650086329118304f, +0.71484657055291564708992195527f,
+	+0.63088076792985890788171633830f, -0.02798376941685985421141374718f,
+	-0.18703481171909308407957067279f, +0.03084138183556076362721936253f,
+	+0.03288301166688519973540751355f, -0.01059740178506903210488320852f
+    },
+    { /* D10 */
+	+0.16010239797419291448072374802f, +0.60382926979718967054011930653f,
+	+0.72430852843777292772807124410f, +0.13842814590132073150539714634f,
+	-0.24229488706638203186257137947f, -0.03224486958463837464847975506f,
+	+0.07757149384004571352313048939f, -0.00624149021279827427419051911f,
+	-0.01258075199908199946850973993f, +0.00333572528547377127799818342f
+    },
+    { /* D12 */
+	+0.11154074335010946362132391724f, +0.49462389039845308567720417688f,
+	+0.75113390802109535067893449844f, +0.31525035170919762908598965481f,
+	-0.22626469396543982007631450066f, -0.12976686756726193556228960588f,
+	+0.09750160558732304910234355254f, +0.02752286553030572862554083950f,
+	-0.03158203931748602956507908070f, +0.00055384220116149613925191840f,
+	+0.00477725751094551063963597525f, -0.00107730108530847956485262161f
+    },
+    { /* D14 */
+	+0.07785205408500917901996352196f, +0.39653931948191730653900039094f,
+	+0.72913209084623511991694307034f, +0.46978228740519312247159116097f,
+	-0.14390600392856497540506836221f, -0.22403618499387498263814042023f,
+	+0.07130921926683026475087657050f, +0.08061260915108307191292248036f,
+	-0.03802993693501441357959206160f, -0.01657454163066688065410767489f,
+	+0.01255099855609984061298988603f, +0.00042957797292136652113212912f,
+	-0.00180164070404749091526826291f, +0.00035371379997452024844629584f
+    },
+    { /* D16 */
+	+0.05441584224310400995500940520f, +0.31287159091429997065916237551f,
+	+0.67563073629728980680780076705f, +0.58535468365420671277126552005f,
+	-0.01582910525634930566738054788f, -0.28401554296154692651620313237f,
+	+0.00047248457391328277036059001f, +0.12874742662047845885702928751f,
+	-0.01736930100180754616961614887f, -0.04408825393079475150676372324f,
+	+0.01398102791739828164872293057f, +0.00874609404740577671638274325f,
+	-0.00487035299345157431042218156f, -0.00039174037337694704629808036f,
+	+0.00067544940645056936636954757f, -0.00011747678412476953373062823f
+    },
+    { /* D18 */
+	+0.03807794736387834658869765888f, +0.24383467461259035373204158165f,
+	+0.60482312369011111190307686743f, +0.65728807805130053807821263905f,
+	+0.13319738582500757619095494590f, -0.29327378327917490880640319524f,
+	-0.09684078322297646051350813354f, +0.14854074933810638013507271751f,
+	+0.03072568147933337921231740072f, -0.06763282906132997367564227483f,
+	+0.00025094711483145195758718975f, +0.02236166212367909720537378270f,
+	-0.00472320475775139727792570785f, -0.00428150368246342983449679500f,
+	+0.00184764688305622647661912949f, +0.00023038576352319596720521639f,
+	-0.00025196318894271013697498868f, +0.00003934732031627159948068988f
+    },
+    { /* D20 */
+	+0.02667005790055555358661744877f, +0.18817680007769148902089297368f,
+	+0.52720118893172558648174482796f, +0.68845903945360356574187178255f,
+	+0.28117234366057746074872699845f, -0.24984642432731537941610189792f,
+	-0.19594627437737704350429925432f, +0.12736934033579326008267723320f,
+	+0.09305736460357235116035228984f, -0.07139414716639708714533609308f,
+	-0.02945753682187581285828323760f, +0.03321267405934100173976365318f,
+	+0.00360655356695616965542329142f, -0.01073317548333057504431811411f,
+	+0.00139535174705290116578931845f, +0.00199240529518505611715874224f,
+	-0.00068585669495971162656137098f, -0.00011646685512928545095148097f,
+	+0.00009358867032006959133405013f, -0.00001326420289452124481243668f
+    },
+};
+
+/* Lane-wise operations on samples with L floats. The pointers must not
+ * overlap, which allows the compiler to vectorize the loops. */
+
+static inline void cvl_wavelets_set1(float *restrict x, const float *restrict y0, float c0, int L)
+{
+    cvl_wavelets_for_lanes(l)
+	x[l] = c0 * y0[l];
+}
+
+static inline void cvl_wavelets_set2(float *restrict x, const float *restrict y0, float c0,
+	const float *restrict y1, float c1, int L)
+{
+    cvl_wavelets_for_lanes(l)
+	x[l] = c0 * y0[l] + c1 * y1[l];
+}
+
+static inline void cvl_wavelets_add1(float *restrict x, const float *restrict y0, float c0, int L)
+{
+    cvl_wavelets_for_lanes(l)
+	x[l] += c0 * y0[l];
+}
+
+static inline void cvl_wavelets_add2(float *restrict x, const float *restrict y0, float c0,
+	const float *restrict y1, float c1, int L)
+{
+    cvl_wavelets_for_lanes(l)
+	x[l] += c0 * y0[l] + c1 * y1[l];
+}
+
+#define CVL_WAVELETS_SAMPLE(p, i) ((p) + (size_t)(i) * L)
+
+/* Returns the number of floats of a sample of the given number of lines,
+ * padded to whole chunks. */
+static int cvl_wavelets_lanes(int lines, int channels)
+{
+    return (lines * channels + CVL_WAVELETS_CHUNK - 1) / CVL_WAVELETS_CHUNK * CVL_WAVELETS_CHUNK;
+}
+
+/* Transforms n samples with L floats each. The buffer in holds the even
+ * samples, followed by the odd samples, and is overwritten. The approximation
+ * is stored in the first (n+1)/2 samples of out, the details in the
+ * remaining n/2 samples. The first 2*(n/2) samples are extended periodically.
+ * If n is odd, the last sample is scaled like an approximation of a pair of
+ * equal samples and appended to the approximation, so that any length can be
+ * inverted exactly. D2 and D4 use the lifting scheme, which works in place
+ * and needs fewer multiplications than the convolution. */
+static void cvl_wavelets_dwt_1d(float *out, float *in, int n, int L, int D)
+{
+    const float sqrt2 = sqrtf(2.0f);
+    const int m = n / 2;
+    float *E = in;
+    float *O = CVL_WAVELETS_SAMPLE(in, n - m);
+    float *a = out;
+    float *d = CVL_WAVELETS_SAMPLE(out, n - m);
+
+    if (D == 2)
+    {
+	for (int i = 0; i < m; i++)
+	{
+	    float *e = CVL_WAVELETS_SAMPLE(E, i);
+	    float *o = CVL_WAVELETS_SAMPLE(O, i);
+	    cvl_wavelets_add1(o, e, -1.0f, L);
+	    cvl_wavelets_add1(e, o, 0.5f, L);
+	    cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(a, i), e, sqrt2, L);
+	    cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(d, i), o, -1.0f / sqrt2, L);
+	}
+    }
+    else if (D == 4)
+    {
+	const float sqrt3 = sqrtf(3.0f);
+	const float ka = (1.0f + sqrt3) / sqrt2;
+	const float kd = (1.0f - sqrt3) / sqrt2;
+	for (int i = 0; i < m; i++)
+	    cvl_wavelets_add1(CVL_WAVELETS_SAMPLE(O, i), CVL_WAVELETS_SAMPLE(E, i), -sqrt3, L);
+	for (int i = 0; i < m; i++)
+	    cvl_wavelets_add2(CVL_WAVELETS_SAMPLE(E, i), CVL_WAVELETS_SAMPLE(O, i), sqrt3 / 4.0f,
+		    CVL_WAVELETS_SAMPLE(O, (i + 1) % m), (sqrt3 - 2.0f) / 4.0f, L);
+	for (int i = 0; i < m; i++)
+	{
+	    cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(a, i), CVL_WAVELETS_SAMPLE(E, i), ka, L);
+	    cvl_wavelets_set2(CVL_WAVELETS_SAMPLE(d, i), CVL_WAVELETS_SAMPLE(O, (i + 1) % m), kd,
+		    CVL_WAVELETS_SAMPLE(E, i), kd, L);
+	}
+    }
+    else
+    {
+	const float *h = cvl_wavelets_coeff[D / 2 - 1];
+	float g[20];
+	for (int c = 0; c < D; c++)
+	    g[c] = (c % 2 == 0 ? h[D - 1 - c] : -h[D - 1 - c]);
+	for (int i = 0; i < m; i++)
+	{
+	    float *ai = CVL_WAVELETS_SAMPLE(a, i);
+	    float *di = CVL_WAVELETS_SAMPLE(d, i);
+	    memset(ai, 0, L * sizeof(float));
+	    memset(di, 0, L * sizeof(float));
+	    for (int k = 0; k < D / 2; k++)
+	    {
+		float *e = CVL_WAVELETS_SAMPLE(E, (i + k) % m);
+		float *o = CVL_WAVELETS_SAMPLE(O, (i + k) % m);
+		cvl_wavelets_add2(ai, e, h[2 * k], o, h[2 * k + 1], L);
+		cvl_wavelets_add2(di, e, g[2 * k], o, g[2 * k + 1], L);
+	    }
+	}
+    }
+    if (n % 2 == 1)
+	cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(a, m), CVL_WAVELETS_SAMPLE(E, m), sqrt2, L);
+}
+
+/* Inverts cvl_wavelets_dwt_1d(): in holds the approximation and the details,
+ * out receives the even samples, followed by the odd samples. */
+static void cvl_wavelets_idwt_1d(float *out, float *in, int n, int L, int D)
+{
+    const float sqrt2 = sqrtf(2.0f);
+    const int m = n / 2;
+    float *E = out;
+    float *O = CVL_WAVELETS_SAMPLE(out, n - m);
+    float *a = in;
+    float *d = CVL_WAVELETS_SAMPLE(in, n - m);
+
+    if (D == 2)
+    {
+	for (int i = 0; i < m; i++)
+	{
+	    float *e = CVL_WAVELETS_SAMPLE(E, i);
+	    float *o = CVL_WAVELETS_SAMPLE(O, i);
+	    cvl_wavelets_set1(e, CVL_WAVELETS_SAMPLE(a, i), 1.0f / sqrt2, L);
+	    cvl_wavelets_set1(o, CVL_WAVELETS_SAMPLE(d, i), -sqrt2, L);
+	    cvl_wavelets_add1(e, o, -0.5f, L);
+	    cvl_wavelets_add1(o, e, 1.0f, L);
+	}
+    }
+    else if (D == 4)
+    {
+	const float sqrt3 = sqrtf(3.0f);
+	const float ka = (1.0f + sqrt3) / sqrt2;
+	const float kd = (1.0f - sqrt3) / sqrt2;
+	for (int i = 0; i < m; i++)
+	{
+	    cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(E, i), CVL_WAVELETS_SAMPLE(a, i), 1.0f / ka, L);
+	    cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(O, (i + 1) % m), CVL_WAVELETS_SAMPLE(d, i), 1.0f / kd, L);
+	}
+	for (int i = 0; i < m; i++)
+	    cvl_wavelets_add1(CVL_WAVELETS_SAMPLE(O, i), CVL_WAVELETS_SAMPLE(E, (i + m - 1) % m), -1.0f, L);
+	for (int i = 0; i < m; i++)
+	    cvl_wavelets_add2(CVL_WAVELETS_SAMPLE(E, i), CVL_WAVELETS_SAMPLE(O, i), -sqrt3 / 4.0f,
+		    CVL_WAVELETS_SAMPLE(O, (i + 1) % m), -(sqrt3 - 2.0f) / 4.0f, L);
+	for (int i = 0; i < m; i++)
+	    cvl_wavelets_add1(CVL_WAVELETS_SAMPLE(O, i), CVL_WAVELETS_SAMPLE(E, i), sqrt3, L);
+    }
+    else
+    {
+	const float *h = cvl_wavelets_coeff[D / 2 - 1];
+	float g[20];
+	for (int c = 0; c < D; c++)
+	    g[c] = (c % 2 == 0 ? h[D - 1 - c] : -h[D - 1 - c]);
+	for (int j = 0; j < m; j++)
+	{
+	    float *e = CVL_WAVELETS_SAMPLE(E, j);
+	    float *o = CVL_WAVELETS_SAMPLE(O, j);
+	    memset(e, 0, L * sizeof(float));
+	    memset(o, 0, L * sizeof(float));
+	    for (int k = 0; k < D / 2; k++)
+	    {
+		int q = ((j - k) % m + m) % m;
+		float *aq = CVL_WAVELETS_SAMPLE(a, q);
+		float *dq = CVL_WAVELETS_SAMPLE(d, q);
+		cvl_wavelets_add2(e, aq, h[2 * k], dq, g[2 * k], L);
+		cvl_wavelets_add2(o, aq, h[2 * k + 1], dq, g[2 * k + 1], L);
+	    }
+	}
+    }
+    if (n % 2 == 1)
+	cvl_wavelets_set1(CVL_WAVELETS_SAMPLE(E, m), CVL_WAVELETS_SAMPLE(a, m), 1.0f / sqrt2, L);
+}
+
+/* One part of a pass over the rows or columns of one level: the blocks first
+ * to last-1 are transformed. */
+typedef struct
+{
+    float *data;
+    int width;
+    int channels;
+    int n;
+    int lines;
+    bool columns;
+    bool inverse;
+    int D;
+    int first;
+    int last;
+    float *buf;
+} cvl_wavelets_job_t;
+
+static void *cvl_wavelets_worker(void *arg)
+{
+    cvl_wavelets_job_t *job = arg;
+    const int n = job->n;
+    const int half = (n + 1) / 2;
+    const size_t sample_stride = (size_t)(job->columns ? job->width : 1) * job->channels;
+    const size_t line_stride = (size_t)(job->columns ? 1 : job->width) * job->channels;
+    const int block = (job->columns ? CVL_WAVELETS_COLUMN_BLOCK : CVL_WAVELETS_ROW_BLOCK);
+    float *in = job->buf;
+    float *out = job->buf + (size_t)n * cvl_wavelets_lanes(block, job->channels);
+
+    for (int b = job->first; b < job->last; b++)
+    {
+	int first_line = b * block;
+	int lines = cvl_mini(block, job->lines - first_line);
+	int floats = lines * job->channels;
+	int L = cvl_wavelets_lanes(lines, job->channels);
+	float *base = job->data + first_line * line_stride;
+	for (int i = 0; i < n; i++)
+	{
+	    // The forward transform reads even and odd samples separately
+	    int k = (job->inverse ? i : i % 2 == 0 ? i / 2 : half + i / 2);
+	    if (job->columns)
+		memcpy(in + (size_t)k * L, base + i * sample_stride, floats * sizeof(float));
+	    else
+		for (int r = 0; r < lines; r++)
+		    for (int c = 0; c < job->channels; c++)
+			in[(size_t)k * L + r * job->channels + c] = base[i * sample_stride + r * line_stride + c];
+	}
+	if (job->inverse)
+	    cvl_wavelets_idwt_1d(out, in, n, L, job->D);
+	else
+	    cvl_wavelets_dwt_1d(out, in, n, L, job->D);
+	for (int i = 0; i < n; i++)
+	{
+	    // The inverse transform writes even and odd samples separately
+	    int k = (!job->inverse ? i : i % 2 == 0 ? i / 2 : half + i / 2);
+	    if (job->columns)
+		memcpy(base + i * sample_stride, out + (size_t)k * L, floats * sizeof(float));
+	    else
+		for (int r = 0; r < lines; r++)
+		    for (int c = 0; c < job->channels; c++)
+			base[i * sample_stride + r * line_stride + c] = out[(size_t)k * L + r * job->channels + c];
+	}
+    }
+    return NULL;
+}
+
+/* Returns the size of the approximation of the given level along an axis of
+ * the given size. */
+static int cvl_wavelets_level_size(int size, int level)
+{
+    for (int l = 0; l < level; l++)
+	size = (size + 1) / 2;
+    return size;
+}
+
+/* Transforms all levels on the CPU. Frames of any size are supported. */
+static void cvl_wavelets_cpu(cvl_frame_t *dst, cvl_frame_t *src, int D, int level, bool inverse)
+{
+    int width = cvl_frame_width(src);
+    int height = cvl_frame_height(src);
+    cvl_frame_t *frame = cvl_frame_new(width, height, cvl_frame_channels(src), cvl_frame_format(src),
+	    CVL_FLOAT, CVL_MEM);
     if (cvl_error())
 	return;
-    
+    float *ptr = cvl_frame_pointer(frame);
+    int channels = (cvl_frame_format(src) == CVL_LUM ? 1 : cvl_frame_format(src) == CVL_UNKNOWN ? 4 : 3);
+    GLint glformat = (cvl_frame_format(src) == CVL_LUM ? GL_LUMINANCE 
+	    : cvl_frame_format(src) == CVL_UNKNOWN ? GL_RGBA : GL_RGB);
+    // Do not start threads for less than 64K samples each
+    int threads = cvl_cpu_threads(width * height, 65536);
+    size_t bufsize = 2 * (size_t)cvl_maxi(width * cvl_wavelets_lanes(CVL_WAVELETS_ROW_BLOCK, channels),
+	    height * cvl_wavelets_lanes(CVL_WAVELETS_COLUMN_BLOCK, channels));
+    float *buf = calloc(threads * bufsize, sizeof(float));
+    if (!buf)
+    {
+	cvl_frame_free(frame);
+	cvl_error_set(CVL_ERROR_MEM, "%s", strerror(ENOMEM));
+	return;
+    }
+    glBindTexture(GL_TEXTURE_2D, cvl_frame_texture(src));
+    glGetTexImage(GL_TEXTURE_2D, 0, glformat, GL_FLOAT, ptr);
+
+    cvl_wavelets_job_t jobs[CVL_CPU_MAX_THREADS];
+    for (int step = 0; step < 2 * level; step++)
+    {
+	// The forward transform goes from level 0 to level-1 and transforms
+	// rows first, the inverse goes the other way.
+	int l = (inverse ? level - 1 - step / 2 : step / 2);
+	bool columns = (inverse ? step % 2 == 0 : step % 2 == 1);
+	int w = cvl_wavelets_level_size(width, l);
+	int h = cvl_wavelets_level_size(height, l);
+	int lines = (columns ? w : h);
+	int block = (columns ? CVL_WAVELETS_COLUMN_BLOCK : CVL_WAVELETS_ROW_BLOCK);
+	int blocks = (lines + block - 1) / block;
+	int t_max = cvl_mini(threads, blocks);
+	for (int t = 0; t < t_max; t++)
+	{
+	    jobs[t].data = ptr;
+	    jobs[t].width = width;
+	    jobs[t].channels = channels;
+	    jobs[t].n = (columns ? h : w);
+	    jobs[t].lines = lines;
+	    jobs[t].columns = columns;
+	    jobs[t].inverse = inverse;
+	    jobs[t].D = D;
+	    jobs[t].first = (long long)blocks * t / t_max;
+	    jobs[t].last = (long long)blocks * (t + 1) / t_max;
+	    jobs[t].buf = buf + t * bufsize;
+	}
+	cvl_cpu_run(cvl_wavelets_worker, jobs, sizeof(cvl_wavelets_job_t), t_max);
+    }
+    free(buf);
+
+    cvl_copy(dst, frame);
+    cvl_frame_free(frame);
+}
+
+/* Transforms on the GPU. The frame dimensions must be divisible by two to the
+ * power of level. */
+static void cvl_wavelets_dwt_gpu(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
+{
     GLuint step1_prg;
     char *step1_prgname = cvl_asprintf("cvl_wavelets_dwt_step1_D=%d", D);
     if ((step1_prg = cvl_gl_program_cache_get(step1_prgname)) == 0)
@@ -155,39 +549,8 @@ void cvl_wavelets_dwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int
     cvl_check_errors();
 }
 
-/**
- * \param dst		The destination frame.
- * \param src		The source frame.
- * \param tmp		A frame to store intermediate results.
- * \param D		The Daubechies wavelet to use.
- * \param level		The level.
- *
- * Performs an Inverse Discrete Wavelet Transform (IDWT) on \a src and stores the
- * result in \a dst. The parameters \a D and \a level must be the same that were
- * given to cvl_wavelets_dwt(). See also cvl_wavelets_dwt().
- * The dimensions of all frames must be divisible by two to the power of \a level.
- */
-void cvl_wavelets_idwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
+static void cvl_wavelets_idwt_gpu(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
 {
-    cvl_assert(dst != NULL);
-    cvl_assert(src != NULL);
-    cvl_assert(tmp != NULL);
-    cvl_assert(dst != src);
-    cvl_assert(dst != tmp);
-    cvl_assert(src != tmp);
-    cvl_assert(cvl_frame_type(tmp) != CVL_UINT8);
-    cvl_assert(cvl_frame_channels(tmp) == cvl_frame_channels(dst));
-    cvl_assert(cvl_frame_width(src) == cvl_frame_width(tmp));
-    cvl_assert(cvl_frame_width(tmp) == cvl_frame_width(dst));
-    cvl_assert(cvl_frame_height(src) == cvl_frame_height(tmp));
-    cvl_assert(cvl_frame_height(tmp) == cvl_frame_height(dst));
-    cvl_assert(D >= 2 && D <= 20 && D % 2 == 0);
-    cvl_assert(level >= 1);
-    cvl_assert(cvl_frame_width(src) % cvl_powi(2, level) == 0);
-    cvl_assert(cvl_frame_height(src) % cvl_powi(2, level) == 0);
-    if (cvl_error())
-	return;
-    
     GLuint step1_prg;
     char *step1_prgname = cvl_asprintf("cvl_wavelets_idwt_step1_D=%d", D);
     if ((step1_prg = cvl_gl_program_cache_get(step1_prgname)) == 0)
@@ -246,6 +609,148 @@ void cvl_wavelets_idwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int
     cvl_check_errors();
 }
 
+/* Checks the parameters of cvl_wavelets_dwt_using() and
+ * cvl_wavelets_idwt_using(), and chooses the method. */
+static cvl_wavelets_method_t cvl_wavelets_method(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp,
+	int D, int level, cvl_wavelets_method_t method)
+{
+    cvl_assert(dst != NULL);
+    cvl_assert(src != NULL);
+    cvl_assert(tmp != NULL);
+    cvl_assert(dst != src);
+    cvl_assert(dst != tmp);
+    cvl_assert(src != tmp);
+    cvl_assert(cvl_frame_type(dst) != CVL_UINT8);
+    cvl_assert(cvl_frame_type(tmp) != CVL_UINT8);
+    cvl_assert(cvl_frame_channels(tmp) == cvl_frame_channels(dst));
+    cvl_assert(cvl_frame_width(src) == cvl_frame_width(tmp));
+    cvl_assert(cvl_frame_width(tmp) == cvl_frame_width(dst));
+    cvl_assert(cvl_frame_height(src) == cvl_frame_height(tmp));
+    cvl_assert(cvl_frame_height(tmp) == cvl_frame_height(dst));
+    cvl_assert(D >= 2 && D <= 20 && D % 2 == 0);
+    cvl_assert(level >= 1);
+    if (cvl_error())
+	return CVL_WAVELETS_AUTO;
+
+    bool divisible = (level < 31
+	    && cvl_frame_width(src) % cvl_powi(2, level) == 0
+	    && cvl_frame_height(src) % cvl_powi(2, level) == 0);
+    if (method == CVL_WAVELETS_AUTO)
+	method = (divisible ? CVL_WAVELETS_GPU : CVL_WAVELETS_CPU);
+    cvl_assert(method != CVL_WAVELETS_GPU || divisible);
+    return method;
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param tmp		A frame to store intermediate results.
+ * \param D		The Daubechies wavelet to use.
+ * \param level		The level.
+ *
+ * Performs a Discrete Wavelet Transform (DWT) on \a src and stores the result
+ * in \a dst. The Daubechies wavelet can be selected from D2 (aka Haar wavelet)
+ * to D20 (the parameter \a D must be even). Level 0 is the original image,
+ * therefore the \a level parameter must be 1 or greater. The frame \a dst
+ * should always be of type #CVL_FLOAT or #CVL_FLOAT16. The frame \a tmp
+ * should have the same dimensions, type, and channels as \a dst.\n
+ * Each level transforms the approximation of the previous level, which has
+ * half its width and height, rounded up. If a dimension of a level is odd,
+ * its last row or column is kept as part of the approximation.\n
+ * This function is equivalent to cvl_wavelets_dwt_using() with
+ * #CVL_WAVELETS_AUTO.
+ */
+void cvl_wavelets_dwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
+{
+    cvl_wavelets_dwt_using(dst, src, tmp, D, level, CVL_WAVELETS_AUTO);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param tmp		A frame to store intermediate results.
+ * \param D		The Daubechies wavelet to use.
+ * \param level		The level.
+ * \param method	The method.
+ *
+ * Performs a Discrete Wavelet Transform like cvl_wavelets_dwt(), using the
+ * given \a method. #CVL_WAVELETS_GPU needs two passes per level, and the
+ * dimensions of the frames must be divisible by two to the power of \a level.
+ * #CVL_WAVELETS_CPU downloads the frame and transforms all levels in place
+ * with parallel threads. It accepts frames of any size, and uses the lifting
+ * scheme for D2 and D4. The frame \a tmp is not used in this case.
+ * #CVL_WAVELETS_AUTO chooses the GPU if the dimensions allow it. The cvl-bench
+ * operations wavelets_dwt and wavelets_dwt_cpu compare both methods.
+ */
+void cvl_wavelets_dwt_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level,
+	cvl_wavelets_method_t method)
+{
+    method = cvl_wavelets_method(dst, src, tmp, D, level, method);
+    if (cvl_error())
+	return;
+
+    if (method == CVL_WAVELETS_CPU)
+	cvl_wavelets_cpu(dst, src, D, level, false);
+    else
+	cvl_wavelets_dwt_gpu(dst, src, tmp, D, level);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param tmp		A frame to store intermediate results.
+ * \param D		The Daubechies wavelet to use.
+ * \param level		The level.
+ *
+ * Performs an Inverse Discrete Wavelet Transform (IDWT) on \a src and stores the
+ * result in \a dst. The parameters \a D and \a level must be the same that were
+ * given to cvl_wavelets_dwt(). See also cvl_wavelets_dwt().\n
+ * This function is equivalent to cvl_wavelets_idwt_using() with
+ * #CVL_WAVELETS_AUTO.
+ */
+void cvl_wavelets_idwt(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level)
+{
+    cvl_wavelets_idwt_using(dst, src, tmp, D, level, CVL_WAVELETS_AUTO);
+}
+
+/**
+ * \param dst		The destination frame.
+ * \param src		The source frame.
+ * \param tmp		A frame to store intermediate results.
+ * \param D		The Daubechies wavelet to use.
+ * \param level		The level.
+ * \param method	The method.
+ *
+ * Performs an Inverse Discrete Wavelet Transform like cvl_wavelets_idwt(),
+ * using the given \a method. Both methods compute the same transform, so
+ * the inverse need not use the method of the forward transform. See also
+ * cvl_wavelets_dwt_using().
+ */
+void cvl_wavelets_idwt_using(cvl_frame_t *dst, cvl_frame_t *src, cvl_frame_t *tmp, int D, int level,
+	cvl_wavelets_method_t method)
+{
+    method = cvl_wavelets_method(dst, src, tmp, D, level, method);
+    if (cvl_error())
+	return;
+
+    if (method == CVL_WAVELETS_CPU)
+	cvl_wavelets_cpu(dst, src, D, level, true);
+    else
+	cvl_wavelets_idwt_gpu(dst, src, tmp, D, level);
+}
+
+/* Computes the texture coordinates that enclose the details of the given
+ * level in a transformed frame: they lie inside upper, but not inside lower. */
+static void cvl_wavelets_bounds(cvl_frame_t *frame, int level, float *lower, float *upper)
+{
+    int width = cvl_frame_width(frame);
+    int height = cvl_frame_height(frame);
+    lower[0] = (float)cvl_wavelets_level_size(width, level) / (float)width;
+    lower[1] = (float)cvl_wavelets_level_size(height, level) / (float)height;
+    upper[0] = (float)cvl_wavelets_level_size(width, level - 1) / (float)width;
+    upper[1] = (float)cvl_wavelets_level_size(height, level - 1) / (float)height;
+}
+
 /**
  * \param dst		The destination frame.
  * \param src		The source frame.
@@ -270,8 +775,8 @@ void cvl_wavelets_hard_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int leve
     {
 	threshold[t] = T[t];
     }
-    float upper_bound = 1.0f / (float)cvl_powi(2, level - 1);
-    float lower_bound = upper_bound / 2.0f;
+    float lower_bound[2], upper_bound[2];
+    cvl_wavelets_bounds(src, level, lower_bound, upper_bound);
     GLuint prg;
     if ((prg = cvl_gl_program_cache_get("cvl_wavelets_hard_thresholding")) == 0)
     {
@@ -279,8 +784,8 @@ void cvl_wavelets_hard_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int leve
     	cvl_gl_program_cache_put("cvl_wavelets_hard_thresholding", prg);
     }
     glUseProgram(prg);
-    glUniform1f(glGetUniformLocation(prg, "upper_bound"), upper_bound);
-    glUniform1f(glGetUniformLocation(prg, "lower_bound"), lower_bound);
+    glUniform2fv(glGetUniformLocation(prg, "upper_bound"), 1, upper_bound);
+    glUniform2fv(glGetUniformLocation(prg, "lower_bound"), 1, lower_bound);
     glUniform4fv(glGetUniformLocation(prg, "T"), 1, threshold);
     cvl_transform(dst, src);
     cvl_check_errors();
@@ -310,8 +815,8 @@ void cvl_wavelets_soft_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int leve
     {
 	threshold[t] = T[t];
     }
-    float upper_bound = 1.0f / (float)cvl_powi(2, level - 1);
-    float lower_bound = upper_bound / 2.0f;
+    float lower_bound[2], upper_bound[2];
+    cvl_wavelets_bounds(src, level, lower_bound, upper_bound);
     GLuint prg;
     if ((prg = cvl_gl_program_cache_get("cvl_wavelets_soft_thresholding")) == 0)
     {
@@ -319,8 +824,8 @@ void cvl_wavelets_soft_thresholding(cvl_frame_t *dst, cvl_frame_t *src, int leve
     	cvl_gl_program_cache_put("cvl_wavelets_soft_thresholding", prg);
     }
     glUseProgram(prg);
-    glUniform1f(glGetUniformLocation(prg, "upper_bound"), upper_bound);
-    glUniform1f(glGetUniformLocation(prg, "lower_bound"), lower_bound);
+    glUniform2fv(glGetUniformLocation(prg, "upper_bound"), 1, upper_bound);
+    glUniform2fv(glGetUniformLocation(prg, "lower_bound"), 1, lower_bound);
     glUniform4fv(glGetUniformLocation(prg, "T"), 1, threshold);
     cvl_transform(dst, src);
     cvl_check_errors();
@@ -0,0 +1,67 @@
+/*
+ * fft_stockham.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * One pass of the radix-2 Stockham FFT along rows or columns. Pass ns (1, 2,
+ * 4, ..., n/2) combines pairs of transforms of length ns into transforms of
+ * length 2ns. Each output position o gathers its two inputs j and j+n/2.
+ * Real and imaginary parts are stored in separate textures.
+ */
+
+#version 110
+
+uniform sampler2D textures[2];	// real and imaginary part
+uniform vec2 size;
+uniform vec2 dir;		// (1,0) for rows, (0,1) for columns
+uniform float n;
+uniform float ns;
+uniform float dir_sign;	// -1 for the forward transform, +1 for the inverse
+uniform float real_input;	// the imaginary part is zero
+uniform float scale;
+
+const float pi = 3.14159265358979323846;
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * size;
+    float o = floor(dot(p, dir));
+    float q = floor((o + 0.5) / (2.0 * ns));
+    float m = o - q * 2.0 * ns;
+    float r = step(ns, m);
+    float jm = m - r * ns;
+    float j = q * ns + jm;
+
+    vec2 pa = (p + (j - o) * dir) / size;
+    vec2 pb = (p + (j + 0.5 * n - o) * dir) / size;
+    vec4 a_re = texture2D(textures[0], pa);
+    vec4 a_im = (1.0 - real_input) * texture2D(textures[1], pa);
+    vec4 b_re = texture2D(textures[0], pb);
+    vec4 b_im = (1.0 - real_input) * texture2D(textures[1], pb);
+
+    float angle = dir_sign * pi * jm / ns;
+    float c = cos(angle);
+    float s = sin(angle);
+    vec4 t_re = b_re * c - b_im * s;
+    vec4 t_im = b_re * s + b_im * c;
+    float f = 1.0 - 2.0 * r;
+    gl_FragData[0] = scale * (a_re + f * t_re);
+    gl_FragData[1] = scale * (a_im + f * t_im);
+}
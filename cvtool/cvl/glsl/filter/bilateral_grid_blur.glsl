@@ -0,0 +1,68 @@
+/*
+ * bilateral_grid_blur.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Blurs the bilateral grid (see bilateral_grid_splat.glsl) in one direction
+ * with a Gauss mask. Cells outside of the grid are zero.
+ */
+
+#version 110
+
+const int k = $k;
+uniform sampler2D textures[2];	// value sums and weight sums
+uniform vec2 dst_size;
+uniform vec3 grid_size;
+uniform float tiles_per_row;
+uniform vec3 dir;		// (1,0,0), (0,1,0), or (0,0,1)
+uniform float mask[2 * k + 1];
+
+vec2 cell_coord(vec3 c)
+{
+    float tile_y = floor((c.z + 0.5) / tiles_per_row);
+    float tile_x = c.z - tile_y * tiles_per_row;
+    return (vec2(tile_x, tile_y) * grid_size.xy + c.xy + 0.5) / dst_size;
+}
+
+void main()
+{
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size);
+    vec2 tile = floor((p + 0.5) / grid_size.xy);
+    vec3 cell = vec3(p - tile * grid_size.xy, tile.y * tiles_per_row + tile.x);
+
+    vec4 sum = vec4(0.0);
+    vec4 weight = vec4(0.0);
+    if (cell.z < grid_size.z)
+    {
+	for (int i = -k; i <= +k; i++)
+	{
+	    vec3 c = cell + float(i) * dir;
+	    if (all(greaterThanEqual(c, vec3(0.0))) && all(lessThan(c, grid_size)))
+	    {
+		vec2 coord = cell_coord(c);
+		sum += mask[i + k] * texture2D(textures[0], coord);
+		weight += mask[i + k] * texture2D(textures[1], coord);
+	    }
+	}
+    }
+    gl_FragData[0] = sum;
+    gl_FragData[1] = weight;
+}
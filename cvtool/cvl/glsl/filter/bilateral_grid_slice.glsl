@@ -0,0 +1,85 @@
+/*
+ * bilateral_grid_slice.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Reads the result of the bilateral filter from the blurred bilateral grid
+ * (see bilateral_grid_splat.glsl): the value and weight sums are interpolated
+ * trilinearly at the position of the pixel, and their ratio is the result.
+ */
+
+#version 110
+
+const int channels = $channels;
+uniform sampler2D textures[3];	// source, value sums, weight sums
+uniform vec2 dst_size;
+uniform vec2 grid_tex_size;
+uniform vec3 grid_size;
+uniform float tiles_per_row;
+uniform float sampling_spatial;
+uniform float sampling_range;
+uniform vec4 range_min;
+
+vec2 cell_coord(vec3 c)
+{
+    float tile_y = floor((c.z + 0.5) / tiles_per_row);
+    float tile_x = c.z - tile_y * tiles_per_row;
+    return (vec2(tile_x, tile_y) * grid_size.xy + c.xy + 0.5) / grid_tex_size;
+}
+
+float slice(vec2 u0, vec2 f, float w, vec4 channel, float offset, float value)
+{
+    float z0 = min(floor(w), grid_size.z - 2.0);
+    float fz = w - z0;
+    vec2 sums = vec2(0.0);
+    for (int dz = 0; dz <= 1; dz++)
+    {
+	for (int dy = 0; dy <= 1; dy++)
+	{
+	    for (int dx = 0; dx <= 1; dx++)
+	    {
+		float weight = (dx == 0 ? 1.0 - f.x : f.x) * (dy == 0 ? 1.0 - f.y : f.y) * (dz == 0 ? 1.0 - fz : fz);
+		vec2 coord = cell_coord(vec3(u0 + vec2(float(dx), float(dy)), z0 + float(dz)));
+		sums += weight * vec2(dot(texture2D(textures[1], coord), channel),
+			dot(texture2D(textures[2], coord), channel));
+	    }
+	}
+    }
+    return sums.y > 0.0 ? offset + sums.x / sums.y : value;
+}
+
+void main()
+{
+    vec4 v = texture2D(textures[0], gl_TexCoord[0].xy);
+    vec2 u = gl_TexCoord[0].xy * dst_size / sampling_spatial;
+    vec2 u0 = min(floor(u), grid_size.xy - 2.0);
+    vec2 f = u - u0;
+    vec4 w = max(vec4(0.0), (v - range_min) / sampling_range);
+    vec4 result = v;
+    result.r = slice(u0, f, w.r, vec4(1.0, 0.0, 0.0, 0.0), range_min.r, v.r);
+    if (channels > 1)
+	result.g = slice(u0, f, w.g, vec4(0.0, 1.0, 0.0, 0.0), range_min.g, v.g);
+    if (channels > 2)
+	result.b = slice(u0, f, w.b, vec4(0.0, 0.0, 1.0, 0.0), range_min.b, v.b);
+    if (channels > 3)
+	result.a = slice(u0, f, w.a, vec4(0.0, 0.0, 0.0, 1.0), range_min.a, v.a);
+    gl_FragColor = result;
+}
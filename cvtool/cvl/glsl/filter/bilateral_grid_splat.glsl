@@ -0,0 +1,77 @@
+/*
+ * bilateral_grid_splat.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Builds the bilateral grid: a 3D grid with the spatial coordinates and the
+ * value as dimensions, which stores the sum of the values and the sum of the
+ * weights of all pixels that fall into each cell. The values are stored
+ * relative to the minimum value, so that constant frames stay exact. Each
+ * channel has its own grid; they share the texture channels.
+ * The depth slices of the grid are stored as tiles of a 2D texture, with
+ * tiles_per_row tiles in each row. Each cell gathers the pixels in its
+ * spatial region; their values are distributed to the two nearest slices with
+ * linear weights.
+ */
+
+#version 110
+
+const int n = $n;		// maximum number of pixels per cell in each direction
+uniform sampler2D textures[1];
+uniform vec2 dst_size;
+uniform vec2 tex_size;
+uniform vec3 grid_size;
+uniform float tiles_per_row;
+uniform float sampling_spatial;
+uniform float sampling_range;
+uniform vec4 range_min;
+
+void main()
+{
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size);
+    vec2 tile = floor((p + 0.5) / grid_size.xy);
+    vec2 cell = p - tile * grid_size.xy;
+    float z = tile.y * tiles_per_row + tile.x;
+
+    vec4 sum = vec4(0.0);
+    vec4 weight = vec4(0.0);
+    if (z < grid_size.z)
+    {
+	vec2 first = ceil((cell - 0.5) * sampling_spatial - 0.5);
+	vec2 end = (cell + 0.5) * sampling_spatial;
+	for (int r = 0; r < n; r++)
+	{
+	    for (int c = 0; c < n; c++)
+	    {
+		vec2 q = first + vec2(float(c), float(r)) + 0.5;
+		if (q.x < end.x && q.y < end.y && q.x > 0.0 && q.y > 0.0 && q.x < tex_size.x && q.y < tex_size.y)
+		{
+		    vec4 v = texture2D(textures[0], q / tex_size) - range_min;
+		    vec4 w = max(vec4(0.0), 1.0 - abs(v / sampling_range - z));
+		    sum += w * v;
+		    weight += w;
+		}
+	    }
+	}
+    }
+    gl_FragData[0] = sum;
+    gl_FragData[1] = weight;
+}
@@ -21,6 +21,10 @@
 
 #version 110
 
+#if $array
+#extension GL_EXT_texture_array : require
+#endif
+
 const int k_h = $k_h;
 const int k_v = $k_v;
 const int k_t = $k_t;
@@ -31,7 +35,13 @@ uniform float kernel[h_len * v_len * t_len];
 uniform float factor;
 uniform float step_h;
 uniform float step_v;
+#if $array
+uniform sampler2DArray textures;
+#define TEXTURE(t, coord) texture2DArray(textures, vec3(coord, float(t)))
+#else
 uniform sampler2D textures[t_len];
+#define TEXTURE(t, coord) texture2D(textures[t], coord)
+#endif
 
 void main()
 {
@@ -40,10 +50,10 @@ void main()
     {
 	for (int r = -k_v; r <= +k_v; r++)
 	{
-	    for (int c = -k_h; c <= +k_v; c++)
+	    for (int c = -k_h; c <= +k_h; c++)
 	    {
 		color += kernel[(t + k_t) * (h_len * v_len) + (r + k_v) * h_len + (c + k_h)]
-		    * texture2D(textures[t + k_t], gl_TexCoord[0].xy 
+		    * TEXTURE(t + k_t, gl_TexCoord[0].xy 
 			    + vec2(float(c) * step_h, float(r) * step_v));
 	    }
 	}
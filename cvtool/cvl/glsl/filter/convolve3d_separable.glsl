@@ -21,20 +21,30 @@
 
 #version 110
 
+#if $array
+#extension GL_EXT_texture_array : require
+#endif
+
 /* The horizontal and vertical direction can be computed using
  * the 2D convolve_separable.glsl .*/
 
 const int k_t = $k_t;
 uniform float mask_t[2 * k_t + 1];
 uniform float factor_t;
+#if $array
+uniform sampler2DArray textures;
+#define TEXTURE(t, coord) texture2DArray(textures, vec3(coord, float(t)))
+#else
 uniform sampler2D textures[2 * k_t + 1];
+#define TEXTURE(t, coord) texture2D(textures[t], coord)
+#endif
 
 void main()
 {
     vec4 color = vec4(0.0, 0.0, 0.0, 0.0);
     for (int t = -k_t; t <= +k_t; t++)
     {
-	color += mask_t[t + k_t] * texture2D(textures[t + k_t], gl_TexCoord[0].xy);
+	color += mask_t[t + k_t] * TEXTURE(t + k_t, gl_TexCoord[0].xy);
     }
     gl_FragColor = factor_t * color;
 }
@@ -0,0 +1,39 @@
+/*
+ * convolve_fft_multiply.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Multiplies the spectrum of a frame with the spectrum of a kernel, which has
+ * only one channel.
+ */
+
+#version 110
+
+uniform sampler2D textures[4];	// frame: real and imaginary part; kernel: real and imaginary part
+
+void main()
+{
+    vec4 a_re = texture2D(textures[0], gl_TexCoord[0].xy);
+    vec4 a_im = texture2D(textures[1], gl_TexCoord[0].xy);
+    float b_re = texture2D(textures[2], gl_TexCoord[0].xy).r;
+    float b_im = texture2D(textures[3], gl_TexCoord[0].xy).r;
+    gl_FragData[0] = a_re * b_re - a_im * b_im;
+    gl_FragData[1] = a_re * b_im + a_im * b_re;
+}
@@ -0,0 +1,40 @@
+/*
+ * convolve_fft_shift.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Copies the source, shifted by the given number of pixels, and multiplies it
+ * with a factor. Pixels outside of the source are clamped. This pads the source
+ * for the FFT convolution and extracts the result from the padded frame.
+ */
+
+#version 110
+
+uniform sampler2D tex;
+uniform vec2 dst_size;
+uniform vec2 tex_size;
+uniform vec2 shift;
+uniform float factor;
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * dst_size;
+    gl_FragColor = factor * texture2D(tex, (p - shift) / tex_size);
+}
@@ -0,0 +1,50 @@
+/*
+ * convolve_lowrank_h.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Horizontal pass of a convolution with a kernel of low rank, which is the sum
+ * of rank separable kernels. The horizontal vectors are applied at once, and
+ * the result of each one is written to its own render target.
+ */
+
+#version 110
+
+const int k = $k;
+const int rank = $rank;
+uniform sampler2D textures[1];
+uniform vec2 step;
+uniform float mask[rank * (2 * k + 1)];
+
+void main()
+{
+    vec4 sum[rank];
+    for (int j = 0; j < rank; j++)
+	sum[j] = vec4(0.0);
+    for (int i = -k; i <= +k; i++)
+    {
+	vec4 t = texture2D(textures[0], gl_TexCoord[0].xy + float(i) * step);
+	for (int j = 0; j < rank; j++)
+	    sum[j] += mask[j * (2 * k + 1) + i + k] * t;
+    }
+    for (int j = 0; j < rank; j++)
+	gl_FragData[j] = sum[j];
+}
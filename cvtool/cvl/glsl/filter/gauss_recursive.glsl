@@ -0,0 +1,130 @@
+/*
+ * gauss_recursive.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * One step of the recursive Gauss filter of Young and van Vliet along rows
+ * (horizontal) or columns. The step computes a block of positions for all
+ * rows at once: each position runs the recursion from the start of the block.
+ * The step also copies the previous block from the result of the previous
+ * step, so that two alternating frames hold all results computed so far.
+ */
+
+#version 110
+
+const bool causal = $causal;
+const bool horizontal = $horizontal;
+const int block = $block;
+uniform sampler2D src;		// input of the causal filter
+uniform sampler2D prev;		// result of the previous step
+uniform sampler2D causal_result;	// input of the anti-causal filter
+uniform vec2 size;
+uniform float len;
+uniform float n;		// first position of the block in filter direction
+uniform float b;
+uniform vec2 c;
+uniform vec3 boundary[3];	// anti-causal initial values from the last three causal results
+
+vec4 get(sampler2D tex, float i)
+{
+    vec2 p = (horizontal ? vec2(i + 0.5, gl_FragCoord.y) : vec2(gl_FragCoord.x, i + 0.5));
+    return texture2D(tex, p / size);
+}
+
+vec4 initial(int j, vec4 w1, vec4 w2, vec4 w3, vec4 u)
+{
+    return u + boundary[j].x * (w1 - u) + boundary[j].y * (w2 - u) + boundary[j].z * (w3 - u);
+}
+
+// y[n] = b x + a0 y1 + a1 y2 + a2 y3, in a form that is less sensitive to
+// rounding errors
+vec4 filter(vec4 x, vec4 y1, vec4 y2, vec4 y3)
+{
+    vec4 d1 = y1 - y2;
+    vec4 d2 = d1 - (y2 - y3);
+    return y1 + b * (x - y1) + c.x * d1 + c.y * d2;
+}
+
+void main()
+{
+    float i = floor(horizontal ? gl_FragCoord.x : gl_FragCoord.y);
+    vec4 y1, y2, y3;
+    if (causal)
+    {
+	if (i < n)
+	{
+	    gl_FragColor = get(prev, i);
+	    return;
+	}
+	// The input is continued with its first value beyond the border
+	vec4 x0 = get(src, 0.0);
+	y1 = (n >= 1.0 ? get(prev, n - 1.0) : x0);
+	y2 = (n >= 2.0 ? get(prev, n - 2.0) : x0);
+	y3 = (n >= 3.0 ? get(prev, n - 3.0) : x0);
+	for (int j = 0; j < block; j++)
+	{
+	    float p = n + float(j);
+	    if (p > i)
+		break;
+	    vec4 y = filter(get(src, p), y1, y2, y3);
+	    y3 = y2;
+	    y2 = y1;
+	    y1 = y;
+	}
+    }
+    else
+    {
+	if (i > n)
+	{
+	    gl_FragColor = get(prev, i);
+	    return;
+	}
+	if (n >= len - 3.0)
+	{
+	    vec4 w1 = get(causal_result, len - 1.0);
+	    vec4 w2 = get(causal_result, len - 2.0);
+	    vec4 w3 = get(causal_result, len - 3.0);
+	    vec4 u = get(src, len - 1.0);
+	    vec4 i0 = initial(0, w1, w2, w3, u);
+	    vec4 i1 = initial(1, w1, w2, w3, u);
+	    vec4 i2 = initial(2, w1, w2, w3, u);
+	    y1 = (n + 1.0 < len ? get(prev, n + 1.0) : i0);
+	    y2 = (n + 2.0 < len ? get(prev, n + 2.0) : n + 2.0 == len ? i0 : i1);
+	    y3 = (n + 3.0 < len ? get(prev, n + 3.0) : n + 3.0 == len ? i0 : n + 2.0 == len ? i1 : i2);
+	}
+	else
+	{
+	    y1 = get(prev, n + 1.0);
+	    y2 = get(prev, n + 2.0);
+	    y3 = get(prev, n + 3.0);
+	}
+	for (int j = 0; j < block; j++)
+	{
+	    float p = n - float(j);
+	    if (p < i)
+		break;
+	    vec4 y = filter(get(causal_result, p), y1, y2, y3);
+	    y3 = y2;
+	    y2 = y1;
+	    y1 = y;
+	}
+    }
+    gl_FragColor = y1;
+}
@@ -0,0 +1,37 @@
+/*
+ * integral_init.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#version 110
+
+uniform sampler2D tex;
+uniform vec2 src_size;
+uniform vec2 dst_size;
+uniform vec2 shift;
+uniform float zero_border;
+uniform float offset;
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * dst_size;
+    vec4 v = texture2D(tex, (p - shift) / src_size) - offset;
+    float inside = 1.0 - zero_border * (1.0 - step(1.0, p.x) * step(1.0, p.y));
+    gl_FragColor = inside * v;
+}
@@ -21,6 +21,10 @@
 
 #version 110
 
+#if $array
+#extension GL_EXT_texture_array : require
+#endif
+
 const int k_h = $k_h;
 const int k_v = $k_v;
 const int k_t = $k_t;
@@ -30,7 +34,13 @@ const int len_t = 2 * k_t + 1;
 const int mask_size = len_h * len_v * len_t;
 uniform float step_h;
 uniform float step_v;
+#if $array
+uniform sampler2DArray textures;
+#define TEXTURE(t, coord) texture2DArray(textures, vec3(coord, float(t)))
+#else
 uniform sampler2D textures[len_t];
+#define TEXTURE(t, coord) texture2D(textures[t], coord)
+#endif
 vec4 mask[mask_size];
 
 void swap_r(int j)
@@ -85,10 +95,10 @@ void main()
     {
 	for (int r = -k_v; r <= +k_v; r++)
 	{
-	    for (int c = -k_h; c <= +k_v; c++)
+	    for (int c = -k_h; c <= +k_h; c++)
 	    {
 		mask[(t + k_t) * (len_h * len_v) + (r + k_v) * len_h + (c + k_h)]
-		    = texture2D(textures[t + k_t], gl_TexCoord[0].xy 
+		    = TEXTURE(t + k_t, gl_TexCoord[0].xy 
 			    + vec2(float(c) * step_h, float(r) * step_v));
 	    }
 	}
@@ -21,13 +21,23 @@
 
 #version 110
 
+#if $array
+#extension GL_EXT_texture_array : require
+#endif
+
 /* The horizontal and vertical direction can be computed using
  * the 2D median_separated.glsl .*/
 
 const int k_t = $k_t;
 const int mask_size = 2 * k_t + 1;
 vec4 mask[mask_size];
+#if $array
+uniform sampler2DArray textures;
+#define TEXTURE(t, coord) texture2DArray(textures, vec3(coord, float(t)))
+#else
 uniform sampler2D textures[mask_size];
+#define TEXTURE(t, coord) texture2D(textures[t], coord)
+#endif
 
 void swap_r(int j)
 {
@@ -79,7 +89,7 @@ void main()
 {
     for (int t = -k_t; t <= +k_t; t++)
     {
-	mask[t + k_t] = texture2D(textures[t + k_t], gl_TexCoord[0].xy);
+	mask[t + k_t] = TEXTURE(t + k_t, gl_TexCoord[0].xy);
     }
     bubblesort();
     gl_FragColor = mask[mask_size / 2];
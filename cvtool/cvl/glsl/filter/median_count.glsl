@@ -0,0 +1,119 @@
+/*
+ * median_count.glsl
+ *
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Exact median for large windows. Instead of sorting the window, the median
+ * is selected by counting: bisection of the value range narrows down an
+ * interval (lo, hi] that contains the median, and the distinct values in this
+ * interval are then visited in ascending order until the median rank is
+ * reached. Each step reads the window once, so the cost is proportional to
+ * the window size times the number of steps. The number of visited values is
+ * usually small, but in the worst case it is the window size.
+ */
+
+#version 110
+
+const int k_h = $k_h;
+const int k_v = $k_v;
+const int iterations = $iterations;
+const int mask_size = (2 * k_h + 1) * (2 * k_v + 1);
+const float rank = float(mask_size / 2 + 1);
+uniform float step_h;
+uniform float step_v;
+uniform sampler2D tex;
+
+vec4 texel(int c, int r)
+{
+    return texture2D(tex, gl_TexCoord[0].xy + vec2(float(c) * step_h, float(r) * step_v));
+}
+
+/* Number of window values <= t */
+vec4 count(vec4 t)
+{
+    vec4 n = vec4(0.0);
+    for (int r = -k_v; r <= +k_v; r++)
+    {
+	for (int c = -k_h; c <= +k_h; c++)
+	{
+	    n += step(texel(c, r), t);
+	}
+    }
+    return n;
+}
+
+void main()
+{
+    vec4 lo = texel(-k_h, -k_v);
+    vec4 hi = lo;
+    for (int r = -k_v; r <= +k_v; r++)
+    {
+	for (int c = -k_h; c <= +k_h; c++)
+	{
+	    vec4 v = texel(c, r);
+	    lo = min(lo, v);
+	    hi = max(hi, v);
+	}
+    }
+
+    /* The median is the minimum if enough values are equal to it. Otherwise
+     * it is in (lo, hi], and n_lo < rank is the number of values <= lo. */
+    vec4 n_lo = count(lo);
+    vec4 done = step(rank, n_lo);
+    vec4 median = lo;
+
+    for (int i = 0; i < iterations; i++)
+    {
+	vec4 mid = 0.5 * (lo + hi);
+	vec4 n = count(mid);
+	vec4 below = step(rank, n);
+	hi = mix(hi, mid, below);
+	lo = mix(mid, lo, below);
+	n_lo = mix(n, n_lo, below);
+    }
+
+    for (int i = 0; i < mask_size; i++)
+    {
+	if (done.r * done.g * done.b * done.a > 0.5)
+	    break;
+	/* Find the smallest value v > lo, and the number of values equal to it. */
+	vec4 v = hi;
+	vec4 n = vec4(0.0);
+	for (int r = -k_v; r <= +k_v; r++)
+	{
+	    for (int c = -k_h; c <= +k_h; c++)
+	    {
+		vec4 s = texel(c, r);
+		vec4 above = 1.0 - step(s, lo);
+		vec4 less = above * (1.0 - step(v, s));
+		vec4 equal = above * step(v, s) * step(s, v);
+		n = mix(n + equal, vec4(1.0), less);
+		v = mix(v, s, less);
+	    }
+	}
+	vec4 found = (1.0 - done) * step(rank, n_lo + n);
+	median = mix(median, v, found);
+	done = max(done, found);
+	n_lo += n;
+	lo = v;
+    }
+
+    gl_FragColor = median;
+}
@@ -21,18 +21,28 @@
 
 #version 110
 
+#if $array
+#extension GL_EXT_texture_array : require
+#endif
+
 /* The horizontal and vertical direction can be computed using
  * the 2D min.glsl .*/
 
 const int k_t = $k_t;
+#if $array
+uniform sampler2DArray textures;
+#define TEXTURE(t, coord) texture2DArray(textures, vec3(coord, float(t)))
+#else
 uniform sampler2D textures[2 * k_t + 1];
+#define TEXTURE(t, coord) texture2D(textures[t], coord)
+#endif
 
 void main()
 {
-    vec4 color = texture2D(textures[0], gl_TexCoord[0].xy);
+    vec4 color = TEXTURE(0, gl_TexCoord[0].xy);
     for (int t = -k_t + 1; t <= +k_t; t++)
     {
-	color = min(color, texture2D(textures[t + k_t], gl_TexCoord[0].xy));
+	color = min(color, TEXTURE(t + k_t, gl_TexCoord[0].xy));
     }
     gl_FragColor = color;
 }
@@ -0,0 +1,45 @@
+/*
+ * minmax_block.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Minimum or maximum filter of van Herk / Gil-Werman in one direction. The
+ * textures hold the block prefix and suffix results of the source, which is
+ * padded with k clamped pixels on both sides. The window [x-k,x+k] of the
+ * source is [x,x+2k] in the padded frame and contains exactly one block
+ * boundary, so its result is combined from one suffix and one prefix.
+ */
+
+#version 110
+
+const bool maximum = $maximum;
+uniform sampler2D textures[2];	// prefix and suffix results
+uniform vec2 dst_size;
+uniform vec2 tex_size;
+uniform vec2 dir;		// filter direction: (1,0) or (0,1)
+uniform float k;
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * dst_size;
+    vec4 suffix = texture2D(textures[1], p / tex_size);
+    vec4 prefix = texture2D(textures[0], (p + 2.0 * k * dir) / tex_size);
+    gl_FragColor = maximum ? max(prefix, suffix) : min(prefix, suffix);
+}
@@ -0,0 +1,66 @@
+/*
+ * minmax_block_scan.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * One step of the block scans of the van Herk / Gil-Werman minimum and maximum
+ * filter. The frame is divided into blocks of the window size along the filter
+ * direction. For each position, the prefix result is the minimum (or maximum)
+ * from the start of its block to the position, and the suffix result is the
+ * minimum (or maximum) from the position to the end of its block.
+ * Both are computed at once with log4(block) steps: each step combines the
+ * results at the distances 0, d, 2d, 3d of the previous step, and d grows by
+ * a factor of 4 from step to step.
+ */
+
+#version 110
+
+const bool maximum = $maximum;
+uniform sampler2D textures[2];	// prefix and suffix results of the previous step
+uniform vec2 dst_size;
+uniform vec2 tex_size;
+uniform vec2 dir;		// filter direction: (1,0) or (0,1)
+uniform float shift;		// offset of the source in filter direction
+uniform float block;
+uniform float d;
+
+vec4 op(vec4 a, vec4 b)
+{
+    return maximum ? max(a, b) : min(a, b);
+}
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * dst_size - shift * dir;
+    float i = floor(dot(gl_TexCoord[0].xy * dst_size, dir));
+    float pos = i - block * floor((i + 0.5) / block);
+    vec4 prefix = texture2D(textures[0], p / tex_size);
+    vec4 suffix = texture2D(textures[1], p / tex_size);
+    for (int j = 1; j < 4; j++)
+    {
+	float dj = float(j) * d;
+	if (pos >= dj)
+	    prefix = op(prefix, texture2D(textures[0], (p - dj * dir) / tex_size));
+	if (pos + dj < block)
+	    suffix = op(suffix, texture2D(textures[1], (p + dj * dir) / tex_size));
+    }
+    gl_FragData[0] = prefix;
+    gl_FragData[1] = suffix;
+}
@@ -0,0 +1,54 @@
+/*
+ * temporal.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#version 110
+
+/* Combines n frames of a temporal window: weighted sum (mode 0), minimum
+ * (mode 1), or maximum (mode 2). Long windows are processed in several passes
+ * by feeding the previous result back in as one of the textures. */
+
+const int n = $n;
+uniform float weights[n];
+uniform sampler2D textures[n];
+
+void main()
+{
+#if $mode == 0
+    vec4 color = vec4(0.0, 0.0, 0.0, 0.0);
+    for (int i = 0; i < n; i++)
+    {
+	color += weights[i] * texture2D(textures[i], gl_TexCoord[0].xy);
+    }
+#elif $mode == 1
+    vec4 color = texture2D(textures[0], gl_TexCoord[0].xy);
+    for (int i = 1; i < n; i++)
+    {
+	color = min(color, texture2D(textures[i], gl_TexCoord[0].xy));
+    }
+#else
+    vec4 color = texture2D(textures[0], gl_TexCoord[0].xy);
+    for (int i = 1; i < n; i++)
+    {
+	color = max(color, texture2D(textures[i], gl_TexCoord[0].xy));
+    }
+#endif
+    gl_FragColor = color;
+}
@@ -0,0 +1,74 @@
+/*
+ * lum_statistics.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * One step of a reduction that computes the luminance statistics needed by the
+ * tone mapping operators: the first destination gets the minimum, maximum,
+ * sum, and log sum of the luminance, and the second destination gets the sums
+ * of the RGB channel values. Each destination pixel reduces a block of 2x2
+ * source pixels; blocks at the right and bottom border may be incomplete.
+ * In the first step, the source is a CVL_XYZ frame. In the following steps,
+ * the sources are the two results of the previous step.
+ */
+
+#version 110
+
+const bool first = $first;
+uniform sampler2D textures[2];
+uniform vec2 src_size;
+uniform vec2 dst_size;
+uniform float max_abs_lum;
+
+$xyz_to_rgb_func
+
+void main()
+{
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size) * 2.0;
+    vec4 lum = vec4(3.4e38, -3.4e38, 0.0, 0.0);
+    vec3 rgb = vec3(0.0);
+    for (int j = 0; j < 2; j++)
+    {
+	for (int i = 0; i < 2; i++)
+	{
+	    vec2 q = p + vec2(float(i), float(j));
+	    if (q.x < src_size.x && q.y < src_size.y)
+	    {
+		vec2 tc = (q + 0.5) / src_size;
+		if (first)
+		{
+		    vec3 xyz = texture2D(textures[0], tc).rgb;
+		    lum = vec4(min(lum.r, xyz.g), max(lum.g, xyz.g),
+			    lum.b + xyz.g, lum.a + log(2.3e-5 + max_abs_lum * xyz.g));
+		    rgb += xyz_to_rgb(xyz);
+		}
+		else
+		{
+		    vec4 l = texture2D(textures[0], tc);
+		    lum = vec4(min(lum.r, l.r), max(lum.g, l.g), lum.b + l.b, lum.a + l.a);
+		    rgb += texture2D(textures[1], tc).rgb;
+		}
+	    }
+	}
+    }
+    gl_FragData[0] = lum;
+    gl_FragData[1] = vec4(rgb, 0.0);
+}
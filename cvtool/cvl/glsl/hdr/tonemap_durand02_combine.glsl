@@ -0,0 +1,43 @@
+/*
+ * tonemap_durand02_combine.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Computes the same result as tonemap_durand02_step1.glsl, but with a log base
+ * layer that was computed by cvl_bilateral().
+ */
+
+#version 110
+
+uniform float max_abs_lum;
+uniform sampler2D textures[2];	// source frame and log base layer
+
+void main()
+{
+    // Assume XYZ color space.
+    vec3 color = texture2D(textures[0], gl_TexCoord[0].xy).rgb;
+    float log_input_intensity = log(max_abs_lum * color.g + 1.0);
+    float log_base = texture2D(textures[1], gl_TexCoord[0].xy).r;
+
+    float x = color.r / (color.r + color.g + color.b);
+    float y = color.g / (color.r + color.g + color.b);
+    gl_FragColor = vec4(log_input_intensity, log_base, x, y);
+}
@@ -0,0 +1,38 @@
+/*
+ * tonemap_durand02_log.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Computes the log intensity that the bilateral filter of durand02 works on,
+ * for use with cvl_bilateral().
+ */
+
+#version 110
+
+uniform float max_abs_lum;
+uniform sampler2D tex;
+
+void main()
+{
+    // Assume XYZ color space.
+    float Y = texture2D(tex, gl_TexCoord[0].xy).g;
+    gl_FragColor = vec4(log(max_abs_lum * Y + 1.0), 0.0, 0.0, 0.0);
+}
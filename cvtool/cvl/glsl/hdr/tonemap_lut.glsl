@@ -0,0 +1,54 @@
+/*
+ * tonemap_lut.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Applies a global tone mapping curve that was baked into a lookup table by
+ * one of the cvl_tonemap_lut_*() functions. The table samples the curve at
+ * luminance values that are evenly spaced in the log2 domain between
+ * log2_min and log2_max. It is interpolated linearly between the two nearest
+ * entries; values outside the range use the first or last entry.
+ */
+
+#version 110
+
+uniform sampler2D textures[2];
+uniform float lut_size;
+uniform float scale;
+uniform float offset;
+
+void main()
+{
+    vec3 XYZ = texture2D(textures[0], gl_TexCoord[0].xy).rgb;
+    float x = XYZ.r / (XYZ.r + XYZ.g + XYZ.b);
+    float y = XYZ.g / (XYZ.r + XYZ.g + XYZ.b);
+
+    // Position in the table; scale and offset map [log2_min,log2_max] to [0,lut_size-1].
+    float t = clamp(log2(max(XYZ.g, 1e-37)) * scale + offset, 0.0, lut_size - 1.0);
+    float i = min(floor(t), lut_size - 2.0);
+    float a = texture2D(textures[1], vec2((i + 0.5) / lut_size, 0.5)).r;
+    float b = texture2D(textures[1], vec2((i + 1.5) / lut_size, 0.5)).r;
+    float new_Y = mix(a, b, t - i);
+
+    float new_X = (new_Y / y) * x;
+    float new_Z = (new_Y / y) * (1.0 - x - y);
+    gl_FragColor = vec4(new_X, new_Y, new_Z, 0.0);
+}
@@ -0,0 +1,106 @@
+/*
+ * tonemap_reinhard02.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2008  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The scales are gaussian smoothed versions of the luminance, see
+ * cvl_tonemap_scales() in cvl_hdr.c. Scale i is stored in one channel of
+ * textures[i + 1], at a pyramid level that is level_factor[i] times smaller
+ * than the source, and is upsampled with bilinear interpolation unless it is
+ * on the source level.
+ */
+
+#version 110
+
+const int n = $n;
+uniform vec2 size;
+uniform vec2 level_size[n];
+uniform float level_factor[n];
+uniform vec4 level_channel[n];
+uniform float s[n];
+uniform float log_avg_lum;
+uniform float brightness;
+uniform float white;
+uniform float sharpness;
+uniform float threshold;
+uniform sampler2D textures[n + 1];
+
+void main()
+{
+    vec2 p = gl_TexCoord[0].xy * size;
+    float g[n];
+    for (int i = 0; i < n; i++)
+    {
+	vec4 v;
+	if (level_factor[i] < 1.5)
+	{
+	    v = texture2D(textures[i + 1], gl_TexCoord[0].xy);
+	}
+	else
+	{
+	    vec2 u = p / level_factor[i] - 0.5;
+	    vec2 u0 = floor(u);
+	    vec2 f = u - u0;
+	    vec2 tc0 = (u0 + 0.5) / level_size[i];
+	    vec2 tc1 = (u0 + 1.5) / level_size[i];
+	    v = mix(
+		    mix(texture2D(textures[i + 1], tc0), texture2D(textures[i + 1], vec2(tc1.x, tc0.y)), f.x),
+		    mix(texture2D(textures[i + 1], vec2(tc0.x, tc1.y)), texture2D(textures[i + 1], tc1), f.x),
+		    f.y);
+	}
+	g[i] = dot(v, level_channel[i]);
+    }
+
+    /* Tone Mapping */
+    vec3 XYZ = texture2D(textures[0], gl_TexCoord[0].xy).rgb;
+    float x = XYZ.r / (XYZ.r + XYZ.g + XYZ.b);
+    float y = XYZ.g / (XYZ.r + XYZ.g + XYZ.b);
+    float old_Y = XYZ.g;
+
+    /* Linear prescaling */
+    float scale_factor = brightness / log_avg_lum;
+    float Lm = scale_factor * old_Y;
+    for (int i = 0; i < n; i++)
+    {
+	g[i] *= scale_factor;
+    }
+
+    /* Dodging and Burning: use the largest scale whose difference to the
+     * next smaller scale is below the threshold. */
+    float Lsmax = old_Y;
+    float prev_g = old_Y;
+    float prev_s = 0.2;
+    for (int i = 0; i < n; i++)
+    {
+	float v = (prev_g - g[i]) / (pow(2.0, sharpness) * brightness / (prev_s * prev_s) + prev_g);
+	if (v < threshold)
+	    Lsmax = g[i];
+	prev_g = g[i];
+	prev_s = s[i];
+    }
+    // global variant: Lsmax = old_Y;
+    float Ld = Lm * (1.0 + Lm / (white * white)) / (1.0 + Lsmax);
+    float new_Y = clamp(Ld, 0.00001, 1.0);
+
+    /* Recompute color */
+    float new_X = (new_Y / y) * x;
+    float new_Z = (new_Y / y) * (1.0 - x - y);
+    gl_FragColor = vec4(new_X, new_Y, new_Z, 0.0);
+}
@@ -0,0 +1,53 @@
+/*
+ * tonemap_scales_blur.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * One pass of a separable gaussian filter that smoothes the luminance with up
+ * to four different masks at once, one per destination channel.
+ * Mode 0 filters horizontally and reads the Y channel of a CVL_XYZ frame.
+ * Mode 1 filters horizontally and reads the first channel of a pyramid level.
+ * Mode 2 filters vertically and reads the result of mode 0 or 1.
+ */
+
+#version 110
+
+const int mode = $mode;
+const int k = $k;
+uniform vec4 mask[2 * k + 1];
+uniform vec2 step;
+uniform sampler2D tex;
+
+void main()
+{
+    vec4 sum = vec4(0.0);
+    for (int i = -k; i <= +k; i++)
+    {
+	vec4 v = texture2D(tex, gl_TexCoord[0].xy + float(i) * step);
+	if (mode == 0)
+	    sum += mask[i + k] * v.g;
+	else if (mode == 1)
+	    sum += mask[i + k] * v.r;
+	else
+	    sum += mask[i + k] * v;
+    }
+    gl_FragColor = sum;
+}
@@ -0,0 +1,54 @@
+/*
+ * tonemap_scales_downsample.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Computes the next level of a luminance pyramid. Each destination pixel is
+ * centered on a block of 2x2 source pixels, and is the weighted average of the
+ * surrounding 4x4 source pixels with the binomial weights 1 3 3 1 in both
+ * directions. Pixels outside of the source are replaced by the nearest border
+ * pixel. In the first step, the source is a CVL_XYZ frame, and its Y channel
+ * is used. In the following steps, the source is the previous level.
+ */
+
+#version 110
+
+const bool first = $first;
+uniform sampler2D tex;
+uniform vec2 src_size;
+uniform vec2 dst_size;
+
+void main()
+{
+    const vec4 weights = vec4(1.0, 3.0, 3.0, 1.0);
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size) * 2.0 - 1.0;
+    float sum = 0.0;
+    for (int j = 0; j < 4; j++)
+    {
+	for (int i = 0; i < 4; i++)
+	{
+	    vec2 q = clamp(p + vec2(float(i), float(j)), vec2(0.0), src_size - 1.0);
+	    vec4 v = texture2D(tex, (q + 0.5) / src_size);
+	    sum += weights[i] * weights[j] * (first ? v.g : v.r);
+	}
+    }
+    gl_FragColor = vec4(sum / 64.0, 0.0, 0.0, 0.0);
+}
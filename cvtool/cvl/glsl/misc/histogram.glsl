@@ -0,0 +1,63 @@
+/*
+ * histogram.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Vertex shader that scatters frame values into histogram bins. Each vertex
+ * (column, channel) reads one value of the current row, and is moved to the
+ * pixel of its bin in a bins x 1 target, where additive blending counts it in
+ * the color component of its channel. Values outside of [lo, hi] are moved
+ * outside of the viewport, so that they are clipped, and so are non-finite
+ * values.
+ */
+
+#version 110
+
+const float bins = $bins.0;
+const float big = 3.4e38;
+uniform sampler2D tex;
+uniform vec2 size;
+uniform float row;
+uniform vec4 lo;
+uniform vec4 hi;
+uniform vec4 scale;
+
+void main()
+{
+    vec4 v = texture2DLod(tex, vec2(gl_Vertex.x + 0.5, row + 0.5) / size, 0.0);
+    vec4 mask = vec4(equal(vec4(gl_Vertex.y), vec4(0.0, 1.0, 2.0, 3.0)));
+    // Do not use dot(v, mask) etc.: non-finite values in other channels would
+    // spoil the result.
+    float value = (mask.r > 0.0 ? v.r : mask.g > 0.0 ? v.g : mask.b > 0.0 ? v.b : v.a);
+    float l = (mask.r > 0.0 ? lo.r : mask.g > 0.0 ? lo.g : mask.b > 0.0 ? lo.b : lo.a);
+    float h = (mask.r > 0.0 ? hi.r : mask.g > 0.0 ? hi.g : mask.b > 0.0 ? hi.b : hi.a);
+    float s = (mask.r > 0.0 ? scale.r : mask.g > 0.0 ? scale.g : mask.b > 0.0 ? scale.b : scale.a);
+    if (abs(value) < big && value >= l && value <= h)
+    {
+	float bin = clamp(floor((value - l) * s), 0.0, bins - 1.0);
+	gl_Position = vec4((bin + 0.5) / bins * 2.0 - 1.0, 0.0, 0.0, 1.0);
+    }
+    else
+    {
+	gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+    }
+    gl_FrontColor = mask;
+}
@@ -28,9 +28,9 @@ uniform float height;
 void main()
 {
     const int k = 1;
-    float kernel[9] = { 1.0, 2.0, 1.0,
-			2.0, 4.0, 2.0,
-			1.0, 2.0, 1.0 };
+    float kernel[9] = float[9](1.0, 2.0, 1.0,
+			       2.0, 4.0, 2.0,
+			       1.0, 2.0, 1.0);
     const float kernel_sum = 16.0;
 
     vec4 color = vec4(0.0, 0.0, 0.0, 0.0);
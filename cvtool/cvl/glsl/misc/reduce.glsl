@@ -32,9 +32,8 @@
 #define CHANNEL $channel
 
 uniform sampler2D tex;
-uniform float step_h;
-uniform float step_v;
-uniform int reduce_case;
+uniform vec2 src_size;
+uniform vec2 dst_size;
 
 
 vec4 reduce_2(vec4 c1, vec4 c2)
@@ -63,15 +62,15 @@ vec4 reduce_2(vec4 c1, vec4 c2)
     r.a = (c1.a <= 0.0 ? c2.a : (c2.a <= 0.0) ? c1.a : (c1.a < c2.a) ? c1.a : c2.a);
     return r;
 # else
-    return (c1.CHANNEL <= 0.0 ? c2.CHANNEL : (c2.CHANNEL <= 0.0) ? c1.CHANNEL : (c1.CHANNEL < c2.CHANNEL) ? c1.CHANNEL : c2.CHANNEL);
+    return (c1.CHANNEL <= 0.0 ? c2 : (c2.CHANNEL <= 0.0) ? c1 : (c1.CHANNEL < c2.CHANNEL) ? c1 : c2);
 # endif
 #elif MODE_ABSMIN_GREATER_ZERO
 # if ALL_CHANNELS
     vec4 r;
-    r.r (abs(c1.r) <= 0.0 ? abs(c2.r) : (abs(c2.r) <= 0.0) ? abs(c1.r) : (abs(c1.r) < abs(c2.r)) ? abs(c1.r) : abs(c2.r));
-    r.g (abs(c1.g) <= 0.0 ? abs(c2.g) : (abs(c2.g) <= 0.0) ? abs(c1.g) : (abs(c1.g) < abs(c2.g)) ? abs(c1.g) : abs(c2.g));
-    r.b (abs(c1.b) <= 0.0 ? abs(c2.b) : (abs(c2.b) <= 0.0) ? abs(c1.b) : (abs(c1.b) < abs(c2.b)) ? abs(c1.b) : abs(c2.b));
-    r.a (abs(c1.a) <= 0.0 ? abs(c2.a) : (abs(c2.a) <= 0.0) ? abs(c1.a) : (abs(c1.a) < abs(c2.a)) ? abs(c1.a) : abs(c2.a));
+    r.r = (abs(c1.r) <= 0.0 ? abs(c2.r) : (abs(c2.r) <= 0.0) ? abs(c1.r) : (abs(c1.r) < abs(c2.r)) ? abs(c1.r) : abs(c2.r));
+    r.g = (abs(c1.g) <= 0.0 ? abs(c2.g) : (abs(c2.g) <= 0.0) ? abs(c1.g) : (abs(c1.g) < abs(c2.g)) ? abs(c1.g) : abs(c2.g));
+    r.b = (abs(c1.b) <= 0.0 ? abs(c2.b) : (abs(c2.b) <= 0.0) ? abs(c1.b) : (abs(c1.b) < abs(c2.b)) ? abs(c1.b) : abs(c2.b));
+    r.a = (abs(c1.a) <= 0.0 ? abs(c2.a) : (abs(c2.a) <= 0.0) ? abs(c1.a) : (abs(c1.a) < abs(c2.a)) ? abs(c1.a) : abs(c2.a));
     return r;
 # else
     bool c1_wins = (abs(c1.CHANNEL) <= 0.0 ? false : (abs(c2.CHANNEL) <= 0.0) ? true 
@@ -108,40 +107,30 @@ vec4 reduce_4(vec4 c1, vec4 c2, vec4 c3, vec4 c4)
 
 void main()
 {
-    float x = gl_TexCoord[0].x;
-    float y = gl_TexCoord[0].y;
-    vec4 c;
-
-    if (reduce_case == 0)
+    // Reduce the 2x2 block of source pixels that belongs to this destination
+    // pixel. Parts of the block that lie outside of the source are ignored.
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size) * 2.0 + 0.5;
+    bool right = (p.x + 1.0 < src_size.x);
+    bool below = (p.y + 1.0 < src_size.y);
+    vec4 c = texture2D(tex, p / src_size);
+#if !MODE_SUM
+    // Apply the mode to a single pixel, too (e.g. abs() in the ABS* modes)
+    c = reduce_2(c, c);
+#endif
+    if (right && below)
     {
-	// Reduce both horizontally and vertically
-	float x0 = x - step_h / 2.0;
-	float y0 = y - step_v / 2.0;
-	float x1 = x0 + step_h;
-	float y1 = y0 + step_v;
-	c = reduce_4(
-		texture2D(tex, vec2(x0, y0)),
-		texture2D(tex, vec2(x0, y1)),
-		texture2D(tex, vec2(x1, y0)),
-		texture2D(tex, vec2(x1, y1)));
+	c = reduce_4(c,
+		texture2D(tex, (p + vec2(0.0, 1.0)) / src_size),
+		texture2D(tex, (p + vec2(1.0, 0.0)) / src_size),
+		texture2D(tex, (p + vec2(1.0, 1.0)) / src_size));
     }
-    else if (reduce_case == 1)
+    else if (right)
     {
-	// Reduce horizontally
-	float x0 = x - step_h / 2.0;
-	float x1 = x0 + step_h;
-	c = reduce_2(
-		texture2D(tex, vec2(x0, y)),
-		texture2D(tex, vec2(x1, y)));
+	c = reduce_2(c, texture2D(tex, (p + vec2(1.0, 0.0)) / src_size));
     }
-    else 
+    else if (below)
     {
-	// Reduce vertically
-	float y0 = y - step_v / 2.0;
-	float y1 = y0 + step_v;
-	c = reduce_2(
-		texture2D(tex, vec2(x, y0)),
-		texture2D(tex, vec2(x, y1)));
+	c = reduce_2(c, texture2D(tex, (p + vec2(0.0, 1.0)) / src_size));
     }
 
     gl_FragColor = c;
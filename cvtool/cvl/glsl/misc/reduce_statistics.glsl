@@ -0,0 +1,103 @@
+/*
+ * reduce_statistics.glsl
+ * 
+ * This file is part of CVL, a computer vision library.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * One step of a reduction that computes several statistics at once: the
+ * minimum, the smallest value greater than the minimum, the maximum, the sum,
+ * the sum of squares, and the number of finite values. Each destination pixel
+ * reduces a block of 2x2 source pixels; blocks at the right and bottom border
+ * may be incomplete, so that the source size need not be a power of two.
+ * In the first step, the source is the frame itself. In the following steps,
+ * the sources are the six results of the previous step.
+ * Non-finite values are ignored. The value big marks missing minimum and
+ * maximum values.
+ */
+
+#version 110
+
+const bool first = $first;
+const float big = 3.4e38;
+uniform sampler2D textures[6];
+uniform vec2 src_size;
+uniform vec2 dst_size;
+
+vec4 select(vec4 a, vec4 b, bvec4 c)
+{
+    return vec4(c.r ? b.r : a.r, c.g ? b.g : a.g, c.b ? b.b : a.b, c.a ? b.a : a.a);
+}
+
+void main()
+{
+    vec2 p = floor(gl_TexCoord[0].xy * dst_size) * 2.0;
+    vec4 min1 = vec4(big);
+    vec4 min2 = vec4(big);
+    vec4 max1 = vec4(-big);
+    vec4 sum = vec4(0.0);
+    vec4 sumsq = vec4(0.0);
+    vec4 count = vec4(0.0);
+    for (int j = 0; j < 2; j++)
+    {
+	for (int i = 0; i < 2; i++)
+	{
+	    vec2 q = p + vec2(float(i), float(j));
+	    if (q.x < src_size.x && q.y < src_size.y)
+	    {
+		vec2 tc = (q + 0.5) / src_size;
+		vec4 b1, b2;
+		if (first)
+		{
+		    vec4 v = texture2D(textures[0], tc);
+		    bvec4 finite = lessThan(abs(v), vec4(big));
+		    b1 = select(vec4(big), v, finite);
+		    b2 = vec4(big);
+		    max1 = max(max1, select(vec4(-big), v, finite));
+		    sum += select(vec4(0.0), v, finite);
+		    sumsq += select(vec4(0.0), v * v, finite);
+		    count += select(vec4(0.0), vec4(1.0), finite);
+		}
+		else
+		{
+		    b1 = texture2D(textures[0], tc);
+		    b2 = texture2D(textures[1], tc);
+		    max1 = max(max1, texture2D(textures[2], tc));
+		    sum += texture2D(textures[3], tc);
+		    sumsq += texture2D(textures[4], tc);
+		    count += texture2D(textures[5], tc);
+		}
+		// Merge (min1, min2) with (b1, b2). The new second minimum is
+		// the smallest of the four values that is greater than the new
+		// minimum.
+		vec4 m = min(min1, b1);
+		min2 = min(min2, b2);
+		min2 = min(min2, select(vec4(big), min1, greaterThan(min1, m)));
+		min2 = min(min2, select(vec4(big), b1, greaterThan(b1, m)));
+		min1 = m;
+	    }
+	}
+    }
+    gl_FragData[0] = min1;
+    gl_FragData[1] = min2;
+    gl_FragData[2] = max1;
+    gl_FragData[3] = sum;
+    gl_FragData[4] = sumsq;
+    gl_FragData[5] = count;
+}
@@ -299,20 +299,15 @@ uniform float xstep;
 uniform float level_boundary;
 uniform sampler2D tex;
 
+/* Periodic extension. The distance to the bound may be larger than the bound
+ * itself if D is larger than the size of the level. */
 float wrap(float z, float bound)
 {
-    if (z < 0.0)
-    {
-	z += bound;
-    }
-    else if (z >= bound)
-    {
-	z -= bound;
-    }
-
-    return z;
+    return mod(z, bound);
 }
 
+/* Result sample i combines the source samples 2i, ..., 2i+D-1. They are read
+ * at their texel centers; doubling the coordinate alone hits texel edges. */
 void main()
 {
     float x = gl_TexCoord[0].x;
@@ -324,7 +319,7 @@ void main()
 	for (int c = 0; c < D; c++)
 	{
 	    newval += approach_coeff[c] * texture2D(tex, 
-		    vec2(wrap(2.0 * x + float(c) * xstep, level_boundary), y));
+		    vec2(wrap(2.0 * x - 0.5 * xstep + float(c) * xstep, level_boundary), y));
 	}
     }
     else				// Details 
@@ -332,7 +327,7 @@ void main()
 	for (int c = 0; c < D; c++)
 	{
 	    newval += detail_coeff[c] * texture2D(tex, 
-		    vec2(wrap(2.0 * (x - level_boundary / 2.0) + float(c) * xstep, level_boundary), y));
+		    vec2(wrap(2.0 * (x - level_boundary / 2.0) - 0.5 * xstep + float(c) * xstep, level_boundary), y));
 	}
     }
     gl_FragColor = newval;
@@ -299,20 +299,15 @@ uniform float ystep;
 uniform float level_boundary;
 uniform sampler2D tex;
 
+/* Periodic extension. The distance to the bound may be larger than the bound
+ * itself if D is larger than the size of the level. */
 float wrap(float z, float bound)
 {
-    if (z < 0.0)
-    {
-	z += bound;
-    }
-    else if (z >= bound)
-    {
-	z -= bound;
-    }
-
-    return z;
+    return mod(z, bound);
 }
 
+/* Result sample i combines the source samples 2i, ..., 2i+D-1. They are read
+ * at their texel centers; doubling the coordinate alone hits texel edges. */
 void main()
 {
     float x = gl_TexCoord[0].x;
@@ -324,7 +319,7 @@ void main()
 	for (int r = 0; r < D; r++)
 	{
 	    newval += approach_coeff[r] * texture2D(tex, 
-		    vec2(x, wrap(2.0 * y + float(r) * ystep, level_boundary)));
+		    vec2(x, wrap(2.0 * y - 0.5 * ystep + float(r) * ystep, level_boundary)));
 	}
     }
     else				// Details
@@ -332,7 +327,7 @@ void main()
 	for (int r = 0; r < D; r++)
 	{
 	    newval += detail_coeff[r] * texture2D(tex, 
-		    vec2(x, wrap(2.0 * (y - level_boundary / 2.0) + float(r) * ystep, level_boundary)));
+		    vec2(x, wrap(2.0 * (y - level_boundary / 2.0) - 0.5 * ystep + float(r) * ystep, level_boundary)));
 	}
     }
     gl_FragColor = newval;
@@ -21,8 +21,8 @@
 
 #version 110
 
-uniform float upper_bound;
-uniform float lower_bound;
+uniform vec2 upper_bound;
+uniform vec2 lower_bound;
 uniform vec4 T;
 uniform sampler2D tex;
 
@@ -34,8 +34,8 @@ void main()
     vec4 newval;
 
     // Only process the Details of the right level.
-    if (x < upper_bound && y < upper_bound
-	    && (x >= lower_bound || y >= lower_bound))
+    if (x < upper_bound.x && y < upper_bound.y
+	    && (x >= lower_bound.x || y >= lower_bound.y))
     {
 	// Hard Thresholding
 	newval.r = (abs(oldval.r) >= T.r ? oldval.r : 0.0);
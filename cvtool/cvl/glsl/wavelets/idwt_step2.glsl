@@ -307,18 +307,11 @@ int mymodulo(int x, int y)
     return x - (x / y) * y;
 }
 
+/* Periodic extension. The distance to the bound may be larger than the bound
+ * itself if D is larger than the size of the level. */
 float wrap(float z, float bound)
 {
-    if (z < 0.0)
-    {
-	z += bound;
-    }
-    else if (z >= bound)
-    {
-  	z -= bound;
-    }
-
-    return z;
+    return mod(z, bound);
 }
 
 void main()
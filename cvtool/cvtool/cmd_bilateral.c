@@ -0,0 +1,81 @@
+/*
+ * cmd_bilateral.c
+ * 
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+
+#include <cvl/cvl.h>
+
+#include "mh.h"
+#include "cvtool.h"
+
+
+void cmd_bilateral_print_help(void)
+{
+    mh_msg_fmt_req(
+	    "bilateral -s|--sigma-spatial=<ss> -r|--sigma-range=<sr>\n"
+	    "\n"
+	    "Smooth frames while preserving edges: each pixel is replaced by a weighted average of its "
+	    "neighborhood, where the weights depend on the spatial distance (sigma ss, in pixels) and "
+	    "on the difference of the values (sigma sr, with values in [0,1]). All channels are "
+	    "filtered independently. The cost does not depend on ss.");
+}
+
+typedef struct
+{
+    float ss, sr;
+} bilateral_params_t;
+
+static cvl_frame_t *bilateral_frame(cvl_frame_t *frame, void *data)
+{
+    bilateral_params_t *p = data;
+    cvl_frame_t *new_frame = cvl_frame_new_tpl(frame);
+    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
+    cvl_bilateral(new_frame, frame, p->ss, p->sr);
+    cvl_frame_free(frame);
+    return new_frame;
+}
+
+int cmd_bilateral(int argc, char *argv[])
+{
+    mh_option_float_t ss = { -1.0f, 0.0f, false, FLT_MAX, true };
+    mh_option_float_t sr = { -1.0f, 0.0f, false, FLT_MAX, true };
+    mh_option_t options[] = 
+    {
+	{ "sigma-spatial", 's', MH_OPTION_FLOAT, &ss, true },
+	{ "sigma-range",   'r', MH_OPTION_FLOAT, &sr, true },
+	mh_option_null
+    };
+
+    mh_msg_set_command_name("%s", argv[0]);
+    if (!mh_getopt(argc, argv, options, 0, 0, NULL))
+    {
+	return 1;
+    }
+
+    bilateral_params_t params = { ss.value, sr.value };
+    return cvtool_process_frames(bilateral_frame, &params) ? 0 : 1;
+}
@@ -111,7 +111,7 @@ int cmd_convolve(int argc, char *argv[])
     if (three_dimensional)
     {
 	cvl_frame_t *new_frame;
-	int framebuflen = (K.value ? K.value_sizes[0] : T.value_sizes[0]);
+	int framebuflen = (K.value ? K.value_sizes[2] : T.value_sizes[0]);
 	cvl_frame_t *framebuf[framebuflen];
 	int future_frames = 0;
 	
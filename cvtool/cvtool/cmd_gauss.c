@@ -30,6 +30,7 @@
 #include <cvl/cvl.h>
 
 #include "mh.h"
+#include "cvtool.h"
 
 
 void cmd_gauss_print_help(void)
@@ -49,10 +50,20 @@ void cmd_gauss_print_help(void)
 	    "specify both sigma and k.");
 }
 
-static bool has_more_data(FILE *f)
+typedef struct
 {
-    int c;
-    return ((c = fgetc(f)) != EOF && ungetc(c, f) != EOF);
+    int kx, ky;
+    float sx, sy;
+} gauss_params_t;
+
+static cvl_frame_t *gauss_frame(cvl_frame_t *frame, void *data)
+{
+    gauss_params_t *p = data;
+    cvl_frame_t *new_frame = cvl_frame_new_tpl(frame);
+    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
+    cvl_gauss(new_frame, frame, p->kx, p->ky, p->sx, p->sy);
+    cvl_frame_free(frame);
+    return new_frame;
 }
 
 int cmd_gauss(int argc, char *argv[])
@@ -79,7 +90,6 @@ int cmd_gauss(int argc, char *argv[])
 	{ "sigma-t", 'T', MH_OPTION_FLOAT, &st,                false },
 	mh_option_null
     };
-    cvl_stream_type_t stream_type;
     bool error;
 
     mh_msg_set_command_name("%s", argv[0]);
@@ -166,96 +176,15 @@ int cmd_gauss(int argc, char *argv[])
 
     if (three_dimensional.value)
     {
-	cvl_frame_t *new_frame;
-	int framebuflen = 2 * kt.value + 1;
-	cvl_frame_t *framebuf[framebuflen];
-	int future_frames = 0;
-	
-	for (int i = 0; i < framebuflen; i++)
-	    framebuf[i] = NULL;
-
-	for (;;)
-	{
-	    // Read the next frame, or take it from the future.
-	    if (future_frames == 0 && has_more_data(stdin))
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2]));
-		error = cvl_error();
-		if (!framebuf[framebuflen / 2])
-		    break;
-	    }
-	    else
-	    {
-		if (future_frames > 0)
-		{
-		    for (int i = 0; i < future_frames; i++)
-		    {
-			framebuf[i + framebuflen / 2] = framebuf[i + framebuflen / 2 + 1];
-		    }
-		    framebuf[framebuflen / 2 + future_frames] = NULL;
-		    future_frames--;
-		}
-		else
-		{
-		    break;
-		}
-	    }
-
-	    // While (has_more_data && future not complete): Read more frames
-	    while (has_more_data(stdin) && future_frames < framebuflen / 2)
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2 + future_frames + 1]));
-		error = cvl_error();
-		if (!framebuf[framebuflen / 2 + future_frames + 1])
-		    break;
-		future_frames++;
-	    }
-	    if (error)
-	    {
-		break;
-	    }
-		
-	    // Process the present frame
-	    new_frame = cvl_frame_new_tpl(framebuf[framebuflen / 2]);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(framebuf[framebuflen / 2])));
-	    cvl_gauss3d(new_frame, framebuf, kx.value, ky.value, kt.value, sx.value, sy.value, st.value);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	    error = cvl_error();
-	    if (error)
-	    {
-		break;
-	    }
-
-	    // Move present into past
-    	    cvl_frame_free(framebuf[0]);
-	    for (int i = 0; i < framebuflen / 2; i++)
-	    {
-		framebuf[i] = framebuf[i + 1];
-	    }
-	}
-	for (int i = 0; i < framebuflen / 2; i++)
-	{
-	    cvl_frame_free(framebuf[i]);
-	}
+	cvl_temporal_filter_t *filter = cvl_temporal_filter_new(CVL_TEMPORAL_GAUSS,
+		kx.value, ky.value, kt.value, sx.value, sy.value, st.value);
+	error = !cvtool_process_frames_temporal(filter);
+	cvl_temporal_filter_free(filter);
     }
     else
     {
-	cvl_frame_t *frame, *new_frame;
-	
-    	while (!cvl_error())
-	{
-	    cvl_read(stdin, &stream_type, &frame);
-	    if (!frame)
-		break;
-	    new_frame = cvl_frame_new_tpl(frame);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
-	    cvl_gauss(new_frame, frame, kx.value, ky.value, sx.value, sy.value);
-	    cvl_frame_free(frame);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	}
-	error = cvl_error();
+	gauss_params_t params = { kx.value, ky.value, sx.value, sy.value };
+	error = !cvtool_process_frames(gauss_frame, &params);
     }
 
     return error ? 1 : 0;
@@ -23,6 +23,8 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <math.h>
 
@@ -34,7 +36,8 @@
 void cmd_info_print_help(void)
 {
     mh_msg_fmt_req(
-	    "info [-s|--statistics] [-S|--single] [-o|--output=<file>]\n"
+	    "info [-s|--statistics] [-r|--reduce=<mode>] [-q|--quantiles=q0[,q1...]] [-H|--histogram=<bins>] "
+	    "[-M|--histogram-method=auto|gpu|cpu] [-c|--channel=0|1|2|3] [-S|--single] [-o|--output=<file>]\n"
 	    "\n"
 	    "Print information about frames in the input stream.\n"
 	    "If --single is used, the command exits after the first frame has been processed.\n"
@@ -43,18 +46,42 @@ void cmd_info_print_help(void)
 	    "The following information will be printed: STREAM (pfs or pnm), CHANNELS (0-4), "
 	    "FORMAT (luminance or color), TYPE (uint8 or float), WIDTH, HEIGHT.\n"
 	    "Statistics are computed for each available channel c: "
-	    "CHc_MIN, CHc_MAX, CHc_MEAN, CHc_MEDIAN, CHc_STDDEVIATION.");
+	    "CHc_MIN, CHc_MAX, CHc_MEAN, CHc_MEDIAN, CHc_STDDEVIATION. "
+	    "Non-finite values are ignored.\n"
+	    "If --reduce is used, the given channel (default: all channels) is reduced to a single value "
+	    "CHc_REDUCE with one of the following modes: min, min-greater-zero, absmin, absmin-greater-zero, "
+	    "max, absmax, sum.\n"
+	    "If --quantiles is used, the given quantiles from [0,1] of the given channel (default: all "
+	    "channels) are printed as CHc_QUANTILEi.\n"
+	    "If --histogram is used, the histogram of the given channel (default: all channels) is "
+	    "computed with the given number of bins between the minimum and maximum finite channel value, "
+	    "and printed as CHc_HISTOGRAM, a comma separated list of counts. The histogram is computed "
+	    "on the GPU or on the CPU; --histogram-method selects one of them (default: auto).");
 }
 
 
 int cmd_info(int argc, char *argv[])
 {
     mh_option_bool_t statistics = { false, true };
+    const char *reduce_names[] = { "min", "min-greater-zero", "absmin", "absmin-greater-zero", 
+	"max", "absmax", "sum", NULL };
+    mh_option_name_t reduce = { -1, reduce_names };
+    mh_option_float_array_t quantiles = { NULL, 1, 0, 1, NULL };
+    mh_option_int_t histogram = { 0, 1, INT_MAX };
+    const char *histogram_method_names[] = { "auto", "gpu", "cpu", NULL };
+    mh_option_name_t histogram_method = { CVL_HISTOGRAM_AUTO, histogram_method_names };
+    const char *channel_names[] = { "0", "1", "2", "3", NULL };
+    mh_option_name_t channel = { -1, channel_names };
     mh_option_bool_t single = { false, true };
     mh_option_file_t output = { NULL, "w", true };
     mh_option_t options[] = 
     {
 	{ "statistics", 's', MH_OPTION_BOOL, &statistics, false },
+	{ "reduce",     'r', MH_OPTION_NAME,        &reduce,     false },
+	{ "quantiles",  'q', MH_OPTION_FLOAT_ARRAY, &quantiles,  false },
+	{ "histogram",  'H', MH_OPTION_INT,         &histogram,  false },
+	{ "histogram-method", 'M', MH_OPTION_NAME,  &histogram_method, false },
+	{ "channel",    'c', MH_OPTION_NAME,        &channel,    false },
 	{ "single",     'S', MH_OPTION_BOOL, &single,     false },
 	{ "output",     'o', MH_OPTION_FILE, &output,     false },
 	mh_option_null
@@ -65,12 +92,20 @@ int cmd_info(int argc, char *argv[])
     mh_msg_set_command_name("%s", argv[0]);    
     if (!mh_getopt(argc, argv, options, 0, 0, NULL))
 	return 1;
+    for (int i = 0; quantiles.value && i < quantiles.value_sizes[0]; i++)
+    {
+	if (!(quantiles.value[i] >= 0.0f && quantiles.value[i] <= 1.0f))
+	{
+	    mh_msg_err("Quantiles must be from [0,1]");
+	    return 1;
+	}
+    }
 
     while (!cvl_error())
     {
 	cvl_read(stdin, &stream_type, &frame);
 	if (!frame)
-	    return 0;
+	    break;
 
 	mh_msg(output.value ? output.value : stderr, MH_MSG_REQ,
 		"STREAM=%s CHANNELS=%d FORMAT=%s TYPE=%s WIDTH=%d HEIGHT=%d",
@@ -92,6 +127,71 @@ int cmd_info(int argc, char *argv[])
 	    }
 	}
 
+	if (reduce.value >= 0)
+	{
+	    float result[4];
+	    cvl_reduce(frame, (cvl_reduce_mode_t)reduce.value, channel.value, result);
+	    for (int c = 0; c < cvl_frame_channels(frame); c++)
+	    {
+		if (channel.value == -1 || channel.value == c)
+		{
+		    mh_msg(output.value ? output.value : stderr, MH_MSG_REQ,
+			    "CH%d_REDUCE=%.6g", c, result[channel.value == -1 ? c : 0]);
+		}
+	    }
+	}
+
+	if (quantiles.value)
+	{
+	    int n = quantiles.value_sizes[0];
+	    float *result = mh_alloc(4 * n * sizeof(float));
+	    cvl_quantiles(frame, channel.value, quantiles.value, n, result);
+	    for (int c = 0; c < cvl_frame_channels(frame); c++)
+	    {
+		if (channel.value == -1 || channel.value == c)
+		{
+		    for (int i = 0; i < n; i++)
+		    {
+			mh_msg(output.value ? output.value : stderr, MH_MSG_REQ,
+				"CH%d_QUANTILE%d=%.6g", c, i, 
+				channel.value == -1 ? result[4 * i + c] : result[i]);
+		    }
+		}
+	    }
+	    free(result);
+	}
+
+	if (histogram.value > 0)
+	{
+	    int bins = histogram.value;
+	    int channels = (channel.value == -1 ? 4 : 1);
+	    float min[4], max[4];
+	    int *h = mh_alloc(channels * bins * sizeof(int));
+	    char *list = mh_alloc(bins * 12);
+	    cvl_statistics(frame, min, max, NULL, NULL, NULL, NULL);
+	    if (channel.value >= 0)
+	    {
+		min[0] = min[channel.value];
+		max[0] = max[channel.value];
+	    }
+	    cvl_histogram_using(frame, channel.value, bins, min, max, h,
+		    (cvl_histogram_method_t)histogram_method.value);
+	    for (int c = 0; c < cvl_frame_channels(frame); c++)
+	    {
+		if (channel.value == -1 || channel.value == c)
+		{
+		    int *hc = h + (channel.value == -1 ? c : 0) * bins;
+		    char *p = list;
+		    for (int b = 0; b < bins; b++)
+			p += sprintf(p, b == 0 ? "%d" : ",%d", hc[b]);
+		    mh_msg(output.value ? output.value : stderr, MH_MSG_REQ,
+			    "CH%d_HISTOGRAM=%s", c, list);
+		}
+	    }
+	    free(list);
+	    free(h);
+	}
+
 	cvl_frame_free(frame);
 
 	if (single.value)
@@ -100,6 +200,7 @@ int cmd_info(int argc, char *argv[])
 
     if (output.value && output.value != stdout)
 	fclose(output.value);
+    free(quantiles.value);
     
     return cvl_error() ? 1 : 0;
 }
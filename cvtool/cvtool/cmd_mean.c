@@ -30,6 +30,7 @@
 #include <cvl/cvl.h>
 
 #include "mh.h"
+#include "cvtool.h"
 
 
 void cmd_mean_print_help(void)
@@ -43,10 +44,19 @@ void cmd_mean_print_help(void)
 	    "Different values for each direction lead to asymmetric filtering.");
 }
 
-static bool has_more_data(FILE *f)
+typedef struct
 {
-    int c;
-    return ((c = fgetc(f)) != EOF && ungetc(c, f) != EOF);
+    int kx, ky;
+} mean_params_t;
+
+static cvl_frame_t *mean_frame(cvl_frame_t *frame, void *data)
+{
+    mean_params_t *p = data;
+    cvl_frame_t *new_frame = cvl_frame_new_tpl(frame);
+    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
+    cvl_mean(new_frame, frame, p->kx, p->ky);
+    cvl_frame_free(frame);
+    return new_frame;
 }
 
 int cmd_mean(int argc, char *argv[])
@@ -65,7 +75,6 @@ int cmd_mean(int argc, char *argv[])
 	{ "k-t",     't', MH_OPTION_INT,   &kt,                false },
 	mh_option_null
     };
-    cvl_stream_type_t stream_type;
     bool error;
 
     mh_msg_set_command_name("%s", argv[0]);
@@ -104,100 +113,15 @@ int cmd_mean(int argc, char *argv[])
 
     if (three_dimensional.value)
     {
-	cvl_frame_t *new_frame;
-	int framebuflen = 2 * kt.value + 1;
-	cvl_frame_t *framebuf[framebuflen];
-	int future_frames = 0;
-	
-	for (int i = 0; i < framebuflen; i++)
-	    framebuf[i] = NULL;
-
-	for (;;)
-	{
-	    // Read the next frame, or take it from the future.
-	    if (future_frames == 0 && has_more_data(stdin))
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2]));
-		if (!framebuf[framebuflen / 2])
-		{
-		    error = true;
-		    break;
-		}
-	    }
-	    else
-	    {
-		if (future_frames > 0)
-		{
-		    for (int i = 0; i < future_frames; i++)
-		    {
-			framebuf[i + framebuflen / 2] = framebuf[i + framebuflen / 2 + 1];
-		    }
-		    framebuf[framebuflen / 2 + future_frames] = NULL;
-		    future_frames--;
-		}
-		else
-		{
-		    break;
-		}
-	    }
-
-	    // While (has_more_data && future not complete): Read more frames
-	    while (has_more_data(stdin) && future_frames < framebuflen / 2)
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2 + future_frames + 1]));
-		if (!framebuf[framebuflen / 2 + future_frames + 1])
-		{
-		    error = true;
-		    break;
-		}
-		future_frames++;
-	    }
-	    if (error)
-	    {
-		break;
-	    }
-		
-	    // Process the present frame
-	    new_frame = cvl_frame_new_tpl(framebuf[framebuflen / 2]);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(framebuf[framebuflen / 2])));
-	    cvl_mean3d(new_frame, framebuf, kx.value, ky.value, kt.value);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	    error = cvl_error();
-	    if (error)
-	    {
-		break;
-	    }
-
-	    // Move present into past
-    	    cvl_frame_free(framebuf[0]);
-	    for (int i = 0; i < framebuflen / 2; i++)
-	    {
-		framebuf[i] = framebuf[i + 1];
-	    }
-	}
-	for (int i = 0; i < framebuflen / 2; i++)
-	{
-	    cvl_frame_free(framebuf[i]);
-	}
+	cvl_temporal_filter_t *filter = cvl_temporal_filter_new(CVL_TEMPORAL_MEAN,
+		kx.value, ky.value, kt.value, 0.0f, 0.0f, 0.0f);
+	error = !cvtool_process_frames_temporal(filter);
+	cvl_temporal_filter_free(filter);
     }
     else
     {
-	cvl_frame_t *frame, *new_frame;
-	
-    	while (!cvl_error())
-	{
-	    cvl_read(stdin, &stream_type, &frame);
-	    if (!frame)
-		break;
-	    new_frame = cvl_frame_new_tpl(frame);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
-	    cvl_mean(new_frame, frame, kx.value, ky.value);
-	    cvl_frame_free(frame);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	}
-	error = cvl_error();
+	mean_params_t params = { kx.value, ky.value };
+	error = !cvtool_process_frames(mean_frame, &params);
     }
 
     return error ? 1 : 0;
@@ -30,6 +30,7 @@
 #include <cvl/cvl.h>
 
 #include "mh.h"
+#include "cvtool.h"
 
 
 void cmd_min_print_help(void)
@@ -37,21 +38,39 @@ void cmd_min_print_help(void)
     mh_msg_fmt_req(
 	    "min [-3|--3d] -k|--k=<k>\n"
 	    "min [-3|--3d] -x|--k-x=<kx> -y|--k-y=<ky> [-t|--k-t=<kt>]\n"
+	    "min -o|--opening -k|--k=<k>\n"
+	    "min -o|--opening -x|--k-x=<kx> -y|--k-y=<ky>\n"
 	    "\n"
 	    "Filter frames, in 2D or 3D (with the third dimension being the time). The kernel size "
 	    "can be given for each dimension, or once for all. It will be (2kx+1)x(2ky+1)[x(2kt+1)]. "
-	    "Different values for each direction lead to asymmetric filtering.");
+	    "Different values for each direction lead to asymmetric filtering.\n"
+	    "The opening option applies Minimum filtering followed by Maximum filtering in 2D "
+	    "(a morphological opening), which removes bright structures that are smaller than the kernel.");
 }
 
-static bool has_more_data(FILE *f)
+typedef struct
 {
-    int c;
-    return ((c = fgetc(f)) != EOF && ungetc(c, f) != EOF);
+    int kx, ky;
+    bool opening;
+} min_params_t;
+
+static cvl_frame_t *min_frame(cvl_frame_t *frame, void *data)
+{
+    min_params_t *p = data;
+    cvl_frame_t *new_frame = cvl_frame_new_tpl(frame);
+    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
+    if (p->opening)
+	cvl_opening(new_frame, frame, p->kx, p->ky);
+    else
+	cvl_min(new_frame, frame, p->kx, p->ky);
+    cvl_frame_free(frame);
+    return new_frame;
 }
 
 int cmd_min(int argc, char *argv[])
 {
     mh_option_bool_t three_dimensional = { false, true };
+    mh_option_bool_t opening = { false, true };
     mh_option_int_t k = { -1, 0, MH_MASKSIZE_K_MAX };
     mh_option_int_t kx = { -1, 0, MH_MASKSIZE_K_MAX };
     mh_option_int_t ky = { -1, 0, MH_MASKSIZE_K_MAX };
@@ -63,9 +82,9 @@ int cmd_min(int argc, char *argv[])
 	{ "k-x",     'x', MH_OPTION_INT,   &kx,                false },
 	{ "k-y",     'y', MH_OPTION_INT,   &ky,                false },
 	{ "k-t",     't', MH_OPTION_INT,   &kt,                false },
+	{ "opening", 'o', MH_OPTION_BOOL,  &opening,           false },
 	mh_option_null
     };
-    cvl_stream_type_t stream_type;
     bool error;
 
     mh_msg_set_command_name("%s", argv[0]);
@@ -76,7 +95,12 @@ int cmd_min(int argc, char *argv[])
 	{
 	    three_dimensional.value = true;
 	}
-	if (k.value >= 0 && (kx.value >= 0 || ky.value >= 0 || kt.value >= 0))
+	if (opening.value && three_dimensional.value)
+	{
+	    mh_msg_err("Opening is only available in 2D");
+	    error = true;
+	}
+	else if (k.value >= 0 && (kx.value >= 0 || ky.value >= 0 || kt.value >= 0))
 	{
 	    mh_msg_err("Kernel size is overdetermined");
 	    error = true;
@@ -104,100 +128,15 @@ int cmd_min(int argc, char *argv[])
 
     if (three_dimensional.value)
     {
-	cvl_frame_t *new_frame;
-	int framebuflen = 2 * kt.value + 1;
-	cvl_frame_t *framebuf[framebuflen];
-	int future_frames = 0;
-	
-	for (int i = 0; i < framebuflen; i++)
-	    framebuf[i] = NULL;
-
-	for (;;)
-	{
-	    // Read the next frame, or take it from the future.
-	    if (future_frames == 0 && has_more_data(stdin))
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2]));
-		if (!framebuf[framebuflen / 2])
-		{
-		    error = true;
-		    break;
-		}
-	    }
-	    else
-	    {
-		if (future_frames > 0)
-		{
-		    for (int i = 0; i < future_frames; i++)
-		    {
-			framebuf[i + framebuflen / 2] = framebuf[i + framebuflen / 2 + 1];
-		    }
-		    framebuf[framebuflen / 2 + future_frames] = NULL;
-		    future_frames--;
-		}
-		else
-		{
-		    break;
-		}
-	    }
-
-	    // While (has_more_data && future not complete): Read more frames
-	    while (has_more_data(stdin) && future_frames < framebuflen / 2)
-	    {
-		cvl_read(stdin, &stream_type, &(framebuf[framebuflen / 2 + future_frames + 1]));
-		if (!framebuf[framebuflen / 2 + future_frames + 1])
-		{
-		    error = true;
-		    break;
-		}
-		future_frames++;
-	    }
-	    if (error)
-	    {
-		break;
-	    }
-		
-	    // Process the present frame
-	    new_frame = cvl_frame_new_tpl(framebuf[framebuflen / 2]);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(framebuf[framebuflen / 2])));
-	    cvl_min3d(new_frame, framebuf, kx.value, ky.value, kt.value);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	    error = cvl_error();
-	    if (error)
-	    {
-		break;
-	    }
-
-	    // Move present into past
-    	    cvl_frame_free(framebuf[0]);
-	    for (int i = 0; i < framebuflen / 2; i++)
-	    {
-		framebuf[i] = framebuf[i + 1];
-	    }
-	}
-	for (int i = 0; i < framebuflen / 2; i++)
-	{
-	    cvl_frame_free(framebuf[i]);
-	}
+	cvl_temporal_filter_t *filter = cvl_temporal_filter_new(CVL_TEMPORAL_MIN,
+		kx.value, ky.value, kt.value, 0.0f, 0.0f, 0.0f);
+	error = !cvtool_process_frames_temporal(filter);
+	cvl_temporal_filter_free(filter);
     }
     else
     {
-	cvl_frame_t *frame, *new_frame;
-	
-    	while (!cvl_error())
-	{
-	    cvl_read(stdin, &stream_type, &frame);
-	    if (!frame)
-		break;
-	    new_frame = cvl_frame_new_tpl(frame);
-	    cvl_frame_set_taglist(new_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
-	    cvl_min(new_frame, frame, kx.value, ky.value);
-	    cvl_frame_free(frame);
-	    cvl_write(stdout, stream_type, new_frame);
-	    cvl_frame_free(new_frame);
-	}
-	error = cvl_error();
+	min_params_t params = { kx.value, ky.value, opening.value };
+	error = !cvtool_process_frames(min_frame, &params);
     }
 
     return error ? 1 : 0;
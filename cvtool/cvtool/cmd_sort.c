@@ -33,19 +33,24 @@
 void cmd_sort_print_help(void)
 {
     mh_msg_fmt_req(
-	    "sort [-k|--key-channel=<k>]\n"
+	    "sort [-k|--key-channel=<k>] [-m|--method=auto|bitonic|radix]\n"
 	    "\n"
 	    "Sort frame contents. The channel k is used as the sorting key. "
-	    "If k is -1, then all channels are sorted independently.");
+	    "If k is -1, then all channels are sorted independently.\n"
+	    "The bitonic method sorts on the GPU, the radix method on the CPU. "
+	    "The default is auto, which currently uses the radix method.");
 }
 
 
 int cmd_sort(int argc, char *argv[] UNUSED)
 {
     mh_option_int_t k = { -1, -1, 3 };
+    const char *method_names[] = { "auto", "bitonic", "radix", NULL };
+    mh_option_name_t method = { 0, method_names };
     mh_option_t options[] = 
     {
-	{ "key-channel", 'k', MH_OPTION_INT, &k, false },
+	{ "key-channel", 'k', MH_OPTION_INT,  &k,      false },
+	{ "method",      'm', MH_OPTION_NAME, &method, false },
 	mh_option_null 
     };
     cvl_stream_type_t stream_type;
@@ -64,7 +69,7 @@ int cmd_sort(int argc, char *argv[] UNUSED)
 	    break;
 	sorted_frame = cvl_frame_new_tpl(frame);
 	cvl_frame_set_taglist(sorted_frame, cvl_taglist_copy(cvl_frame_taglist(frame)));
-	cvl_sort(sorted_frame, frame, k.value);
+	cvl_sort_using(sorted_frame, frame, k.value, (cvl_sort_method_t)method.value);
 	cvl_frame_free(frame);
 	cvl_write(stdout, stream_type, sorted_frame);
 	cvl_frame_free(sorted_frame);
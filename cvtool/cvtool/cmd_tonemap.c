@@ -21,10 +21,12 @@
 
 #include "config.h"
 
+#include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <float.h>
+#include <errno.h>
 
 #include <cvl/cvl.h>
 
@@ -42,6 +44,8 @@ void cmd_tonemap_print_help(void)
 	    "tonemap -m|--method=ashikhmin02 [-l|--max-absolute-luminance=<l>] [--local-contrast=<c>]\n"
 	    "tonemap -m|--method=durand02 [-l|--max-absolute-luminance=<l>] [--sigma-spatial=<ss>] [--sigma-luminance=<sl>] [--base-contrast=<bc>]\n"
 	    "tonemap -m|--method=reinhard02 [--key-value=<a>] [--white=<w>] [--sharpness=<s>] [--epsilon=<e>]\n"
+	    "tonemap ... [-t|--adaptation-time=<t>] [--no-lut]\n"
+	    "tonemap --batch=<file> [...]\n"
 	    "\n"
 	    "Tone map frames. High dynamic range (HDR) frames are read from standard input, and low dynamic range (LDR) frames "
 	    "are written to standard output. For some methods, the results should be gamma corrected.\n"
@@ -53,73 +57,381 @@ void cmd_tonemap_print_help(void)
 	    "The defaults for reinhard05 are i=0.0, l=0.5, c=0.5.\n"
 	    "The default for ashikhmin02 is c=0.5.\n"
 	    "The defaults for durand02 are ss=0.3, sl=0.4, bc=2.0.\n"
-	    "The defaults for reinhard02 are a=0.1, w=1.0, s=10.0, e=0.5.");
+	    "The defaults for reinhard02 are a=0.1, w=1.0, s=10.0, e=0.5.\n"
+	    "The methods tumblin99, reinhard05, ashikhmin02, and reinhard02 depend on luminance statistics of the input. "
+	    "For videos, these statistics can be smoothed over time to avoid flickering: the adaptation time t is the "
+	    "time constant in frames. The default is t=0, which disables smoothing.\n"
+	    "The methods schlick94, tumblin99, and drago03 apply their curve with a lookup table. With --no-lut, "
+	    "the curve is evaluated for each pixel instead.\n"
+	    "With --batch, several tone mapping configurations are applied to each input frame, and the luminance "
+	    "statistics are computed only once per frame. Each line of the batch file contains the name of an output "
+	    "file followed by the options for one configuration, separated by white space. Options given on the "
+	    "command line are the defaults for all lines. Empty lines and text following # are ignored. "
+	    "The output file name - means standard output.");
 }
 
 
-int cmd_tonemap(int argc, char *argv[])
+typedef enum 
+{ 
+    TM_SCHLICK94, 
+    TM_TUMBLIN99, 
+    TM_DRAGO03, 
+    TM_REINHARD05, 
+    TM_ASHIKHMIN02,
+    TM_DURAND02,
+    TM_REINHARD02
+} method_t;
+
+static const char *method_names[] = 
+{ 
+    "schlick94", 
+    "tumblin99", 
+    "drago03", 
+    "reinhard05", 
+    "ashikhmin02",
+    "durand02", 
+    "reinhard02", 
+    NULL 
+};
+
+/* One tone mapping configuration: the options, the output, and the state that
+ * is kept across frames. */
+typedef struct
+{
+    mh_option_name_t method;
+    mh_option_float_t max_abs_lum;
+    mh_option_float_t schlick94_p;
+    mh_option_float_t tr99_disp_adapt_level;
+    mh_option_float_t tr99_max_contrast;
+    mh_option_float_t drago03_max_disp_lum;
+    mh_option_float_t drago03_bias;
+    mh_option_float_t reinhard05_intensity;
+    mh_option_float_t reinhard05_light_adapt;
+    mh_option_float_t reinhard05_chroma_adapt;
+    mh_option_float_t ashikhmin02_local_contrast;
+    mh_option_float_t durand02_sigma_spatial;
+    mh_option_float_t durand02_sigma_luminance;
+    mh_option_float_t durand02_base_contrast;
+    mh_option_float_t reinhard02_key_value;
+    mh_option_float_t reinhard02_white;
+    mh_option_float_t reinhard02_sharpness;
+    mh_option_float_t reinhard02_epsilon;
+    mh_option_float_t adaptation_time;
+    mh_option_bool_t no_lut;
+    FILE *output;
+    cvl_lum_adaptation_t *adaptation;
+    cvl_frame_t *lut;
+    bool lut_valid;
+    float lut_log_avg_lum;
+} tonemap_config_t;
+
+/* Luminance statistics of a frame, computed for a given maximum absolute
+ * luminance. */
+typedef struct
+{
+    float max_abs_lum;
+    float min_lum;
+    float max_lum;
+    float avg_lum;
+    float log_avg_lum;
+    float channel_avg[3];
+} tonemap_statistics_t;
+
+static void tonemap_config_init(tonemap_config_t *c)
+{
+    c->method = (mh_option_name_t){ -1, method_names };
+    c->max_abs_lum = (mh_option_float_t){ -1.0f, 0.0f, false, FLT_MAX, true };
+    c->schlick94_p = (mh_option_float_t){ 100.0f, 1.0f, true, FLT_MAX, true };
+    c->tr99_disp_adapt_level = (mh_option_float_t){ 100.0f, 0.0f, false, FLT_MAX, true };
+    c->tr99_max_contrast = (mh_option_float_t){ 70.0f, 0.0f, false, FLT_MAX, true };
+    c->drago03_max_disp_lum = (mh_option_float_t){ 200.0f, 0.0f, false, FLT_MAX, true };
+    c->drago03_bias = (mh_option_float_t){ 0.85f, 0.0f, true, 1.0f, true };
+    c->reinhard05_intensity = (mh_option_float_t){ 0.0f, -8.0f, true, 8.0f, true };
+    c->reinhard05_light_adapt = (mh_option_float_t){ 0.5f, 0.0f, true, 1.0f, true };
+    c->reinhard05_chroma_adapt = (mh_option_float_t){ 0.5f, 0.0f, true, 1.0f, true };
+    c->ashikhmin02_local_contrast = (mh_option_float_t){ 0.5f, 0.0f, true, 10.0f, true };
+    c->durand02_sigma_spatial = (mh_option_float_t){ 0.3f, 0.0f, false, FLT_MAX, true };
+    c->durand02_sigma_luminance = (mh_option_float_t){ 0.4f, 0.0f, false, FLT_MAX, true };
+    c->durand02_base_contrast = (mh_option_float_t){ 3.0f, 1.0f, false, FLT_MAX, true };
+    c->reinhard02_key_value = (mh_option_float_t){ 0.1f, 0.0f, false, 1.0f, true };
+    c->reinhard02_white = (mh_option_float_t){ 1.0f, 0.0f, true, 100.0f, false };
+    c->reinhard02_sharpness = (mh_option_float_t){ 10.0f, 0.0f, true, 100.0f, false };
+    c->reinhard02_epsilon = (mh_option_float_t){ 0.5f, 0.0f, true, 1.0f, true };
+    c->adaptation_time = (mh_option_float_t){ 0.0f, 0.0f, true, FLT_MAX, true };
+    c->no_lut = (mh_option_bool_t){ false, true };
+    c->output = NULL;
+    c->adaptation = NULL;
+    c->lut = NULL;
+    c->lut_valid = false;
+    c->lut_log_avg_lum = 0.0f;
+}
+
+/* Parses the options of a configuration. The --batch option is only accepted
+ * if batch is not NULL. */
+static bool tonemap_getopt(int argc, char *argv[], tonemap_config_t *c, mh_option_file_t *batch,
+	int nonopt_args, int *first_argument)
 {
-    typedef enum 
-    { 
-	TM_SCHLICK94, 
-	TM_TUMBLIN99, 
-	TM_DRAGO03, 
-	TM_REINHARD05, 
-	TM_ASHIKHMIN02,
-	TM_DURAND02,
-	TM_REINHARD02
-    } method_t;
-    const char *method_names[] = 
-    { 
-	"schlick94", 
-	"tumblin99", 
-	"drago03", 
-	"reinhard05", 
-	"ashikhmin02",
-	"durand02", 
-	"reinhard02", 
-	NULL 
-    };
-    mh_option_name_t method = { -1, method_names };
-    mh_option_float_t max_abs_lum = { -1.0f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t schlick94_p = { 100.0f, 1.0f, true, FLT_MAX, true };
-    mh_option_float_t tr99_disp_adapt_level = { 100.0f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t tr99_max_contrast = { 70.0f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t drago03_max_disp_lum = { 200.0f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t drago03_bias = { 0.85f, 0.0f, true, 1.0f, true };
-    mh_option_float_t reinhard05_intensity = { 0.0f, -8.0f, true, 8.0f, true };
-    mh_option_float_t reinhard05_light_adapt = { 0.5f, 0.0f, true, 1.0f, true };
-    mh_option_float_t reinhard05_chroma_adapt = { 0.5f, 0.0f, true, 1.0f, true };
-    mh_option_float_t ashikhmin02_local_contrast = { 0.5f, 0.0f, true, 10.0f, true };
-    mh_option_float_t durand02_sigma_spatial = { 0.3f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t durand02_sigma_luminance = { 0.4f, 0.0f, false, FLT_MAX, true };
-    mh_option_float_t durand02_base_contrast = { 3.0f, 1.0f, false, FLT_MAX, true };
-    mh_option_float_t reinhard02_key_value = { 0.1f, 0.0f, false, 1.0f, true };
-    mh_option_float_t reinhard02_white = { 1.0f, 0.0f, true, 100.0f, false };
-    mh_option_float_t reinhard02_sharpness = { 10.0f, 0.0f, true, 100.0f, false };
-    mh_option_float_t reinhard02_epsilon = { 0.5f, 0.0f, true, 1.0f, true };
     mh_option_t options[] = 
     {
-	{ "method",                    'm', MH_OPTION_NAME,  &method,                     true  },
-	{ "max-absolute-luminance",    'l', MH_OPTION_FLOAT, &max_abs_lum,                false },
-	{ "brightness",               '\0', MH_OPTION_FLOAT, &schlick94_p,                false },
-	{ "display-adaptation-level", '\0', MH_OPTION_FLOAT, &tr99_disp_adapt_level,      false },
-	{ "max-displayable-contrast", '\0', MH_OPTION_FLOAT, &tr99_max_contrast,          false },
-	{ "max-display-luminance",    '\0', MH_OPTION_FLOAT, &drago03_max_disp_lum,       false },
-	{ "bias",                     '\0', MH_OPTION_FLOAT, &drago03_bias,               false },
-	{ "intensity",                '\0', MH_OPTION_FLOAT, &reinhard05_intensity,       false },
-	{ "light-adaptation",         '\0', MH_OPTION_FLOAT, &reinhard05_light_adapt,     false },
-	{ "chromatic-adaptation",     '\0', MH_OPTION_FLOAT, &reinhard05_chroma_adapt,    false },
-	{ "local-contrast",           '\0', MH_OPTION_FLOAT, &ashikhmin02_local_contrast, false },
-	{ "sigma-spatial",            '\0', MH_OPTION_FLOAT, &durand02_sigma_spatial,     false },
-	{ "sigma-luminance" ,         '\0', MH_OPTION_FLOAT, &durand02_sigma_luminance,   false },
-	{ "base-contrast",            '\0', MH_OPTION_FLOAT, &durand02_base_contrast,     false },
-	{ "key-value",                '\0', MH_OPTION_FLOAT, &reinhard02_key_value,       false },
-	{ "white",                    '\0', MH_OPTION_FLOAT, &reinhard02_white,           false },
-	{ "sharpness",                '\0', MH_OPTION_FLOAT, &reinhard02_sharpness,       false },
-	{ "epsilon",                  '\0', MH_OPTION_FLOAT, &reinhard02_epsilon,         false },
+	{ "method",                    'm', MH_OPTION_NAME,  &c->method,                     false },
+	{ "max-absolute-luminance",    'l', MH_OPTION_FLOAT, &c->max_abs_lum,                false },
+	{ "brightness",               '\0', MH_OPTION_FLOAT, &c->schlick94_p,                false },
+	{ "display-adaptation-level", '\0', MH_OPTION_FLOAT, &c->tr99_disp_adapt_level,      false },
+	{ "max-displayable-contrast", '\0', MH_OPTION_FLOAT, &c->tr99_max_contrast,          false },
+	{ "max-display-luminance",    '\0', MH_OPTION_FLOAT, &c->drago03_max_disp_lum,       false },
+	{ "bias",                     '\0', MH_OPTION_FLOAT, &c->drago03_bias,               false },
+	{ "intensity",                '\0', MH_OPTION_FLOAT, &c->reinhard05_intensity,       false },
+	{ "light-adaptation",         '\0', MH_OPTION_FLOAT, &c->reinhard05_light_adapt,     false },
+	{ "chromatic-adaptation",     '\0', MH_OPTION_FLOAT, &c->reinhard05_chroma_adapt,    false },
+	{ "local-contrast",           '\0', MH_OPTION_FLOAT, &c->ashikhmin02_local_contrast, false },
+	{ "sigma-spatial",            '\0', MH_OPTION_FLOAT, &c->durand02_sigma_spatial,     false },
+	{ "sigma-luminance" ,         '\0', MH_OPTION_FLOAT, &c->durand02_sigma_luminance,   false },
+	{ "base-contrast",            '\0', MH_OPTION_FLOAT, &c->durand02_base_contrast,     false },
+	{ "key-value",                '\0', MH_OPTION_FLOAT, &c->reinhard02_key_value,       false },
+	{ "white",                    '\0', MH_OPTION_FLOAT, &c->reinhard02_white,           false },
+	{ "sharpness",                '\0', MH_OPTION_FLOAT, &c->reinhard02_sharpness,       false },
+	{ "epsilon",                  '\0', MH_OPTION_FLOAT, &c->reinhard02_epsilon,         false },
+	{ "adaptation-time",           't', MH_OPTION_FLOAT, &c->adaptation_time,            false },
+	{ "no-lut",                   '\0', MH_OPTION_BOOL,  &c->no_lut,                     false },
+	{ "batch",                    '\0', MH_OPTION_FILE,  batch,                          false },
 	mh_option_null
     };
+    if (!batch)
+    {
+	options[sizeof(options) / sizeof(options[0]) - 2] = mh_option_null;
+    }
+    return mh_getopt(argc, argv, options, nonopt_args, nonopt_args, first_argument);
+}
+
+/* Reads a line of the batch file and splits it into arguments at white space,
+ * ignoring everything after a #. The first argument is the command name.
+ * Returns NULL at the end of the file. */
+static char *tonemap_read_batch_line(FILE *f, const char *command_name, int *argc, char ***argv)
+{
+    size_t size = 128;
+    size_t len = 0;
+    char *line = mh_alloc(size * sizeof(char));
+    int c;
+    while ((c = fgetc(f)) != EOF && c != '\n')
+    {
+	if (len + 1 == size)
+	{
+	    size *= 2;
+	    line = mh_realloc(line, size * sizeof(char));
+	}
+	line[len++] = c;
+    }
+    if (c == EOF && len == 0)
+    {
+	free(line);
+	return NULL;
+    }
+    line[len] = '\0';
+    char *comment = strchr(line, '#');
+    if (comment)
+    {
+	*comment = '\0';
+    }
+
+    *argv = mh_alloc((len / 2 + 3) * sizeof(char *));
+    (*argv)[0] = (char *)command_name;
+    *argc = 1;
+    char *p = line;
+    for (;;)
+    {
+	p += strspn(p, " \t\r\v\f");
+	if (*p == '\0')
+	    break;
+	(*argv)[(*argc)++] = p;
+	p += strcspn(p, " \t\r\v\f");
+	if (*p != '\0')
+	    *p++ = '\0';
+    }
+    (*argv)[*argc] = NULL;
+    return line;
+}
+
+/* Reads the configurations from the batch file. Each configuration starts
+ * with the given defaults. On error, the configurations that were read so far
+ * are returned, too. */
+static bool tonemap_read_batch(FILE *f, const char *command_name, const tonemap_config_t *defaults,
+	tonemap_config_t **configs, int *configs_count)
+{
+    bool error = false;
+    int line_number = 0;
+    char *line;
+    int line_argc;
+    char **line_argv;
+
+    *configs = NULL;
+    *configs_count = 0;
+    while (!error && (line = tonemap_read_batch_line(f, command_name, &line_argc, &line_argv)))
+    {
+	line_number++;
+	if (line_argc > 1)
+	{
+	    tonemap_config_t c = *defaults;
+	    int first_argument;
+	    if (!tonemap_getopt(line_argc, line_argv, &c, NULL, 1, &first_argument))
+	    {
+		mh_msg_err("Batch file line %d: invalid configuration", line_number);
+		error = true;
+	    }
+	    else if (c.method.value < 0)
+	    {
+		mh_msg_err("Batch file line %d: no method", line_number);
+		error = true;
+	    }
+	    else if (strcmp(line_argv[first_argument], "-") == 0)
+	    {
+		c.output = stdout;
+	    }
+	    else if (!(c.output = fopen(line_argv[first_argument], "w")))
+	    {
+		mh_msg_err("Cannot open %s: %s", line_argv[first_argument], strerror(errno));
+		error = true;
+	    }
+	    if (!error)
+	    {
+		*configs = mh_realloc(*configs, (*configs_count + 1) * sizeof(tonemap_config_t));
+		(*configs)[(*configs_count)++] = c;
+	    }
+	}
+	free(line_argv);
+	free(line);
+    }
+    if (!error && ferror(f))
+    {
+	mh_msg_err("Cannot read batch file: %s", strerror(errno));
+	error = true;
+    }
+    if (!error && *configs_count == 0)
+    {
+	mh_msg_err("Batch file contains no configurations");
+	error = true;
+    }
+    return !error;
+}
+
+/* Gets the luminance statistics of the current frame for the given maximum
+ * absolute luminance. Statistics that were already computed for the current
+ * frame are reused. */
+static const tonemap_statistics_t *tonemap_get_statistics(cvl_frame_t *frame, float max_abs_lum,
+	tonemap_statistics_t *statistics, int *statistics_count)
+{
+    for (int i = 0; i < *statistics_count; i++)
+    {
+	if (statistics[i].max_abs_lum == max_abs_lum)
+	{
+	    return &(statistics[i]);
+	}
+    }
+    tonemap_statistics_t *s = &(statistics[(*statistics_count)++]);
+    s->max_abs_lum = max_abs_lum;
+    cvl_lum_statistics(frame, max_abs_lum, &s->min_lum, &s->max_lum, &s->avg_lum, &s->log_avg_lum, s->channel_avg);
+    return s;
+}
+
+/* Applies the tone mapping configuration c to frame. The temporary frames rgb
+ * and tmp depend only on the frame, so they are created when they are first
+ * needed and then shared by all configurations. */
+static void tonemap_apply(tonemap_config_t *c, cvl_frame_t *tonemapped_frame, cvl_frame_t *frame,
+	const tonemap_statistics_t *s, cvl_frame_t **rgb, cvl_frame_t **tmp)
+{
+    if ((c->method.value == TM_REINHARD05) && !*rgb)
+    {
+	*rgb = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
+		3, CVL_RGB, CVL_FLOAT, CVL_TEXTURE);
+	cvl_convert_format(*rgb, frame);
+    }
+    if ((c->method.value == TM_ASHIKHMIN02 || c->method.value == TM_DURAND02 
+		|| c->method.value == TM_REINHARD02) && !*tmp)
+    {
+	*tmp = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
+		4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
+    }
+
+    if (c->no_lut.value && c->method.value == TM_SCHLICK94)
+    {
+	cvl_tonemap_schlick94(tonemapped_frame, frame, c->schlick94_p.value);
+    }
+    else if (c->no_lut.value && c->method.value == TM_TUMBLIN99)
+    {
+	cvl_tonemap_tumblin99(tonemapped_frame, frame, c->max_abs_lum.value,
+		s->log_avg_lum, c->tr99_disp_adapt_level.value, c->tr99_max_contrast.value);
+    }
+    else if (c->no_lut.value && c->method.value == TM_DRAGO03)
+    {
+	cvl_tonemap_drago03(tonemapped_frame, frame, c->max_abs_lum.value, 
+		c->drago03_bias.value, c->drago03_max_disp_lum.value);
+    }
+    else if (c->method.value == TM_SCHLICK94)
+    {
+	if (!c->lut_valid)
+	{
+	    cvl_tonemap_lut_schlick94(c->lut, c->schlick94_p.value);
+	    c->lut_valid = true;
+	}
+	cvl_tonemap_lut(tonemapped_frame, frame, c->lut);
+    }
+    else if (c->method.value == TM_TUMBLIN99)
+    {
+	if (!c->lut_valid || s->log_avg_lum != c->lut_log_avg_lum)
+	{
+	    cvl_tonemap_lut_tumblin99(c->lut, c->max_abs_lum.value,
+		    s->log_avg_lum, c->tr99_disp_adapt_level.value, c->tr99_max_contrast.value);
+	    c->lut_valid = true;
+	    c->lut_log_avg_lum = s->log_avg_lum;
+	}
+	cvl_tonemap_lut(tonemapped_frame, frame, c->lut);
+    }
+    else if (c->method.value == TM_DRAGO03)
+    {
+	if (!c->lut_valid)
+	{
+	    cvl_tonemap_lut_drago03(c->lut, c->max_abs_lum.value, 
+		    c->drago03_bias.value, c->drago03_max_disp_lum.value);
+	    c->lut_valid = true;
+	}
+	cvl_tonemap_lut(tonemapped_frame, frame, c->lut);
+    }
+    else if (c->method.value == TM_REINHARD05)
+    {
+	cvl_tonemap_reinhard05(tonemapped_frame, frame,
+		s->min_lum, s->avg_lum, s->log_avg_lum, *rgb, s->channel_avg,
+		c->reinhard05_intensity.value,
+		c->reinhard05_chroma_adapt.value,
+		c->reinhard05_light_adapt.value);
+    }
+    else if (c->method.value == TM_ASHIKHMIN02)
+    {
+	cvl_tonemap_ashikhmin02(tonemapped_frame, frame,
+		s->min_lum * c->max_abs_lum.value, c->max_abs_lum.value, *tmp, 
+		c->ashikhmin02_local_contrast.value);
+    }
+    else if (c->method.value == TM_DURAND02)
+    {
+	cvl_tonemap_durand02(tonemapped_frame, frame, c->max_abs_lum.value, *tmp,
+		cvl_gauss_sigma_to_k(c->durand02_sigma_spatial.value),
+		c->durand02_sigma_spatial.value,
+		c->durand02_sigma_luminance.value,
+		c->durand02_base_contrast.value);
+    }
+    else if (c->method.value == TM_REINHARD02)
+    {
+	cvl_tonemap_reinhard02(tonemapped_frame, frame, *tmp, s->log_avg_lum,
+		c->reinhard02_key_value.value, c->reinhard02_white.value, 
+		c->reinhard02_sharpness.value, c->reinhard02_epsilon.value);
+    }
+}
+
+
+int cmd_tonemap(int argc, char *argv[])
+{
+    tonemap_config_t defaults;
+    mh_option_file_t batch = { NULL, "r", false };
+    tonemap_config_t *configs = NULL;
+    int configs_count = 0;
     cvl_stream_type_t stream_type;
     cvl_format_t format;
     cvl_frame_t *frame, *tonemapped_frame;
@@ -127,13 +439,46 @@ int cmd_tonemap(int argc, char *argv[])
     float tmp_max_abs_lum;
 
     mh_msg_set_command_name("%s", argv[0]);    
-    if (!mh_getopt(argc, argv, options, 0, 0, NULL))
+    tonemap_config_init(&defaults);
+    if (!tonemap_getopt(argc, argv, &defaults, &batch, 0, NULL))
     {
 	return 1;
     }
 
     bool error = false;
-    while (!cvl_error())
+    if (batch.value)
+    {
+	error = !tonemap_read_batch(batch.value, argv[0], &defaults, &configs, &configs_count);
+	fclose(batch.value);
+    }
+    else if (defaults.method.value < 0)
+    {
+	mh_msg_err("option --method (-m) is mandatory");
+	error = true;
+    }
+    else
+    {
+	configs = mh_alloc(sizeof(tonemap_config_t));
+	configs[0] = defaults;
+	configs[0].output = stdout;
+	configs_count = 1;
+    }
+    for (int i = 0; !error && i < configs_count; i++)
+    {
+	tonemap_config_t *c = &(configs[i]);
+	if (c->method.value == TM_TUMBLIN99 || c->method.value == TM_REINHARD05
+		|| c->method.value == TM_ASHIKHMIN02 || c->method.value == TM_REINHARD02)
+	{
+	    c->adaptation = cvl_lum_adaptation_new(c->adaptation_time.value);
+	}
+	if (!c->no_lut.value && (c->method.value == TM_SCHLICK94 
+		    || c->method.value == TM_TUMBLIN99 || c->method.value == TM_DRAGO03))
+	{
+	    c->lut = cvl_frame_new(4096, 1, 1, CVL_LUM, CVL_FLOAT, CVL_MEM);
+	}
+    }
+
+    while (!error && !cvl_error())
     {
 	cvl_read(stdin, &stream_type, &frame);
 	if (!frame)
@@ -150,102 +495,58 @@ int cmd_tonemap(int argc, char *argv[])
 	}
 	luminance_tag = cvl_taglist_get(cvl_frame_taglist(frame), "LUMINANCE");
 	cvl_reduce(frame, CVL_REDUCE_MAX, 1, &tmp_max_abs_lum);
-	if (tmp_max_abs_lum > 1.001 || (luminance_tag && strcmp(luminance_tag, "ABSOLUTE")))
+	bool absolute = (tmp_max_abs_lum > 1.001 || (luminance_tag && strcmp(luminance_tag, "ABSOLUTE")));
+	if (absolute)
 	{
 	    cvl_frame_t *tmpframe = cvl_frame_new_tpl(frame);
 	    cvl_luminance_range(tmpframe, frame, 0.0f, tmp_max_abs_lum);
 	    cvl_frame_free(frame);
 	    frame = tmpframe;
-	    if (max_abs_lum.value < 0.0f)
-	    {
-		max_abs_lum.value = tmp_max_abs_lum;
-	    }
-	}
-	else if (max_abs_lum.value < 0.0f)
-	{
-	    max_abs_lum.value = 150.0f;
-	}
-	tonemapped_frame = cvl_frame_new_tpl(frame);
-	if (method.value == TM_SCHLICK94)
-	{
-	    cvl_tonemap_schlick94(tonemapped_frame, frame, schlick94_p.value);
-	}
-	else if (method.value == TM_TUMBLIN99)
-	{
-	    cvl_frame_t *tmp = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame), 
-		    1, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
-	    float log_avg_lum = cvl_log_avg_lum(frame, tmp, max_abs_lum.value);
-	    cvl_frame_free(tmp);
-	    cvl_tonemap_tumblin99(tonemapped_frame, frame, max_abs_lum.value,
-		    log_avg_lum, tr99_disp_adapt_level.value, tr99_max_contrast.value);
-	}
-	else if (method.value == TM_DRAGO03)
-	{
-	    cvl_tonemap_drago03(tonemapped_frame, frame, max_abs_lum.value, 
-		    drago03_bias.value, drago03_max_disp_lum.value);
-	}
-	else if (method.value == TM_REINHARD05)
-	{
-  	    float min_lum;
-  	    float avg_lum;
- 	    float log_avg_lum;
-	    float channel_avg[4];
-	    cvl_frame_t *tmpframe = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
-		    3, CVL_RGB, CVL_FLOAT, CVL_TEXTURE);
-	    cvl_reduce(frame, CVL_REDUCE_MIN, 1, &min_lum);
-	    cvl_reduce(frame, CVL_REDUCE_SUM, 1, &avg_lum);
-	    avg_lum /= (float)cvl_frame_size(frame);
-	    log_avg_lum = cvl_log_avg_lum(frame, tmpframe, 1.0f);
-	    cvl_convert_format(tmpframe, frame);
-	    cvl_reduce(tmpframe, CVL_REDUCE_SUM, -1, channel_avg);
-	    channel_avg[0] /= (float)cvl_frame_size(frame);
-	    channel_avg[1] /= (float)cvl_frame_size(frame);
-	    channel_avg[2] /= (float)cvl_frame_size(frame);
-            cvl_tonemap_reinhard05(tonemapped_frame, frame,
-		    min_lum, avg_lum, log_avg_lum, tmpframe, channel_avg,
-		    reinhard05_intensity.value,
-		    reinhard05_chroma_adapt.value,
-		    reinhard05_light_adapt.value);
-	    cvl_frame_free(tmpframe);
-	}
-	else if (method.value == TM_ASHIKHMIN02)
-	{
-	    cvl_frame_t *tmpframe = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
-		    4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
-	    float min_abs_lum;
-	    cvl_reduce(frame, CVL_REDUCE_MIN, 1, &min_abs_lum);
-	    min_abs_lum *= max_abs_lum.value;
-	    cvl_tonemap_ashikhmin02(tonemapped_frame, frame,
-	    	    min_abs_lum, max_abs_lum.value, tmpframe, ashikhmin02_local_contrast.value);
-	    cvl_frame_free(tmpframe);
 	}
-	else if (method.value == TM_DURAND02)
-	{
-	    cvl_frame_t *tmp = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame), 
-		    4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
-	    // Limit kernel size to 9x9 because the graphics card cannot handle more
-	    cvl_tonemap_durand02(tonemapped_frame, frame, max_abs_lum.value, tmp,
-		    mh_mini(4, cvl_gauss_sigma_to_k(durand02_sigma_spatial.value)),
-		    durand02_sigma_spatial.value,
-		    durand02_sigma_luminance.value,
-		    durand02_base_contrast.value);
-	    cvl_frame_free(tmp);
-	}
-	else if (method.value == TM_REINHARD02)
+
+	tonemap_statistics_t statistics[configs_count];
+	int statistics_count = 0;
+	cvl_frame_t *rgb = NULL;
+	cvl_frame_t *tmp = NULL;
+	for (int i = 0; i < configs_count && !cvl_error(); i++)
 	{
-	    cvl_frame_t *tmpframe = cvl_frame_new(cvl_frame_width(frame), cvl_frame_height(frame),
-		    4, CVL_UNKNOWN, CVL_FLOAT, CVL_TEXTURE);
-	    float log_avg_lum = cvl_log_avg_lum(frame, tmpframe, 1.0f);
-	    cvl_tonemap_reinhard02(tonemapped_frame, frame, tmpframe, log_avg_lum,
-		    reinhard02_key_value.value, reinhard02_white.value, 
-		    reinhard02_sharpness.value, reinhard02_epsilon.value);
-	    cvl_frame_free(tmpframe);
+	    tonemap_config_t *c = &(configs[i]);
+	    tonemap_statistics_t adapted;
+	    if (c->max_abs_lum.value < 0.0f)
+	    {
+		c->max_abs_lum.value = (absolute ? tmp_max_abs_lum : 150.0f);
+	    }
+	    if (c->adaptation)
+	    {
+		const tonemap_statistics_t *s = tonemap_get_statistics(frame, 
+			c->method.value == TM_TUMBLIN99 ? c->max_abs_lum.value : 1.0f,
+			statistics, &statistics_count);
+		cvl_lum_adaptation_put_statistics(c->adaptation, 
+			s->min_lum, s->max_lum, s->avg_lum, s->log_avg_lum, s->channel_avg);
+		cvl_lum_adaptation_get(c->adaptation, &adapted.min_lum, &adapted.max_lum, 
+			&adapted.avg_lum, &adapted.log_avg_lum, adapted.channel_avg);
+	    }
+	    tonemapped_frame = cvl_frame_new_tpl(frame);
+	    tonemap_apply(c, tonemapped_frame, frame, &adapted, &rgb, &tmp);
+	    cvl_convert_format_inplace(tonemapped_frame, format);
+	    cvl_write(c->output, stream_type, tonemapped_frame);
+	    cvl_frame_free(tonemapped_frame);
 	}
+	cvl_frame_free(rgb);
+	cvl_frame_free(tmp);
 	cvl_frame_free(frame);
-	cvl_convert_format_inplace(tonemapped_frame, format);
-	cvl_write(stdout, stream_type, tonemapped_frame);
-	cvl_frame_free(tonemapped_frame);
     }
 
+    for (int i = 0; i < configs_count; i++)
+    {
+	cvl_frame_free(configs[i].lut);
+	cvl_lum_adaptation_free(configs[i].adaptation);
+	if (configs[i].output != stdout && fclose(configs[i].output) != 0 && !error)
+	{
+	    mh_msg_err("Output error: %s", strerror(errno));
+	    error = true;
+	}
+    }
+    free(configs);
     return (cvl_error() || error) ? 1 : 0;
 }
@@ -35,8 +35,8 @@
 void cmd_wavelets_print_help(void)
 {
     mh_msg_fmt_req(
-	    "wavelets -t|--task=dwt -D|--daubechies=<D> -l|--level=<l>\n"
-	    "wavelets -t|--task=idwt -D|--daubechies=<D> -l|--level=<l>\n"
+	    "wavelets -t|--task=dwt -D|--daubechies=<D> -l|--level=<l> [-m|--method=auto|gpu|cpu]\n"
+	    "wavelets -t|--task=idwt -D|--daubechies=<D> -l|--level=<l> [-m|--method=auto|gpu|cpu]\n"
 	    "wavelets -t|--task=hard-thresholding -l|--level=<l> -T|--threshold=<t>\n"
 	    "wavelets -t|--task=soft-thresholding -l|--level=<l> -T|--threshold=<t>\n"
 	    "\n"
@@ -44,6 +44,9 @@ void cmd_wavelets_print_help(void)
 	    "transformed data.\n"
 	    "The parameter D chooses the Daubechies wavelet (D2, ..., D20; only even numbers). The level l must be at least 1. "
 	    "The threshold parameter for hard and soft thresholding is applied to all input channels. "
+	    "Frames of any size are accepted. "
+	    "The gpu method requires the width and height to be divisible by 2^l, the cpu method accepts any size. "
+	    "The default is auto, which uses the gpu method whenever possible. "
 	    "The output of this command is always of type float; it has to be manually converted if necessary.");
 }
 
@@ -62,12 +65,15 @@ int cmd_wavelets(int argc, char *argv[])
     mh_option_int_t D = { -1, 2, 20 };
     mh_option_int_t level = { -1, 1, INT_MAX };
     mh_option_float_t threshold = { -FLT_MAX, -FLT_MAX, false, FLT_MAX, true };
+    const char *method_names[] = { "auto", "gpu", "cpu", NULL };
+    mh_option_name_t method = { 0, method_names };
     mh_option_t options[] = 
     {
 	{ "task",       't', MH_OPTION_NAME,  &task,      true  },
 	{ "daubechies", 'D', MH_OPTION_INT,   &D,         false },
 	{ "level",      'l', MH_OPTION_INT,   &level,     true  },
 	{ "threshold",  'T', MH_OPTION_FLOAT, &threshold, false },
+	{ "method",     'm', MH_OPTION_NAME,  &method,    false },
 	mh_option_null
     };
     cvl_frame_t *inframe, *outframe, *tmpframe;
@@ -98,6 +104,11 @@ int cmd_wavelets(int argc, char *argv[])
 	mh_msg_err("Task %s requires parameter 'threshold'", task_names[task.value]);
 	return 1;
     }
+    if ((task.value == TASK_HT || task.value == TASK_ST) && method.value != CVL_WAVELETS_AUTO)
+    {
+	mh_msg_err("Invalid parameter 'method' for task %s", task_names[task.value]);
+	return 1;
+    }
 
     bool error = false;
     while (!cvl_error())
@@ -105,6 +116,16 @@ int cmd_wavelets(int argc, char *argv[])
 	cvl_read(stdin, NULL, &inframe);
 	if (!inframe)
 	    break;
+	if (method.value == CVL_WAVELETS_GPU
+		&& (level.value >= 31
+		    || cvl_frame_width(inframe) % (1 << level.value) != 0
+		    || cvl_frame_height(inframe) % (1 << level.value) != 0))
+	{
+	    mh_msg_err("Method gpu requires width and height to be divisible by 2^%d", level.value);
+	    cvl_frame_free(inframe);
+	    error = true;
+	    break;
+	}
 
 	outframe = cvl_frame_new(cvl_frame_width(inframe), cvl_frame_height(inframe),
 		cvl_frame_channels(inframe), cvl_frame_format(inframe), CVL_FLOAT, CVL_TEXTURE);
@@ -112,13 +133,15 @@ int cmd_wavelets(int argc, char *argv[])
 	if (task.value == TASK_DWT)
 	{
 	    tmpframe = cvl_frame_new_tpl(outframe);
-	    cvl_wavelets_dwt(outframe, inframe, tmpframe, D.value, level.value);
+	    cvl_wavelets_dwt_using(outframe, inframe, tmpframe, D.value, level.value,
+		    (cvl_wavelets_method_t)method.value);
 	    cvl_frame_free(tmpframe);
 	}
 	else if (task.value == TASK_IDWT)
 	{
 	    tmpframe = cvl_frame_new_tpl(outframe);
-	    cvl_wavelets_idwt(outframe, inframe, tmpframe, D.value, level.value);
+	    cvl_wavelets_idwt_using(outframe, inframe, tmpframe, D.value, level.value,
+		    (cvl_wavelets_method_t)method.value);
 	    cvl_frame_free(tmpframe);
 	}
 	else if (task.value == TASK_HT)
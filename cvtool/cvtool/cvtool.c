@@ -35,9 +35,12 @@
 #include <cvl/cvl.h>
 
 #include "mh.h"
+#include "cvtool.h"
 
 
 char *program_name;
+const char *cvtool_display_name = NULL;
+int cvtool_jobs = 1;
 
 /*
  * The command functions. All live in their own .c file (except for the trivial
@@ -61,6 +64,7 @@ typedef struct
 #define COMMAND(NAME)  { #NAME, cmd_ ## NAME, cmd_ ## NAME ## _print_help }
 
 COMMAND_DECL(affine)
+COMMAND_DECL(bilateral)
 COMMAND_DECL(blend)
 COMMAND_DECL(channelcombine)
 COMMAND_DECL(channelextract)
@@ -106,6 +110,7 @@ COMMAND_DECL(wavelets)
 cvtool_command_t commands[] = 
 {
     COMMAND(affine),
+    COMMAND(bilateral),
     COMMAND(blend),
     COMMAND(channelcombine),
     COMMAND(channelextract),
@@ -156,6 +161,71 @@ cvtool_command_t commands[] =
  * this line.
  */
 
+bool cvtool_process_frames(cvl_parallel_func_t func, void *data)
+{
+    cvl_stream_type_t stream_type;
+    cvl_frame_t *frame;
+
+    if (cvtool_jobs <= 1)
+    {
+	while (!cvl_error())
+	{
+	    cvl_read(stdin, &stream_type, &frame);
+	    if (!frame)
+		break;
+	    frame = func(frame, data);
+	    cvl_write(stdout, stream_type, frame);
+	    cvl_frame_free(frame);
+	}
+    }
+    else
+    {
+	cvl_parallel_t *parallel = cvl_parallel_new(cvtool_display_name, cvtool_jobs, func, data);
+	while (!cvl_error())
+	{
+	    cvl_read(stdin, &stream_type, &frame);
+	    if (!frame)
+		break;
+	    cvl_parallel_put(parallel, frame);
+	    // Keep at most two frames per job in flight, and write results as
+	    // soon as they are available.
+	    while ((frame = cvl_parallel_get(parallel, cvl_parallel_pending(parallel) >= 2 * cvtool_jobs)))
+	    {
+		cvl_write(stdout, stream_type, frame);
+		cvl_frame_free(frame);
+	    }
+	}
+	while (!cvl_error() && (frame = cvl_parallel_get(parallel, true)))
+	{
+	    cvl_write(stdout, stream_type, frame);
+	    cvl_frame_free(frame);
+	}
+	cvl_parallel_free(parallel);
+    }
+    return !cvl_error();
+}
+
+bool cvtool_process_frames_temporal(cvl_temporal_filter_t *filter)
+{
+    cvl_stream_type_t stream_type;
+    cvl_frame_t *frame;
+    bool eof = false;
+
+    while (!eof && !cvl_error())
+    {
+	cvl_read(stdin, &stream_type, &frame);
+	eof = !frame;
+	cvl_temporal_filter_put(filter, frame);
+	cvl_frame_free(frame);
+	while ((frame = cvl_temporal_filter_get(filter)))
+	{
+	    cvl_write(stdout, stream_type, frame);
+	    cvl_frame_free(frame);
+	}
+    }
+    return !cvl_error();
+}
+
 int cmd_strcmp(const cvtool_command_t *c1, const cvtool_command_t *c2)
 {
     return strcmp(c1->name, c2->name);
@@ -215,7 +285,7 @@ int cmd_help(int argc, char *argv[])
     if (argc == 1)
     {
 	mh_msg_fmt_req(
-		"Usage: %s [-q|--quiet] [-v|--verbose] <command> [argument...]\n"
+		"Usage: %s [-q|--quiet] [-v|--verbose] [-j|--jobs=<n>] [--profile] [--trace=<file>] <command> [argument...]\n"
 		"\n"
 		"Available commands:\n",
 		program_name);
@@ -250,6 +320,63 @@ int cmd_help(int argc, char *argv[])
     }
 }
 
+static bool parse_jobs(const char *s, int *jobs)
+{
+    char *p;
+    long value;
+
+    errno = 0;
+    value = strtol(s, &p, 10);
+    if (p == s || *p != '\0' || errno == ERANGE || value < 1 || value > 256)
+	return false;
+#if !HAVE_PTHREAD
+    if (value > 1)
+    {
+	mh_msg_wrn("POSIX threads are not available; using 1 job");
+	value = 1;
+    }
+#endif
+    *jobs = value;
+    return true;
+}
+
+static void print_profile(void)
+{
+    int ops = cvl_profile_ops();
+    cvl_profile_op_t op[ops > 0 ? ops : 1];
+    double wall_time = 0.0;
+
+    for (int i = 0; i < ops; i++)
+    {
+	cvl_profile_op(i, &(op[i]));
+	wall_time += op[i].wall_time;
+    }
+    /* Sort by wall time, highest first */
+    for (int i = 1; i < ops; i++)
+    {
+	cvl_profile_op_t tmp = op[i];
+	int j;
+	for (j = i; j > 0 && op[j - 1].wall_time < tmp.wall_time; j--)
+	    op[j] = op[j - 1];
+	op[j] = tmp;
+    }
+    mh_msg_inf("%10s %10s %10s %10s %10s  %s", 
+	    "calls", "wall ms", "gpu ms", "Mpixel", "MB", "operation");
+    for (int i = 0; i < ops; i++)
+    {
+	char gpu_time[32];
+	if (op[i].gpu_time < 0.0)
+	    strcpy(gpu_time, "-");
+	else
+	    snprintf(gpu_time, sizeof(gpu_time), "%.3f", op[i].gpu_time * 1000.0);
+	mh_msg_inf("%10d %10.3f %10s %10.3f %10.3f  %s", 
+		op[i].calls, op[i].wall_time * 1000.0, gpu_time,
+		(double)op[i].pixels / 1e6, (double)op[i].bytes / (1024.0 * 1024.0),
+		op[i].name);
+    }
+    mh_msg_inf("%10s %10.3f %10s %10s %10s  %s", "", wall_time * 1000.0, "", "", "", "total");
+}
+
 int main(int argc, char *argv[])
 {
     int exitcode = 0;
@@ -292,24 +419,65 @@ int main(int argc, char *argv[])
     else
     {
 	int argv_cmd_index = 1;
-	if (argc > argv_cmd_index + 1 && (strcmp(argv[argv_cmd_index], "-q") == 0 
-		    || strcmp(argv[argv_cmd_index], "--quiet") == 0))
+	const char *jobs_arg = NULL;
+	bool profile = false;
+	const char *trace_arg = NULL;
+	FILE *trace_file = NULL;
+	while (argc > argv_cmd_index + 1 && argv[argv_cmd_index][0] == '-')
 	{
-	    argv_cmd_index++;
-	    mh_msg_set_output_level(MH_MSG_WRN);
+	    if (strcmp(argv[argv_cmd_index], "-q") == 0 
+		    || strcmp(argv[argv_cmd_index], "--quiet") == 0)
+	    {
+		argv_cmd_index++;
+		mh_msg_set_output_level(MH_MSG_WRN);
+	    }
+	    else if (strcmp(argv[argv_cmd_index], "-v") == 0 
+		    || strcmp(argv[argv_cmd_index], "--verbose") == 0)
+	    {
+		argv_cmd_index++;
+		mh_msg_set_output_level(MH_MSG_DBG);
+	    }
+	    else if (strcmp(argv[argv_cmd_index], "-j") == 0 && argc > argv_cmd_index + 2)
+	    {
+		jobs_arg = argv[argv_cmd_index + 1];
+		argv_cmd_index += 2;
+	    }
+	    else if (strncmp(argv[argv_cmd_index], "--jobs=", 7) == 0)
+	    {
+		jobs_arg = argv[argv_cmd_index] + 7;
+		argv_cmd_index++;
+	    }
+	    else if (strcmp(argv[argv_cmd_index], "--profile") == 0)
+	    {
+		profile = true;
+		argv_cmd_index++;
+	    }
+	    else if (strncmp(argv[argv_cmd_index], "--trace=", 8) == 0)
+	    {
+		trace_arg = argv[argv_cmd_index] + 8;
+		argv_cmd_index++;
+	    }
+	    else
+	    {
+		break;
+	    }
 	}
-	if (argc > argv_cmd_index + 1 && (strcmp(argv[argv_cmd_index], "-v") == 0 
-		    || strcmp(argv[argv_cmd_index], "--verbose") == 0))
+	int cmd_index = cmd_find(argv[argv_cmd_index]);
+	if (jobs_arg && !parse_jobs(jobs_arg, &cvtool_jobs))
 	{
-    	    argv_cmd_index++;
-	    mh_msg_set_output_level(MH_MSG_DBG);
+	    mh_msg_err("invalid number of jobs: %s", jobs_arg);
+	    exitcode = 1;
 	}
-	int cmd_index = cmd_find(argv[argv_cmd_index]);
-	if (cmd_index < 0)
+	else if (cmd_index < 0)
 	{
 	    mh_msg_err("command unknown: %s", argv[argv_cmd_index]);
 	    exitcode = 1;
 	}
+	else if (trace_arg && !(trace_file = fopen(trace_arg, "w")))
+	{
+	    mh_msg_err("cannot open %s: %s", trace_arg, strerror(errno));
+	    exitcode = 1;
+	}
     	else if (commands[cmd_index].cmd == cmd_help || commands[cmd_index].cmd == cmd_version)
 	{
 	    /* Do not cretae a GL context for these simple commands */
@@ -329,6 +497,7 @@ int main(int argc, char *argv[])
 	    else
 #endif
 	    {
+		cvtool_display_name = display_name;
 		cvl_gl_context_t *ctx = cvl_gl_context_new(display_name);
 		if (!ctx)
 		{
@@ -346,7 +515,15 @@ int main(int argc, char *argv[])
 		    if (!cvl_error())
 		    {
 			cvl_initialized = true;
+			if (profile)
+			    cvl_profile_enable(true);
+			if (trace_file)
+			    cvl_profile_trace_start(trace_file);
 			exitcode = commands[cmd_index].cmd(argc - argv_cmd_index, &(argv[argv_cmd_index]));
+			if (trace_file)
+			    cvl_profile_trace_stop();
+			if (cvl_profile_enabled())
+			    print_profile();
 		    }
 		    if (cvl_error())
 		    {
@@ -361,6 +538,11 @@ int main(int argc, char *argv[])
 		}
 	    }
 	}
+	if (trace_file && fclose(trace_file) != 0)
+	{
+	    mh_msg_err("cannot write %s: %s", trace_arg, strerror(errno));
+	    exitcode = 1;
+	}
     }
     return exitcode;
 }
@@ -0,0 +1,46 @@
+/*
+ * cvtool.h
+ *
+ * This file is part of cvtool, a computer vision tool.
+ *
+ * Copyright (C) 2010  Martin Lambers <marlam@marlam.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CVTOOL_H
+#define CVTOOL_H
+
+#include <stdbool.h>
+
+#include <cvl/cvl.h>
+
+/* The X display that cvtool uses (NULL on W32). */
+extern const char *cvtool_display_name;
+
+/* The number of parallel jobs requested with --jobs. */
+extern int cvtool_jobs;
+
+/* Read all frames from stdin, process each with func, and write the results
+ * to stdout. The function takes ownership of its frame and returns the
+ * result. The frames are independent of each other, so they are distributed
+ * to cvtool_jobs parallel CVL contexts if more than one job was requested.
+ * Returns false on error. */
+bool cvtool_process_frames(cvl_parallel_func_t func, void *data);
+
+/* Read all frames from stdin, pass them through the temporal filter, and
+ * write the results to stdout. Returns false on error. */
+bool cvtool_process_frames_temporal(cvl_temporal_filter_t *filter);
+
+#endif
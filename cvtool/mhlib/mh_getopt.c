@@ -588,6 +588,8 @@ bool mh_getopt(int argc, char *argv[], mh_option_t *options,
     }
     error = false;
     opterr = 0;
+    /* Reinitialize getopt_long(), so that mh_getopt() can be called more than once. */
+    optind = 0;
     while (!error)
     {
 	int optval = getopt_long(argc, argv, shortopts, longopts, NULL);
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+
+. $CVTOOL_TESTS_COMMON
+
+cmd_tests_init
+
+$CVTOOL create -w 50 -h 40 -c 0x336699 > c.pnm 
+
+$CVTOOL bilateral -s 1 -r 0.1 < c.pnm > x.pnm
+cmp c.pnm x.pnm 
+$CVTOOL bilateral -s 8 -r 0.2 < c.pnm > y.pnm
+cmp c.pnm y.pnm 
+
+# A step edge from 50 to 200 with uniform noise of +-20: the flat areas must be
+# smoothed, and the edge must be preserved, which a Gauss filter would not do
+for size in 64x48 320x240; do
+	LC_ALL=C awk -v w=${size%x*} -v h=${size#*x} 'BEGIN {
+		srand(7);
+		printf "P5\n%d %d\n255\n", w, h > "step.pgm";
+		printf "P5\n%d %d\n255\n", w, h > "noisy.pgm";
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++) {
+				v = (x < w / 2 ? 50 : 200);
+				printf "%c", v > "step.pgm";
+				printf "%c", v - 20 + int(rand() * 41) > "noisy.pgm";
+			}
+	}'
+	$CVTOOL bilateral -s 4 -r 0.1 < noisy.pgm > s.pgm
+	$CVTOOL diff -s -o - step.pgm s.pgm > sdiff.txt
+	grep 'maximum error' sdiff.txt | awk '{ if ($7 > 0.04) exit 1 }'
+	grep 'mean error' sdiff.txt | awk '{ if ($7 > 0.015) exit 1 }'
+done
+
+# This grid would be too large for a texture with the sigma values as sampling
+# distances, so it must be sampled more coarsely. The range sigma is below the
+# noise level, so the noise is kept.
+$CVTOOL bilateral -s 1 -r 0.004 < noisy.pgm > n.pgm
+$CVTOOL diff -s -o - step.pgm n.pgm > ndiff.txt
+grep 'maximum error' ndiff.txt | awk '{ if ($7 > 0.08) exit 1 }'
+
+cmd_tests_cleanup
@@ -19,4 +19,119 @@ cmp 123.pnm x123.pnm
 $CVTOOL convolve -K 3x3x3:1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 < rgb.pnm > y123.pnm 
 cmp 123.pnm y123.pnm 
 
+# temporal kernel larger than the number of texture units
+$CVTOOL merge -o merge3.txt 2.pnm 2.pnm 2.pnm > 222.pnm 
+ones=1
+for i in `seq 80`; do ones=$ones,1; done
+$CVTOOL convolve -X 1:1 -Y 1:1 -T 81:$ones < 222.pnm > x222.pnm 
+cmp 222.pnm x222.pnm 
+$CVTOOL convolve -K 81x1x1:$ones < 222.pnm > y222.pnm 
+cmp 222.pnm y222.pnm 
+
+# A temporal kernel of 81 taps is passed as a texture array. Its center 9 taps
+# have distinct weights and all others are zero, so on a stream of distinct
+# frames it must give the same result as the 9 tap kernel, which uses one
+# texture per frame. This checks the order of the layers. The streams have
+# three channels and two channels (of unknown format).
+for s in `seq 12`; do cmd_tests_random 16 12 3 $s; done | $CVTOOL convert -t float > rgb12.pfs
+for s in 1 2; do
+	LC_ALL=C awk -v s=$s 'BEGIN { srand(s); for (i = 0; i < 12 * 16 * 12; i++) print int(rand() * 256) / 256 }' \
+		| cmd_tests_pfs 16 12 > ch$s.pfs
+done
+$CVTOOL channelcombine ch1.pfs ch2.pfs > uv12.pfs
+t9=1,2,3,4,5,6,7,8,9
+t81=0
+for i in `seq 35`; do t81=$t81,0; done
+t81=$t81,$t9
+for i in `seq 36`; do t81=$t81,0; done
+for f in rgb12.pfs uv12.pfs; do
+	$CVTOOL convolve -X 1:1 -Y 1:1 -T 9:$t9 < $f > t9.pfs
+	$CVTOOL convolve -X 1:1 -Y 1:1 -T 81:$t81 < $f > t81.pfs
+	$CVTOOL diff -s -o - t9.pfs t81.pfs | grep 'maximum error' \
+		| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 } END { if (NR != 12) exit 1 }'
+	$CVTOOL convolve -K 9x1x1:$t9 < $f > k9.pfs
+	$CVTOOL convolve -K 81x1x1:$t81 < $f > k81.pfs
+	$CVTOOL diff -s -o - k9.pfs k81.pfs | grep 'maximum error' \
+		| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 } END { if (NR != 12) exit 1 }'
+done
+
+# spatial kernels of rank 1 and 2, which are applied as separable kernels: a
+# pseudo random color frame and an asymmetric kernel with 11 rows and 15
+# columns, against the convolution computed by awk
+for rank in 1 2; do
+	LC_ALL=C awk -v w=31 -v h=27 -v kh=7 -v kv=5 -v rank=$rank 'BEGIN {
+		srand(5);
+		printf "P6\n%d %d\n255\n", w, h > "l.ppm";
+		printf "P6\n%d %d\n255\n", w, h > "lr.ppm";
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++)
+				for (i = 0; i < 3; i++) {
+					v[x, y, i] = int(rand() * 256);
+					printf "%c", v[x, y, i] > "l.ppm";
+				}
+		sum = 0;
+		for (r = -kv; r <= kv; r++)
+			for (c = -kh; c <= kh; c++) {
+				m[c, r] = (c + kh + 1) * (r + kv + 1);
+				if (rank == 2)
+					m[c, r] += (kh - c + 1) * ((r + kv) % 4 + 1);
+				sum += m[c, r];
+				printf "%s%d", (r == -kv && c == -kh ? "" : ","), m[c, r] > "lk.txt";
+			}
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++)
+				for (i = 0; i < 3; i++) {
+					s = 0;
+					for (r = -kv; r <= kv; r++)
+						for (c = -kh; c <= kh; c++)
+							s += m[c, r] * v[x + c < 0 ? 0 : x + c >= w ? w - 1 : x + c,
+								y + r < 0 ? 0 : y + r >= h ? h - 1 : y + r, i];
+					printf "%c", int(s / sum + 0.5) > "lr.ppm";
+				}
+	}'
+	$CVTOOL --trace=ltrace.json convolve -K 11x15:`cat lk.txt` < l.ppm > xl.ppm
+	grep "\"name\":\"cvl_convolve_lowrank_h_k=7_rank=$rank\"" ltrace.json > /dev/null
+	$CVTOOL diff -s -o - lr.ppm xl.ppm > ldiff.txt
+	grep 'maximum error' ldiff.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.005) exit 1 }'
+	# the decomposition is reused for the following frames of a stream
+	cat l.ppm l.ppm l.ppm | $CVTOOL convolve -K 11x15:`cat lk.txt` > xl3.ppm
+	cat xl.ppm xl.ppm xl.ppm | cmp - xl3.ppm
+done
+
+# spatial kernel large enough for the FFT path: pseudo random gray frames,
+# whose padded sizes use the GPU (64x64) and the CPU transform (50x50), and a
+# pseudo random 27x27 kernel, against the convolution computed by awk
+for size in 38x30 23x23; do
+	LC_ALL=C awk -v w=${size%x*} -v h=${size#*x} -v k=13 'BEGIN {
+		srand(3);
+		printf "P5\n%d %d\n255\n", w, h > "f.pgm";
+		printf "P5\n%d %d\n255\n", w, h > "fr.pgm";
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++) {
+				v[x, y] = int(rand() * 256);
+				printf "%c", v[x, y] > "f.pgm";
+			}
+		sum = 0;
+		for (r = -k; r <= k; r++)
+			for (c = -k; c <= k; c++) {
+				m[c, r] = 1 + int(rand() * 9);
+				sum += m[c, r];
+				printf "%s%d", (r == -k && c == -k ? "" : ","), m[c, r] > "k.txt";
+			}
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++) {
+				s = 0;
+				for (r = -k; r <= k; r++)
+					for (c = -k; c <= k; c++)
+						s += m[c, r] * v[x + c < 0 ? 0 : x + c >= w ? w - 1 : x + c,
+							y + r < 0 ? 0 : y + r >= h ? h - 1 : y + r];
+				printf "%c", int(s / sum + 0.5) > "fr.pgm";
+			}
+	}'
+	$CVTOOL --trace=ftrace.json convolve -K 27x27:`cat k.txt` < f.pgm > xf.pgm
+	grep '"name":"cvl_convolve_fft_multiply"' ftrace.json > /dev/null
+	$CVTOOL diff -s -o - fr.pgm xf.pgm > fdiff.txt
+	grep 'maximum error' fdiff.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.005) exit 1 }'
+done
+
 cmd_tests_cleanup
@@ -16,4 +16,9 @@ cmp r.pnm xr.pnm
 $CVTOOL flip < rgb.pnm > xbgr.pnm 
 cmp bgr.pnm xbgr.pnm 
 
+# Passes without a GL program are traced under the function name
+$CVTOOL --trace=trace.json flip < rgb.pnm > tbgr.pnm
+cmp bgr.pnm tbgr.pnm
+grep '"name":"cvl_flip"' trace.json > /dev/null
+
 cmd_tests_cleanup
@@ -14,4 +14,41 @@ $CVTOOL gauss -x 1 -y 2 --sigma-x=0.5 --sigma-y=1.0 < rgb.pnm > /dev/null
 $CVTOOL gauss -3 -k1 < rgb.pnm > /dev/null 
 $CVTOOL gauss -x 1 -y 2 -t 3 --sigma-x=0.5 --sigma-y=1.0 --sigma-t=1.5 < rgb.pnm > /dev/null 
 
+# large sigma (recursive filter) against the convolution
+$CVTOOL create -n 1 -w 40 -h 40 -c 0x0000ff | $CVTOOL resize -w 99 -h 99 -x 10 -y 50 -c 0xff0000 > sq.pnm
+$CVTOOL gauss -x 60 -y 60 --sigma-x=24 --sigma-y=24 < sq.pnm > iir.pnm
+$CVTOOL gauss -x 59 -y 59 --sigma-x=24 --sigma-y=24 < sq.pnm > fir.pnm
+$CVTOOL diff -s -o - iir.pnm fir.pnm > iirdiff.txt
+grep 'maximum error' iirdiff.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.02) exit 1 }'
+
+# sigma above the limit of a single recursive pass, against the convolution
+# and against two recursive passes with 36^2 + 48^2 = 60^2
+$CVTOOL create -n 1 -w 40 -h 40 -c 0x0000ff | $CVTOOL resize -w 199 -h 149 -x 30 -y 70 -c 0xff0000 \
+	| $CVTOOL convert -t float > sq2.pfs
+$CVTOOL gauss -x 150 -y 150 --sigma-x=60 --sigma-y=60 < sq2.pfs > iir2.pfs
+$CVTOOL gauss -x 149 -y 149 --sigma-x=60 --sigma-y=60 < sq2.pfs > fir2.pfs
+$CVTOOL diff -s -o - iir2.pfs fir2.pfs > iirdiff2.txt
+grep 'maximum error' iirdiff2.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.02) exit 1 }'
+$CVTOOL gauss -x 90 -y 90 --sigma-x=36 --sigma-y=36 < sq2.pfs \
+	| $CVTOOL gauss -x 120 -y 120 --sigma-x=48 --sigma-y=48 > iir3.pfs
+$CVTOOL diff -s -o - iir2.pfs iir3.pfs > iirdiff3.txt
+grep 'maximum error' iirdiff3.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.01) exit 1 }'
+
+cat r.pnm rgb.pnm g.pnm b.pnm rgb.pnm > stream.pnm
+$CVTOOL gauss -k2 < stream.pnm > s1.pnm
+$CVTOOL -j 3 gauss -k2 < stream.pnm > s3.pnm
+cmp s1.pnm s3.pnm
+$CVTOOL --profile gauss -k2 < stream.pnm > sp.pnm 2> profile.txt
+cmp s1.pnm sp.pnm
+grep 'calls *wall ms *gpu ms *Mpixel *MB *operation$' profile.txt > /dev/null
+# one horizontal and one vertical pass per frame
+awk '$NF == "cvl_convolve_separable_k=2" { passes = $4 }
+	$NF == "cvl_read" { reads = $4 }
+	END { exit (reads < 1 || passes != 2 * reads) }' profile.txt
+grep ' total$' profile.txt > /dev/null
+$CVTOOL --trace=trace.json gauss -k2 < stream.pnm > st.pnm
+cmp s1.pnm st.pnm
+grep '"name":"cvl_read","cat":"cvl","ph":"X"' trace.json > /dev/null
+grep '"frame":4' trace.json > /dev/null
+
 cmd_tests_cleanup
@@ -35,4 +35,283 @@ cmp t4s.txt xt4s.txt
 
 $CVTOOL info -S -s -o dummy.txt < t3.pnm
 
+$CVTOOL create -t uint8 -f lum   -n 1 -w   7 -h   3 -c white	> t5.pnm
+echo "STREAM=pnm CHANNELS=1 FORMAT=luminance TYPE=uint8 WIDTH=7 HEIGHT=3"	>  t5s.txt
+echo "CH0_MIN=1 CH0_MAX=1 CH0_MEAN=1 CH0_MEDIAN=1 CH0_STDDEVIATION=0"		>> t5s.txt
+$CVTOOL info -s -o xt5s.txt < t5.pnm
+cmp t5s.txt xt5s.txt
+
+# Non-constant data with an NPOT size, so that the fused reduction must combine
+# different values at the borders. The reference is computed from the bytes.
+LC_ALL=C awk 'BEGIN {
+	w = 13; h = 7; n = w * h;
+	srand(3);
+	printf "P6\n%d %d\n255\n", w, h > "t6.pnm";
+	for (i = 0; i < n; i++)
+		for (c = 0; c < 3; c++) {
+			v[c, i] = int(rand() * 256);
+			printf "%c", v[c, i] > "t6.pnm";
+		}
+	for (c = 0; c < 3; c++) {
+		min = 255; max = 0; sum = 0; sumsq = 0;
+		for (i = 0; i < n; i++) {
+			x = v[c, i] / 255;
+			if (v[c, i] < min) min = v[c, i];
+			if (v[c, i] > max) max = v[c, i];
+			sum += x; sumsq += x * x;
+			for (j = i; j > 0 && s[j - 1] > v[c, i]; j--)
+				s[j] = s[j - 1];
+			s[j] = v[c, i];
+		}
+		mean = sum / n;
+		stddev = sqrt((sumsq - sum * sum / n) / (n - 1));
+		printf "%.6f %.6f %.6f %.6f %.6f\n", min / 255, max / 255, mean, s[int(n / 2)] / 255, stddev > "t6s.txt";
+	}
+}'
+$CVTOOL info -s -o xt6s.txt < t6.pnm
+sed -n '2,$p' xt6s.txt | sed -e 's/CH[0-9]_[A-Z]*=//g' | paste -d ' ' - t6s.txt | awk '
+	{ for (i = 1; i <= 5; i++) { d = $i - $(i + 5); if (d < -0.0001 || d > 0.0001) exit 1 } }
+	END { if (NR != 3) exit 1 }'
+
+# All reduction modes, for all channels and for single channels, on a uint8
+# color frame and on a float frame with negative values. Some sizes are not
+# powers of two, so that the reduction steps must handle incomplete blocks. The
+# single pixel of the 1x1 float frame is negative to check the ABS* modes.
+modes="min min-greater-zero absmin absmin-greater-zero max absmax sum"
+for size in 1x1 1x7 13x7 37x29 64x1; do
+	LC_ALL=C awk -v w=${size%x*} -v h=${size#*x} -v modes="$modes" '
+	function put(v,   s, e, b, i) {
+		s = 0; e = 0; b = 0;
+		if (v < 0) { s = 1; v = -v; }
+		if (v != 0) {
+			while (v >= 2) { v /= 2; e++; }
+			while (v < 1) { v *= 2; e--; }
+			b = s * 2^31 + (e + 127) * 2^23 + (v - 1) * 2^23;
+		}
+		for (i = 0; i < 4; i++) { printf "%c", b % 256 > "f.pfs"; b = int(b / 256); }
+	}
+	function reduce(m, c, n,   r, i, x) {
+		r = "none";
+		for (i = 0; i < n; i++) {
+			x = v[c, i];
+			if (m ~ /^abs/ && x < 0) x = -x;
+			if (m == "sum") r = (r == "none" ? x : r + x);
+			else if (m ~ /greater-zero/ && x <= 0) continue;
+			else if (m ~ /min/ && (r == "none" || x < r)) r = x;
+			else if (m ~ /max/ && (r == "none" || x > r)) r = x;
+		}
+		return r;
+	}
+	BEGIN {
+		n = w * h; nm = split(modes, mode, " ");
+		srand(w * 100 + h);
+		printf "P6\n%d %d\n255\n", w, h > "r.pnm";
+		for (i = 0; i < n; i++)
+			for (c = 0; c < 3; c++) {
+				b = (rand() < 0.1 ? 0 : int(rand() * 256));
+				printf "%c", b > "r.pnm";
+				v[c, i] = b / 255;
+			}
+		for (m = 1; m <= nm; m++)
+			for (s = -1; s < 3; s++)
+				for (c = 0; c < 3; c++)
+					if (s == -1 || s == c)
+						print "r.pnm", mode[m], s, c, reduce(mode[m], c, n) > "ref.txt";
+		printf "PFS1\n%d %d\n1\n0\nY\n0\nENDH", w, h > "f.pfs";
+		for (i = 0; i < n; i++) {
+			v[0, i] = (rand() < 0.1 ? 0 : (int(rand() * 129) - 80) / 16);
+			if (n == 1)
+				v[0, i] = -1.5;
+			put(v[0, i]);
+		}
+		for (m = 1; m <= nm; m++)
+			for (s = -1; s < 1; s++)
+				print "f.pfs", mode[m], s, 0, reduce(mode[m], 0, n) > "ref.txt";
+	}'
+	rm -f got.txt
+	for f in r.pnm f.pfs; do
+		for mode in $modes; do
+			for s in -1 0 1 2; do
+				[ $f = f.pfs -a $s -gt 0 ] && continue
+				copt=""
+				[ $s -ge 0 ] && copt="-c $s"
+				$CVTOOL info -r $mode $copt -o - < $f | sed -n '2,$p' \
+					| sed -e "s/^CH\([0-9]\)_REDUCE=/$f $mode $s \1 /" >> got.txt
+			done
+		done
+	done
+	paste -d ' ' ref.txt got.txt | awk '
+		{
+			if ($1 != $6 || $2 != $7 || $3 != $8 || $4 != $9) exit 1;
+			if ($5 == "none") next;
+			d = $5 - $10; if (d < 0) d = -d;
+			t = $5; if (t < 0) t = -t; if (t < 1) t = 1;
+			if (d > 0.00001 * t) exit 1;
+		}'
+	[ `wc -l < ref.txt` = `wc -l < got.txt` ]
+done
+
+# Quantiles of a uint8 color frame and of a float frame with negative values.
+# Both have many duplicate values, and the 1x1 frames have a single value.
+qs="0,0.1,0.25,0.333,0.5,0.75,0.9,1"
+for size in 1x1 2x1 17x11 40x30; do
+	LC_ALL=C awk -v w=${size%x*} -v h=${size#*x} -v qs="$qs" '
+	function put(v,   s, e, b, i) {
+		s = 0; e = 0; b = 0;
+		if (v < 0) { s = 1; v = -v; }
+		if (v != 0) {
+			while (v >= 2) { v /= 2; e++; }
+			while (v < 1) { v *= 2; e--; }
+			b = s * 2^31 + (e + 127) * 2^23 + (v - 1) * 2^23;
+		}
+		for (i = 0; i < 4; i++) { printf "%c", b % 256 > "q.pfs"; b = int(b / 256); }
+	}
+	function quantiles(f, c, n,   i, j, x, k) {
+		for (i = 0; i < n; i++) {
+			x = v[c, i];
+			for (j = i; j > 0 && s[j - 1] > x; j--)
+				s[j] = s[j - 1];
+			s[j] = x;
+		}
+		for (k = 1; k <= nq; k++)
+			print f, c, k - 1, s[int(q[k] * (n - 1) + 0.5)] > "qref.txt";
+	}
+	BEGIN {
+		n = w * h; nq = split(qs, q, ",");
+		srand(w * 100 + h);
+		printf "P6\n%d %d\n255\n", w, h > "q.pnm";
+		for (i = 0; i < n; i++)
+			for (c = 0; c < 3; c++) {
+				b = int(rand() * (3 + 4 * c)) * int(255 / (2 + 4 * c));
+				printf "%c", b > "q.pnm";
+				v[c, i] = b / 255;
+			}
+		for (c = 0; c < 3; c++)
+			quantiles("q.pnm", c, n);
+		printf "PFS1\n%d %d\n1\n0\nY\n0\nENDH", w, h > "q.pfs";
+		for (i = 0; i < n; i++) {
+			v[0, i] = (int(rand() * 17) - 8) / 4;
+			put(v[0, i]);
+		}
+		quantiles("q.pfs", 0, n);
+	}'
+	rm -f qgot.txt
+	for f in q.pnm q.pfs; do
+		$CVTOOL info -q $qs -o - < $f | sed -n '2,$p' \
+			| sed -e "s/^CH\([0-9]\)_QUANTILE\([0-9]\)=/$f \1 \2 /" >> qgot.txt
+	done
+	paste -d ' ' qref.txt qgot.txt | awk '
+		{
+			if ($1 != $5 || $2 != $6 || $3 != $7) exit 1;
+			d = $4 - $8; if (d < -0.000001 || d > 0.000001) exit 1;
+		}'
+	[ `wc -l < qref.txt` = `wc -l < qgot.txt` ]
+	$CVTOOL info -q $qs -c 1 -o - < q.pnm | sed -n '2,$p' \
+		| sed -e "s/^CH\([0-9]\)_QUANTILE\([0-9]\)=/q.pnm \1 \2 /" > qgot1.txt
+	grep '^q.pnm 1 ' qgot.txt | cmp - qgot1.txt
+done
+
+# Histograms of skewed distributions: a uint8 color frame whose values are
+# cubes of random numbers, and a float frame with negative values whose bins
+# receive different numbers of values. Both frames contain their limits, so
+# that the histogram range is known.
+LC_ALL=C awk -v w=37 -v h=23 '
+	function put(v,   s, e, b, i) {
+		s = 0; e = 0; b = 0;
+		if (v < 0) { s = 1; v = -v; }
+		if (v != 0) {
+			while (v >= 2) { v /= 2; e++; }
+			while (v < 1) { v *= 2; e--; }
+			b = s * 2^31 + (e + 127) * 2^23 + (v - 1) * 2^23;
+		}
+		for (i = 0; i < 4; i++) { printf "%c", b % 256 > "h.pfs"; b = int(b / 256); }
+	}
+	BEGIN {
+		n = w * h; bins = 9;
+		srand(11);
+		printf "P6\n%d %d\n255\n", w, h > "h.pnm";
+		for (i = 0; i < n; i++)
+			for (c = 0; c < 3; c++) {
+				r = rand();
+				b = (i == 0 ? 0 : i == 1 ? 255 : int(255 * r * r * (c == 1 ? 1 : r)));
+				printf "%c", b > "h.pnm";
+				hist[c, int(b * (bins - 1) / 255)]++;
+			}
+		printf "PFS1\n%d %d\n1\n0\nY\n0\nENDH", w, h > "h.pfs";
+		for (i = 0; i < n; i++) {
+			r = rand();
+			v = (i == 0 ? -2 : i == 1 ? 2 : int(16 * r * r) / 4 - 2);
+			put(v);
+			hist[3, int((v + 2) * 2)]++;
+		}
+		for (c = 0; c < 4; c++) {
+			printf "CH%d_HISTOGRAM=", (c < 3 ? c : 0) > "href.txt";
+			for (b = 0; b < bins; b++)
+				printf (b == 0 ? "%d" : ",%d"), hist[c, b] > "href.txt";
+			printf "\n" > "href.txt";
+		}
+	}'
+$CVTOOL info -H 9 -o hgot.txt < h.pnm
+$CVTOOL info -H 9 -o - < h.pfs >> hgot.txt
+grep -v STREAM hgot.txt | cmp - href.txt
+$CVTOOL info -H 9 -c 2 -o - < h.pnm | grep CH2 | cmp - <(sed -n 3p href.txt)
+for method in gpu cpu; do
+	$CVTOOL info -H 9 -M $method -o - < h.pnm | grep -v STREAM | cmp - <(sed -n 1,3p href.txt)
+	$CVTOOL info -H 9 -M $method -o - < h.pfs | grep -v STREAM | cmp - <(sed -n 4p href.txt)
+done
+
+# Histograms of a float frame with three channels whose limits are not exactly
+# representable, so that only careful rounding puts the maximum into the last
+# bin. The other values are in the middle of their bins. Each channel contains
+# infinite and NaN values in different places, which must be ignored.
+LC_ALL=C awk -v w=29 -v h=17 '
+	function put(c, v,   s, e, b, i) {
+		if (v == "inf") b = 2139095040;
+		else if (v == "-inf") b = 4286578688;
+		else if (v == "nan") b = 2143289344;
+		else {
+			s = 0; e = 0; b = 0;
+			if (v < 0) { s = 1; v = -v; }
+			if (v != 0) {
+				while (v >= 2) { v /= 2; e++; }
+				while (v < 1) { v *= 2; e--; }
+				b = s * 2^31 + (e + 127) * 2^23 + int((v - 1) * 2^23 + 0.5);
+			}
+		}
+		for (i = 0; i < 4; i++) { printf "%c", b % 256 > ("n" c ".pfs"); b = int(b / 256); }
+	}
+	BEGIN {
+		n = w * h; bins = 7;
+		lo[0] = -0.3; hi[0] = 0.7; lo[1] = 0.1; hi[1] = 1.9; lo[2] = -5.2; hi[2] = -1.3;
+		special[0] = "inf"; special[1] = "-inf"; special[2] = "nan";
+		srand(5);
+		for (c = 0; c < 3; c++) {
+			printf "PFS1\n%d %d\n1\n0\nY\n0\nENDH", w, h > ("n" c ".pfs");
+			for (b = 0; b < bins; b++)
+				hist[c, b] = 0;
+			for (i = 0; i < n; i++) {
+				r = rand();
+				if (i % 11 == 3 * c + 1) {
+					put(c, special[int(r * 3)]);
+				} else if (i % 13 == c || i < 2) {
+					put(c, i % 2 ? hi[c] : lo[c]);
+					hist[c, i % 2 ? bins - 1 : 0]++;
+				} else {
+					b = int(r * (bins - 1));
+					put(c, lo[c] + (b + 0.5) * (hi[c] - lo[c]) / (bins - 1));
+					hist[c, b]++;
+				}
+			}
+			printf "CH%d_HISTOGRAM=", c > "nref.txt";
+			for (b = 0; b < bins; b++)
+				printf (b == 0 ? "%d" : ",%d"), hist[c, b] > "nref.txt";
+			printf "\n" > "nref.txt";
+		}
+	}'
+$CVTOOL channelcombine n0.pfs n1.pfs n2.pfs > n.pfs
+for method in auto gpu cpu; do
+	$CVTOOL info -H 7 -M $method -o - < n.pfs | grep -v STREAM | cmp - nref.txt
+	$CVTOOL info -H 7 -M $method -c 1 -o - < n.pfs | grep -v STREAM | cmp - <(sed -n 2p nref.txt)
+done
+
 cmd_tests_cleanup
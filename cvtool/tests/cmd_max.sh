@@ -16,4 +16,22 @@ $CVTOOL merge -o merge3.txt X.pnm Y.pnm Z.pnm > XYZ.pnm
 $CVTOOL max -3 -k 1 < lmd.pnm > xXYZ.pnm
 cmp XYZ.pnm xXYZ.pnm
 
+# large window (block scans) against two smaller windows
+$CVTOOL create -n 1 -w 40 -h 30 -c 0x0080ff | $CVTOOL resize -w 99 -h 99 -x 10 -y 50 -c 0xff4000 > sq.pnm
+$CVTOOL max -x 40 -y 35 < sq.pnm > sq1.pnm
+$CVTOOL max -x 20 -y 20 < sq.pnm | $CVTOOL max -x 20 -y 15 > sq2.pnm
+cmp sq1.pnm sq2.pnm
+
+# A closing with a 5x5 kernel removes a dark 3x3 square and keeps a dark 8x7
+# rectangle unchanged
+$CVTOOL create -w 20 -h 16 -c 0xffffff > bg.pnm
+$CVTOOL create -w 3 -h 3 -c 0x202020 | $CVTOOL resize -w 20 -h 16 -x 5 -y 4 -c 0xffffff > small.pnm
+$CVTOOL create -w 8 -h 7 -c 0x202020 | $CVTOOL resize -w 20 -h 16 -x 6 -y 5 -c 0xffffff > large.pnm
+$CVTOOL max -c -k 2 < small.pnm > xsmall.pnm
+cmp bg.pnm xsmall.pnm
+$CVTOOL max --closing -x 2 -y 2 < large.pnm > xlarge.pnm
+cmp large.pnm xlarge.pnm
+$CVTOOL max -k 2 < large.pnm > ylarge.pnm
+if cmp -s large.pnm ylarge.pnm; then exit 1; fi
+
 cmd_tests_cleanup
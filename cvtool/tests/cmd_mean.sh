@@ -16,6 +16,66 @@ $CVTOOL merge -o merge2.txt 1.pnm 2.pnm 3.pnm > 123.pnm
 $CVTOOL mean -3 -k 1 < rgb.pnm > x123.pnm 
 cmp 123.pnm x123.pnm 
 
+# temporal window larger than the number of texture units
+$CVTOOL merge -o merge3.txt 2.pnm 2.pnm 2.pnm 2.pnm 2.pnm > 22222.pnm
+$CVTOOL mean -x 1 -y 1 -t 40 < 22222.pnm > x22222.pnm
+cmp 22222.pnm x22222.pnm
+
+# Temporal mean of a stream of 150 distinct frames, against a reference that
+# averages the clamped 3x3x(2kt+1) window directly. The stream is longer than
+# the interval in which the running sum is recomputed, and kt=40 needs more
+# texture units than are available.
+for kt in 2 40; do
+	LC_ALL=C awk -v w=7 -v h=5 -v n=150 -v kt=$kt 'BEGIN {
+		srand(27);
+		for (f = 0; f < n; f++) for (i = 0; i < w * h; i++) {
+			v[f, i] = int(rand() * 1024) / 1024;
+			print v[f, i] > "seq.txt";
+		}
+		for (f = 0; f < n; f++) for (y = 0; y < h; y++) for (x = 0; x < w; x++) {
+			s = 0;
+			for (t = f - kt; t <= f + kt; t++)
+				for (yy = y - 1; yy <= y + 1; yy++)
+					for (xx = x - 1; xx <= x + 1; xx++) {
+						tc = (t < 0 ? 0 : t >= n ? n - 1 : t);
+						yc = (yy < 0 ? 0 : yy >= h ? h - 1 : yy);
+						xc = (xx < 0 ? 0 : xx >= w ? w - 1 : xx);
+						s += v[tc, yc * w + xc];
+					}
+			print s / (9 * (2 * kt + 1)) > "seqref.txt";
+		}
+	}'
+	cmd_tests_pfs 7 5 < seq.txt > seq.pfs
+	cmd_tests_pfs 7 5 < seqref.txt > seqref.pfs
+	$CVTOOL mean -x 1 -y 1 -t $kt < seq.pfs > xseq.pfs
+	$CVTOOL diff -s -o - seqref.pfs xseq.pfs | grep 'maximum error' \
+		| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 } END { if (NR != 150) exit 1 }'
+done
+
+# The trace events of the temporal passes belong to the output frame that is
+# being computed, not to the input frame that was read last
+for s in 1 2 3 4 5; do cmd_tests_random 8 8 3 $s; done > seq5.ppm
+$CVTOOL --trace=trace.json mean -x 1 -y 1 -t 2 < seq5.ppm > /dev/null
+awk '
+	BEGIN { written = 0; bad = 0; }
+	/"name":"cvl_temporal_mode=/ { if (index($0, "\"frame\":" written ",") == 0) bad = 1; seen[written] = 1; }
+	/"name":"cvl_write"/ { written++; }
+	END { for (i = 0; i < 5; i++) if (!seen[i]) bad = 1; exit (bad || written != 5); }' trace.json
+
+# large kernel (integral image) against the separable convolution
+$CVTOOL mean -k 20 < rgb.pnm > xrgb.pnm
+cmp rgb.pnm xrgb.pnm
+cmd_tests_random 99 77 3 | $CVTOOL convert -t float > rnd.pfs
+o41=1
+for i in `seq 40`; do o41=$o41,1; done
+o25=1
+for i in `seq 24`; do o25=$o25,1; done
+$CVTOOL mean -x 20 -y 12 < rnd.pfs > sat.pfs
+$CVTOOL convolve -X 41:$o41 -Y 25:$o25 < rnd.pfs > box.pfs
+$CVTOOL diff -s -o - sat.pfs box.pfs > satdiff.txt
+grep 'maximum error' satdiff.txt | awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0005) exit 1 }'
+if cmp -s rnd.pfs sat.pfs; then exit 1; fi
+
 $CVTOOL mean -k 1 < rgb.pnm > /dev/null
 $CVTOOL mean -x 1 -y 1 < rgb.pnm > /dev/null
 
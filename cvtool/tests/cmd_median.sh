@@ -12,6 +12,34 @@ $CVTOOL merge -o merge1.txt r.pnm g.pnm b.pnm > rgb.pnm
 $CVTOOL median -k 1 < rgb.pnm > xrgb.pnm 
 cmp rgb.pnm xrgb.pnm 
 
+$CVTOOL median -k 4 < rgb.pnm > xrgb.pnm 
+cmp rgb.pnm xrgb.pnm 
+
+# Pseudo random gray frame and its median with a (2kx+1)x(2ky+1) window and
+# clamped borders
+cmd_tests_random 24 20 1 > r.pgm
+tail -c $((24 * 20)) r.pgm | od -A n -v -t u1 | LC_ALL=C awk -v w=24 -v h=20 -v kx=4 -v ky=2 '
+	{ for (f = 1; f <= NF; f++) { v[n % w, int(n / w)] = $f; n++; } }
+	END {
+		printf "P5\n%d %d\n255\n", w, h;
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++) {
+				n = 0;
+				for (r = y - ky; r <= y + ky; r++)
+					for (c = x - kx; c <= x + kx; c++) {
+						s = v[c < 0 ? 0 : c >= w ? w - 1 : c, r < 0 ? 0 : r >= h ? h - 1 : r];
+						for (i = n++; i > 0 && a[i - 1] > s; i--)
+							a[i] = a[i - 1];
+						a[i] = s;
+					}
+				printf "%c", a[int(n / 2)];
+			}
+	}' > rm.pgm
+$CVTOOL median -x 4 -y 2 < r.pgm > xr.pgm
+cmp rm.pgm xr.pgm
+$CVTOOL convert -t float < r.pgm | $CVTOOL median -x 4 -y 2 | $CVTOOL convert -t uint8 > xr.pgm
+cmp rm.pgm xr.pgm
+
 $CVTOOL median -3 -k 0 < rgb.pnm > yrgb.pnm 
 cmp rgb.pnm yrgb.pnm 
 
@@ -19,5 +47,6 @@ $CVTOOL median -a -k 1 < rgb.pnm > xrgb.pnm
 cmp rgb.pnm xrgb.pnm 
 
 $CVTOOL median -a -3 -k 1 < rgb.pnm > /dev/null
+$CVTOOL median -3 -x 0 -y 0 -t 40 < rgb.pnm > /dev/null
 
 cmd_tests_cleanup
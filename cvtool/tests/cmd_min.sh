@@ -14,4 +14,22 @@ $CVTOOL merge -o merge3.txt 0.pnm 0.pnm 0.pnm > 000.pnm
 $CVTOOL min -3 -k 1 < lmd.pnm > x000.pnm
 cmp 000.pnm x000.pnm
 
+# large window (block scans) against two smaller windows
+$CVTOOL create -n 1 -w 40 -h 30 -c 0x0080ff | $CVTOOL resize -w 99 -h 99 -x 10 -y 50 -c 0xff4000 > sq.pnm
+$CVTOOL min -x 40 -y 35 < sq.pnm > sq1.pnm
+$CVTOOL min -x 20 -y 20 < sq.pnm | $CVTOOL min -x 20 -y 15 > sq2.pnm
+cmp sq1.pnm sq2.pnm
+
+# An opening with a 5x5 kernel removes a bright 3x3 square and keeps a bright 8x7
+# rectangle unchanged
+$CVTOOL create -w 20 -h 16 -c 0x202020 > bg.pnm
+$CVTOOL create -w 3 -h 3 -c 0xffffff | $CVTOOL resize -w 20 -h 16 -x 5 -y 4 -c 0x202020 > small.pnm
+$CVTOOL create -w 8 -h 7 -c 0xffffff | $CVTOOL resize -w 20 -h 16 -x 6 -y 5 -c 0x202020 > large.pnm
+$CVTOOL min -o -k 2 < small.pnm > xsmall.pnm
+cmp bg.pnm xsmall.pnm
+$CVTOOL min --opening -x 2 -y 2 < large.pnm > xlarge.pnm
+cmp large.pnm xlarge.pnm
+$CVTOOL min -k 2 < large.pnm > ylarge.pnm
+if cmp -s large.pnm ylarge.pnm; then exit 1; fi
+
 cmd_tests_cleanup
@@ -12,4 +12,105 @@ $CVTOOL combine -m topbottom b.pnm a.pnm > ba.pnm
 $CVTOOL sort < ab.pnm > xba.pnm
 cmp ba.pnm xba.pnm
 
+# A frame whose size is not a power of two
+$CVTOOL create -t uint8 -f lum -w 30 -h 20 -c 0xffffff > c.pnm
+$CVTOOL create -t uint8 -f lum -w 30 -h 20 -c 0x000000 > d.pnm
+$CVTOOL combine -m topbottom c.pnm d.pnm > cd.pnm 
+$CVTOOL combine -m topbottom d.pnm c.pnm > dc.pnm
+
+$CVTOOL sort < cd.pnm > xdc.pnm
+cmp dc.pnm xdc.pnm
+
+# Random data with references computed by awk:
+# - r.pgm: a gray frame with NPOT size
+# - c.ppm: a color frame whose channels are sorted independently
+# - k.ppm: a color frame sorted by channel 1, with unique keys
+# - d.ppm: a color frame sorted by channel 1, with duplicate keys. Only the
+#   radix sort is stable, so the order of pixels with equal keys is known.
+# - f.txt: float values with negative numbers and duplicates
+LC_ALL=C awk 'BEGIN {
+	srand(5);
+	w = 43; h = 17; n = w * h;
+	printf "P5\n%d %d\n255\n", w, h > "r.pgm";
+	printf "P5\n%d %d\n255\n", w, h > "rs.pgm";
+	for (i = 0; i < n; i++) {
+		v = int(rand() * 256); cnt[v]++;
+		printf "%c", v > "r.pgm";
+	}
+	for (v = 0; v < 256; v++)
+		for (i = 0; i < cnt[v]; i++)
+			printf "%c", v > "rs.pgm";
+
+	w = 29; h = 13; n = w * h;
+	printf "P6\n%d %d\n255\n", w, h > "c.ppm";
+	printf "P6\n%d %d\n255\n", w, h > "cs.ppm";
+	for (i = 0; i < n; i++)
+		for (c = 0; c < 3; c++) {
+			v = int(rand() * 256); ccnt[c, v]++;
+			printf "%c", v > "c.ppm";
+		}
+	for (c = 0; c < 3; c++) {
+		i = 0;
+		for (v = 0; v < 256; v++)
+			for (j = 0; j < ccnt[c, v]; j++)
+				cs[c, i++] = v;
+	}
+	for (i = 0; i < n; i++)
+		printf "%c%c%c", cs[0, i], cs[1, i], cs[2, i] > "cs.ppm";
+
+	w = 16; h = 16; n = w * h;
+	for (i = 0; i < n; i++)
+		key[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		j = int(rand() * (i + 1)); t = key[i]; key[i] = key[j]; key[j] = t;
+	}
+	printf "P6\n%d %d\n255\n", w, h > "k.ppm";
+	for (i = 0; i < n; i++) {
+		r = int(rand() * 256); b = int(rand() * 256);
+		printf "%c%c%c", r, key[i], b > "k.ppm";
+		kr[key[i]] = r; kb[key[i]] = b;
+	}
+	printf "P6\n%d %d\n255\n", w, h > "ks.ppm";
+	for (i = 0; i < n; i++)
+		printf "%c%c%c", kr[i], i, kb[i] > "ks.ppm";
+
+	w = 43; h = 17; n = w * h;
+	printf "P6\n%d %d\n255\n", w, h > "d.ppm";
+	for (i = 0; i < n; i++) {
+		r = int(rand() * 256); g = 25 * int(rand() * 10); b = int(rand() * 256);
+		printf "%c%c%c", r, g, b > "d.ppm";
+		dk[g, dcnt[g]++] = sprintf("%c%c%c", r, g, b);
+	}
+	printf "P6\n%d %d\n255\n", w, h > "ds.ppm";
+	for (g = 0; g < 256; g += 25)
+		for (i = 0; i < dcnt[g]; i++)
+			printf "%s", dk[g, i] > "ds.ppm";
+
+	w = 37; h = 11; n = w * h;
+	for (i = 0; i < n; i++) {
+		v = (int(rand() * 33) - 16) / 8; fcnt[v * 8 + 16]++;
+		print v > "f.txt";
+	}
+	for (v = 0; v <= 32; v++)
+		for (i = 0; i < fcnt[v]; i++)
+			print (v - 16) / 8 > "fs.txt";
+}'
+cmd_tests_pfs 37 11 < f.txt > f.pfs
+cmd_tests_pfs 37 11 < fs.txt > fs.pfs
+
+for method in auto bitonic radix; do
+	$CVTOOL sort -m $method < r.pgm > xrs.pgm
+	cmp rs.pgm xrs.pgm
+	$CVTOOL sort -m $method < c.ppm > xcs.ppm
+	cmp cs.ppm xcs.ppm
+	$CVTOOL sort -m $method -k 1 < k.ppm > xks.ppm
+	cmp ks.ppm xks.ppm
+	$CVTOOL sort -m $method < f.pfs > xfs.pfs
+	cmp fs.pfs xfs.pfs
+done
+for method in auto radix; do
+	$CVTOOL sort -m $method -k 1 < d.ppm > xds.ppm
+	cmp ds.ppm xds.ppm
+done
+
 cmd_tests_cleanup
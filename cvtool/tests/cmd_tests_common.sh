@@ -11,3 +11,35 @@ function cmd_tests_cleanup() {
 	rm -r "$TTMP"
 	CVTOOL="`echo $CVTOOL | sed -e s/^\\\.\\\.\\\///`"
 }
+
+# Writes a frame with pseudo random 8 bit values. The arguments are the width,
+# the height, the number of channels (1 or 3), and optionally a seed.
+function cmd_tests_random() {
+	LC_ALL=C awk -v w=$1 -v h=$2 -v c=$3 -v seed=${4:-1} 'BEGIN {
+		srand(seed);
+		printf "P%d\n%d %d\n255\n", (c == 1 ? 5 : 6), w, h;
+		for (i = 0; i < w * h * c; i++)
+			printf "%c", int(rand() * 256);
+	}'
+}
+
+# Writes float luminance frames in PFS format. The arguments are the width and
+# the height; the values are read from standard input, separated by white
+# space, and are rounded to the nearest 32 bit float. Every width*height values
+# form a new frame.
+function cmd_tests_pfs() {
+	LC_ALL=C awk -v w=$1 -v h=$2 '
+	{
+		for (f = 1; f <= NF; f++) {
+			if (n++ % (w * h) == 0) printf "PFS1\n%d %d\n1\n0\nY\n0\nENDH", w, h;
+			v = $f; s = 0; e = 0; b = 0;
+			if (v < 0) { s = 1; v = -v; }
+			if (v != 0) {
+				while (v >= 2) { v /= 2; e++; }
+				while (v < 1) { v *= 2; e--; }
+				b = s * 2^31 + (e + 127) * 2^23 + int((v - 1) * 2^23 + 0.5);
+			}
+			for (i = 0; i < 4; i++) { printf "%c", b % 256; b = int(b / 256); }
+		}
+	}'
+}
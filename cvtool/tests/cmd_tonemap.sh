@@ -12,6 +12,123 @@ $CVTOOL tonemap -m reinhard05 --intensity=0.1 --light-adaptation=0.5 --chromatic
 $CVTOOL tonemap -m ashikhmin02 --local-contrast=0.5 < r.pnm > /dev/null
 $CVTOOL tonemap -m drago03 --max-display-luminance=200.0 --bias=0.84 < r.pnm > /dev/null
 $CVTOOL tonemap -m durand02 --sigma-spatial=0.3 --sigma-luminance=0.4 --base-contrast=3 < r.pnm > /dev/null
+$CVTOOL tonemap -m durand02 --sigma-spatial=8 --sigma-luminance=0.4 --base-contrast=3 < r.pnm > /dev/null
 $CVTOOL tonemap -m reinhard02 --key-value=0.1 --white=1.0 --sharpness=10.0 --epsilon=0.5 < r.pnm > /dev/null
+cat r.pnm r.pnm r.pnm | $CVTOOL tonemap -m reinhard05 --adaptation-time=2 > /dev/null
+cat r.pnm r.pnm r.pnm | $CVTOOL tonemap -m tumblin99 -t 10 > /dev/null
+cat r.pnm r.pnm | $CVTOOL tonemap -m drago03 > /dev/null
+
+cat > batch.txt << EOF
+# output      options
+drago03.pnm   -m drago03 --bias=0.7
+tumblin99.pnm -m tumblin99
+reinhard05.pnm -m reinhard05 --intensity=0.1
+EOF
+cat r.pnm r.pnm | $CVTOOL tonemap --batch=batch.txt -t 2 > /dev/null
+cat r.pnm r.pnm | $CVTOOL tonemap -m drago03 --bias=0.7 > x.pnm
+cmp x.pnm drago03.pnm
+cat r.pnm r.pnm | $CVTOOL tonemap -m tumblin99 -t 2 > x.pnm
+cmp x.pnm tumblin99.pnm
+cat r.pnm r.pnm | $CVTOOL tonemap -m reinhard05 --intensity=0.1 -t 2 > x.pnm
+cmp x.pnm reinhard05.pnm
+
+# A stream that jumps from a dark frame to a bright frame. With adaptation time
+# 0, each frame must be mapped exactly as if it was the only frame. With
+# adaptation time 2, the first frame is mapped like that, and the following
+# frames must approach the mapping of the bright frame smoothly: the mean
+# error must be clearly larger than 0 for the second frame, and then decrease
+# from frame to frame.
+cmd_tests_random 32 24 3 1 > dark.ppm
+$CVTOOL create -w 32 -h 24 -c 0xc0c0c0 > gray.ppm
+$CVTOOL mix -w 1,3 dark.ppm gray.ppm > bright.ppm
+cat dark.ppm bright.ppm bright.ppm bright.ppm bright.ppm > stream.ppm
+for method in tumblin99 reinhard05 ashikhmin02 reinhard02; do
+	$CVTOOL tonemap -m $method < dark.ppm > single.ppm
+	for i in 1 2 3 4; do
+		$CVTOOL tonemap -m $method < bright.ppm >> single.ppm
+	done
+	$CVTOOL tonemap -m $method -t 0 < stream.ppm > x.ppm
+	cmp single.ppm x.ppm
+	$CVTOOL tonemap -m $method -t 2 < stream.ppm > x.ppm
+	$CVTOOL diff -s -o - single.ppm x.ppm | grep 'mean error' | awk '
+		NR == 1 { for (i = 7; i <= NF; i++) if ($i != 0) exit 1; }
+		NR == 2 { for (i = 7; i <= NF; i++) if ($i < 0.01) exit 1; }
+		NR > 2 { for (i = 7; i <= NF; i++) if ($i >= last[i]) exit 1; }
+		{ for (i = 7; i <= NF; i++) last[i] = $i; }
+		END { if (NR != 5) exit 1; }'
+done
+
+# The lookup tables of schlick94, tumblin99, and drago03 must match the direct
+# evaluation of the curves within 3/255, for a color frame and for a float
+# luminance frame with a high dynamic range.
+cmd_tests_random 64 48 3 3 > ldr.ppm
+LC_ALL=C awk 'BEGIN {
+	srand(4);
+	for (i = 0; i < 64 * 48; i++)
+		print int(rand() * 256) / 128 * 2 ^ int(rand() * 24 - 14);
+}' | cmd_tests_pfs 64 48 > hdr.pfs
+for method in schlick94 tumblin99 drago03; do
+	for f in ldr.ppm hdr.pfs; do
+		$CVTOOL tonemap -m $method < $f > lut.$f
+		$CVTOOL tonemap -m $method --no-lut < $f > direct.$f
+		$CVTOOL diff -s -o - lut.$f direct.$f | grep 'maximum error' \
+			| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.012) exit 1 }'
+	done
+done
+
+# The scales of reinhard02 are computed on a luminance pyramid. The result must
+# match a reference that uses full gaussian masks at full resolution within
+# 0.012 per pixel and 0.001 on average, for even and odd frame sizes.
+for size in "48 40" "61 37"; do
+	LC_ALL=C awk -v w=${size% *} -v h=${size#* } '
+	function blur(src, dst, s,   k, g, t, i, x, y, xx, yy, sum, wsum) {
+		k = int(4 * s + 1);
+		for (i = -k; i <= k; i++) g[i] = exp(-i * i / (2 * s * s));
+		for (y = 0; y < h; y++) for (x = 0; x < w; x++) {
+			sum = 0; wsum = 0;
+			for (i = -k; i <= k; i++) {
+				xx = x + i; xx = (xx < 0 ? 0 : xx >= w ? w - 1 : xx);
+				sum += g[i] * src[y * w + xx]; wsum += g[i];
+			}
+			t[y * w + x] = sum / wsum;
+		}
+		for (y = 0; y < h; y++) for (x = 0; x < w; x++) {
+			sum = 0; wsum = 0;
+			for (i = -k; i <= k; i++) {
+				yy = y + i; yy = (yy < 0 ? 0 : yy >= h ? h - 1 : yy);
+				sum += g[i] * t[yy * w + x]; wsum += g[i];
+			}
+			dst[y * w + x] = sum / wsum;
+		}
+	}
+	BEGIN {
+		srand(8); n = w * h;
+		for (y = 0; y < h; y++) for (x = 0; x < w; x++) {
+			v = (x < w / 2 ? 0.05 : 0.6) * (1 + 0.5 * sin(x / 3) * cos(y / 5)) + 0.05 * rand();
+			if ((x - w / 4) ^ 2 + (y - h / 2) ^ 2 < 25) v = 0.95;
+			Y[y * w + x] = int(v * 1024) / 1024;
+			print Y[y * w + x] > "in.txt";
+			logsum += log(2.3e-5 + Y[y * w + x]);
+		}
+		sf = 0.1 / exp(logsum / n);
+		split("2.4 4.8 7.2 9.6", s, " ");
+		for (i = 1; i <= 4; i++) { delete B; blur(Y, B, s[i]); for (j = 0; j < n; j++) G[i, j] = B[j] * sf; }
+		for (j = 0; j < n; j++) {
+			lm = sf * Y[j]; ls = Y[j]; lp = Y[j]; sp = 0.2;
+			for (i = 1; i <= 4; i++) {
+				if ((lp - G[i, j]) / (2 ^ 10 * 0.1 / (sp * sp) + lp) < 0.5) ls = G[i, j];
+				lp = G[i, j]; sp = s[i];
+			}
+			ld = lm * (1 + lm) / (1 + ls);
+			print (ld < 0.00001 ? 0.00001 : ld > 1 ? 1 : ld) > "ref.txt";
+		}
+	}'
+	cmd_tests_pfs $size < in.txt > in.pfs
+	cmd_tests_pfs $size < ref.txt > ref.pfs
+	$CVTOOL tonemap -m reinhard02 --key-value=0.1 --white=1.0 --sharpness=10.0 --epsilon=0.5 < in.pfs > out.pfs
+	$CVTOOL diff -s -o - ref.pfs out.pfs > stat.txt
+	grep 'maximum error' stat.txt | awk '{ if ($7 > 0.012) exit 1 }'
+	grep 'mean error' stat.txt | awk '{ if ($7 > 0.001) exit 1 }'
+done
 
 cmd_tests_cleanup
@@ -17,4 +17,52 @@ $CVTOOL wavelets -t idwt -D 2 -l 1 < st.pfs > xxred.pfs
 $CVTOOL convert -t uint8 < xxred.pfs > xxred.ppm
 cmp red.ppm xxred.ppm
 
+# Frames of odd size are transformed on the CPU
+$CVTOOL create -w 13 -h 7 -c 0x336699 > a.ppm
+$CVTOOL create -w 13 -h 6 -c 0xcc2211 > b.ppm
+$CVTOOL combine -m topbottom a.ppm b.ppm > ab.ppm
+$CVTOOL convert -t float < ab.ppm > ab.pfs
+$CVTOOL wavelets -t dwt -D 4 -l 3 < ab.pfs > dwt.pfs
+$CVTOOL wavelets -t idwt -D 4 -l 3 < dwt.pfs > xab.pfs
+$CVTOOL convert -t uint8 < xab.pfs > xab.ppm
+cmp ab.ppm xab.ppm
+$CVTOOL wavelets -t dwt -D 8 -l 2 < ab.pfs > dwt.pfs
+$CVTOOL wavelets -t hard-thresholding -l 2 -T 0 < dwt.pfs > ht.pfs
+$CVTOOL wavelets -t idwt -D 8 -l 2 < ht.pfs > xab.pfs
+$CVTOOL convert -t uint8 < xab.pfs > xab.ppm
+cmp ab.ppm xab.ppm
+
+# Known D2 coefficients of the ramp x + 4y on a 4x4 frame. Level 1 has the
+# approximations 5 9 21 25 and the details -1 (horizontal), -4 (vertical), and
+# 0 (diagonal); level 2 transforms the approximations again.
+LC_ALL=C awk 'BEGIN { for (y = 0; y < 4; y++) for (x = 0; x < 4; x++) print x + 4 * y }' \
+	| cmd_tests_pfs 4 4 > ramp.pfs
+echo "5 9 -1 -1 21 25 -1 -1 -4 -4 0 0 -4 -4 0 0" | cmd_tests_pfs 4 4 > d2l1.pfs
+echo "30 -4 -1 -1 -16 0 -1 -1 -4 -4 0 0 -4 -4 0 0" | cmd_tests_pfs 4 4 > d2l2.pfs
+for method in gpu cpu; do
+	for l in 1 2; do
+		$CVTOOL wavelets -t dwt -D 2 -l $l -m $method < ramp.pfs > dwt.pfs
+		$CVTOOL diff -s -o - d2l$l.pfs dwt.pfs | grep 'maximum error' \
+			| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 }'
+	done
+done
+
+# The CPU and GPU methods must agree on frames whose size allows both
+cmd_tests_random 64 48 3 5 > r.ppm
+$CVTOOL convert -t float < r.ppm > r.pfs
+for D in 2 4 8 20; do
+	for l in 1 3; do
+		$CVTOOL wavelets -t dwt -D $D -l $l -m gpu < r.pfs > gpu.pfs
+		$CVTOOL wavelets -t dwt -D $D -l $l -m cpu < r.pfs > cpu.pfs
+		$CVTOOL diff -s -o - gpu.pfs cpu.pfs | grep 'maximum error' \
+			| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 }'
+		$CVTOOL wavelets -t idwt -D $D -l $l -m gpu < gpu.pfs > igpu.pfs
+		$CVTOOL wavelets -t idwt -D $D -l $l -m cpu < gpu.pfs > icpu.pfs
+		$CVTOOL diff -s -o - igpu.pfs icpu.pfs | grep 'maximum error' \
+			| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 }'
+		$CVTOOL diff -s -o - r.pfs icpu.pfs | grep 'maximum error' \
+			| awk '{ for (i = 7; i <= NF; i++) if ($i > 0.0001) exit 1 }'
+	done
+done
+
 cmd_tests_cleanup